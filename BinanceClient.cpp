@@ -16,17 +16,19 @@
 #include <sys/types.h>
 #include <sched.h>
 #include "EventLoop.h"
+#include "HugePageArena.h"
+#include "MarketDataCodec.h"
+#ifdef __linux__
+#include "IoUringTransport.h"
+#endif
 #include <random>
+#include <algorithm>
 #include <spdlog/spdlog.h>
 #include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <boost/interprocess/file_mapping.hpp>
 #include <boost/interprocess/mapped_region.hpp>
 
-#ifdef __linux__
-#include <numa.h>
-#endif
-
 // CircuitBreaker implementation
 CircuitBreaker::CircuitBreaker(int failure_threshold, std::chrono::seconds reset_timeout)
     : failure_threshold_(failure_threshold), reset_timeout_(reset_timeout) {}
@@ -65,18 +67,38 @@ void CircuitBreaker::record_failure() {
 }
 
 // BinanceClient implementation
-BinanceClient::BinanceClient(size_t thread_count) 
-    : event_loop_pool_(std::make_unique<EventLoopPool>(thread_count)),
-      market_data_loop_(std::make_unique<EventLoop>()),
-      orderbook_manager_(std::make_unique<OrderbookManager>()),
-      message_processor_(std::make_unique<MessageProcessor>(market_data_loop_->get_io_context(), *orderbook_manager_)),
+BinanceClient::BinanceClient(size_t thread_count, const StartupConfig& startup_config, RuntimeMode runtime_mode)
+    : orderbook_manager_(std::make_unique<OrderbookManager>()),
+      trade_statistics_(std::make_unique<TradeStatistics>()),
       running_(false),
       circuit_breaker_(5, std::chrono::seconds(30)),
       work_(std::make_unique<boost::asio::io_context::work>(io_context_)),
-      ws_handler_pool_(),
-      rest_handler_pool_()
+      startup_orchestrator_(startup_config)
 {
-    spdlog::info("BinanceClient initialized with {} threads", thread_count);
+    ssl_ctx_.set_default_verify_paths();
+    runtime_mode_ = runtime_mode;
+    if (runtime_mode_ == RuntimeMode::ShardPerCore) {
+        shard_runtime_ = std::make_unique<ShardRuntime>(thread_count);
+        for (size_t i = 0; i < shard_runtime_->size(); ++i) {
+            ShardSlice slice;
+            slice.books = std::make_unique<OrderbookManager>(1);  // one owner thread, nothing to stripe
+            slice.processor = std::make_unique<MessageProcessor>(shard_runtime_->loop(i).get_io_context(), *slice.books);
+            slice.processor->set_inline(true);
+            slice.processor->set_trade_statistics(trade_statistics_.get());
+            shard_slices_.push_back(std::move(slice));
+        }
+    } else {
+        event_loop_pool_ = std::make_unique<EventLoopPool>(thread_count);
+        symbol_router_ = std::make_unique<SymbolRouter>(*event_loop_pool_);
+        // The market data loop is hot and keeps spinning while traffic flows; the
+        // connection loops park between bursts
+        market_data_loop_ = std::make_unique<EventLoop>(WaitConfig{WaitStrategy::Adaptive});
+        message_processor_ = std::make_unique<MessageProcessor>(market_data_loop_->get_io_context(), *orderbook_manager_);
+        message_processor_->set_router(symbol_router_.get());
+        message_processor_->set_trade_statistics(trade_statistics_.get());
+    }
+    spdlog::info("BinanceClient initialized with {} threads{}", thread_count,
+                 shard_runtime_ ? " as shard-per-core" : "");
     for (size_t i = 0; i < thread_count; ++i) {
         worker_threads_.emplace_back([this] { io_context_.run(); });
     }
@@ -89,28 +111,133 @@ BinanceClient::~BinanceClient() {
 void BinanceClient::start(const std::vector<std::string>& symbols) {
     spdlog::info("Starting BinanceClient with {} symbols", symbols.size());
     running_ = true;
-    balance_symbols(symbols);
-    event_loop_pool_->run();
-    market_data_loop_->run();
+    start_time_ = std::chrono::steady_clock::now();
 
+    std::vector<std::string> streams;
+    streams.reserve(symbols.size());
     for (const auto& symbol : symbols) {
-        create_handlers_for_symbol(symbol);
+        streams.push_back(stream_symbol(symbol));
+    }
+    balance_symbols(streams);
+    {
+        std::unique_lock<std::shared_mutex> lock(symbols_mutex_);
+        for (const auto& symbol : symbols) {
+            active_symbols_.push_back(symbol);
+        }
     }
 
-    market_data_loop_->post([this]() { message_processor_->run(); });
+    if (topology_.enabled) {
+        for (auto& thread : worker_threads_) {
+            pin_thread(thread, topology_.housekeeping_cpus);
+        }
+        analytics_pool_.set_affinity(topology_.housekeeping_cpus);
+        for (const auto& placement : get_thread_layout()) {
+            std::string cpus;
+            for (int cpu : placement.cpus) {
+                cpus += (cpus.empty() ? "" : ",") + std::to_string(cpu);
+            }
+            spdlog::info("Thread {}: cpu {} node {}", placement.thread,
+                         cpus.empty() ? "any" : cpus,
+                         placement.node < 0 ? "any" : std::to_string(placement.node));
+        }
+    }
+
+    if (stream_transport_ == StreamTransport::IoUring) {
+        setup_io_uring();
+    }
+    if (shard_runtime_) {
+        shard_runtime_->run();
+    } else {
+        event_loop_pool_->run();
+        market_data_loop_->run();
+    }
+    start_clock_sync();
+
+    auto sync_listener = [this](const std::string& symbol, bool synced) {
+        on_book_sync_changed(symbol, synced);
+    };
+    orderbook_manager_->setSyncListener(sync_listener);
+    for (auto& slice : shard_slices_) {
+        slice.books->setSyncListener(sync_listener);
+    }
+    startup_orchestrator_.begin(streams);
+    restore_books(streams);
+
+    // Snapshot handlers exist before any stream opens so the first open can schedule them
+    for (const auto& symbol : streams) {
+        create_snapshot_handler(symbol);
+    }
+
+    // All combined-stream connections are opened at once; each schedules its snapshot
+    // fetches on open, at the offsets the weight budget allows
+    const auto& config = startup_orchestrator_.config();
+    auto schedule = StartupOrchestrator::plan_snapshot_schedule(streams.size(), config);
+    std::unordered_map<std::string, std::chrono::milliseconds> offset_of;
+    for (size_t i = 0; i < streams.size(); ++i) {
+        offset_of.emplace(streams[i], schedule[i]);
+    }
+    // A shard's connections only carry its own symbols
+    std::vector<std::vector<std::string>> partitions;
+    if (shard_runtime_) {
+        partitions.resize(shard_runtime_->size());
+        for (const auto& symbol : streams) {
+            partitions[shard_runtime_->find(symbol)].push_back(symbol);
+        }
+    } else {
+        partitions.push_back(streams);
+    }
+    for (const auto& partition : partitions) {
+        for (const auto& group : StartupOrchestrator::group_streams(partition, config.streams_per_connection)) {
+            std::vector<std::chrono::milliseconds> offsets;
+            for (const auto& symbol : group) {
+                offsets.push_back(offset_of[symbol]);
+            }
+            create_stream_connection(group, offsets);
+        }
+    }
+
+    if (message_processor_) {
+        market_data_loop_->post([this]() { message_processor_->run(); }, EventLoop::Priority::High);
+    }
 }
 
 void BinanceClient::stop() {
-    running_ = false;
+    bool was_running = running_.exchange(false);
+    if (time_sync_handler_) {
+        time_sync_handler_->stop();
+    }
+    // Combined-stream handlers are shared by all of their symbols
+    std::unordered_set<WebSocketHandler*> stopped;
     for (auto& [symbol, handler] : ws_handlers_) {
-        handler->stop();
+        if (stopped.insert(handler.get()).second) {
+            handler->stop();
+        }
     }
     for (auto& [symbol, handler] : rest_handlers_) {
         handler->stop();
     }
-    message_processor_->stop();
-    event_loop_pool_->stop();
-    market_data_loop_->stop();
+    if (shard_runtime_) {
+        shard_runtime_->stop();
+    } else {
+        message_processor_->stop();
+        event_loop_pool_->stop();
+        market_data_loop_->stop();
+    }
+#ifdef __linux__
+    for (auto& [loop, transport] : io_uring_transports_) {
+        transport->detach();
+    }
+#endif
+    // Lets a periodic checkpoint finish before the final one below
+    analytics_pool_.shutdown();
+
+    if (was_running && !checkpoint_path_.empty()) {
+        try {
+            checkpoint_books();
+        } catch (const std::exception& e) {
+            log_error(std::string("Order book checkpoint failed: ") + e.what());
+        }
+    }
 
     work_.reset();
     for (auto& thread : worker_threads_) {
@@ -121,7 +248,45 @@ void BinanceClient::stop() {
 }
 
 std::string BinanceClient::get_orderbook_snapshot(const std::string& symbol, int depth) const {
-    return orderbook_manager_->getOrderbookSnapshot(symbol, depth);
+    std::string stream = stream_symbol(symbol);
+    return books_for(stream).getOrderbookSnapshot(stream, depth);
+}
+
+void BinanceClient::get_orderbook_snapshots(const std::vector<std::string>& symbols, int depth,
+                                            BookBatch& out) const {
+    // Books are keyed by stream symbol, as get_orderbook_snapshot's are; assigned in place
+    // so a reused batch keeps its strings' capacity
+    out.symbols.resize(symbols.size());
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        out.symbols[i].assign(symbols[i]);
+        std::transform(out.symbols[i].begin(), out.symbols[i].end(), out.symbols[i].begin(), ::tolower);
+    }
+    if (!shard_runtime_) {
+        orderbook_manager_->getSnapshots(out.symbols, depth, out);
+        return;
+    }
+    // Each manager is asked once, for its own symbols; 0 is the shared manager
+    out.reset(symbols.size());
+    out.groups.clear();
+    for (uint32_t i = 0; i < symbols.size(); ++i) {
+        out.groups.emplace_back(static_cast<size_t>(shard_runtime_->find(out.symbols[i]) + 1), i);
+    }
+    std::sort(out.groups.begin(), out.groups.end());
+    for (size_t i = 0; i < out.groups.size();) {
+        const size_t group = out.groups[i].first;
+        out.positions.clear();
+        for (; i < out.groups.size() && out.groups[i].first == group; ++i) {
+            out.positions.push_back(out.groups[i].second);
+        }
+        const OrderbookManager& books = group == 0 ? *orderbook_manager_ : *shard_slices_[group - 1].books;
+        books.appendSnapshots(out.symbols, out.positions, depth, out);
+    }
+}
+
+bool BinanceClient::encode_orderbook_snapshot(const std::string& symbol, int depth, uint32_t symbol_id,
+                                              std::string& out) const {
+    std::string stream = stream_symbol(symbol);
+    return books_for(stream).encodeSnapshot(stream, depth, symbol_id, out);
 }
 
 void BinanceClient::add_symbol(const std::string& symbol) {
@@ -167,29 +332,12 @@ void BinanceClient::monitor_system_health() {
     // Implement system health monitoring logic
 }
 
-void BinanceClient::reconnect_failed_connections() {
-    for (auto& [symbol, handler] : ws_handlers_) {
-        if (!handler->is_connected()) {
-            handler->connect();
-        }
-    }
-    for (auto& [symbol, handler] : rest_handlers_) {
-        if (!handler->is_connected()) {
-            handler->start_polling();
-        }
-    }
-}
-
 TradingStats BinanceClient::get_trading_stats(const std::string& symbol) const {
-    // Implement actual trading statistics logic here
-    // Now returning random data as an example
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<> volume_dis(1000, 10000);
-    static std::uniform_real_distribution<> price_change_dis(-5, 5);
-
-    (void)symbol;  // Suppress unused parameter warning
-    return TradingStats{volume_dis(gen), price_change_dis(gen)};
+    // Windows run on trade times, which are exchange milliseconds since the epoch. Until
+    // the clock is synced the local clock may be off by more than a window, so they only
+    // move with the trades themselves.
+    int64_t now_ms = clock_sync_.has_estimate() ? clock_sync_.local_to_exchange_ms(wall_clock_us()) : 0;
+    return trade_statistics_->get(stream_symbol(symbol), now_ms);
 }
 
 void BinanceClient::clean_old_data() {
@@ -197,6 +345,28 @@ void BinanceClient::clean_old_data() {
     // Implement old data cleaning logic
 }
 
+void BinanceClient::run_housekeeping() {
+    if (!running_) {
+        return;
+    }
+    try {
+        analytics_pool_.enqueue([this]() { clean_old_data(); });
+        analytics_pool_.enqueue([this]() { generate_report(); });
+        if (!checkpoint_path_.empty()) {
+            analytics_pool_.enqueue([this]() {
+                try {
+                    checkpoint_books();
+                } catch (const std::exception& e) {
+                    log_error(std::string("Order book checkpoint failed: ") + e.what());
+                }
+            });
+        }
+    } catch (const std::runtime_error& e) {
+        // stop() shut the pool down between the check and the enqueue
+        spdlog::debug("Skipping housekeeping: {}", e.what());
+    }
+}
+
 void BinanceClient::update_configuration() {
     std::cout << "Updating configuration..." << std::endl;
     // Implement configuration update logic
@@ -214,13 +384,18 @@ ResourceUsage BinanceClient::get_resource_usage() const {
 }
 
 bool BinanceClient::need_load_balancing() const {
-    // Implement load balancing check logic
-    return false;
+    // Shards keep their symbols for life; moving one means moving its connection
+    return !shard_runtime_ && symbol_router_->is_imbalanced();
 }
 
 void BinanceClient::perform_load_balancing() {
-    std::cout << "Performing load balancing..." << std::endl;
-    // Implement load balancing logic
+    if (shard_runtime_) {
+        return;
+    }
+    size_t migrated = symbol_router_->rebalance();
+    if (migrated > 0) {
+        spdlog::info("Load balancing moved {} symbols, loop imbalance now {:.2f}", migrated, symbol_router_->imbalance());
+    }
 }
 
 bool BinanceClient::has_new_market_data() const {
@@ -236,11 +411,249 @@ void BinanceClient::process_new_market_data() {
 void BinanceClient::generate_report() const {
     std::cout << "Generating report..." << std::endl;
     // Implement report generation logic
+    for (const auto& arena : HugePageArena::report()) {
+        spdlog::info("Arena {}: {} of {} bytes used on {}, {} bytes freed, {} heap fallbacks",
+                     HugePageArena::kind_name(arena.kind), arena.used, arena.reserved,
+                     HugePageArena::backing_name(arena.backing), arena.freed, arena.heap_fallbacks);
+    }
+    if (capture_) {
+        CaptureStats capture = capture_->stats();
+        spdlog::info("Capture: {} records, {} bytes, {} dropped, {} segments sealed", capture.records, capture.bytes,
+                     capture.dropped, capture.segments_sealed);
+    }
 }
 
 int BinanceClient::check_network_latency() const {
-    // Implement network latency check logic
-    return 50; // Return an example value in milliseconds
+    // One-way feed latency, which both transports measure; ping RTT is websocketpp only and
+    // would not compare. A combined connection is listed once per symbol but counts once.
+    std::vector<int64_t> medians;
+    std::unordered_set<const WebSocketHandler*> seen;
+    for (const auto& [symbol, handler] : ws_handlers_) {
+        if (!seen.insert(handler.get()).second) {
+            continue;
+        }
+        ConnectionLatency latency = handler->get_latency();
+        if (latency.exchange_to_local.count > 0) {
+            medians.push_back(latency.exchange_to_local.p50_us);
+        }
+    }
+    if (medians.empty()) {
+        return -1;
+    }
+    auto mid = medians.begin() + medians.size() / 2;
+    std::nth_element(medians.begin(), mid, medians.end());
+    return static_cast<int>(*mid / 1000);
+}
+
+ConnectionLatency BinanceClient::get_connection_latency(const std::string& symbol) const {
+    tbb::concurrent_hash_map<std::string, std::shared_ptr<WebSocketHandler>>::const_accessor acc;
+    if (!ws_handlers_.find(acc, stream_symbol(symbol))) {
+        return ConnectionLatency{};
+    }
+    return acc->second->get_latency();
+}
+
+void BinanceClient::set_socket_profile(const LowLatencySocketProfile& profile) {
+    socket_profile_ = profile;
+}
+
+void BinanceClient::set_capture(const CaptureConfig& config) {
+    capture_ = std::make_unique<CaptureJournal>(config);
+    capture_book_tops_ = config.book_tops;
+    spdlog::info("Capturing raw feed payloads to {}", capture_->directory());
+    install_view_listener();
+}
+
+void BinanceClient::set_shared_books(const std::string& name, uint32_t capacity) {
+    shared_books_ = std::make_unique<SharedBookPublisher>(name, capacity);
+    orderbook_manager_->setSharedPublisher(shared_books_.get());
+    for (auto& slice : shard_slices_) {
+        slice.books->setSharedPublisher(shared_books_.get());
+    }
+}
+
+void BinanceClient::set_fanout(const FanoutConfig& config) {
+    fanout_ = std::make_unique<FanoutServer>(config);
+    install_view_listener();
+}
+
+void BinanceClient::install_view_listener() {
+    OrderbookManager::ViewListener listener;
+    if (fanout_ || capture_book_tops_) {
+        listener = [this](const std::string& symbol, const BookView& view) { on_book_view(symbol, view); };
+    }
+    orderbook_manager_->setViewListener(listener);
+    for (auto& slice : shard_slices_) {
+        slice.books->setViewListener(listener);
+    }
+}
+
+void BinanceClient::on_book_view(const std::string& symbol, const BookView& view) {
+    if (fanout_) {
+        fanout_->on_book(symbol, view);
+    }
+    if (capture_book_tops_) {
+        capture_book_top(symbol, view);
+    }
+}
+
+void BinanceClient::capture_book_top(const std::string& symbol, const BookView& view) {
+    // A symbol's views come from one shard at a time, so the last recorded top is kept
+    // per thread; the journal's symbol ID is resolved once, not per view
+    struct RecordedTop {
+        const CaptureJournal* journal = nullptr;
+        md::Bbo bbo{};
+    };
+    thread_local std::unordered_map<std::string, RecordedTop> recorded;
+    RecordedTop& top = recorded[symbol];
+    if (top.journal != capture_.get()) {
+        top.journal = capture_.get();
+        top.bbo = md::Bbo{};
+        top.bbo.symbol_id = capture_->symbol_id(symbol);
+        top.bbo.exchange = md::Exchange::Binance;
+    }
+    md::Level bid = view.bid_count ? md::Level{md::to_fixed(view.bids[0].price), md::to_fixed(view.bids[0].quantity)}
+                                   : md::Level{0, 0};
+    md::Level ask = view.ask_count ? md::Level{md::to_fixed(view.asks[0].price), md::to_fixed(view.asks[0].quantity)}
+                                   : md::Level{0, 0};
+    if (top.bbo.sequence != 0 && bid.price == top.bbo.bid.price && bid.quantity == top.bbo.bid.quantity &&
+        ask.price == top.bbo.ask.price && ask.quantity == top.bbo.ask.quantity) {
+        return;
+    }
+    top.bbo.bid = bid;
+    top.bbo.ask = ask;
+    top.bbo.update_id = view.last_update_id;
+    top.bbo.local_ns = CaptureJournal::now_ns();
+    ++top.bbo.sequence;
+    char message[md::encoded_size<md::Bbo>()];
+    md::encode(message, top.bbo);
+    capture_->append(CaptureSource::Normalized, 0, top.bbo.symbol_id, top.bbo.local_ns,
+                     std::string_view(message, sizeof(message)));
+}
+
+void BinanceClient::set_endpoints(const ExchangeEndpoints& endpoints) {
+    endpoints_ = endpoints;
+    spdlog::info("Using stream endpoint {} and REST endpoint {}:{}", endpoints_.stream_base, endpoints_.rest_host,
+                 endpoints_.rest_port);
+}
+
+void BinanceClient::set_stream_transport(StreamTransport transport) {
+#ifdef __linux__
+    if (transport == StreamTransport::IoUring && !IoUringTransport::is_supported()) {
+        throw std::runtime_error("io_uring is not available on this kernel");
+    }
+#else
+    if (transport == StreamTransport::IoUring) {
+        throw std::runtime_error("io_uring streams need Linux");
+    }
+#endif
+    stream_transport_ = transport;
+}
+
+void BinanceClient::setup_io_uring() {
+#ifdef __linux__
+    if (endpoints_.stream_base.compare(0, 5, "ws://") != 0) {
+        throw std::invalid_argument("io_uring streams need a ws:// stream base, not " + endpoints_.stream_base);
+    }
+    std::vector<EventLoop*> loops;
+    if (shard_runtime_) {
+        for (size_t i = 0; i < shard_runtime_->size(); ++i) {
+            loops.push_back(&shard_runtime_->loop(i));
+        }
+    } else {
+        for (size_t i = 0; i < event_loop_pool_->size(); ++i) {
+            loops.push_back(&event_loop_pool_->get_event_loop(i));
+        }
+    }
+    IoUringConfig config;
+    config.single_issuer = false;  // created here, driven by the loop's thread
+    for (EventLoop* loop : loops) {
+        auto transport = std::make_unique<IoUringTransport>(config);
+        transport->attach(*loop);
+        io_uring_transports_.emplace_back(loop, std::move(transport));
+    }
+    spdlog::info("Reading streams through io_uring on {} loops", loops.size());
+#endif
+}
+
+void BinanceClient::set_trade_stream(const std::string& trade_stream) {
+    if (!trade_stream.empty() && trade_stream != "trade" && trade_stream != "aggTrade") {
+        throw std::invalid_argument("Unknown trade stream: " + trade_stream);
+    }
+    trade_stream_ = trade_stream;
+}
+
+void BinanceClient::set_checkpoint_path(const std::string& path) {
+    checkpoint_path_ = path;
+}
+
+void BinanceClient::checkpoint_books() const {
+    BookCheckpoint::Books books;
+    std::vector<const OrderbookManager*> managers{orderbook_manager_.get()};
+    for (const auto& slice : shard_slices_) {
+        managers.push_back(slice.books.get());
+    }
+    for (const auto* manager : managers) {
+        for (auto& entry : manager->exportBooks()) {
+            // Books that never saw a sequenced update cannot be resumed
+            if (entry.second.last_update_id > 0) {
+                books.push_back(std::move(entry));
+            }
+        }
+    }
+    auto begin = std::chrono::steady_clock::now();
+    BookCheckpoint::save(checkpoint_path_, books);
+    spdlog::info("Checkpointed {} order books to {} ({} bytes) in {} us", books.size(), checkpoint_path_,
+                 BookCheckpoint::encoded_size(books),
+                 std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count());
+}
+
+size_t BinanceClient::restore_books(const std::vector<std::string>& symbols) {
+    if (checkpoint_path_.empty()) {
+        return 0;
+    }
+    std::unordered_set<std::string> wanted(symbols.begin(), symbols.end());
+    size_t restored = 0;
+    for (auto& [symbol, book] : BookCheckpoint::load(checkpoint_path_)) {
+        if (!wanted.count(symbol)) {
+            continue;
+        }
+        if (shard_runtime_) {
+            // Queued behind the reservation from place_symbol
+            OrderbookManager* books = &books_for(symbol);
+            shard_runtime_->send(shard_runtime_->find(symbol), [books, symbol = symbol, book = std::move(book)]() mutable {
+                books->restoreBook(symbol, std::move(book));
+            });
+        } else {
+            orderbook_manager_->restoreBook(symbol, std::move(book));
+        }
+        ++restored;
+    }
+    if (restored > 0) {
+        spdlog::info("Restored {} stale order books from {}", restored, checkpoint_path_);
+    }
+    return restored;
+}
+
+void BinanceClient::start_clock_sync() {
+    // The response handler takes every body, so the processor is never fed
+    MessageProcessor& processor = shard_runtime_ ? *shard_slices_.front().processor : *message_processor_;
+    time_sync_handler_ = std::make_shared<RestApiHandler>(io_context_, ssl_ctx_, endpoints_.rest_host, endpoints_.rest_port,
+                                                          "/api/v3/time", processor);
+    time_sync_handler_->set_polling_interval(5000);
+    time_sync_handler_->set_response_handler(
+        [this](std::string&& body, std::chrono::system_clock::time_point sent, std::chrono::system_clock::time_point received) {
+            int64_t server_time_ms = extract_json_integer(body, "serverTime");
+            if (server_time_ms <= 0) {
+                spdlog::warn("Unexpected time endpoint response: {}", body);
+                return;
+            }
+            auto to_us = [](std::chrono::system_clock::time_point tp) {
+                return std::chrono::duration_cast<std::chrono::microseconds>(tp.time_since_epoch()).count();
+            };
+            clock_sync_.add_sample(to_us(sent), server_time_ms, to_us(received));
+        });
+    time_sync_handler_->start_polling();
 }
 
 void BinanceClient::update_trading_strategy() {
@@ -273,60 +686,195 @@ void BinanceClient::process_market_data() {
 }
 
 void BinanceClient::check_load_balancing() {
-    if (need_load_balancing()) {
-        perform_load_balancing();
-    }
+    // rebalance() samples on its own interval and only migrates past the imbalance threshold
+    perform_load_balancing();
 }
 
 size_t BinanceClient::get_shard(const std::string& symbol) const {
     std::hash<std::string> hasher;
-    return hasher(symbol) % event_loop_pool_->size();
+    return hasher(symbol) % (shard_runtime_ ? shard_runtime_->size() : event_loop_pool_->size());
 }
 
 void BinanceClient::balance_symbols(const std::vector<std::string>& symbols) {
-    size_t num_groups = event_loop_pool_->size();
+    size_t num_groups = shard_runtime_ ? shard_runtime_->size() : event_loop_pool_->size();
     symbol_groups_.resize(num_groups);
 
     for (const auto& symbol : symbols) {
-        size_t group = get_shard(symbol);
+        size_t group = place_symbol(symbol);
         symbol_groups_[group].push_back(symbol);
     }
 }
 
-void BinanceClient::create_handlers_for_symbol(const std::string& symbol) {
-    EventLoop& event_loop = event_loop_pool_->get_next_event_loop();
+size_t BinanceClient::place_symbol(const std::string& symbol) {
+    size_t levels = startup_orchestrator_.config().snapshot_limit;
+    if (shard_runtime_) {
+        size_t shard = shard_runtime_->assign(symbol);
+        OrderbookManager* books = shard_slices_[shard].books.get();
+        shard_runtime_->send(shard, [books, symbol, levels]() { books->reserveBook(symbol, levels); });
+        return shard;
+    }
+    size_t loop = symbol_router_->assign(symbol);
+    // Runs ahead of the symbol's first message on the loop that will own the book
+    symbol_router_->route(symbol, [this, symbol, levels]() {
+        orderbook_manager_->reserveBook(symbol, levels);
+    });
+    return loop;
+}
 
-    boost::asio::ssl::context ctx(boost::asio::ssl::context::tlsv12_client);
-    ctx.set_default_verify_paths();
+OrderbookManager& BinanceClient::books_for(const std::string& symbol) const {
+    int shard = shard_runtime_ ? shard_runtime_->find(symbol) : -1;
+    return shard < 0 ? *orderbook_manager_ : *shard_slices_[shard].books;
+}
 
-    auto ws_handler = std::shared_ptr<WebSocketHandler>(
-        ws_handler_pool_.allocate(),
-        [this](WebSocketHandler* p) { 
-            p->~WebSocketHandler();
-            ws_handler_pool_.deallocate(p); 
+MessageProcessor& BinanceClient::processor_for(const std::string& symbol) const {
+    int shard = shard_runtime_ ? shard_runtime_->find(symbol) : -1;
+    return shard < 0 ? *message_processor_ : *shard_slices_[shard].processor;
+}
+
+EventLoop& BinanceClient::loop_for(const std::string& symbol) {
+    int shard = shard_runtime_ ? shard_runtime_->find(symbol) : -1;
+    return shard < 0 ? event_loop_pool_->get_next_event_loop() : shard_runtime_->loop(shard);
+}
+
+void BinanceClient::create_handlers_for_symbol(const std::string& symbol) {
+    std::string stream = stream_symbol(symbol);
+    place_symbol(stream);
+    startup_orchestrator_.add_symbol(stream);
+    create_snapshot_handler(stream);
+    create_stream_connection({stream}, {std::chrono::milliseconds(0)});
+}
+
+void BinanceClient::create_stream_connection(const std::vector<std::string>& symbols,
+                                             const std::vector<std::chrono::milliseconds>& snapshot_offsets) {
+    // In shard mode every symbol of a connection is on the same shard
+    EventLoop& event_loop = loop_for(symbols.front());
+
+    // Handler and control block share one slab block; larger handlers fall back to operator new
+    auto ws_handler = std::allocate_shared<WebSocketHandler>(
+        SlabStlAllocator<WebSocketHandler>(), event_loop.get_io_context(), symbols, processor_for(symbols.front()));
+    ws_handler->set_clock_sync(&clock_sync_);
+    ws_handler->set_socket_profile(socket_profile_);
+    ws_handler->set_capture(capture_.get());
+    ws_handler->set_stream_base(endpoints_.stream_base);
+    ws_handler->set_trade_stream(trade_stream_);
+#ifdef __linux__
+    for (auto& [loop, transport] : io_uring_transports_) {
+        if (loop == &event_loop) {
+            ws_handler->set_io_uring(transport.get());
         }
-    );
-    new (ws_handler.get()) WebSocketHandler(event_loop.get_io_context(), symbol, *message_processor_);
-
-    auto rest_handler = std::shared_ptr<RestApiHandler>(
-        rest_handler_pool_.allocate(),
-        [this](RestApiHandler* p) { 
-            p->~RestApiHandler();
-            rest_handler_pool_.deallocate(p); 
+    }
+#endif
+
+    // Diffs are buffered from the moment the stream opens; a snapshot taken after that
+    // point always overlaps them. Offsets count from start(), so a late open or a
+    // reconnect fetches immediately.
+    // A book restored from a checkpoint first gets a grace period in which the stream
+    // may continue its update ID; the fetch is dropped if that resumed it.
+    ws_handler->set_connected_callback([this, symbols, snapshot_offsets]() {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time_);
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            auto delay = std::max(snapshot_offsets[i] - elapsed, std::chrono::milliseconds(0));
+            if (books_for(symbols[i]).isStale(symbols[i])) {
+                delay += startup_orchestrator_.config().resume_grace;
+            }
+            tbb::concurrent_hash_map<std::string, std::shared_ptr<RestApiHandler>>::const_accessor acc;
+            if (rest_handlers_.find(acc, symbols[i])) {
+                acc->second->fetch_snapshot(delay);
+            }
+        }
+    });
+
+    for (const auto& symbol : symbols) {
+        ws_handlers_.insert(std::make_pair(symbol, ws_handler));
+    }
+    ws_handler->connect();
+}
+
+void BinanceClient::create_snapshot_handler(const std::string& symbol) {
+    EventLoop& event_loop = loop_for(symbol);
+
+    std::string rest_symbol = symbol;
+    std::transform(rest_symbol.begin(), rest_symbol.end(), rest_symbol.begin(), ::toupper);
+    std::string target = "/api/v3/depth?symbol=" + rest_symbol +
+                         "&limit=" + std::to_string(startup_orchestrator_.config().snapshot_limit);
+    auto rest_handler = std::allocate_shared<RestApiHandler>(
+        SlabStlAllocator<RestApiHandler>(), event_loop.get_io_context(), ssl_ctx_, endpoints_.rest_host, endpoints_.rest_port, target,
+        processor_for(symbol));
+    rest_handler->set_symbol(symbol);
+    rest_handler->set_capture(capture_.get());
+    OrderbookManager* books = &books_for(symbol);
+    StartupOrchestrator* orchestrator = &startup_orchestrator_;
+    rest_handler->set_fetch_condition([books, orchestrator, symbol]() {
+        if (books->isSynced(symbol)) {
+            return false;
         }
-    );
-    new (rest_handler.get()) RestApiHandler(event_loop.get_io_context(), ctx, "api.binance.com", "443", "/api/v3/depth?symbol=" + symbol, *message_processor_);
+        orchestrator->on_snapshot_request();
+        return true;
+    });
+    rest_handler->set_failure_handler([this, symbol]() { on_snapshot_failed(symbol); });
 
-    ws_handlers_.insert(std::make_pair(symbol, ws_handler));
     rest_handlers_.insert(std::make_pair(symbol, rest_handler));
+}
 
-    ws_handler->connect();
-    rest_handler->start_polling();
+void BinanceClient::on_book_sync_changed(const std::string& symbol, bool synced) {
+    if (synced) {
+        startup_orchestrator_.on_book_consistent(symbol);
+        return;
+    }
+    // Sequence gap: the book waits for a fresh snapshot while diffs keep buffering. The
+    // fetch waits for the symbol's backoff and a slot in the resync weight budget.
+    tbb::concurrent_hash_map<std::string, std::shared_ptr<RestApiHandler>>::const_accessor acc;
+    if (running_ && rest_handlers_.find(acc, symbol)) {
+        acc->second->fetch_snapshot(startup_orchestrator_.schedule_resync(symbol));
+    }
+}
+
+void BinanceClient::on_snapshot_failed(const std::string& symbol) {
+    // Until its stream opens, a symbol waits for the fetch the open schedules
+    {
+        tbb::concurrent_hash_map<std::string, std::shared_ptr<WebSocketHandler>>::const_accessor ws;
+        if (!running_ || !ws_handlers_.find(ws, symbol) || !ws->second->is_connected()) {
+            return;
+        }
+    }
+    tbb::concurrent_hash_map<std::string, std::shared_ptr<RestApiHandler>>::const_accessor acc;
+    if (rest_handlers_.find(acc, symbol)) {
+        acc->second->fetch_snapshot(startup_orchestrator_.schedule_resync(symbol));
+    }
+}
+
+std::string BinanceClient::stream_symbol(const std::string& symbol) {
+    std::string result = symbol;
+    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+    return result;
 }
 
 void BinanceClient::remove_handlers_for_symbol(const std::string& symbol) {
-    ws_handlers_.erase(symbol);
-    rest_handlers_.erase(symbol);
+    std::string stream = stream_symbol(symbol);
+    {
+        tbb::concurrent_hash_map<std::string, std::shared_ptr<WebSocketHandler>>::accessor acc;
+        if (ws_handlers_.find(acc, stream)) {
+            // A combined connection keeps serving its other symbols
+            if (acc->second->get_symbols().size() > 1) {
+                acc->second->unsubscribe(stream);
+            } else {
+                acc->second->stop();
+            }
+        }
+    }
+    {
+        tbb::concurrent_hash_map<std::string, std::shared_ptr<RestApiHandler>>::accessor acc;
+        if (rest_handlers_.find(acc, stream)) {
+            acc->second->stop();
+        }
+    }
+    ws_handlers_.erase(stream);
+    rest_handlers_.erase(stream);
+    if (shard_runtime_) {
+        shard_runtime_->remove(stream);
+    } else {
+        symbol_router_->remove(stream);
+    }
 }
 
 void BinanceClient::log_error(const std::string& error_message) {
@@ -334,16 +882,31 @@ void BinanceClient::log_error(const std::string& error_message) {
 }
 
 void BinanceClient::set_cpu_affinity(int cpu_id) {
-#ifdef __linux__
-    if (cpu_id >= 0) {
-        cpu_set_t cpuset;
-        CPU_ZERO(&cpuset);
-        CPU_SET(cpu_id, &cpuset);
-        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+    if (cpu_id >= 0 && !pin_current_thread({cpu_id})) {
+        spdlog::warn("Failed to set CPU affinity (cpu_id: {})", cpu_id);
+    }
+}
+
+void BinanceClient::set_topology(const TopologyConfig& config) {
+    if (running_) {
+        spdlog::warn("Topology changes take effect only before start()");
+        return;
+    }
+    topology_ = config;
+    if (topology_.enabled) {
+        if (shard_runtime_) {
+            shard_runtime_->set_affinity(topology_.event_loop_cpus, topology_.local_memory);
+        } else {
+            event_loop_pool_->set_affinity(topology_.event_loop_cpus, topology_.local_memory);
+            market_data_loop_->set_affinity(topology_.market_data_cpu, topology_.local_memory);
+        }
+    }
+}
+
+void BinanceClient::pin_housekeeping_thread() const {
+    if (topology_.enabled && !topology_.housekeeping_cpus.empty()) {
+        pin_current_thread(topology_.housekeeping_cpus);
     }
-#else
-    spdlog::warn("CPU affinity setting is not supported on this platform (cpu_id: {})", cpu_id);
-#endif
 }
 
 // SymbolManager implementation
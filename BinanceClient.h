@@ -5,6 +5,17 @@
 #include "RestApiHandler.h"
 #include "MessageProcessor.h"
 #include "OrderbookManager.h"
+#include "LatencyMonitor.h"
+#include "StartupOrchestrator.h"
+#include "BookCheckpoint.h"
+#include "SymbolRouter.h"
+#include "CpuTopology.h"
+#include "ThreadPool.h"
+#include "ShardRuntime.h"
+#include "ExchangeEndpoints.h"
+#include "SharedBookPublisher.h"
+#include "FanoutServer.h"
+#include "TradeStatistics.h"
 #include <unordered_map>
 #include <unordered_set>
 #include <memory>
@@ -20,12 +31,7 @@
 #include <tbb/concurrent_hash_map.h>
 #include <tbb/concurrent_vector.h>
 #include <chrono>
-#include "MemoryPool.h"
-
-struct TradingStats {
-    double volume;
-    double price_change;
-};
+#include "SlabAllocator.h"
 
 struct ResourceUsage {
     double cpu_usage;
@@ -50,21 +56,34 @@ private:
 
 class BinanceClient {
 public:
-    BinanceClient(size_t thread_count = std::thread::hardware_concurrency());
+    // thread_count is the number of event loops, or of shards in ShardPerCore mode
+    BinanceClient(size_t thread_count = std::thread::hardware_concurrency(),
+                  const StartupConfig& startup_config = StartupConfig(),
+                  RuntimeMode runtime_mode = RuntimeMode::SharedQueue);
     ~BinanceClient();
 
     void start(const std::vector<std::string>& symbols);
     void stop();
     std::string get_orderbook_snapshot(const std::string& symbol, int depth) const;
+    // Binary counterpart for consumers that would otherwise parse the JSON again, see
+    // OrderbookManager::encodeSnapshot
+    bool encode_orderbook_snapshot(const std::string& symbol, int depth, uint32_t symbol_id, std::string& out) const;
+    // Every requested book in one pass into a batch the caller reuses, see
+    // OrderbookManager::getSnapshots. Symbols in either case, as for get_orderbook_snapshot.
+    void get_orderbook_snapshots(const std::vector<std::string>& symbols, int depth, BookBatch& out) const;
 
     void add_symbol(const std::string& symbol);
     void remove_symbol(const std::string& symbol);
     std::vector<std::string> get_active_symbols() const;
 
     void monitor_system_health();
-    void reconnect_failed_connections();
+    // Rolling 1s, 1m and 24h volume, VWAP, price change and trade count from the trade
+    // stream, as of now; all zero without trades or with the trade stream off
     TradingStats get_trading_stats(const std::string& symbol) const;
     void clean_old_data();
+    // Runs clean_old_data, generate_report and, with a checkpoint path, checkpoint_books
+    // on the analytics pool, away from the feed threads
+    void run_housekeeping();
     void update_configuration();
     ResourceUsage get_resource_usage() const;
     bool need_load_balancing() const;
@@ -72,7 +91,50 @@ public:
     bool has_new_market_data() const;
     void process_new_market_data();
     void generate_report() const;
+    // Median across connections of their median exchange-to-local latency, in ms; -1 if unknown
     int check_network_latency() const;
+    // Of the connection carrying symbol, in either case
+    ConnectionLatency get_connection_latency(const std::string& symbol) const;
+    const ClockSync& get_clock_sync() const { return clock_sync_; }
+    // Time to first consistent book per symbol since start() (or add_symbol)
+    StartupReport get_startup_report() const { return startup_orchestrator_.report(); }
+    // Per-loop and per-symbol load behind placement decisions; nullptr in ShardPerCore
+    // mode, where placement is fixed
+    const SymbolRouter* get_symbol_router() const { return symbol_router_.get(); }
+    RuntimeMode get_runtime_mode() const { return runtime_mode_; }
+
+    // stop() writes every book to this file and start() restores them as stale; empty disables
+    void set_checkpoint_path(const std::string& path);
+    void checkpoint_books() const;
+
+    // Applies to connections created after the call
+    void set_socket_profile(const LowLatencySocketProfile& profile);
+    // Call before start(): records every raw WebSocket and REST payload into rolling
+    // segment files in config.directory, and with config.book_tops every change of a
+    // book's best bid or ask. Throws std::runtime_error if it cannot.
+    void set_capture(const CaptureConfig& config);
+    const CaptureJournal* get_capture() const { return capture_.get(); }
+    // Call before start(): publishes every book's top levels into the named POSIX
+    // shared-memory region for SharedBookReader in other processes. Throws
+    // std::runtime_error if the region cannot be created.
+    void set_shared_books(const std::string& name, uint32_t capacity = 1024);
+    const SharedBookPublisher* get_shared_books() const { return shared_books_.get(); }
+    // Call before start(): serves snapshots and deltas of every book to local consumers
+    // over WebSocket. Throws if the port cannot be bound.
+    void set_fanout(const FanoutConfig& config);
+    const FanoutServer* get_fanout() const { return fanout_.get(); }
+    // Call before start(): the stream and REST endpoints every connection uses
+    void set_endpoints(const ExchangeEndpoints& endpoints);
+    const ExchangeEndpoints& get_endpoints() const { return endpoints_; }
+    // Call before start(): reads the streams through io_uring instead of websocketpp, one
+    // ring per connection loop. Needs a ws:// stream base such as a local_exchange, which
+    // start() checks. Throws std::runtime_error where io_uring is unavailable.
+    void set_stream_transport(StreamTransport transport);
+    StreamTransport get_stream_transport() const { return stream_transport_; }
+    // Call before start(): "aggTrade" (the default) or "trade" is subscribed alongside
+    // every symbol's depth for get_trading_stats, "" subscribes depth only. Throws
+    // std::invalid_argument for other streams.
+    void set_trade_stream(const std::string& trade_stream);
     void update_trading_strategy();
     void perform_risk_management_check();
     void update_market_depth();
@@ -82,12 +144,55 @@ public:
     void check_load_balancing();
 
     void set_cpu_affinity(int cpu_id);
+    // Call before start(): pins the event loops, the market data loop and the REST
+    // workers, and has each symbol's book allocated on its loop's NUMA node
+    void set_topology(const TopologyConfig& config);
+    const CpuTopology& get_cpu_topology() const { return cpu_topology_; }
+    std::vector<ThreadPlacement> get_thread_layout() const { return describe_layout(topology_, cpu_topology_); }
+    // Keeps a helper thread off the hot cores; no-op without a topology
+    void pin_housekeeping_thread() const;
 
 private:
+#ifdef __linux__
+    // StreamTransport::IoUring: the ring of each connection loop. Declared first so they
+    // outlive the loops and whatever the loops' io_contexts still hold at destruction.
+    // Linux only, where BinanceClient.cpp sees the complete type.
+    std::vector<std::pair<EventLoop*, std::unique_ptr<IoUringTransport>>> io_uring_transports_;
+#endif
+    StreamTransport stream_transport_ = StreamTransport::Websocketpp;
+    // Shared mode only: connection loops, the router, the market data loop and its
+    // processor. ShardPerCore builds just shard_runtime_ and shard_slices_.
     std::unique_ptr<EventLoopPool> event_loop_pool_;
+    // Symbol -> loop placement for message processing, rebalanced from measured load
+    std::unique_ptr<SymbolRouter> symbol_router_;
     std::unique_ptr<EventLoop> market_data_loop_;
+    // Shared mode's books; in ShardPerCore mode it stays empty and answers for symbols
+    // no shard holds
     std::unique_ptr<OrderbookManager> orderbook_manager_;
     std::unique_ptr<MessageProcessor> message_processor_;
+    // Before the handlers, so it outlives them
+    std::unique_ptr<CaptureJournal> capture_;
+    std::unique_ptr<SharedBookPublisher> shared_books_;
+    std::unique_ptr<FanoutServer> fanout_;
+    bool capture_book_tops_ = false;
+    // Fed by every processor, including the shards'
+    std::unique_ptr<TradeStatistics> trade_statistics_;
+    std::string trade_stream_ = "aggTrade";
+    // ShardPerCore: each shard has its own books and an inline processor, used only from
+    // the shard's loop. Book changes reach a shard through its mailbox; queries from
+    // other threads read through OrderbookManager's own locking.
+    struct ShardSlice {
+        std::unique_ptr<OrderbookManager> books;
+        std::unique_ptr<MessageProcessor> processor;
+    };
+    // Hands every published book view to the fan-out server and the capture, if set
+    void install_view_listener();
+    void on_book_view(const std::string& symbol, const BookView& view);
+    void capture_book_top(const std::string& symbol, const BookView& view);
+
+    RuntimeMode runtime_mode_ = RuntimeMode::SharedQueue;
+    std::unique_ptr<ShardRuntime> shard_runtime_;
+    std::vector<ShardSlice> shard_slices_;
     tbb::concurrent_hash_map<std::string, std::shared_ptr<WebSocketHandler>> ws_handlers_;
     tbb::concurrent_hash_map<std::string, std::shared_ptr<RestApiHandler>> rest_handlers_;
     std::vector<std::vector<std::string>> symbol_groups_;
@@ -100,6 +205,21 @@ private:
     void balance_symbols(const std::vector<std::string>& symbols);
     void create_handlers_for_symbol(const std::string& symbol);
     void remove_handlers_for_symbol(const std::string& symbol);
+    void create_stream_connection(const std::vector<std::string>& symbols,
+                                  const std::vector<std::chrono::milliseconds>& snapshot_offsets);
+    void create_snapshot_handler(const std::string& symbol);
+    void on_book_sync_changed(const std::string& symbol, bool synced);
+    // Retries a failed snapshot fetch inside the resync budget once the symbol's stream is open
+    void on_snapshot_failed(const std::string& symbol);
+    // Assigns the symbol a loop (or shard) and reserves its book from that loop's thread
+    size_t place_symbol(const std::string& symbol);
+    // The books, processor and loop a symbol's data goes through in the current mode
+    OrderbookManager& books_for(const std::string& symbol) const;
+    MessageProcessor& processor_for(const std::string& symbol) const;
+    EventLoop& loop_for(const std::string& symbol);
+    // Creates and attaches a ring per connection loop; before the loops run
+    void setup_io_uring();
+    static std::string stream_symbol(const std::string& symbol);
 
     void log_error(const std::string& error_message);
 
@@ -108,8 +228,24 @@ private:
     boost::asio::io_context io_context_;
     std::vector<std::thread> worker_threads_;
     std::unique_ptr<boost::asio::io_context::work> work_;
-    MemoryPool<WebSocketHandler> ws_handler_pool_;
-    MemoryPool<RestApiHandler> rest_handler_pool_;
+    boost::asio::ssl::context ssl_ctx_{boost::asio::ssl::context::tlsv12_client};
+
+    ClockSync clock_sync_;
+    LowLatencySocketProfile socket_profile_;
+    ExchangeEndpoints endpoints_;
+    std::shared_ptr<RestApiHandler> time_sync_handler_;
+    void start_clock_sync();
+
+    StartupOrchestrator startup_orchestrator_;
+    std::chrono::steady_clock::time_point start_time_;
+    std::string checkpoint_path_;
+    size_t restore_books(const std::vector<std::string>& symbols);
+
+    CpuTopology cpu_topology_ = CpuTopology::detect();
+    TopologyConfig topology_;
+
+    static constexpr size_t ANALYTICS_THREADS = 2;
+    WorkStealingThreadPool analytics_pool_{ANALYTICS_THREADS};
 
     class SymbolManager {
     public:
@@ -0,0 +1,154 @@
+#include "BookCheckpoint.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+
+namespace bip = boost::interprocess;
+
+namespace {
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t book_count;
+    uint64_t total_size;
+};
+
+struct BookHeader {
+    uint32_t symbol_len;
+    uint32_t bid_count;
+    uint32_t ask_count;
+    uint32_t reserved;
+    uint64_t last_update_id;
+};
+
+static_assert(sizeof(PriceLevel) == 2 * sizeof(double), "PriceLevel is written as two doubles");
+
+size_t padded(size_t n) {
+    return (n + 7) & ~size_t(7);
+}
+
+size_t book_size(const std::string& symbol, const Orderbook& book) {
+    return sizeof(BookHeader) + padded(symbol.size()) + (book.bids.size() + book.asks.size()) * sizeof(PriceLevel);
+}
+
+}  // namespace
+
+size_t BookCheckpoint::encoded_size(const Books& books) {
+    size_t size = sizeof(Header);
+    for (const auto& [symbol, book] : books) {
+        size += book_size(symbol, book);
+    }
+    return size;
+}
+
+void BookCheckpoint::save(const std::string& path, const Books& books) {
+    const size_t size = encoded_size(books);
+    const std::string tmp_path = path + ".tmp";
+
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Cannot create checkpoint file " + tmp_path);
+        }
+    }
+    std::filesystem::resize_file(tmp_path, size);
+
+    {
+        bip::file_mapping mapping(tmp_path.c_str(), bip::read_write);
+        bip::mapped_region region(mapping, bip::read_write, 0, size);
+        char* out = static_cast<char*>(region.get_address());
+
+        Header header{MAGIC, VERSION, books.size(), size};
+        std::memcpy(out, &header, sizeof(header));
+        size_t offset = sizeof(header);
+
+        for (const auto& [symbol, book] : books) {
+            BookHeader book_header{static_cast<uint32_t>(symbol.size()),
+                                   static_cast<uint32_t>(book.bids.size()),
+                                   static_cast<uint32_t>(book.asks.size()), 0, book.last_update_id};
+            std::memcpy(out + offset, &book_header, sizeof(book_header));
+            offset += sizeof(book_header);
+
+            std::memcpy(out + offset, symbol.data(), symbol.size());
+            std::memset(out + offset + symbol.size(), 0, padded(symbol.size()) - symbol.size());
+            offset += padded(symbol.size());
+
+            std::memcpy(out + offset, book.bids.data(), book.bids.size() * sizeof(PriceLevel));
+            offset += book.bids.size() * sizeof(PriceLevel);
+            std::memcpy(out + offset, book.asks.data(), book.asks.size() * sizeof(PriceLevel));
+            offset += book.asks.size() * sizeof(PriceLevel);
+        }
+
+        if (!region.flush()) {
+            throw std::runtime_error("Failed to flush checkpoint file " + tmp_path);
+        }
+    }
+
+    std::filesystem::rename(tmp_path, path);
+}
+
+BookCheckpoint::Books BookCheckpoint::load(const std::string& path) {
+    Books books;
+    std::error_code ec;
+    const auto file_size = std::filesystem::file_size(path, ec);
+    if (ec || file_size < sizeof(Header)) {
+        return books;
+    }
+
+    try {
+        bip::file_mapping mapping(path.c_str(), bip::read_only);
+        bip::mapped_region region(mapping, bip::read_only);
+        const char* in = static_cast<const char*>(region.get_address());
+        const size_t size = region.get_size();
+
+        Header header;
+        std::memcpy(&header, in, sizeof(header));
+        if (header.magic != MAGIC || header.version != VERSION || header.total_size != size) {
+            spdlog::warn("Ignoring invalid order book checkpoint {}", path);
+            return books;
+        }
+
+        size_t offset = sizeof(header);
+        books.reserve(header.book_count);
+        for (uint64_t i = 0; i < header.book_count; ++i) {
+            BookHeader book_header;
+            if (size - offset < sizeof(book_header)) {
+                break;
+            }
+            std::memcpy(&book_header, in + offset, sizeof(book_header));
+            offset += sizeof(book_header);
+
+            const size_t levels = static_cast<size_t>(book_header.bid_count) + book_header.ask_count;
+            if (size - offset < padded(book_header.symbol_len) + levels * sizeof(PriceLevel)) {
+                break;
+            }
+
+            std::string symbol(in + offset, book_header.symbol_len);
+            offset += padded(book_header.symbol_len);
+
+            Orderbook book;
+            book.last_update_id = book_header.last_update_id;
+            book.bids.resize(book_header.bid_count);
+            book.asks.resize(book_header.ask_count);
+            std::memcpy(book.bids.data(), in + offset, book.bids.size() * sizeof(PriceLevel));
+            offset += book.bids.size() * sizeof(PriceLevel);
+            std::memcpy(book.asks.data(), in + offset, book.asks.size() * sizeof(PriceLevel));
+            offset += book.asks.size() * sizeof(PriceLevel);
+
+            books.emplace_back(std::move(symbol), std::move(book));
+        }
+        if (books.size() != header.book_count) {
+            spdlog::warn("Order book checkpoint {} is truncated, restored {} of {} books",
+                         path, books.size(), header.book_count);
+        }
+    } catch (const bip::interprocess_exception& e) {
+        spdlog::warn("Cannot map order book checkpoint {}: {}", path, e.what());
+        books.clear();
+    }
+    return books;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "OrderbookManager.h"
+
+// Compact on-disk image of every order book, written through a memory mapping on
+// shutdown and mapped back on start so books are readable before the network is up.
+//
+// Layout (native endianness, 8-byte aligned):
+//   Header   { magic, version, book_count, total_size }
+//   per book { symbol_len, bid_count, ask_count, last_update_id,
+//              symbol (padded to 8), bids[] {price, qty}, asks[] {price, qty} }
+class BookCheckpoint {
+public:
+    using Books = std::vector<std::pair<std::string, Orderbook>>;
+
+    static constexpr uint32_t MAGIC = 0x4B434F42;  // "BOCK"
+    static constexpr uint32_t VERSION = 1;
+
+    // Writes to path + ".tmp" and renames, so a crash never leaves a torn checkpoint.
+    // Throws std::runtime_error on I/O failure.
+    static void save(const std::string& path, const Books& books);
+    // Returns no books if the file is missing or not a valid checkpoint
+    static Books load(const std::string& path);
+
+    static size_t encoded_size(const Books& books);
+};
@@ -0,0 +1,541 @@
+#include "CaptureJournal.h"
+#include "EpochReclaimer.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <spdlog/spdlog.h>
+
+namespace bip = boost::interprocess;
+namespace fs = std::filesystem;
+
+namespace {
+
+struct SegmentHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t segment;
+    uint64_t capacity;
+    uint64_t data_size;     // 0 until sealed
+    uint64_t record_count;  // 0 until sealed
+    int64_t created_ns;
+    uint64_t reserved[2];
+};
+static_assert(sizeof(SegmentHeader) == 64);
+
+struct RecordHeader {
+    uint32_t length;  // payload bytes, stored last
+    uint8_t source;
+    uint8_t reserved[3];
+    uint32_t connection_id;
+    uint32_t symbol_id;
+    int64_t receive_ns;
+};
+static_assert(sizeof(RecordHeader) == 24);
+
+struct IndexHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t segment;
+    uint64_t record_count;
+    uint64_t data_size;
+    int64_t first_ns;
+    int64_t last_ns;
+    uint32_t symbol_count;
+    uint32_t entry_count;
+};
+
+struct IndexEntry {
+    int64_t receive_ns;
+    uint64_t offset;
+};
+
+constexpr size_t PAGE_SIZE = 4096;
+constexpr int ROLL_SPINS = 1024;  // loads of current_ while another writer switches segments
+
+size_t padded(size_t n) {
+    return (n + 7) & ~size_t(7);
+}
+
+// Segment numbers in a directory, ascending
+std::vector<uint64_t> list_segments(const std::string& directory) {
+    std::vector<uint64_t> segments;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        const std::string name = entry.path().filename().string();
+        constexpr std::string_view prefix = "capture-";
+        constexpr std::string_view suffix = ".seg";
+        if (name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        const std::string digits = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+        if (std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            segments.push_back(std::stoull(digits));
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+}  // namespace
+
+struct CaptureJournal::Segment {
+    uint64_t index = 0;
+    std::string path;
+    bip::mapped_region region;
+    char* base = nullptr;
+    size_t capacity = 0;
+    size_t flushed = sizeof(SegmentHeader);  // flusher only
+    alignas(64) std::atomic<size_t> reserved{sizeof(SegmentHeader)};
+    alignas(64) std::atomic<size_t> committed{sizeof(SegmentHeader)};
+    std::atomic<size_t> sealed_at{SIZE_MAX};  // end of the data, set by the writer that closed it
+};
+
+CaptureJournal::CaptureJournal(const CaptureConfig& config) : config_(config) {
+    if (config_.segment_size < sizeof(SegmentHeader) + PAGE_SIZE) {
+        throw std::invalid_argument("Capture segment_size is too small");
+    }
+    config_.segment_size = (config_.segment_size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    fs::create_directories(config_.directory);
+    for (uint64_t segment : list_segments(config_.directory)) {
+        sealed_segments_.push_back(segment);
+        next_segment_ = segment + 1;
+    }
+    symbol_names_.emplace_back();
+
+    active_ = open_segment();
+    current_.store(active_.get(), std::memory_order_release);
+    spare_owned_ = open_segment();
+    spare_.store(spare_owned_.get(), std::memory_order_release);
+    flusher_ = std::thread([this]() { run(); });
+}
+
+CaptureJournal::~CaptureJournal() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    flusher_.join();
+    try {
+        close_live_segment();
+    } catch (const std::exception& e) {
+        spdlog::error("Capture journal close failed: {}", e.what());
+    }
+}
+
+uint32_t CaptureJournal::register_connection() {
+    return next_connection_.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t CaptureJournal::symbol_id(const std::string& symbol) {
+    if (symbol.empty()) {
+        return 0;
+    }
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> lock(symbols_mutex_);
+        auto it = symbol_ids_.find(symbol);
+        if (it != symbol_ids_.end()) {
+            return it->second;
+        }
+        id = static_cast<uint32_t>(symbol_names_.size());
+        symbol_names_.push_back(symbol);
+        symbol_ids_.emplace(symbol, id);
+    }
+    // In the stream too, so a segment left unsealed by a crash still names its symbols
+    append(CaptureSource::Symbol, 0, id, now_ns(), symbol);
+    return id;
+}
+
+bool CaptureJournal::append(CaptureSource source, uint32_t connection_id, uint32_t symbol_id, int64_t receive_ns,
+                            std::string_view payload) {
+    const size_t size = padded(sizeof(RecordHeader) + payload.size());
+    // A closed segment's control block may still be reached through a pointer loaded
+    // before the switch; the flusher retires it instead of deleting it
+    EpochReclaimer::Guard guard;
+    Segment* segment = current_.load(std::memory_order_acquire);
+    if (size > config_.segment_size - sizeof(SegmentHeader)) {
+        segment = nullptr;
+    }
+    while (segment) {
+        const size_t offset = segment->reserved.fetch_add(size, std::memory_order_relaxed);
+        if (offset + size <= segment->capacity) {
+            char* out = segment->base + offset;
+            RecordHeader header{0, static_cast<uint8_t>(source), {}, connection_id, symbol_id, receive_ns};
+            std::memcpy(out, &header, sizeof(header));
+            std::memcpy(out + sizeof(header), payload.data(), payload.size());
+            std::atomic_ref<uint32_t>(reinterpret_cast<RecordHeader*>(out)->length)
+                .store(static_cast<uint32_t>(payload.size()), std::memory_order_release);
+            segment->committed.fetch_add(size, std::memory_order_release);
+            records_.fetch_add(1, std::memory_order_relaxed);
+            bytes_.fetch_add(payload.size(), std::memory_order_relaxed);
+            return true;
+        }
+        if (offset <= segment->capacity) {
+            // First reservation past the end: this writer closes the segment and puts the
+            // spare live. Without a spare the journal drops records until the flusher
+            // opens a segment.
+            segment->sealed_at.store(offset, std::memory_order_release);
+            Segment* next = spare_.exchange(nullptr, std::memory_order_acq_rel);
+            current_.store(next, std::memory_order_release);
+            wake_.notify_one();
+            segment = next;
+            continue;
+        }
+        // Another writer is switching segments
+        Segment* next = current_.load(std::memory_order_acquire);
+        for (int spin = 0; next == segment && spin < ROLL_SPINS; ++spin) {
+            next = current_.load(std::memory_order_acquire);
+        }
+        segment = next == segment ? nullptr : next;
+    }
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+CaptureStats CaptureJournal::stats() const {
+    CaptureStats stats;
+    stats.records = records_.load(std::memory_order_relaxed);
+    stats.bytes = bytes_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.segments_sealed = segments_sealed_.load(std::memory_order_relaxed);
+    stats.segments_deleted = segments_deleted_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::string CaptureJournal::segment_path(const std::string& directory, uint64_t segment) {
+    char name[40];
+    std::snprintf(name, sizeof(name), "capture-%08llu.seg", static_cast<unsigned long long>(segment));
+    return (fs::path(directory) / name).string();
+}
+
+std::string CaptureJournal::index_path(const std::string& directory, uint64_t segment) {
+    std::string path = segment_path(directory, segment);
+    path.replace(path.size() - 3, 3, "idx");
+    return path;
+}
+
+int64_t CaptureJournal::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void CaptureJournal::run() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    while (!stopping_) {
+        wake_.wait_for(lock, config_.flush_interval);
+        if (stopping_) {
+            break;
+        }
+        lock.unlock();
+        try {
+            service();
+        } catch (const std::exception& e) {
+            spdlog::error("Capture journal: {}", e.what());
+        }
+        lock.lock();
+    }
+}
+
+void CaptureJournal::service() {
+    Segment* live = current_.load(std::memory_order_acquire);
+    if (spare_owned_ && spare_.load(std::memory_order_acquire) == nullptr) {
+        if (live == active_.get()) {
+            return;  // a writer took the spare and has not installed it yet
+        }
+        // The spare went live
+        if (active_) {
+            sealing_.push_back(std::move(active_));
+        }
+        active_ = std::move(spare_owned_);
+    }
+    if (active_ && live != active_.get()) {
+        // Closed with no spare ready
+        sealing_.push_back(std::move(active_));
+    }
+
+    if (!active_) {
+        active_ = open_segment();
+        current_.store(active_.get(), std::memory_order_release);
+    }
+    if (!spare_owned_) {
+        spare_owned_ = open_segment();
+        spare_.store(spare_owned_.get(), std::memory_order_release);
+    }
+
+    // Records may complete out of order, so the committed byte count only approximates
+    // the written prefix; sealing syncs the whole segment anyway
+    const size_t committed = active_->committed.load(std::memory_order_acquire);
+    if (committed > active_->flushed) {
+        const size_t from = active_->flushed / PAGE_SIZE * PAGE_SIZE;
+        active_->region.flush(from, committed - from, true);
+        active_->flushed = committed;
+    }
+
+    for (auto it = sealing_.begin(); it != sealing_.end();) {
+        Segment& segment = **it;
+        if (segment.committed.load(std::memory_order_acquire) == segment.sealed_at.load(std::memory_order_acquire)) {
+            seal(segment);
+            EpochReclaimer::retire(it->release());
+            it = sealing_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    enforce_retention();
+}
+
+std::unique_ptr<CaptureJournal::Segment> CaptureJournal::open_segment() {
+    auto segment = std::make_unique<Segment>();
+    segment->index = next_segment_++;
+    segment->path = segment_path(config_.directory, segment->index);
+    segment->capacity = config_.segment_size;
+    try {
+        {
+            std::ofstream file(segment->path, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                throw std::runtime_error("cannot create file");
+            }
+        }
+        fs::resize_file(segment->path, segment->capacity);
+        bip::file_mapping mapping(segment->path.c_str(), bip::read_write);
+        segment->region = bip::mapped_region(mapping, bip::read_write, 0, segment->capacity);
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Cannot create capture segment " + segment->path + ": " + e.what());
+    }
+    segment->base = static_cast<char*>(segment->region.get_address());
+
+    SegmentHeader header{SEGMENT_MAGIC, VERSION, segment->index, segment->capacity, 0, 0, now_ns(), {}};
+    std::memcpy(segment->base, &header, sizeof(header));
+    if (config_.prefault) {
+        // Allocates the file's pages now rather than on the first write to each of them
+        for (size_t offset = PAGE_SIZE; offset < segment->capacity; offset += PAGE_SIZE) {
+            static_cast<volatile char*>(segment->base)[offset] = 0;
+        }
+    }
+    return segment;
+}
+
+void CaptureJournal::seal(Segment& segment) {
+    const size_t data_size = segment.sealed_at.load(std::memory_order_acquire);
+    const uint64_t record_count = write_index(segment, data_size);
+
+    auto* header = reinterpret_cast<SegmentHeader*>(segment.base);
+    header->data_size = data_size;
+    header->record_count = record_count;
+    segment.region.flush(0, data_size, false);
+
+    // Unmap before truncating away the unused tail
+    segment.region = bip::mapped_region();
+    segment.base = nullptr;
+    fs::resize_file(segment.path, data_size);
+
+    sealed_segments_.push_back(segment.index);
+    segments_sealed_.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t CaptureJournal::write_index(const Segment& segment, size_t data_size) {
+    std::vector<std::string> symbols;
+    {
+        std::lock_guard<std::mutex> lock(symbols_mutex_);
+        symbols = symbol_names_;
+    }
+
+    std::vector<IndexEntry> entries;
+    int64_t first_ns = 0;
+    int64_t last_ns = 0;
+    uint64_t record_count = 0;
+    for (size_t offset = sizeof(SegmentHeader); offset + sizeof(RecordHeader) <= data_size; ++record_count) {
+        RecordHeader header;
+        std::memcpy(&header, segment.base + offset, sizeof(header));
+        if (record_count % INDEX_STRIDE == 0) {
+            entries.push_back({header.receive_ns, offset});
+        }
+        first_ns = record_count == 0 ? header.receive_ns : first_ns;
+        last_ns = header.receive_ns;
+        offset += padded(sizeof(RecordHeader) + header.length);
+    }
+
+    const std::string path = index_path(config_.directory, segment.index);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Cannot create capture index " + path);
+    }
+    IndexHeader header{INDEX_MAGIC, VERSION, segment.index, record_count, data_size, first_ns, last_ns,
+                       static_cast<uint32_t>(symbols.size() - 1), static_cast<uint32_t>(entries.size())};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    static const char zeros[8] = {};
+    for (uint32_t id = 1; id < symbols.size(); ++id) {
+        const uint32_t fields[2] = {id, static_cast<uint32_t>(symbols[id].size())};
+        file.write(reinterpret_cast<const char*>(fields), sizeof(fields));
+        file.write(symbols[id].data(), static_cast<std::streamsize>(symbols[id].size()));
+        file.write(zeros, static_cast<std::streamsize>(padded(symbols[id].size()) - symbols[id].size()));
+    }
+    file.write(reinterpret_cast<const char*>(entries.data()),
+               static_cast<std::streamsize>(entries.size() * sizeof(IndexEntry)));
+    if (!file) {
+        throw std::runtime_error("Failed to write capture index " + path);
+    }
+    return record_count;
+}
+
+void CaptureJournal::enforce_retention() {
+    while (config_.max_segments > 0 && sealed_segments_.size() > config_.max_segments) {
+        const uint64_t segment = sealed_segments_.front();
+        sealed_segments_.pop_front();
+        std::error_code ec;
+        fs::remove(segment_path(config_.directory, segment), ec);
+        fs::remove(index_path(config_.directory, segment), ec);
+        segments_deleted_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void CaptureJournal::close_live_segment() {
+    // Writers must be done: whatever is live now is closed where it stands
+    Segment* spare = spare_.exchange(nullptr, std::memory_order_acq_rel);
+    Segment* live = current_.exchange(nullptr, std::memory_order_acq_rel);
+    if (spare_owned_ && spare == nullptr) {
+        if (active_) {
+            sealing_.push_back(std::move(active_));
+        }
+        active_ = std::move(spare_owned_);
+    }
+    if (active_ && live != active_.get()) {
+        sealing_.push_back(std::move(active_));
+    }
+    if (active_) {
+        const size_t offset = active_->reserved.fetch_add(active_->capacity + 1, std::memory_order_acq_rel);
+        if (offset <= active_->capacity) {
+            active_->sealed_at.store(offset, std::memory_order_release);
+        }
+        sealing_.push_back(std::move(active_));
+    }
+    for (auto& segment : sealing_) {
+        while (segment->committed.load(std::memory_order_acquire) != segment->sealed_at.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        seal(*segment);
+    }
+    sealing_.clear();
+    enforce_retention();
+
+    if (spare_owned_) {
+        const std::string path = spare_owned_->path;
+        spare_owned_.reset();
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+}
+
+struct CaptureReader::Mapping {
+    bip::file_mapping file;
+    bip::mapped_region region;
+};
+
+CaptureReader::CaptureReader(const std::string& directory)
+    : directory_(directory), segments_(list_segments(directory)) {
+    if (segments_.empty()) {
+        throw std::runtime_error("No capture segments in " + directory);
+    }
+}
+
+CaptureReader::~CaptureReader() = default;
+
+bool CaptureReader::next(CaptureRecord& record) {
+    for (;;) {
+        if (!mapping_ || offset_ + sizeof(RecordHeader) > end_) {
+            if (!open_next()) {
+                return false;
+            }
+            continue;
+        }
+        const char* base = static_cast<const char*>(mapping_->region.get_address());
+        RecordHeader header;
+        std::memcpy(&header, base + offset_, sizeof(header));
+        const size_t size = padded(sizeof(RecordHeader) + header.length);
+        if (header.length == 0 || offset_ + size > end_) {
+            offset_ = end_;  // end of an unsealed segment
+            continue;
+        }
+        std::string_view payload(base + offset_ + sizeof(RecordHeader), header.length);
+        offset_ += size;
+        if (header.source == static_cast<uint8_t>(CaptureSource::Symbol)) {
+            set_symbol(header.symbol_id, payload);
+            continue;
+        }
+        record.source = static_cast<CaptureSource>(header.source);
+        record.connection_id = header.connection_id;
+        record.symbol_id = header.symbol_id;
+        record.receive_ns = header.receive_ns;
+        record.segment = segments_[next_segment_ - 1];
+        record.payload = payload;
+        return true;
+    }
+}
+
+const std::string& CaptureReader::symbol(uint32_t id) const {
+    static const std::string unknown;
+    return id < symbols_.size() ? symbols_[id] : unknown;
+}
+
+bool CaptureReader::open_next() {
+    mapping_.reset();
+    while (next_segment_ < segments_.size()) {
+        const uint64_t segment = segments_[next_segment_++];
+        const std::string path = CaptureJournal::segment_path(directory_, segment);
+        std::error_code ec;
+        const size_t size = fs::file_size(path, ec);
+        if (ec || size < sizeof(SegmentHeader)) {
+            continue;
+        }
+        auto mapping = std::make_unique<Mapping>();
+        mapping->file = bip::file_mapping(path.c_str(), bip::read_only);
+        mapping->region = bip::mapped_region(mapping->file, bip::read_only, 0, size);
+        SegmentHeader header;
+        std::memcpy(&header, mapping->region.get_address(), sizeof(header));
+        if (header.magic != CaptureJournal::SEGMENT_MAGIC || header.version != CaptureJournal::VERSION) {
+            spdlog::warn("Skipping {}: not a capture segment", path);
+            continue;
+        }
+        load_index_symbols(segment);
+        mapping_ = std::move(mapping);
+        offset_ = sizeof(SegmentHeader);
+        end_ = header.data_size > 0 ? std::min<size_t>(header.data_size, size) : size;
+        return true;
+    }
+    return false;
+}
+
+void CaptureReader::load_index_symbols(uint64_t segment) {
+    std::ifstream file(CaptureJournal::index_path(directory_, segment), std::ios::binary);
+    IndexHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != CaptureJournal::INDEX_MAGIC) {
+        return;  // unsealed: the segment's own symbol records name its symbols
+    }
+    std::string name;
+    for (uint32_t i = 0; i < header.symbol_count; ++i) {
+        uint32_t fields[2];
+        if (!file.read(reinterpret_cast<char*>(fields), sizeof(fields))) {
+            return;
+        }
+        name.resize(padded(fields[1]));
+        if (!file.read(name.data(), static_cast<std::streamsize>(name.size()))) {
+            return;
+        }
+        set_symbol(fields[0], std::string_view(name.data(), fields[1]));
+    }
+}
+
+void CaptureReader::set_symbol(uint32_t id, std::string_view name) {
+    if (id >= symbols_.size()) {
+        symbols_.resize(id + 1);
+    }
+    symbols_[id] = std::string(name);
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class CaptureSource : uint8_t {
+    WebSocket = 1,
+    Rest = 2,
+    Symbol = 3,  // symbol table entry: symbol_id names the payload
+    Normalized = 4,  // a MarketDataCodec message the client derived, not feed input
+};
+
+struct CaptureConfig {
+    std::string directory;
+    size_t segment_size = 64 * 1024 * 1024;
+    size_t max_segments = 0;  // oldest sealed segments are deleted beyond this, 0 keeps all
+    std::chrono::milliseconds flush_interval{100};
+    bool prefault = true;     // touch the next segment's pages before it goes live
+    bool book_tops = false;   // BinanceClient also records each change of a book's best bid or ask as an md::Bbo
+};
+
+struct CaptureStats {
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    uint64_t dropped = 0;          // no live segment (the flusher is behind) or larger than a segment
+    uint64_t segments_sealed = 0;
+    uint64_t segments_deleted = 0;
+};
+
+// Append-only journal of raw feed payloads in rolling memory-mapped segment files.
+//
+// Segment file capture-NNNNNNNN.seg (native endianness, records 8-byte aligned):
+//   SegmentHeader { magic, version, segment, capacity, data_size, record_count, created_ns }
+//   records       { length, source, connection_id, symbol_id, receive_ns, payload (padded) }
+// A record's length is stored last, with release ordering, so a reader of a segment left
+// open by a crash stops at the first record whose length is still zero. Sealing fills in
+// data_size and record_count, truncates the file and writes capture-NNNNNNNN.idx next to
+// it: the symbol table and every INDEX_STRIDE-th record's receive time and offset.
+//
+// append() is lock-free: one fetch_add reserves space in the live segment and the record
+// is copied straight into the mapping. The writer whose reservation runs past the end
+// switches to the spare segment the background thread keeps ready; flushing, sealing,
+// indexing and retention all run on that thread. A record that finds no live segment is
+// dropped and counted rather than waited for. Writers that raced a switch may still touch
+// a closed segment's counters, so its control block goes through EpochReclaimer.
+class CaptureJournal {
+public:
+    static constexpr uint32_t SEGMENT_MAGIC = 0x4C4E4A43;  // "CJNL"
+    static constexpr uint32_t INDEX_MAGIC = 0x58444A43;    // "CJDX"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t INDEX_STRIDE = 64;
+
+    // Creates the directory if needed and continues numbering after any segments in it.
+    // Throws std::runtime_error if the first segment cannot be created.
+    explicit CaptureJournal(const CaptureConfig& config);
+    // Seals the live segment
+    ~CaptureJournal();
+
+    CaptureJournal(const CaptureJournal&) = delete;
+    CaptureJournal& operator=(const CaptureJournal&) = delete;
+
+    // Resolve once per connection, not per message: these take a lock
+    uint32_t register_connection();
+    // 0 is reserved for records without a single symbol (combined streams)
+    uint32_t symbol_id(const std::string& symbol);
+
+    // Safe from any thread; false if the record was dropped
+    bool append(CaptureSource source, uint32_t connection_id, uint32_t symbol_id, int64_t receive_ns,
+                std::string_view payload);
+
+    CaptureStats stats() const;
+    const std::string& directory() const { return config_.directory; }
+
+    static std::string segment_path(const std::string& directory, uint64_t segment);
+    static std::string index_path(const std::string& directory, uint64_t segment);
+    static int64_t now_ns();
+
+private:
+    struct Segment;
+
+    CaptureConfig config_;
+    std::atomic<Segment*> current_{nullptr};  // written by a rolling writer or the flusher
+    std::atomic<Segment*> spare_{nullptr};    // taken by the rolling writer
+
+    std::atomic<uint64_t> records_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> segments_sealed_{0};
+    std::atomic<uint64_t> segments_deleted_{0};
+    std::atomic<uint32_t> next_connection_{1};
+
+    std::mutex symbols_mutex_;
+    std::unordered_map<std::string, uint32_t> symbol_ids_;
+    std::vector<std::string> symbol_names_;  // index is the id; 0 is the empty name
+
+    // Flusher thread state
+    std::unique_ptr<Segment> active_;
+    std::unique_ptr<Segment> spare_owned_;
+    std::vector<std::unique_ptr<Segment>> sealing_;
+    std::deque<uint64_t> sealed_segments_;
+    uint64_t next_segment_ = 0;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread flusher_;
+
+    void run();
+    void service();
+    std::unique_ptr<Segment> open_segment();
+    void seal(Segment& segment);
+    // Returns the segment's record count
+    uint64_t write_index(const Segment& segment, size_t data_size);
+    void enforce_retention();
+    void close_live_segment();
+};
+
+struct CaptureRecord {
+    CaptureSource source = CaptureSource::WebSocket;
+    uint32_t connection_id = 0;
+    uint32_t symbol_id = 0;
+    int64_t receive_ns = 0;
+    uint64_t segment = 0;
+    std::string_view payload;  // valid until next() moves to another segment
+};
+
+// Reads the segments of a capture directory in order, sealed or not. Symbol table
+// records are absorbed into symbol() instead of being returned.
+class CaptureReader {
+public:
+    // Throws std::runtime_error if the directory has no segments
+    explicit CaptureReader(const std::string& directory);
+    ~CaptureReader();
+
+    bool next(CaptureRecord& record);
+
+    // Empty for unknown ids and for 0
+    const std::string& symbol(uint32_t id) const;
+    const std::vector<uint64_t>& segments() const { return segments_; }
+
+private:
+    struct Mapping;
+
+    std::string directory_;
+    std::vector<uint64_t> segments_;
+    size_t next_segment_ = 0;
+    std::unique_ptr<Mapping> mapping_;
+    size_t offset_ = 0;
+    size_t end_ = 0;
+    std::vector<std::string> symbols_;
+
+    bool open_next();
+    void load_index_symbols(uint64_t segment);
+    void set_symbol(uint32_t id, std::string_view name);
+};
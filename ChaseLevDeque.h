@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Chase-Lev work-stealing deque (Le et al., "Correct and Efficient Work-Stealing for
+// Weak Memory Models"). The owner pushes and takes at the bottom, LIFO; any thread may
+// steal from the top, FIFO. The ring grows on demand; outgrown rings are kept until
+// destruction because a thief may still be reading one.
+//
+// T must be trivially copyable and fit in an atomic, in practice a pointer.
+template<typename T>
+class ChaseLevDeque {
+private:
+    struct Ring {
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+
+        explicit Ring(size_t capacity) : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+        size_t capacity() const { return mask + 1; }
+        T load(int64_t index) const { return slots[index & mask].load(std::memory_order_relaxed); }
+        void store(int64_t index, T value) { slots[index & mask].store(value, std::memory_order_relaxed); }
+    };
+
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    std::atomic<Ring*> ring_;
+    std::vector<std::unique_ptr<Ring>> rings_;  // owner only
+
+    Ring* grow(Ring* ring, int64_t bottom, int64_t top) {
+        auto bigger = std::make_unique<Ring>(ring->capacity() * 2);
+        for (int64_t i = top; i < bottom; ++i) {
+            bigger->store(i, ring->load(i));
+        }
+        Ring* raw = bigger.get();
+        rings_.push_back(std::move(bigger));
+        ring_.store(raw, std::memory_order_release);
+        return raw;
+    }
+
+public:
+    // capacity must be a power of two
+    explicit ChaseLevDeque(size_t capacity = 256) {
+        rings_.push_back(std::make_unique<Ring>(capacity));
+        ring_.store(rings_.back().get(), std::memory_order_relaxed);
+    }
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    // Owner only
+    void push(T value) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<int64_t>(ring->capacity()) - 1) {
+            ring = grow(ring, bottom, top);
+        }
+        ring->store(bottom, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only; newest first
+    bool take(T& out) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+        out = ring->load(bottom);
+        if (top == bottom) {
+            // Last element: race the thieves for it
+            bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Any thread; oldest first. False when empty or when another thread won the race.
+    bool steal(T& out) {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return false;
+        }
+        Ring* ring = ring_.load(std::memory_order_acquire);
+        T value = ring->load(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return false;
+        }
+        out = value;
+        return true;
+    }
+
+    bool empty() const {
+        return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+    }
+
+    size_t size() const {
+        int64_t size = bottom_.load(std::memory_order_relaxed) - top_.load(std::memory_order_relaxed);
+        return size > 0 ? static_cast<size_t>(size) : 0;
+    }
+};
@@ -0,0 +1,230 @@
+#include "CpuTopology.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <spdlog/spdlog.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
+namespace {
+
+bool read_line(const std::string& path, std::string& line) {
+    std::ifstream file(path);
+    return file && std::getline(file, line);
+}
+
+}  // namespace
+
+std::vector<int> CpuTopology::parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        try {
+            size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            spdlog::warn("Ignoring malformed CPU range '{}'", range);
+        }
+    }
+    return cpus;
+}
+
+CpuTopology CpuTopology::from_nodes(std::vector<NumaNode> nodes) {
+    CpuTopology topology;
+    topology.nodes_ = std::move(nodes);
+    std::sort(topology.nodes_.begin(), topology.nodes_.end(),
+              [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+    for (auto& node : topology.nodes_) {
+        std::sort(node.cpus.begin(), node.cpus.end());
+    }
+    return topology;
+}
+
+CpuTopology CpuTopology::detect() {
+    std::vector<NumaNode> nodes;
+#ifdef __linux__
+    std::string line;
+    std::vector<int> online;
+    if (read_line("/sys/devices/system/cpu/online", line)) {
+        online = parse_cpu_list(line);
+    }
+
+    if (DIR* dir = opendir("/sys/devices/system/node")) {
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+                !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+                continue;
+            }
+            if (!read_line("/sys/devices/system/node/" + name + "/cpulist", line)) {
+                continue;
+            }
+            NumaNode node;
+            node.id = std::stoi(name.substr(4));
+            for (int cpu : parse_cpu_list(line)) {
+                if (online.empty() || std::find(online.begin(), online.end(), cpu) != online.end()) {
+                    node.cpus.push_back(cpu);
+                }
+            }
+            // Memory-only nodes have no CPUs to place threads on
+            if (!node.cpus.empty()) {
+                nodes.push_back(std::move(node));
+            }
+        }
+        closedir(dir);
+    }
+
+    if (nodes.empty() && !online.empty()) {
+        nodes.push_back({0, online});
+    }
+#endif
+    if (nodes.empty()) {
+        NumaNode node;
+        for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) {
+            node.cpus.push_back(static_cast<int>(cpu));
+        }
+        nodes.push_back(std::move(node));
+    }
+    return from_nodes(std::move(nodes));
+}
+
+size_t CpuTopology::cpu_count() const {
+    size_t count = 0;
+    for (const auto& node : nodes_) {
+        count += node.cpus.size();
+    }
+    return count;
+}
+
+int CpuTopology::node_of(int cpu) const {
+    for (const auto& node : nodes_) {
+        if (std::find(node.cpus.begin(), node.cpus.end(), cpu) != node.cpus.end()) {
+            return node.id;
+        }
+    }
+    return -1;
+}
+
+TopologyConfig TopologyConfig::automatic(const CpuTopology& topology, size_t event_loops) {
+    TopologyConfig config;
+    config.enabled = true;
+    config.event_loop_cpus.assign(event_loops, -1);
+
+    std::vector<int> cpus;
+    for (const auto& node : topology.nodes()) {
+        cpus.insert(cpus.end(), node.cpus.begin(), node.cpus.end());
+    }
+    if (cpus.size() < 2) {
+        // Nothing to separate hot threads from
+        config.housekeeping_cpus = cpus;
+        return config;
+    }
+
+    config.housekeeping_cpus.push_back(cpus.front());
+    size_t next = 1;
+    config.market_data_cpu = cpus[next++];
+    for (size_t i = 0; i < event_loops && next < cpus.size(); ++i) {
+        config.event_loop_cpus[i] = cpus[next++];
+    }
+    // Cores left over after every hot thread has one are free for housekeeping too
+    config.housekeeping_cpus.insert(config.housekeeping_cpus.end(), cpus.begin() + next, cpus.end());
+    return config;
+}
+
+std::vector<ThreadPlacement> describe_layout(const TopologyConfig& config, const CpuTopology& topology) {
+    auto place = [&](const std::string& thread, const std::vector<int>& cpus) {
+        ThreadPlacement placement{thread, {}, -1};
+        if (!config.enabled) {
+            return placement;
+        }
+        for (int cpu : cpus) {
+            if (cpu >= 0) {
+                placement.cpus.push_back(cpu);
+            }
+        }
+        if (!placement.cpus.empty()) {
+            placement.node = topology.node_of(placement.cpus.front());
+        }
+        for (int cpu : placement.cpus) {
+            if (topology.node_of(cpu) != placement.node) {
+                placement.node = -1;
+                break;
+            }
+        }
+        return placement;
+    };
+
+    std::vector<ThreadPlacement> layout;
+    layout.push_back(place("market-data", {config.market_data_cpu}));
+    for (size_t i = 0; i < config.event_loop_cpus.size(); ++i) {
+        layout.push_back(place("event-loop-" + std::to_string(i), {config.event_loop_cpus[i]}));
+    }
+    layout.push_back(place("housekeeping", config.housekeeping_cpus));
+    return layout;
+}
+
+#ifdef __linux__
+namespace {
+
+bool to_cpu_set(const std::vector<int>& cpus, cpu_set_t& set) {
+    CPU_ZERO(&set);
+    bool any = false;
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+            any = true;
+        }
+    }
+    return any;
+}
+
+}  // namespace
+#endif
+
+bool pin_current_thread(const std::vector<int>& cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    return to_cpu_set(cpus, set) && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    spdlog::warn("CPU affinity setting is not supported on this platform");
+    return false;
+#endif
+}
+
+bool pin_thread(std::thread& thread, const std::vector<int>& cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    return thread.joinable() && to_cpu_set(cpus, set) &&
+           pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+    (void)thread;
+    (void)cpus;
+    spdlog::warn("CPU affinity setting is not supported on this platform");
+    return false;
+#endif
+}
+
+void use_local_memory() {
+#ifdef HAVE_LIBNUMA
+    if (numa_available() != -1) {
+        numa_set_localalloc();
+    }
+#endif
+    // Without libnuma the kernel default already places pages on the node of the
+    // thread that first touches them
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <vector>
+
+struct NumaNode {
+    int id = 0;
+    std::vector<int> cpus;
+};
+
+// Online CPUs grouped by NUMA node, read from sysfs. Machines without node
+// information are reported as a single node holding every CPU.
+class CpuTopology {
+public:
+    static CpuTopology detect();
+    static CpuTopology from_nodes(std::vector<NumaNode> nodes);
+    // Kernel cpulist format, e.g. "0-3,8,10-11"
+    static std::vector<int> parse_cpu_list(const std::string& list);
+
+    const std::vector<NumaNode>& nodes() const { return nodes_; }
+    size_t cpu_count() const;
+    // -1 for CPUs not in the topology
+    int node_of(int cpu) const;
+
+private:
+    std::vector<NumaNode> nodes_;
+};
+
+// Which core each thread runs on. -1 leaves a thread to the scheduler.
+struct TopologyConfig {
+    bool enabled = false;
+    std::vector<int> event_loop_cpus;    // one per pool loop: connections and symbol processing
+    int market_data_cpu = -1;            // market data loop
+    std::vector<int> housekeeping_cpus;  // REST workers and the helper threads in main.cpp
+    bool local_memory = true;            // pinned threads allocate from their own node
+
+    // Keeps the first CPU for housekeeping and the OS, then fills the remaining CPUs
+    // node by node: market data loop first, event loops after it, so hot threads
+    // share a node for as long as it has cores. Loops beyond the core count stay unpinned.
+    static TopologyConfig automatic(const CpuTopology& topology, size_t event_loops);
+};
+
+struct ThreadPlacement {
+    std::string thread;
+    std::vector<int> cpus;  // empty when unpinned
+    int node = -1;          // -1 when unpinned or spanning nodes
+};
+
+// Per-thread layout implied by a config, in the order it is reported at startup
+std::vector<ThreadPlacement> describe_layout(const TopologyConfig& config, const CpuTopology& topology);
+
+// Restrict a thread to the given CPUs; false if unsupported or rejected by the OS
+bool pin_current_thread(const std::vector<int>& cpus);
+bool pin_thread(std::thread& thread, const std::vector<int>& cpus);
+// Make later allocations of the calling thread come from its local NUMA node,
+// whatever policy the process was started with
+void use_local_memory();
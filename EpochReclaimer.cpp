@@ -0,0 +1,260 @@
+#include "EpochReclaimer.h"
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t ACTIVE = 1;  // low bit of Record::state; the epoch is in the bits above
+
+struct alignas(64) Record {
+    std::atomic<uint64_t> state{0};
+    std::atomic<bool> in_use{false};
+    std::atomic<uint64_t> retired{0};    // written by the owning thread only
+    std::atomic<uint64_t> reclaimed{0};
+    Record* next = nullptr;
+};
+
+struct Retired {
+    void* p;
+    void (*deleter)(void*);
+    uint64_t epoch;
+};
+
+struct Global {
+    std::atomic<uint64_t> epoch{1};
+    std::atomic<Record*> records{nullptr};
+
+    // Bags of exited threads
+    std::mutex orphan_mutex;
+    std::vector<Retired> orphans;
+    std::atomic<size_t> orphan_count{0};
+    std::atomic<uint64_t> orphans_reclaimed{0};
+};
+
+Global& global() {
+    // Never destroyed: threads may retire from thread_local destructors after main returns
+    static Global* g = new Global();
+    return *g;
+}
+
+Record* acquire_record() {
+    Global& g = global();
+    for (Record* r = g.records.load(std::memory_order_acquire); r; r = r->next) {
+        bool free = false;
+        if (!r->in_use.load(std::memory_order_relaxed) &&
+            r->in_use.compare_exchange_strong(free, true, std::memory_order_acquire)) {
+            return r;
+        }
+    }
+    auto* r = new Record();
+    r->in_use.store(true, std::memory_order_relaxed);
+    Record* head = g.records.load(std::memory_order_relaxed);
+    do {
+        r->next = head;
+    } while (!g.records.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+    return r;
+}
+
+void pin(Record* r) {
+    // Sequentially consistent RMW: the announcement is visible before any pointer the
+    // guarded code loads afterwards
+    r->state.exchange((global().epoch.load(std::memory_order_relaxed) << 1) | ACTIVE, std::memory_order_seq_cst);
+}
+
+void unpin(Record* r) {
+    r->state.store(0, std::memory_order_release);
+}
+
+// Advances the global epoch if every active guard runs in the current one
+bool try_advance() {
+    Global& g = global();
+    uint64_t epoch = g.epoch.load(std::memory_order_seq_cst);
+    for (Record* r = g.records.load(std::memory_order_acquire); r; r = r->next) {
+        uint64_t state = r->state.load(std::memory_order_seq_cst);
+        if ((state & ACTIVE) && (state >> 1) != epoch) {
+            return false;
+        }
+    }
+    g.epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+    return true;
+}
+
+class ThreadState {
+public:
+    Record* record = acquire_record();
+    unsigned depth = 0;
+    size_t since_advance = 0;
+
+    ~ThreadState() {
+        Global& g = global();
+        std::lock_guard<std::mutex> lock(g.orphan_mutex);
+        for (auto& bag : bags_) {
+            g.orphans.insert(g.orphans.end(), bag.items.begin(), bag.items.end());
+        }
+        g.orphan_count.store(g.orphans.size(), std::memory_order_relaxed);
+        record->state.store(0, std::memory_order_relaxed);
+        record->in_use.store(false, std::memory_order_release);
+    }
+
+    void retire(void* p, void (*deleter)(void*)) {
+        uint64_t epoch = global().epoch.load(std::memory_order_seq_cst);
+        Bag& bag = bags_[epoch % 3];
+        if (bag.epoch != epoch) {
+            free(bag);  // three or more epochs old
+            bag.epoch = epoch;
+        }
+        bag.items.push_back({p, deleter, epoch});
+        record->retired.store(record->retired.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (++since_advance >= EpochReclaimer::RETIRE_BATCH) {
+            since_advance = 0;
+            try_advance();
+            reclaim();
+        }
+    }
+
+    // Frees bags at least two epochs behind the global one. Exited threads' bags are
+    // skipped if another thread is busy with them, unless wait is set.
+    void reclaim(bool wait = false) {
+        uint64_t epoch = global().epoch.load(std::memory_order_acquire);
+        for (auto& bag : bags_) {
+            if (!bag.items.empty() && bag.epoch + 2 <= epoch) {
+                free(bag);
+            }
+        }
+        if (global().orphan_count.load(std::memory_order_relaxed) > 0) {
+            reclaim_orphans(epoch, wait);
+        }
+    }
+
+private:
+    struct Bag {
+        uint64_t epoch = 0;
+        std::vector<Retired> items;
+    };
+
+    Bag bags_[3];
+    std::vector<Retired> freeing_;
+
+    void free(Bag& bag) {
+        // Deleters may retire more, so run them from a separate list
+        freeing_.swap(bag.items);
+        for (auto& item : freeing_) {
+            item.deleter(item.p);
+        }
+        record->reclaimed.store(record->reclaimed.load(std::memory_order_relaxed) + freeing_.size(),
+                                std::memory_order_relaxed);
+        freeing_.clear();
+    }
+
+    static void reclaim_orphans(uint64_t epoch, bool wait) {
+        Global& g = global();
+        std::vector<Retired> ready;
+        {
+            std::unique_lock<std::mutex> lock(g.orphan_mutex, std::defer_lock);
+            if (wait) {
+                lock.lock();
+            } else if (!lock.try_lock()) {
+                return;
+            }
+            auto keep = g.orphans.begin();
+            for (auto& item : g.orphans) {
+                if (item.epoch + 2 <= epoch) {
+                    ready.push_back(item);
+                } else {
+                    *keep++ = item;
+                }
+            }
+            g.orphans.erase(keep, g.orphans.end());
+            g.orphan_count.store(g.orphans.size(), std::memory_order_relaxed);
+        }
+        for (auto& item : ready) {
+            item.deleter(item.p);
+        }
+        g.orphans_reclaimed.fetch_add(ready.size(), std::memory_order_relaxed);
+    }
+};
+
+thread_local ThreadState* t_state = nullptr;
+thread_local bool t_state_destroyed = false;
+
+struct StateReaper {
+    ~StateReaper() {
+        delete t_state;
+        t_state = nullptr;
+        t_state_destroyed = true;
+    }
+};
+
+ThreadState* thread_state() {
+    if (t_state == nullptr && !t_state_destroyed) {
+        static thread_local StateReaper reaper;
+        (void)reaper;
+        t_state = new ThreadState();
+    }
+    return t_state;
+}
+
+}  // namespace
+
+EpochReclaimer::Guard::Guard() {
+    ThreadState* state = thread_state();
+    if (state == nullptr) {
+        record_ = acquire_record();
+        borrowed_ = true;
+        pin(static_cast<Record*>(record_));
+    } else if (state->depth++ == 0) {
+        record_ = state->record;
+        pin(state->record);
+    }
+}
+
+EpochReclaimer::Guard::~Guard() {
+    if (borrowed_) {
+        auto* record = static_cast<Record*>(record_);
+        unpin(record);
+        record->in_use.store(false, std::memory_order_release);
+        return;
+    }
+    if (ThreadState* state = t_state) {
+        if (--state->depth == 0) {
+            unpin(static_cast<Record*>(record_));
+        }
+    }
+}
+
+void EpochReclaimer::retire(void* p, void (*deleter)(void*)) {
+    if (ThreadState* state = thread_state()) {
+        state->retire(p, deleter);
+        return;
+    }
+    Global& g = global();
+    std::lock_guard<std::mutex> lock(g.orphan_mutex);
+    g.orphans.push_back({p, deleter, g.epoch.load(std::memory_order_seq_cst)});
+    g.orphan_count.store(g.orphans.size(), std::memory_order_relaxed);
+}
+
+void EpochReclaimer::synchronize() {
+    Global& g = global();
+    const uint64_t target = g.epoch.load(std::memory_order_seq_cst) + 2;
+    while (g.epoch.load(std::memory_order_seq_cst) < target) {
+        if (!try_advance()) {
+            std::this_thread::yield();
+        }
+    }
+    if (ThreadState* state = thread_state()) {
+        state->reclaim(true);
+    }
+}
+
+EpochReclaimer::Stats EpochReclaimer::stats() {
+    Global& g = global();
+    Stats stats;
+    stats.epoch = g.epoch.load(std::memory_order_relaxed);
+    stats.reclaimed = g.orphans_reclaimed.load(std::memory_order_relaxed);
+    for (Record* r = g.records.load(std::memory_order_acquire); r; r = r->next) {
+        stats.retired += r->retired.load(std::memory_order_relaxed);
+        stats.reclaimed += r->reclaimed.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
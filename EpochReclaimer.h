@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Epoch-based reclamation for lock-free structures whose readers may still hold a node
+// another thread has unlinked.
+//
+// Readers wrap every access in a Guard, which announces the global epoch the thread
+// runs in; guards nest and cost one atomic exchange on the outermost entry. A writer
+// that unlinks a node retire()s it instead of deleting it. Retired nodes sit in the
+// retiring thread's bag for the epoch they were retired in and are freed once the
+// global epoch is two ahead, when no guard that could have seen them is left. Every
+// RETIRE_BATCH retirements the retiring thread tries to advance the epoch, which only
+// succeeds when every active guard has caught up with it, so a thread parked inside a
+// guard holds reclamation back but never blocks readers or writers.
+class EpochReclaimer {
+public:
+    static constexpr size_t RETIRE_BATCH = 64;
+
+    class Guard {
+    public:
+        Guard();
+        ~Guard();
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        void* record_ = nullptr;  // set on the outermost guard of a thread
+        bool borrowed_ = false;   // record taken for this guard alone, after thread exit cleanup
+    };
+
+    struct Stats {
+        uint64_t epoch = 0;
+        uint64_t retired = 0;
+        uint64_t reclaimed = 0;
+    };
+
+    // deleter runs on whichever thread reclaims p, at the latest at thread exit
+    // handoff or synchronize()
+    static void retire(void* p, void (*deleter)(void*));
+
+    template<typename T>
+    static void retire(T* p) {
+        retire(p, [](void* q) { delete static_cast<T*>(q); });
+    }
+
+    // Waits out every guard active at the call, then frees what this thread and exited
+    // threads retired before it. Must not be called inside a Guard.
+    static void synchronize();
+    static Stats stats();
+};
+
+// A pointer readers load without locks while a writer replaces it: the RCU pattern for
+// published read-mostly state. Readers must hold an EpochReclaimer::Guard for as long as
+// they use the returned object; replaced objects are retired, not deleted. Writers
+// serialize among themselves.
+template<typename T>
+class EpochPublished {
+public:
+    EpochPublished() = default;
+    ~EpochPublished() { delete current_.load(std::memory_order_relaxed); }
+
+    EpochPublished(const EpochPublished&) = delete;
+    EpochPublished& operator=(const EpochPublished&) = delete;
+
+    void publish(std::unique_ptr<T> value) {
+        T* old = current_.exchange(value.release(), std::memory_order_acq_rel);
+        if (old) {
+            EpochReclaimer::retire(old);
+        }
+    }
+
+    // nullptr until the first publish
+    const T* read(const EpochReclaimer::Guard&) const {
+        return current_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<T*> current_{nullptr};
+};
@@ -1,5 +1,6 @@
 #include "EventLoop.h"
 #include "LockFreePriorityQueue.h"
+#include "CpuTopology.h"
 #include <iostream>
 #include <stdexcept>
 #include <boost/asio.hpp>
@@ -7,53 +8,312 @@
 #include <atomic>
 #include <vector>
 #include <queue>
+#include <algorithm>
+#include <limits>
+#include <pthread.h>
+#include <time.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
-EventLoop::EventLoop() : work_(std::make_unique<boost::asio::io_context::work>(io_context_)) {}
+namespace {
+
+int64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+thread_local EventLoop* current_loop = nullptr;
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+}  // namespace
+
+EventLoop::EventLoop(const WaitConfig& wait_config, const SchedulerConfig& scheduler_config)
+    : work_(std::make_unique<boost::asio::io_context::work>(io_context_)),
+      tasks_(scheduler_config.queue_capacity),
+      scheduler_config_(scheduler_config),
+      wait_config_(wait_config),
+      spin_limit_(wait_config.spin_time) {
+#ifdef __linux__
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        throw std::runtime_error("Failed to create eventfd for EventLoop wakeups");
+    }
+    wake_descriptor_ = std::make_unique<boost::asio::posix::stream_descriptor>(io_context_, wake_fd_);
+#endif
+}
 
 EventLoop::~EventLoop() {
     stop();
-    PrioritizedTask task;
-    while (tasks_.pop(task)) {
-        // Clear remaining tasks
+    Task task;
+    for (size_t lane = 0; lane < PRIORITY_COUNT; ++lane) {
+        while (tasks_.pop(lane, task)) {
+            // Clear remaining tasks
+        }
     }
 }
 
 void EventLoop::run() {
-    thread_ = std::thread([this]() {
-        while (running_) {
-            io_context_.restart();
-            io_context_.poll(); // Using poll to handle multiple tasks in one go (non-blocking)
-            process_tasks(); // Process tasks from the queue
+    started_at_ = std::chrono::steady_clock::now();
+    thread_ = std::thread([this]() { loop(); });
+}
+
+void EventLoop::set_affinity(int cpu, bool local_memory) {
+    cpu_ = cpu;
+    local_memory_ = local_memory;
+}
+
+void EventLoop::loop() {
+    current_loop = this;
+    if (cpu_ >= 0) {
+        if (!pin_current_thread({cpu_})) {
+            std::cerr << "Failed to pin event loop to CPU " << cpu_ << std::endl;
+        } else if (local_memory_) {
+            use_local_memory();
+        }
+    }
+#ifdef __linux__
+    arm_wakeup();
+#endif
+    bool idle_pass = false;
+    std::chrono::steady_clock::time_point idle_since;
+    while (running_) {
+        int64_t pass_start = steady_ns();
+        io_context_.restart();
+        size_t handled = io_context_.poll(); // Using poll to handle multiple tasks in one go (non-blocking)
+        handled += process_tasks(); // Process tasks from the queue
+        for (auto& poller : pollers_) {
+            handled += poller();
         }
-    });
+        if (handled > 0) {
+            busy_ns_.fetch_add(steady_ns() - pass_start, std::memory_order_relaxed);
+            idle_pass = false;
+        } else {
+            if (!idle_pass) {
+                idle_pass = true;
+                idle_since = std::chrono::steady_clock::now();
+            }
+            idle(idle_since);
+        }
+    }
 }
 
 void EventLoop::stop() {
     running_ = false;
     work_.reset();
+    wake();
     if (thread_.joinable()) {
         thread_.join();
     }
 }
 
-void EventLoop::post(std::function<void()> task, Priority priority) {
-    tasks_.push({std::move(task), priority});
+void EventLoop::post(Task task, Priority priority) {
+    tasks_.push(std::move(task), static_cast<size_t>(priority));
+    if (idle_post_ns_.load(std::memory_order_relaxed) == 0) {
+        int64_t expected = 0;
+        idle_post_ns_.compare_exchange_strong(expected, steady_ns(), std::memory_order_relaxed);
+    }
+    notify();
 }
 
-void EventLoop::process_tasks() {
-    PrioritizedTask task;
-    while (tasks_.pop(task)) {
-        task.task();
+void EventLoop::notify() {
+    if (wait_config_.strategy == WaitStrategy::BusySpin) {
+        return;
+    }
+
+    // Pairs with the fence in park(): either the loop sees the work or we see it parked
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked_.load(std::memory_order_relaxed) && parked_.exchange(false)) {
+        wakeups_.fetch_add(1, std::memory_order_relaxed);
+        wake();
     }
 }
 
-size_t EventLoop::get_task_count() const {
-    return tasks_.size();
+void EventLoop::add_poller(std::function<size_t()> poller) {
+    pollers_.push_back(std::move(poller));
+}
+
+EventLoop* EventLoop::current() {
+    return current_loop;
+}
+
+size_t EventLoop::process_tasks() {
+    // Bounded batch so a busy queue never keeps the loop away from its sockets
+    Task task;
+    size_t processed = 0;
+    while (processed < scheduler_config_.batch_size) {
+        int lane = next_lane();
+        if (lane < 0 || !tasks_.pop(lane, task)) {
+            break;
+        }
+        if (processed == 0) {
+            int64_t posted_ns = idle_post_ns_.exchange(0, std::memory_order_relaxed);
+            if (posted_ns != 0) {
+                wake_latency_.record((steady_ns() - posted_ns) / 1000);
+            }
+        }
+        dispatched_[lane].fetch_add(1, std::memory_order_relaxed);
+        task();
+        task.reset();  // release captures now, not when the next task overwrites it
+        ++processed;
+    }
+    return processed;
 }
 
-EventLoopPool::EventLoopPool(size_t thread_count) {
+int EventLoop::next_lane() {
+    // Strict priority, except that a lane passed over starvation_limit times goes next
+    for (size_t lane = 0; lane < PRIORITY_COUNT; ++lane) {
+        if (bypassed_[lane] >= scheduler_config_.starvation_limit && !tasks_.empty(lane)) {
+            bypassed_[lane] = 0;
+            starvation_promotions_.fetch_add(1, std::memory_order_relaxed);
+            return static_cast<int>(lane);
+        }
+    }
+    for (int lane = static_cast<int>(PRIORITY_COUNT) - 1; lane >= 0; --lane) {
+        if (!tasks_.empty(lane)) {
+            bypassed_[lane] = 0;
+            for (int lower = 0; lower < lane; ++lower) {
+                if (!tasks_.empty(lower)) {
+                    ++bypassed_[lower];
+                }
+            }
+            return lane;
+        }
+    }
+    return -1;
+}
+
+void EventLoop::idle(std::chrono::steady_clock::time_point& idle_since) {
+    if (wait_config_.strategy == WaitStrategy::BusySpin) {
+        cpu_relax();
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto idle_for = now - idle_since;
+    switch (wait_config_.strategy) {
+    case WaitStrategy::SpinThenYield:
+        if (idle_for > spin_limit_) {
+            parks_.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::yield();
+        } else {
+            cpu_relax();
+        }
+        break;
+
+    case WaitStrategy::SpinThenBlock:
+        if (idle_for > spin_limit_) {
+            park();
+        } else {
+            cpu_relax();
+        }
+        break;
+
+    case WaitStrategy::Adaptive:
+        if (idle_for <= spin_limit_) {
+            cpu_relax();
+        } else if (idle_for <= 2 * spin_limit_) {
+            std::this_thread::yield();
+        } else {
+            park();
+            // Work that shows up soon after parking means the spin phase was too short,
+            // a long quiet period means spinning was wasted
+            auto woke = std::chrono::steady_clock::now();
+            const std::chrono::steady_clock::duration min_spin = wait_config_.spin_time / 8;
+            if (woke - now < std::chrono::milliseconds(1) && !tasks_.empty()) {
+                spin_limit_ = std::min<std::chrono::steady_clock::duration>(wait_config_.max_spin_time, spin_limit_ * 2);
+            } else {
+                spin_limit_ = std::max(min_spin, spin_limit_ / 2);
+            }
+            idle_since = woke;
+        }
+        break;
+
+    case WaitStrategy::BusySpin:
+        break;
+    }
+}
+
+void EventLoop::park() {
+    parks_.fetch_add(1, std::memory_order_relaxed);
+    parked_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!tasks_.empty() || !running_) {
+        parked_.store(false, std::memory_order_relaxed);
+        return;
+    }
+    // Returns on an I/O completion, a timer, an eventfd wakeup from post(), or max_block
+    io_context_.restart();
+    io_context_.run_one_for(wait_config_.max_block);
+    parked_.store(false, std::memory_order_relaxed);
+}
+
+void EventLoop::wake() {
+#ifdef __linux__
+    uint64_t one = 1;
+    ssize_t written = write(wake_fd_, &one, sizeof(one));
+    (void)written;  // EAGAIN means a wakeup is already pending
+#else
+    boost::asio::post(io_context_, []() {});
+#endif
+}
+
+#ifdef __linux__
+void EventLoop::arm_wakeup() {
+    wake_descriptor_->async_wait(boost::asio::posix::stream_descriptor::wait_read,
+        [this](const boost::system::error_code& ec) {
+            if (ec) {
+                return;
+            }
+            uint64_t count;
+            ssize_t drained = read(wake_fd_, &count, sizeof(count));
+            (void)drained;
+            if (running_) {
+                arm_wakeup();
+            }
+        });
+}
+#endif
+
+EventLoopStats EventLoop::get_stats() const {
+    EventLoopStats stats;
+    stats.parks = parks_.load(std::memory_order_relaxed);
+    stats.wakeups = wakeups_.load(std::memory_order_relaxed);
+    stats.wake_latency = wake_latency_.stats();
+    for (size_t lane = 0; lane < PRIORITY_COUNT; ++lane) {
+        stats.dispatched[lane] = dispatched_[lane].load(std::memory_order_relaxed);
+    }
+    stats.starvation_promotions = starvation_promotions_.load(std::memory_order_relaxed);
+    stats.busy_ns = busy_ns_.load(std::memory_order_relaxed);
+    stats.queue_overflows = tasks_.overflows();
+
+    if (thread_.joinable()) {
+        clockid_t clock;
+        timespec cpu{};
+        if (pthread_getcpuclockid(const_cast<std::thread&>(thread_).native_handle(), &clock) == 0 &&
+            clock_gettime(clock, &cpu) == 0) {
+            double cpu_s = cpu.tv_sec + cpu.tv_nsec / 1e9;
+            double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_at_).count();
+            if (wall_s > 0) {
+                stats.cpu_utilization = std::min(1.0, cpu_s / wall_s);
+            }
+        }
+    }
+    return stats;
+}
+
+EventLoopPool::EventLoopPool(size_t thread_count, const WaitConfig& wait_config, const SchedulerConfig& scheduler_config) {
     for (size_t i = 0; i < thread_count; ++i) {
-        event_loops_.push_back(std::make_unique<EventLoop>());
+        event_loops_.push_back(std::make_unique<EventLoop>(wait_config, scheduler_config));
     }
 }
 
@@ -61,6 +321,12 @@ EventLoopPool::~EventLoopPool() {
     stop();
 }
 
+void EventLoopPool::set_affinity(const std::vector<int>& cpus, bool local_memory) {
+    for (size_t i = 0; i < event_loops_.size(); ++i) {
+        event_loops_[i]->set_affinity(i < cpus.size() ? cpus[i] : -1, local_memory);
+    }
+}
+
 void EventLoopPool::run() {
     for (auto& loop : event_loops_) {
         loop->run();
@@ -95,4 +361,3 @@ EventLoop& EventLoopPool::get_next_event_loop() {
 
     return *selected_loop;
 }
-
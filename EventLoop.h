@@ -2,53 +2,135 @@
 
 #include <boost/asio.hpp>
 #include "LockFreePriorityQueue.h"
+#include "Task.h"
+#include "LatencyMonitor.h"
 #include <thread>
 #include <atomic>
 #include <vector>
+#include <array>
+#include <functional>
 #include <memory>
+#include <chrono>
+
+// How a loop waits when it has neither I/O completions nor queued tasks.
+enum class WaitStrategy {
+    BusySpin,       // never gives up the core; for dedicated hot loops
+    SpinThenYield,  // spins, then yields the time slice on every idle pass
+    SpinThenBlock,  // spins, then parks in the io_context until I/O or an eventfd wakeup
+    Adaptive        // spin budget grows when work returns quickly after going idle, shrinks otherwise
+};
+
+struct WaitConfig {
+    WaitStrategy strategy = WaitStrategy::SpinThenBlock;
+    std::chrono::microseconds spin_time{50};        // idle time spent spinning before yielding or blocking
+    std::chrono::microseconds max_spin_time{2000};  // Adaptive upper bound
+    std::chrono::milliseconds max_block{100};       // bound on a single park
+};
+
+// How queued tasks are drained between io_context polls.
+struct SchedulerConfig {
+    size_t batch_size = 64;           // tasks run per pass before polling I/O again
+    uint32_t starvation_limit = 32;   // higher-priority tasks a waiting lower lane lets through before it runs one
+    size_t queue_capacity = 1024;     // preallocated tasks per priority lane; beyond it posts spill to a locked list
+};
+
+struct EventLoopStats {
+    double cpu_utilization = 0.0;  // loop thread CPU time / wall time since run(), 0..1
+    uint64_t parks = 0;            // times the loop blocked or yielded
+    uint64_t wakeups = 0;          // eventfd wakeups sent by post()
+    LatencyStats wake_latency;     // post() of the first task of a batch until the loop picks it up
+    std::array<uint64_t, 3> dispatched{};  // tasks run per priority, indexed by Priority
+    uint64_t starvation_promotions = 0;    // lower-priority tasks run ahead of waiting higher ones
+    uint64_t busy_ns = 0;          // time spent running handlers and tasks, excludes waiting
+    uint64_t queue_overflows = 0;  // posts that found their lane full and allocated
+};
 
 class EventLoop {
 public:
     enum class Priority { Low, Medium, High };
 
-    EventLoop();
+    explicit EventLoop(const WaitConfig& wait_config = WaitConfig(),
+                       const SchedulerConfig& scheduler_config = SchedulerConfig());
     ~EventLoop();
 
     void run();
     void stop();
-    void post(std::function<void()> task, Priority priority = Priority::Medium);
+    void post(Task task, Priority priority = Priority::Medium);
+    // Called on the loop thread every pass, after queued tasks; returns the work it did.
+    // Register before run(). Work a poller finds is not seen by park(), so whoever makes
+    // it available must call notify() afterwards.
+    void add_poller(std::function<size_t()> poller);
+    // Wakes the loop if it is parked
+    void notify();
+    // The loop running on the calling thread, nullptr off loop threads
+    static EventLoop* current();
 
     boost::asio::io_context& get_io_context() { return io_context_; }
     size_t get_task_count() const { return tasks_.size(); }
 
-private:
-    struct PrioritizedTask {
-        std::function<void()> task;
-        Priority priority;
+    const WaitConfig& get_wait_config() const { return wait_config_; }
+    EventLoopStats get_stats() const;
+    uint64_t get_busy_ns() const { return busy_ns_.load(std::memory_order_relaxed); }
+
+    // Takes effect at run(): the loop thread pins itself to cpu (-1 for any) and, with
+    // local_memory, allocates from that CPU's NUMA node
+    void set_affinity(int cpu, bool local_memory = true);
+    int get_cpu() const { return cpu_; }
 
-        bool operator<(const PrioritizedTask& other) const {
-            return priority < other.priority;
-        }
-    };
+private:
+    static constexpr size_t PRIORITY_COUNT = 3;
 
     boost::asio::io_context io_context_;
     std::unique_ptr<boost::asio::io_context::work> work_;
     std::thread thread_;
     std::atomic<bool> running_{true};
-    LockFreePriorityQueue<PrioritizedTask> tasks_;
+    // One FIFO lane per Priority value, served highest first
+    LockFreePriorityQueue<Task, PRIORITY_COUNT> tasks_;
+    SchedulerConfig scheduler_config_;
+    std::array<uint32_t, PRIORITY_COUNT> bypassed_{};  // consumer only
+    std::array<std::atomic<uint64_t>, PRIORITY_COUNT> dispatched_{};
+    std::atomic<uint64_t> starvation_promotions_{0};
+    std::vector<std::function<size_t()>> pollers_;
+
+    WaitConfig wait_config_;
+    std::chrono::steady_clock::duration spin_limit_;
+    std::atomic<bool> parked_{false};
+    std::atomic<int64_t> idle_post_ns_{0};   // first post since the loop went idle
+    std::atomic<uint64_t> parks_{0};
+    std::atomic<uint64_t> wakeups_{0};
+    LatencyTracker wake_latency_;
+    std::chrono::steady_clock::time_point started_at_;
+    std::atomic<uint64_t> busy_ns_{0};
+    int cpu_ = -1;
+    bool local_memory_ = false;
+
+#ifdef __linux__
+    int wake_fd_ = -1;
+    std::unique_ptr<boost::asio::posix::stream_descriptor> wake_descriptor_;
+    void arm_wakeup();
+#endif
 
-    void process_tasks();
+    void loop();
+    size_t process_tasks();
+    int next_lane();
+    void idle(std::chrono::steady_clock::time_point& idle_since);
+    void park();
+    void wake();
 };
 
 class EventLoopPool {
 public:
-    EventLoopPool(size_t thread_count);
+    EventLoopPool(size_t thread_count, const WaitConfig& wait_config = WaitConfig(),
+                  const SchedulerConfig& scheduler_config = SchedulerConfig());
     ~EventLoopPool();
 
     EventLoop& get_next_event_loop();
     void run();
     void stop();
     size_t size() const { return event_loops_.size(); }
+    EventLoop& get_event_loop(size_t index) { return *event_loops_.at(index); }
+    // One CPU per loop in order, -1 leaves a loop unpinned; call before run()
+    void set_affinity(const std::vector<int>& cpus, bool local_memory = true);
 
 private:
     std::vector<std::unique_ptr<EventLoop>> event_loops_;
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+// Where BinanceClient connects. The defaults are Binance production; LocalExchange (or
+// anything speaking the same depth-stream and REST protocols) can stand in for it.
+struct ExchangeEndpoints {
+    // Stream paths /ws/<symbol>@depth and /stream?streams=... are appended. WebSocketHandler
+    // speaks plain WebSocket, so a local stand-in is reached with ws://.
+    std::string stream_base = "wss://stream.binance.com:9443";
+    // REST requests always use TLS; the peer certificate is not verified
+    std::string rest_host = "api.binance.com";
+    std::string rest_port = "443";
+
+    static ExchangeEndpoints local(unsigned short stream_port, unsigned short rest_port,
+                                   const std::string& host = "127.0.0.1") {
+        ExchangeEndpoints endpoints;
+        endpoints.stream_base = "ws://" + host + ":" + std::to_string(stream_port);
+        endpoints.rest_host = host;
+        endpoints.rest_port = std::to_string(rest_port);
+        return endpoints;
+    }
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+// Messages FanoutServer sends its consumers, with the encoders it uses and the decoder
+// and book a consumer needs. Header-only and free of the client's dependencies.
+//
+// Per subscribed symbol a consumer gets one snapshot of the top levels, then deltas.
+// A delta lists the levels whose quantity changed since the previous message, with 0
+// for levels that left the top; applying it and keeping the best `depth` levels gives
+// the server's current top. Deltas are conflated for consumers that fall behind, so
+// update_id can jump, but previous_update_id always equals the update_id of the
+// message before it and sequence always advances by one per symbol.
+//
+// JSON (text frames):
+//   {"type":"snapshot"|"delta","s":"btcusdt","seq":1,"pu":0,"u":100,"b":[[price,qty],...],"a":[...]}
+// Binary (binary frames): MarketDataCodec messages. A connection gets a SymbolDefinition
+// before the first snapshot of each symbol, then Snapshot and Delta messages for its ID
+// with fixed-point levels; BinaryDecoder turns them back into Messages.
+
+#include "MarketDataCodec.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace fanout {
+
+enum class MessageType : uint8_t {
+    Snapshot = 1,
+    Delta = 2,
+};
+
+struct Level {
+    double price;
+    double quantity;
+};
+
+struct Message {
+    MessageType type = MessageType::Snapshot;
+    std::string symbol;
+    uint64_t sequence = 0;
+    uint64_t previous_update_id = 0;
+    uint64_t update_id = 0;
+    std::vector<Level> bids;  // best first
+    std::vector<Level> asks;
+};
+
+inline void append_number(std::string& out, double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+inline void append_number(std::string& out, uint64_t value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+// Replaces out's contents, keeping its capacity
+inline void encode_json(const Message& message, std::string& out) {
+    out.assign(message.type == MessageType::Snapshot ? "{\"type\":\"snapshot\",\"s\":\"" : "{\"type\":\"delta\",\"s\":\"");
+    out += message.symbol;
+    out += "\",\"seq\":";
+    append_number(out, message.sequence);
+    out += ",\"pu\":";
+    append_number(out, message.previous_update_id);
+    out += ",\"u\":";
+    append_number(out, message.update_id);
+    auto side = [&out](const char* key, const std::vector<Level>& levels) {
+        out += key;
+        for (size_t i = 0; i < levels.size(); ++i) {
+            out += i ? ",[" : "[";
+            append_number(out, levels[i].price);
+            out += ',';
+            append_number(out, levels[i].quantity);
+            out += ']';
+        }
+        out += ']';
+    };
+    side(",\"b\":[", message.bids);
+    side(",\"a\":[", message.asks);
+    out += '}';
+}
+
+// Replaces out's contents, keeping its capacity
+inline void encode_definition(uint32_t symbol_id, const std::string& symbol, std::string& out) {
+    md::encode(out, md::make_definition(symbol_id, symbol));
+}
+
+// Replaces out's contents, keeping its capacity. Sides are limited to 65535 levels.
+inline void encode_binary(const Message& message, uint32_t symbol_id, int64_t local_ns, std::string& out) {
+    md::Level levels[2 * 64];
+    std::vector<md::Level> spill;
+    const size_t count = message.bids.size() + message.asks.size();
+    md::Level* fixed = levels;
+    if (count > std::size(levels)) {
+        spill.resize(count);
+        fixed = spill.data();
+    }
+    size_t i = 0;
+    for (const auto* side : {&message.bids, &message.asks}) {
+        for (const Level& level : *side) {
+            fixed[i++] = md::Level{md::to_fixed(level.price), md::to_fixed(level.quantity)};
+        }
+    }
+    const md::Level* asks = fixed + message.bids.size();
+    if (message.type == MessageType::Snapshot) {
+        md::Snapshot block{};
+        block.symbol_id = symbol_id;
+        block.exchange = md::Exchange::Binance;
+        block.sequence = message.sequence;
+        block.update_id = message.update_id;
+        block.local_ns = local_ns;
+        md::encode(out, block, fixed, message.bids.size(), asks, message.asks.size());
+    } else {
+        md::Delta block{};
+        block.symbol_id = symbol_id;
+        block.exchange = md::Exchange::Binance;
+        block.sequence = message.sequence;
+        block.previous_update_id = message.previous_update_id;
+        block.update_id = message.update_id;
+        block.local_ns = local_ns;
+        md::encode(out, block, fixed, message.bids.size(), asks, message.asks.size());
+    }
+}
+
+// A binary consumer's side of one connection: remembers the symbol definitions
+class BinaryDecoder {
+public:
+    enum class Result {
+        Message,     // a snapshot or delta was decoded into message
+        Definition,  // a symbol was defined, nothing to apply
+        Invalid,     // truncated, another schema or template, or an undefined symbol
+    };
+
+    Result decode(std::string_view frame, Message& message) {
+        switch (md::template_id(frame)) {
+        case md::SymbolDefinition::TEMPLATE_ID: {
+            md::View<md::SymbolDefinition> view;
+            if (!view.wrap(frame)) {
+                return Result::Invalid;
+            }
+            md::SymbolDefinition definition = view.block();
+            symbols_[definition.symbol_id] = std::string(definition.symbol());
+            return Result::Definition;
+        }
+        case md::Snapshot::TEMPLATE_ID: {
+            md::View<md::Snapshot> view;
+            if (!view.wrap(frame)) {
+                return Result::Invalid;
+            }
+            md::Snapshot block = view.block();
+            message.type = MessageType::Snapshot;
+            message.previous_update_id = 0;
+            return fill(block.symbol_id, block.sequence, block.update_id, view, message);
+        }
+        case md::Delta::TEMPLATE_ID: {
+            md::View<md::Delta> view;
+            if (!view.wrap(frame)) {
+                return Result::Invalid;
+            }
+            md::Delta block = view.block();
+            message.type = MessageType::Delta;
+            message.previous_update_id = block.previous_update_id;
+            return fill(block.symbol_id, block.sequence, block.update_id, view, message);
+        }
+        default:
+            return Result::Invalid;
+        }
+    }
+
+private:
+    std::unordered_map<uint32_t, std::string> symbols_;
+
+    template<typename View>
+    Result fill(uint32_t symbol_id, uint64_t sequence, uint64_t update_id, const View& view, Message& message) {
+        auto symbol = symbols_.find(symbol_id);
+        if (symbol == symbols_.end()) {
+            return Result::Invalid;
+        }
+        message.symbol = symbol->second;
+        message.sequence = sequence;
+        message.update_id = update_id;
+        auto side = [](const md::Levels& levels, std::vector<Level>& out) {
+            out.resize(levels.size());
+            for (size_t i = 0; i < levels.size(); ++i) {
+                md::Level level = levels[i];
+                out[i] = Level{md::to_double(level.price), md::to_double(level.quantity)};
+            }
+        };
+        side(view.bids(), message.bids);
+        side(view.asks(), message.asks);
+        return Result::Message;
+    }
+};
+
+// A consumer's copy of one symbol's top levels
+class Book {
+public:
+    explicit Book(size_t depth) : depth_(depth) {}
+
+    // False, leaving the book unchanged, for a delta that does not continue it
+    bool apply(const Message& message) {
+        if (message.type == MessageType::Snapshot) {
+            bids_ = message.bids;
+            asks_ = message.asks;
+        } else if (message.sequence != sequence_ + 1 || message.previous_update_id != update_id_) {
+            return false;
+        } else {
+            merge(bids_, message.bids, [](double a, double b) { return a > b; });
+            merge(asks_, message.asks, [](double a, double b) { return a < b; });
+        }
+        sequence_ = message.sequence;
+        update_id_ = message.update_id;
+        return true;
+    }
+
+    const std::vector<Level>& bids() const { return bids_; }
+    const std::vector<Level>& asks() const { return asks_; }
+    uint64_t update_id() const { return update_id_; }
+    uint64_t sequence() const { return sequence_; }
+
+private:
+    size_t depth_;
+    std::vector<Level> bids_;
+    std::vector<Level> asks_;
+    uint64_t sequence_ = 0;
+    uint64_t update_id_ = 0;
+
+    template<typename Better>
+    void merge(std::vector<Level>& side, const std::vector<Level>& changes, Better better) {
+        for (const Level& change : changes) {
+            auto it = std::lower_bound(side.begin(), side.end(), change.price,
+                                       [&better](const Level& level, double price) { return better(level.price, price); });
+            bool found = it != side.end() && it->price == change.price;
+            if (change.quantity == 0.0) {
+                if (found) {
+                    side.erase(it);
+                }
+            } else if (found) {
+                it->quantity = change.quantity;
+            } else {
+                side.insert(it, change);
+            }
+        }
+        if (side.size() > depth_) {
+            side.resize(depth_);
+        }
+    }
+};
+
+}  // namespace fanout
@@ -0,0 +1,386 @@
+#include "FanoutServer.h"
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/websocket.hpp>
+#include <simdjson.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <deque>
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace websocket = beast::websocket;
+using net::ip::tcp;
+
+namespace {
+
+auto redirect(boost::system::error_code& ec) {
+    return net::redirect_error(net::use_awaitable, ec);
+}
+
+std::string lower(std::string_view text) {
+    std::string out(text);
+    std::transform(out.begin(), out.end(), out.begin(), [](unsigned char c) { return std::tolower(c); });
+    return out;
+}
+
+std::string_view query_param(std::string_view target, std::string_view name) {
+    size_t question = target.find('?');
+    if (question == std::string_view::npos) {
+        return std::string_view();
+    }
+    std::string_view query = target.substr(question + 1);
+    while (!query.empty()) {
+        size_t end = query.find('&');
+        std::string_view pair = query.substr(0, end);
+        if (pair.size() > name.size() && pair.substr(0, name.size()) == name && pair[name.size()] == '=') {
+            return pair.substr(name.size() + 1);
+        }
+        query = end == std::string_view::npos ? std::string_view() : query.substr(end + 1);
+    }
+    return std::string_view();
+}
+
+// Levels of `now` that differ from `before`, plus 0-quantity entries for prices that
+// left; both sides are sorted best first by `better`
+template<typename Better>
+void diff_side(const PriceLevel* before, size_t before_count, const PriceLevel* now, size_t now_count,
+               Better better, std::vector<fanout::Level>& out) {
+    size_t i = 0, j = 0;
+    while (i < before_count || j < now_count) {
+        if (j == now_count || (i < before_count && better(before[i].price, now[j].price))) {
+            out.push_back(fanout::Level{before[i++].price, 0.0});
+        } else if (i == before_count || better(now[j].price, before[i].price)) {
+            out.push_back(fanout::Level{now[j].price, now[j].quantity});
+            ++j;
+        } else {
+            if (before[i].quantity != now[j].quantity) {
+                out.push_back(fanout::Level{now[j].price, now[j].quantity});
+            }
+            ++i;
+            ++j;
+        }
+    }
+}
+
+}  // namespace
+
+struct FanoutServer::Feed {
+    Feed(std::string symbol, uint32_t id) : symbol(std::move(symbol)), id(id) {}
+
+    std::string symbol;
+    uint32_t id;  // symbol ID in binary messages
+    // Written by the feed threads
+    std::mutex mutex;
+    BookView latest;
+    bool has_latest = false;
+    std::atomic<bool> pending{false};
+    // Server thread only
+    BookView current;
+    bool has_current = false;
+    std::vector<std::shared_ptr<Client>> subscribers;
+};
+
+struct FanoutServer::Client {
+    struct Subscription {
+        BookView sent;          // the top as of the last message, what the consumer now has
+        bool has_sent = false;
+        uint64_t sequence = 0;
+        bool queued = false;    // in `changed`, so later updates conflate into that entry
+    };
+
+    explicit Client(tcp::socket socket) : ws(std::move(socket)) {}
+
+    websocket::stream<beast::tcp_stream> ws;
+    bool binary = false;
+    std::unordered_map<Feed*, Subscription> subscriptions;
+    std::deque<Feed*> changed;
+    std::deque<std::string> control;  // subscription acknowledgements, sent first
+    std::deque<std::string> definitions;  // binary symbol definitions, sent before any book message
+    bool writing = false;
+    bool closed = false;
+    fanout::Message message;  // reused for every message
+    std::string frame;
+};
+
+FanoutServer::FanoutServer(const FanoutConfig& config)
+    : config_(config), acceptor_(ioc_, {net::ip::make_address(config.address), config.port}) {
+    port_ = acceptor_.local_endpoint().port();
+    net::co_spawn(ioc_, accept_loop(), net::detached);
+    thread_ = std::thread([this]() { ioc_.run(); });
+    spdlog::info("Fan-out server listening on {}:{}", config_.address, port_);
+}
+
+FanoutServer::~FanoutServer() {
+    ioc_.stop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+FanoutStats FanoutServer::stats() const {
+    FanoutStats stats;
+    stats.clients = clients_.load();
+    stats.updates = updates_.load();
+    stats.messages_sent = messages_sent_.load();
+    stats.bytes_sent = bytes_sent_.load();
+    stats.conflated = conflated_.load();
+    return stats;
+}
+
+FanoutServer::Feed& FanoutServer::feed_for(const std::string& symbol) {
+    {
+        std::shared_lock<std::shared_mutex> lock(feeds_mutex_);
+        auto it = feeds_.find(symbol);
+        if (it != feeds_.end()) {
+            return *it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(feeds_mutex_);
+    auto& feed = feeds_[symbol];
+    if (!feed) {
+        feed = std::make_unique<Feed>(symbol, static_cast<uint32_t>(feeds_.size()));
+    }
+    return *feed;
+}
+
+void FanoutServer::on_book(const std::string& symbol, const BookView& view) {
+    Feed& feed = feed_for(symbol);
+    {
+        std::lock_guard<std::mutex> lock(feed.mutex);
+        feed.latest = view;
+        feed.has_latest = true;
+    }
+    updates_.fetch_add(1, std::memory_order_relaxed);
+    if (!feed.pending.exchange(true, std::memory_order_acq_rel)) {
+        net::post(ioc_, [this, &feed]() { deliver(feed); });
+    } else {
+        conflated_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void FanoutServer::deliver(Feed& feed) {
+    // Cleared before the copy: a view stored after it posts another delivery
+    feed.pending.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(feed.mutex);
+        if (!feed.has_latest) {
+            return;
+        }
+        feed.current = feed.latest;
+    }
+    feed.has_current = true;
+    for (const auto& client : feed.subscribers) {
+        mark_changed(client, feed);
+    }
+}
+
+void FanoutServer::mark_changed(const std::shared_ptr<Client>& client, Feed& feed) {
+    auto it = client->subscriptions.find(&feed);
+    if (it == client->subscriptions.end()) {
+        return;
+    }
+    if (it->second.queued) {
+        conflated_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    it->second.queued = true;
+    client->changed.push_back(&feed);
+    if (!client->writing && !client->closed) {
+        client->writing = true;
+        net::co_spawn(ioc_, write_loop(client), net::detached);
+    }
+}
+
+void FanoutServer::subscribe(const std::shared_ptr<Client>& client, const std::string& symbol) {
+    Feed& feed = feed_for(lower(symbol));
+    if (client->subscriptions.try_emplace(&feed).second) {
+        feed.subscribers.push_back(client);
+        if (client->binary) {
+            fanout::encode_definition(feed.id, feed.symbol, client->definitions.emplace_back());
+        }
+        mark_changed(client, feed);  // the snapshot, once the feed has a view
+    }
+}
+
+void FanoutServer::unsubscribe(const std::shared_ptr<Client>& client, const std::string& symbol) {
+    Feed& feed = feed_for(lower(symbol));
+    if (client->subscriptions.erase(&feed)) {
+        auto& subscribers = feed.subscribers;
+        subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), client), subscribers.end());
+    }
+}
+
+bool FanoutServer::build_message(Client& client, Feed& feed) {
+    auto it = client.subscriptions.find(&feed);
+    if (it == client.subscriptions.end() || !feed.has_current) {
+        return false;
+    }
+    Client::Subscription& subscription = it->second;
+    const BookView& now = feed.current;
+    fanout::Message& message = client.message;
+    message.bids.clear();
+    message.asks.clear();
+    if (!subscription.has_sent) {
+        message.type = fanout::MessageType::Snapshot;
+        for (uint32_t i = 0; i < now.bid_count; ++i) {
+            message.bids.push_back(fanout::Level{now.bids[i].price, now.bids[i].quantity});
+        }
+        for (uint32_t i = 0; i < now.ask_count; ++i) {
+            message.asks.push_back(fanout::Level{now.asks[i].price, now.asks[i].quantity});
+        }
+    } else {
+        const BookView& before = subscription.sent;
+        message.type = fanout::MessageType::Delta;
+        diff_side(before.bids, before.bid_count, now.bids, now.bid_count,
+                  [](double a, double b) { return a > b; }, message.bids);
+        diff_side(before.asks, before.ask_count, now.asks, now.ask_count,
+                  [](double a, double b) { return a < b; }, message.asks);
+        // Changes below the top only move the update ID; they ride along with the next real change
+        if (message.bids.empty() && message.asks.empty()) {
+            return false;
+        }
+    }
+    message.symbol = feed.symbol;
+    message.sequence = ++subscription.sequence;
+    message.previous_update_id = subscription.has_sent ? subscription.sent.last_update_id : 0;
+    message.update_id = now.last_update_id;
+    subscription.sent = now;
+    subscription.has_sent = true;
+    if (client.binary) {
+        auto local_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        fanout::encode_binary(message, feed.id, local_ns, client.frame);
+    } else {
+        fanout::encode_json(message, client.frame);
+    }
+    return true;
+}
+
+net::awaitable<void> FanoutServer::accept_loop() {
+    for (;;) {
+        boost::system::error_code ec;
+        auto socket = co_await acceptor_.async_accept(redirect(ec));
+        if (ec) {
+            co_return;
+        }
+        socket.set_option(tcp::no_delay(true), ec);
+        net::co_spawn(ioc_, session(std::move(socket)), net::detached);
+    }
+}
+
+net::awaitable<void> FanoutServer::session(tcp::socket socket) {
+    auto client = std::make_shared<Client>(std::move(socket));
+    boost::system::error_code ec;
+    beast::flat_buffer buffer;
+    http::request<http::string_body> req;
+    co_await http::async_read(client->ws.next_layer(), buffer, req, redirect(ec));
+    if (ec || !websocket::is_upgrade(req)) {
+        co_return;
+    }
+    std::string_view target(req.target().data(), req.target().size());
+    client->binary = query_param(target, "format") == "binary";
+    co_await client->ws.async_accept(req, redirect(ec));
+    if (ec) {
+        co_return;
+    }
+    clients_.fetch_add(1, std::memory_order_relaxed);
+
+    std::string_view symbols = query_param(target, "symbols");
+    while (!symbols.empty()) {
+        size_t comma = symbols.find(',');
+        if (comma != 0) {
+            subscribe(client, std::string(symbols.substr(0, comma)));
+        }
+        symbols = comma == std::string_view::npos ? std::string_view() : symbols.substr(comma + 1);
+    }
+
+    // {"method":"SUBSCRIBE","params":["btcusdt"],"id":1}
+    simdjson::dom::parser parser;
+    beast::flat_buffer frame;
+    for (;;) {
+        frame.consume(frame.size());
+        co_await client->ws.async_read(frame, redirect(ec));
+        if (ec) {
+            break;
+        }
+        std::string text = beast::buffers_to_string(frame.data());
+        simdjson::dom::element request;
+        std::string_view method;
+        simdjson::dom::array params;
+        if (parser.parse(text).get(request) || request["method"].get(method) || request["params"].get(params)) {
+            continue;
+        }
+        int64_t id = 0;
+        if (request["id"].get(id)) {
+            id = 0;
+        }
+        for (auto param : params) {
+            std::string_view symbol;
+            if (param.get(symbol)) {
+                continue;
+            }
+            if (method == "SUBSCRIBE") {
+                subscribe(client, std::string(symbol));
+            } else if (method == "UNSUBSCRIBE") {
+                unsubscribe(client, std::string(symbol));
+            }
+        }
+        client->control.push_back("{\"result\":null,\"id\":" + std::to_string(id) + "}");
+        if (!client->writing) {
+            client->writing = true;
+            net::co_spawn(ioc_, write_loop(client), net::detached);
+        }
+    }
+
+    client->closed = true;
+    std::vector<std::string> subscribed;
+    for (const auto& entry : client->subscriptions) {
+        subscribed.push_back(entry.first->symbol);
+    }
+    for (const auto& symbol : subscribed) {
+        unsubscribe(client, symbol);
+    }
+    clients_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+net::awaitable<void> FanoutServer::write_loop(std::shared_ptr<Client> client) {
+    boost::system::error_code ec;
+    while (!ec && !client->closed) {
+        if (!client->control.empty()) {
+            client->frame = std::move(client->control.front());
+            client->control.pop_front();
+            client->ws.text(true);
+        } else if (!client->definitions.empty()) {
+            client->frame = std::move(client->definitions.front());
+            client->definitions.pop_front();
+            client->ws.binary(true);
+        } else if (!client->changed.empty()) {
+            Feed* feed = client->changed.front();
+            client->changed.pop_front();
+            auto it = client->subscriptions.find(feed);
+            if (it == client->subscriptions.end()) {
+                continue;  // unsubscribed while queued
+            }
+            it->second.queued = false;
+            if (!build_message(*client, *feed)) {
+                continue;
+            }
+            client->ws.binary(client->binary);
+        } else {
+            break;
+        }
+        co_await client->ws.async_write(net::buffer(client->frame), redirect(ec));
+        if (!ec) {
+            messages_sent_.fetch_add(1, std::memory_order_relaxed);
+            bytes_sent_.fetch_add(client->frame.size(), std::memory_order_relaxed);
+        }
+    }
+    client->writing = false;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "FanoutProtocol.h"
+#include "OrderbookManager.h"
+#include <boost/asio.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+struct FanoutConfig {
+    std::string address = "127.0.0.1";
+    unsigned short port = 0;  // 0 picks a free port
+};
+
+struct FanoutStats {
+    uint64_t clients = 0;           // connected now
+    uint64_t updates = 0;           // book views received from the feed
+    uint64_t messages_sent = 0;
+    uint64_t bytes_sent = 0;
+    uint64_t conflated = 0;         // updates merged into one not yet delivered, or not yet sent to a client
+};
+
+// Republishes book tops to local consumers over WebSocket, so many internal processes
+// share one exchange connection. Consumers connect to ws://address:port/?format=json
+// (the default) or ?format=binary, optionally with &symbols=btcusdt,ethusdt, and
+// subscribe or unsubscribe with {"method":"SUBSCRIBE","params":["btcusdt"],"id":1}.
+// Each subscription gets a snapshot and then deltas, see FanoutProtocol.h.
+//
+// on_book() is the only call the feed threads make: it copies the view and wakes the
+// server thread at most once per pending symbol. Every consumer has its own queue of
+// changed symbols with at most one entry per symbol, so a consumer that cannot keep up
+// gets conflated deltas and never holds back the feed or other consumers.
+class FanoutServer {
+public:
+    // Binds and starts serving; throws if the port cannot be bound
+    explicit FanoutServer(const FanoutConfig& config);
+    ~FanoutServer();
+
+    FanoutServer(const FanoutServer&) = delete;
+    FanoutServer& operator=(const FanoutServer&) = delete;
+
+    // From any thread, e.g. as OrderbookManager's view listener
+    void on_book(const std::string& symbol, const BookView& view);
+
+    unsigned short port() const { return port_; }
+    FanoutStats stats() const;
+
+private:
+    struct Feed;
+    struct Client;
+
+    FanoutConfig config_;
+    boost::asio::io_context ioc_;
+    boost::asio::ip::tcp::acceptor acceptor_;
+    unsigned short port_ = 0;
+
+    // Feeds are created by on_book or a subscription and live as long as the server
+    mutable std::shared_mutex feeds_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<Feed>> feeds_;
+
+    std::atomic<uint64_t> clients_{0};
+    std::atomic<uint64_t> updates_{0};
+    std::atomic<uint64_t> messages_sent_{0};
+    std::atomic<uint64_t> bytes_sent_{0};
+    std::atomic<uint64_t> conflated_{0};
+    std::thread thread_;
+
+    Feed& feed_for(const std::string& symbol);
+    boost::asio::awaitable<void> accept_loop();
+    boost::asio::awaitable<void> session(boost::asio::ip::tcp::socket socket);
+    boost::asio::awaitable<void> write_loop(std::shared_ptr<Client> client);
+    // Server thread: takes the feed's latest view and queues it for its subscribers
+    void deliver(Feed& feed);
+    void subscribe(const std::shared_ptr<Client>& client, const std::string& symbol);
+    void unsubscribe(const std::shared_ptr<Client>& client, const std::string& symbol);
+    void mark_changed(const std::shared_ptr<Client>& client, Feed& feed);
+    // Builds the client's next message for a feed; false if nothing changed since the last one
+    bool build_message(Client& client, Feed& feed);
+};
@@ -0,0 +1,194 @@
+#include "HugePageArena.h"
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+std::array<std::atomic<HugePageArena*>, ARENA_KIND_COUNT> g_arenas{};
+
+size_t round_up(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+void* map_anonymous(size_t size, int extra_flags) {
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+}  // namespace
+
+HugePageArena::HugePageArena(ArenaKind kind, const ArenaOptions& options) : kind_(kind) {
+    reserve(options);
+}
+
+HugePageArena::~HugePageArena() {
+    if (base_) {
+        munmap(base_, size_);
+    }
+}
+
+void HugePageArena::reserve(const ArenaOptions& options) {
+    if (options.bytes == 0) {
+        return;
+    }
+    const size_t size = round_up(options.bytes, HUGE_PAGE_SIZE);
+    const bool prefault = options.prefault || options.lock;
+
+#ifdef MAP_HUGETLB
+    if (options.explicit_pages) {
+        int flags = MAP_HUGETLB | (prefault ? MAP_POPULATE : 0);
+#ifdef MAP_HUGE_2MB
+        flags |= MAP_HUGE_2MB;
+#endif
+        // Fails unless vm.nr_hugepages has enough free pages for the whole arena
+        if (void* p = map_anonymous(size, flags)) {
+            base_ = static_cast<char*>(p);
+            size_ = size;
+            backing_ = Backing::ExplicitHugePages;
+            prefaulted_ = prefault;
+        }
+    }
+#endif
+
+    if (!base_) {
+        // Over-map by one huge page and trim both ends, so the arena starts on a 2MB
+        // boundary and the kernel can back it with huge pages from the first byte
+        void* p = map_anonymous(size + HUGE_PAGE_SIZE, 0);
+        if (!p) {
+            return;
+        }
+        const auto raw = reinterpret_cast<uintptr_t>(p);
+        const auto aligned = round_up(raw, HUGE_PAGE_SIZE);
+        const size_t head = aligned - raw;
+        const size_t tail = HUGE_PAGE_SIZE - head;
+        if (head > 0) {
+            munmap(p, head);
+        }
+        if (tail > 0) {
+            munmap(reinterpret_cast<void*>(aligned + size), tail);
+        }
+        base_ = reinterpret_cast<char*>(aligned);
+        size_ = size;
+        backing_ = Backing::NormalPages;
+#ifdef MADV_HUGEPAGE
+        if (options.transparent && madvise(base_, size_, MADV_HUGEPAGE) == 0) {
+            backing_ = Backing::TransparentHugePages;
+        }
+#endif
+        if (prefault) {
+            // Writes, not reads: a read fault maps the shared zero page and would fault again
+            const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            for (size_t off = 0; off < size_; off += page) {
+                static_cast<volatile char*>(base_)[off] = 0;
+            }
+            prefaulted_ = true;
+        }
+    }
+
+    if (options.lock) {
+        // Typically fails under the default RLIMIT_MEMLOCK; the arena works either way
+        locked_ = mlock(base_, size_) == 0;
+    }
+}
+
+void* HugePageArena::allocate(size_t size, size_t alignment) {
+    size_t offset = offset_.load(std::memory_order_relaxed);
+    for (;;) {
+        const size_t start = round_up(reinterpret_cast<uintptr_t>(base_) + offset, alignment) -
+                             reinterpret_cast<uintptr_t>(base_);
+        if (start > size_ || size > size_ - start) {
+            return nullptr;
+        }
+        if (offset_.compare_exchange_weak(offset, start + size, std::memory_order_relaxed)) {
+            return base_ + start;
+        }
+    }
+}
+
+bool HugePageArena::contains(const void* p) const {
+    const auto* c = static_cast<const char*>(p);
+    return base_ && c >= base_ && c < base_ + size_;
+}
+
+HugePageArena::Stats HugePageArena::stats() const {
+    Stats stats;
+    stats.kind = kind_;
+    stats.backing = backing_;
+    stats.reserved = size_;
+    stats.used = offset_.load(std::memory_order_relaxed);
+    stats.freed = freed_.load(std::memory_order_relaxed);
+    stats.heap_fallbacks = heap_fallbacks_.load(std::memory_order_relaxed);
+    stats.prefaulted = prefaulted_;
+    stats.locked = locked_;
+    return stats;
+}
+
+HugePageArena& HugePageArena::configure(ArenaKind kind, const ArenaOptions& options) {
+    auto& slot = g_arenas[static_cast<size_t>(kind)];
+    // Never destroyed: blocks carved from it may be freed from static destructors
+    auto* arena = new HugePageArena(kind, options);
+    HugePageArena* expected = nullptr;
+    if (!slot.compare_exchange_strong(expected, arena, std::memory_order_acq_rel)) {
+        delete arena;
+        throw std::runtime_error(std::string("Arena already configured: ") + kind_name(kind));
+    }
+    return *arena;
+}
+
+HugePageArena* HugePageArena::get(ArenaKind kind) {
+    return g_arenas[static_cast<size_t>(kind)].load(std::memory_order_acquire);
+}
+
+void* HugePageArena::allocate_from(ArenaKind kind, size_t size, size_t alignment) {
+    if (HugePageArena* arena = get(kind)) {
+        if (void* p = arena->allocate(size, alignment)) {
+            return p;
+        }
+        arena->heap_fallbacks_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return ::operator new(size, std::align_val_t(alignment));
+}
+
+void HugePageArena::deallocate_from(ArenaKind kind, void* p, size_t size, size_t alignment) {
+    if (p == nullptr) {
+        return;
+    }
+    if (HugePageArena* arena = get(kind); arena && arena->contains(p)) {
+        arena->freed_.fetch_add(size, std::memory_order_relaxed);
+        return;
+    }
+    ::operator delete(p, size, std::align_val_t(alignment));
+}
+
+std::vector<HugePageArena::Stats> HugePageArena::report() {
+    std::vector<Stats> stats;
+    for (auto& slot : g_arenas) {
+        if (HugePageArena* arena = slot.load(std::memory_order_acquire)) {
+            stats.push_back(arena->stats());
+        }
+    }
+    return stats;
+}
+
+const char* HugePageArena::kind_name(ArenaKind kind) {
+    switch (kind) {
+        case ArenaKind::Slabs: return "slabs";
+        case ArenaKind::Rings: return "rings";
+        case ArenaKind::Buffers: return "buffers";
+    }
+    return "unknown";
+}
+
+const char* HugePageArena::backing_name(Backing backing) {
+    switch (backing) {
+        case Backing::ExplicitHugePages: return "2MB huge pages";
+        case Backing::TransparentHugePages: return "transparent huge pages";
+        case Backing::NormalPages: return "normal pages";
+        case Backing::None: break;
+    }
+    return "none";
+}
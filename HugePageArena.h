@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// What each process-wide arena holds
+enum class ArenaKind {
+    Slabs,    // SlabAllocator slabs: book levels, published book views, queue nodes, handlers
+    Rings,    // SpscMailbox and LockFreePriorityQueue cells
+    Buffers,  // io_uring receive buffers
+};
+
+constexpr size_t ARENA_KIND_COUNT = 3;
+
+struct ArenaOptions {
+    size_t bytes = 0;              // rounded up to HUGE_PAGE_SIZE
+    bool explicit_pages = true;    // try MAP_HUGETLB from the preallocated 2MB pool first
+    bool transparent = true;       // then a 2MB-aligned mapping advised MADV_HUGEPAGE
+    bool prefault = false;         // touch every page at reservation
+    bool lock = false;             // mlock the whole arena (implies prefault)
+};
+
+// A range of memory reserved once at startup and carved by a bump pointer, so the hot
+// structures carved from it share a few 2MB TLB entries instead of hundreds of 4K ones.
+// Reservation tries explicit huge pages, then transparent huge pages, then normal pages;
+// if even that fails the arena stays empty and every allocation returns nullptr, so
+// callers fall back to the heap. Pre-faulting and mlock are best effort, see stats().
+//
+// Space is never reused: freed blocks are only counted. The arenas are meant for
+// structures built at startup that live until exit.
+class HugePageArena {
+public:
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    enum class Backing { None, ExplicitHugePages, TransparentHugePages, NormalPages };
+
+    struct Stats {
+        ArenaKind kind = ArenaKind::Slabs;
+        Backing backing = Backing::None;
+        size_t reserved = 0;
+        size_t used = 0;             // carved out, including alignment padding
+        size_t freed = 0;            // handed back, not reusable
+        uint64_t heap_fallbacks = 0; // requests that did not fit and went to the heap
+        bool prefaulted = false;
+        bool locked = false;
+    };
+
+    HugePageArena(ArenaKind kind, const ArenaOptions& options);
+    ~HugePageArena();
+
+    HugePageArena(const HugePageArena&) = delete;
+    HugePageArena& operator=(const HugePageArena&) = delete;
+
+    // Thread safe. alignment must be a power of two. Returns nullptr when full.
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    bool contains(const void* p) const;
+    Stats stats() const;
+
+    // Sets up the process-wide arena of a kind. Call once per kind, before the structures
+    // it backs are built; throws std::runtime_error if the kind is already configured.
+    static HugePageArena& configure(ArenaKind kind, const ArenaOptions& options);
+    // nullptr until configured
+    static HugePageArena* get(ArenaKind kind);
+
+    // From the configured arena of a kind, or the heap if there is none or it is full
+    static void* allocate_from(ArenaKind kind, size_t size, size_t alignment);
+    static void deallocate_from(ArenaKind kind, void* p, size_t size, size_t alignment);
+
+    // One entry per configured arena
+    static std::vector<Stats> report();
+    static const char* kind_name(ArenaKind kind);
+    static const char* backing_name(Backing backing);
+
+private:
+    ArenaKind kind_;
+    Backing backing_ = Backing::None;
+    char* base_ = nullptr;
+    size_t size_ = 0;
+    bool prefaulted_ = false;
+    bool locked_ = false;
+    std::atomic<size_t> offset_{0};
+    std::atomic<size_t> freed_{0};
+    std::atomic<uint64_t> heap_fallbacks_{0};
+
+    void reserve(const ArenaOptions& options);
+};
+
+// Fixed array of default-constructed T carved from an arena, for ring storage
+template<typename T>
+class ArenaArray {
+public:
+    ArenaArray() = default;
+    ArenaArray(ArenaKind kind, size_t count) : kind_(kind), count_(count) {
+        data_ = static_cast<T*>(HugePageArena::allocate_from(kind, sizeof(T) * count, alignof(T)));
+        size_t built = 0;
+        try {
+            for (; built < count; ++built) {
+                ::new (data_ + built) T();
+            }
+        } catch (...) {
+            std::destroy_n(data_, built);
+            HugePageArena::deallocate_from(kind_, data_, sizeof(T) * count_, alignof(T));
+            throw;
+        }
+    }
+
+    ~ArenaArray() { reset(); }
+
+    ArenaArray(ArenaArray&& other) noexcept
+        : kind_(other.kind_), data_(std::exchange(other.data_, nullptr)), count_(std::exchange(other.count_, 0)) {}
+    ArenaArray& operator=(ArenaArray&& other) noexcept {
+        if (this != &other) {
+            reset();
+            kind_ = other.kind_;
+            data_ = std::exchange(other.data_, nullptr);
+            count_ = std::exchange(other.count_, 0);
+        }
+        return *this;
+    }
+
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    size_t size() const { return count_; }
+
+private:
+    ArenaKind kind_ = ArenaKind::Rings;
+    T* data_ = nullptr;
+    size_t count_ = 0;
+
+    void reset() {
+        if (data_) {
+            std::destroy_n(data_, count_);
+            HugePageArena::deallocate_from(kind_, data_, sizeof(T) * count_, alignof(T));
+            data_ = nullptr;
+            count_ = 0;
+        }
+    }
+};
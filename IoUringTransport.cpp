@@ -0,0 +1,723 @@
+#include "IoUringTransport.h"
+#include "MessageProcessor.h"
+#include <spdlog/spdlog.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint64_t kRecvTag = 1ULL << 56;
+constexpr uint64_t kSendTag = 2ULL << 56;
+constexpr uint64_t kTagMask = 0xFFULL << 56;
+// Receives carry the slot's generation between the tag and the connection ID
+constexpr int kGenerationShift = 32;
+constexpr uint64_t kGenerationMask = 0xFFFFFFULL;
+constexpr uint64_t kConnMask = 0xFFFFFFFFULL;
+constexpr uint16_t kBufferGroup = 0;
+
+template <typename T>
+T load_acquire(const T* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+template <typename T>
+void store_release(T* p, T v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+int sys_io_uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int sys_io_uring_register(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+void* map_ring(size_t size, int fd, off_t offset) {
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+} // namespace
+
+IoUringTransport::IoUringTransport(const IoUringConfig& config) : config_(config) {
+    if (config_.buffer_count == 0 || (config_.buffer_count & (config_.buffer_count - 1)) != 0 ||
+        config_.buffer_count > 32768) {
+        throw std::invalid_argument("IoUringTransport buffer_count must be a power of two <= 32768");
+    }
+    try {
+        setup_ring();
+        setup_buffer_ring();
+    } catch (...) {
+        teardown();
+        throw;
+    }
+}
+
+IoUringTransport::~IoUringTransport() {
+    detach();
+    teardown();
+}
+
+bool IoUringTransport::is_supported() {
+    io_uring_params params{};
+    int fd = sys_io_uring_setup(4, &params);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    return (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+}
+
+void IoUringTransport::setup_ring() {
+    io_uring_params params{};
+    unsigned base_flags = 0;
+    if (config_.sqpoll) {
+        base_flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = config_.sqpoll_idle_ms;
+        if (config_.sqpoll_cpu >= 0) {
+            base_flags |= IORING_SETUP_SQ_AFF;
+            params.sq_thread_cpu = static_cast<unsigned>(config_.sqpoll_cpu);
+        }
+    }
+
+    // Single issuer + cooperative task running avoid IPIs on newer kernels; retry without them otherwise
+    bool cooperative = config_.single_issuer && !config_.sqpoll;
+    params.flags = base_flags | (cooperative ? IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN : 0);
+    unsigned sq_thread_idle = params.sq_thread_idle;
+    unsigned sq_thread_cpu = params.sq_thread_cpu;
+    ring_fd_ = sys_io_uring_setup(config_.entries, &params);
+    if (ring_fd_ < 0 && errno == EINVAL) {
+        params = io_uring_params{};
+        params.flags = base_flags;
+        params.sq_thread_idle = sq_thread_idle;
+        params.sq_thread_cpu = sq_thread_cpu;
+        ring_fd_ = sys_io_uring_setup(config_.entries, &params);
+    }
+    if (ring_fd_ < 0) {
+        throw std::runtime_error(std::string("io_uring_setup failed: ") + std::strerror(errno));
+    }
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        throw std::runtime_error("io_uring kernel support is too old (no IORING_FEAT_SINGLE_MMAP)");
+    }
+
+    sq_ring_size_ = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                             params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    sq_ring_ = map_ring(sq_ring_size_, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == nullptr) {
+        throw std::runtime_error("Failed to map io_uring rings");
+    }
+    cq_ring_ = sq_ring_;
+    cq_ring_size_ = 0;  // shared with the SQ mapping
+
+    auto* sq = static_cast<char*>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_flags_ = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sqe_tail_ = sqe_submitted_ = *sq_tail_;
+
+    auto* cq = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(map_ring(sqes_size_, ring_fd_, IORING_OFF_SQES));
+    if (sqes_ == nullptr) {
+        throw std::runtime_error("Failed to map io_uring SQEs");
+    }
+}
+
+void IoUringTransport::setup_buffer_ring() {
+    buf_mask_ = config_.buffer_count - 1;
+    buf_ring_size_ = config_.buffer_count * sizeof(io_uring_buf);
+    void* ring = mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+        throw std::runtime_error("Failed to allocate provided buffer ring");
+    }
+    buf_ring_ = static_cast<io_uring_buf*>(ring);
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = config_.buffer_count;
+    reg.bgid = kBufferGroup;
+    if (sys_io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        throw std::runtime_error(std::string("Failed to register provided buffer ring: ") + std::strerror(errno));
+    }
+
+    buffers_ = ArenaArray<char>(ArenaKind::Buffers, static_cast<size_t>(config_.buffer_count) * config_.buffer_size);
+    for (unsigned bid = 0; bid < config_.buffer_count; ++bid) {
+        recycle_buffer(static_cast<uint16_t>(bid));
+    }
+    publish_buffers();
+}
+
+void IoUringTransport::teardown() {
+    if (buf_ring_ != nullptr) {
+        munmap(buf_ring_, buf_ring_size_);
+        buf_ring_ = nullptr;
+    }
+    if (sqes_ != nullptr) {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if (sq_ring_ != nullptr) {
+        munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = nullptr;
+    }
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+        ring_fd_ = -1;
+    }
+}
+
+io_uring_sqe* IoUringTransport::get_sqe() {
+    if (sqe_tail_ - load_acquire(sq_head_) >= sq_entries_) {
+        // SQ full: push what we have to the kernel before queueing more
+        flush_sq();
+        enter(sqe_tail_ - sqe_submitted_, 0, 0);
+        sqe_submitted_ = sqe_tail_;
+    }
+    unsigned index = sqe_tail_ & sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    ++sqe_tail_;
+    return sqe;
+}
+
+void IoUringTransport::flush_sq() {
+    store_release(sq_tail_, sqe_tail_);
+}
+
+int IoUringTransport::enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    ++stats_.enter_calls;
+    int ret = sys_io_uring_enter(ring_fd_, to_submit, min_complete, flags);
+    if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        spdlog::error("io_uring_enter failed: {}", std::strerror(errno));
+    }
+    return ret;
+}
+
+void IoUringTransport::recycle_buffer(uint16_t bid) {
+    io_uring_buf* buf = &buf_ring_[buf_tail_ & buf_mask_];
+    buf->addr = reinterpret_cast<uint64_t>(buffers_.data() + static_cast<size_t>(bid) * config_.buffer_size);
+    buf->len = config_.buffer_size;
+    buf->bid = bid;
+    ++buf_tail_;
+}
+
+void IoUringTransport::publish_buffers() {
+    // The ring tail overlays the resv field of the first entry
+    auto* tail = reinterpret_cast<uint16_t*>(reinterpret_cast<char*>(buf_ring_) + offsetof(io_uring_buf, resv));
+    store_release(tail, buf_tail_);
+}
+
+uint32_t IoUringTransport::add_connection(int fd, DataHandler on_data, CloseHandler on_close) {
+    uint32_t conn_id = 0;
+    while (conn_id < connections_.size() && connections_[conn_id].active) {
+        ++conn_id;
+    }
+    if (conn_id == connections_.size()) {
+        connections_.emplace_back();
+    }
+    Connection& conn = connections_[conn_id];
+    conn.fd = fd;
+    conn.active = true;
+    conn.generation = (conn.generation + 1) & kGenerationMask;
+    conn.on_data = std::move(on_data);
+    conn.on_close = std::move(on_close);
+    drop_queued_sends(conn);
+    arm_receive(conn_id);
+    return conn_id;
+}
+
+void IoUringTransport::remove_connection(uint32_t conn_id) {
+    if (conn_id >= connections_.size() || !connections_[conn_id].active) {
+        return;
+    }
+    connections_[conn_id].active = false;
+    drop_queued_sends(connections_[conn_id]);
+    // Completes the outstanding multishot receive with EOF
+    shutdown(connections_[conn_id].fd, SHUT_RDWR);
+}
+
+void IoUringTransport::send(uint32_t conn_id, std::string data) {
+    if (conn_id >= connections_.size() || !connections_[conn_id].active) {
+        return;
+    }
+    Connection& conn = connections_[conn_id];
+    uint64_t send_id = next_send_id_++ & ~kTagMask;
+    PendingSend& pending = pending_sends_[send_id];
+    pending.data = std::move(data);
+    pending.conn_id = conn_id;
+    pending.generation = conn.generation;
+    conn.sends.push_back(send_id);
+    // Two sends in flight on one socket could interleave after a short send
+    if (conn.sends.size() == 1) {
+        submit_send(send_id);
+    }
+}
+
+void IoUringTransport::submit_send(uint64_t send_id) {
+    const PendingSend& pending = pending_sends_.at(send_id);
+    io_uring_sqe* sqe = get_sqe();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = connections_[pending.conn_id].fd;
+    sqe->addr = reinterpret_cast<uint64_t>(pending.data.data() + pending.offset);
+    sqe->len = static_cast<uint32_t>(pending.data.size() - pending.offset);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = kSendTag | send_id;
+}
+
+void IoUringTransport::handle_send_completion(uint64_t send_id, int res) {
+    auto it = pending_sends_.find(send_id);
+    if (it == pending_sends_.end()) {
+        return;
+    }
+    PendingSend& pending = it->second;
+    Connection* conn = nullptr;
+    if (pending.conn_id < connections_.size() && connections_[pending.conn_id].active &&
+        connections_[pending.conn_id].generation == pending.generation) {
+        conn = &connections_[pending.conn_id];
+    }
+    if (res <= 0) {
+        spdlog::warn("io_uring send failed: {}", res == 0 ? "nothing sent" : std::strerror(-res));
+    } else {
+        pending.offset += static_cast<size_t>(res);
+        stats_.bytes_sent += static_cast<uint64_t>(res);
+        if (conn && pending.offset < pending.data.size()) {
+            ++stats_.short_sends;
+            submit_send(send_id);
+            return;
+        }
+    }
+    pending_sends_.erase(it);
+    if (conn) {
+        conn->sends.pop_front();
+        if (!conn->sends.empty()) {
+            submit_send(conn->sends.front());
+        }
+    }
+}
+
+void IoUringTransport::drop_queued_sends(Connection& conn) {
+    // The front one is in flight: its completion still needs the bytes and frees them
+    for (size_t i = 1; i < conn.sends.size(); ++i) {
+        pending_sends_.erase(conn.sends[i]);
+    }
+    conn.sends.clear();
+}
+
+void IoUringTransport::arm_receive(uint32_t conn_id) {
+    io_uring_sqe* sqe = get_sqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = connections_[conn_id].fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = kRecvTag | (uint64_t{connections_[conn_id].generation} << kGenerationShift) | conn_id;
+}
+
+size_t IoUringTransport::poll(bool wait) {
+    flush_sq();
+
+    unsigned to_submit = 0;
+    unsigned flags = 0;
+    bool need_enter = false;
+    if (config_.sqpoll) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (load_acquire(sq_flags_) & IORING_SQ_NEED_WAKEUP) {
+            flags |= IORING_ENTER_SQ_WAKEUP;
+            need_enter = true;
+        }
+    } else {
+        to_submit = sqe_tail_ - sqe_submitted_;
+        need_enter = to_submit > 0;
+    }
+    if (wait && load_acquire(cq_tail_) == *cq_head_) {
+        flags |= IORING_ENTER_GETEVENTS;
+        need_enter = true;
+    }
+    if (need_enter) {
+        enter(to_submit, (flags & IORING_ENTER_GETEVENTS) ? 1 : 0, flags);
+    }
+    sqe_submitted_ = sqe_tail_;
+
+    size_t handled = 0;
+    unsigned head = *cq_head_;
+    unsigned tail = load_acquire(cq_tail_);
+    while (head != tail) {
+        handle_completion(cqes_[head & cq_mask_]);
+        ++head;
+        ++handled;
+        if (head == tail) {
+            // Release the slots before re-reading so the kernel can keep posting
+            store_release(cq_head_, head);
+            tail = load_acquire(cq_tail_);
+        }
+    }
+    store_release(cq_head_, head);
+    publish_buffers();
+    stats_.completions += handled;
+    return handled;
+}
+
+void IoUringTransport::run(const std::atomic<bool>& running) {
+    while (running.load(std::memory_order_relaxed)) {
+        poll(true);
+    }
+}
+
+void IoUringTransport::attach(EventLoop& loop) {
+    wake_descriptor_ = std::make_unique<boost::asio::posix::stream_descriptor>(loop.get_io_context(), ring_fd_);
+    loop.add_poller([this]() {
+        size_t handled = poll(false);
+        // Armed only with the CQ drained: the fd stays readable until then, so a wait
+        // re-armed from its own handler would complete again inside the same io_context poll
+        if (!wakeup_armed_ && wake_descriptor_) {
+            arm_wakeup();
+        }
+        return handled;
+    });
+}
+
+void IoUringTransport::detach() {
+    if (wake_descriptor_) {
+        wake_descriptor_->release();  // the ring fd stays ours
+        wake_descriptor_.reset();
+        wakeup_armed_ = false;
+    }
+}
+
+void IoUringTransport::arm_wakeup() {
+    // Only ends a park; the loop's poller reaps the completions and re-arms on the same pass
+    wakeup_armed_ = true;
+    wake_descriptor_->async_wait(boost::asio::posix::stream_descriptor::wait_read,
+        [this](const boost::system::error_code&) { wakeup_armed_ = false; });
+}
+
+void IoUringTransport::handle_completion(const io_uring_cqe& cqe) {
+    uint64_t tag = cqe.user_data & kTagMask;
+    uint64_t id = cqe.user_data & ~kTagMask;
+
+    if (tag == kSendTag) {
+        handle_send_completion(id, cqe.res);
+        return;
+    }
+    uint64_t generation = (id >> kGenerationShift) & kGenerationMask;
+    id &= kConnMask;
+    if (tag != kRecvTag || id >= connections_.size()) {
+        return;
+    }
+
+    Connection& conn = connections_[id];
+    if (generation != conn.generation) {
+        // A receive of the slot's previous connection: only its buffer matters now
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            recycle_buffer(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+        }
+        return;
+    }
+    if (cqe.res > 0) {
+        uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        if (conn.active) {
+            ++stats_.receives;
+            stats_.bytes_received += static_cast<uint64_t>(cqe.res);
+            conn.on_data(buffers_.data() + static_cast<size_t>(bid) * config_.buffer_size,
+                         static_cast<size_t>(cqe.res));
+        }
+        recycle_buffer(bid);
+        if (!(cqe.flags & IORING_CQE_F_MORE) && conn.active) {
+            ++stats_.recv_rearms;
+            arm_receive(static_cast<uint32_t>(id));
+        }
+        return;
+    }
+
+    if (cqe.res == -ENOBUFS && conn.active) {
+        // Ran out of provided buffers; they are republished at the end of this poll
+        ++stats_.recv_rearms;
+        arm_receive(static_cast<uint32_t>(id));
+        return;
+    }
+
+    bool was_active = conn.active;
+    conn.active = false;
+    drop_queued_sends(conn);
+    if (was_active && conn.on_close) {
+        conn.on_close(cqe.res == 0 ? 0 : -cqe.res);
+    }
+}
+
+IoUringWebSocketFeed::IoUringWebSocketFeed(IoUringTransport& transport, const std::string& host, const std::string& port,
+                                           const std::string& path, MessageProcessor& message_processor)
+    : transport_(transport), host_(host), port_(port), path_(path), message_processor_(message_processor) {}
+
+IoUringWebSocketFeed::~IoUringWebSocketFeed() {
+    stop();
+}
+
+namespace {
+
+std::string base64(const unsigned char* data, size_t len) {
+    std::string out(4 * ((len + 2) / 3), '\0');
+    int written = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(out.data()), data, static_cast<int>(len));
+    out.resize(static_cast<size_t>(written));
+    return out;
+}
+
+// RFC 6455 4.1: 16 random bytes, base64
+std::string websocket_key() {
+    unsigned char nonce[16];
+    if (RAND_bytes(nonce, sizeof(nonce)) != 1) {
+        std::random_device device;
+        for (auto& byte : nonce) {
+            byte = static_cast<unsigned char>(device());
+        }
+    }
+    return base64(nonce, sizeof(nonce));
+}
+
+// What the server must answer in Sec-WebSocket-Accept for key
+std::string websocket_accept(const std::string& key) {
+    std::string input = key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_len = 0;
+    EVP_Digest(input.data(), input.size(), digest, &digest_len, EVP_sha1(), nullptr);
+    return base64(digest, digest_len);
+}
+
+// Value of a response header, matched case-insensitively; empty if absent
+std::string header_value(const std::string& headers, const std::string& name) {
+    size_t line = headers.find("\r\n");
+    while (line != std::string::npos && line + 2 < headers.size()) {
+        size_t begin = line + 2;
+        size_t end = headers.find("\r\n", begin);
+        if (end == std::string::npos) {
+            end = headers.size();
+        }
+        size_t colon = headers.find(':', begin);
+        if (colon < end && colon - begin == name.size() &&
+            std::equal(name.begin(), name.end(), headers.begin() + static_cast<std::ptrdiff_t>(begin),
+                       [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) ==
+                                                   std::tolower(static_cast<unsigned char>(b)); })) {
+            size_t value = headers.find_first_not_of(" \t", colon + 1);
+            size_t value_end = headers.find_last_not_of(" \t", end - 1);
+            return value < end ? headers.substr(value, value_end + 1 - value) : std::string();
+        }
+        line = end;
+    }
+    return std::string();
+}
+
+constexpr size_t kMaxUpgradeResponse = 16384;
+
+}  // namespace
+
+struct IoUringWebSocketFeed::Handshake {
+    explicit Handshake(boost::asio::io_context& ioc) : resolver(ioc), socket(ioc), deadline(ioc) {}
+
+    boost::asio::ip::tcp::resolver resolver;
+    boost::asio::ip::tcp::socket socket;
+    boost::asio::steady_timer deadline;
+    std::string key;
+    std::string request;
+    std::string response;
+    std::array<char, 4096> chunk;
+    ConnectHandler done;
+    // Set once it succeeded, failed or was stopped; handlers that run later touch nothing else
+    bool finished = false;
+};
+
+void IoUringWebSocketFeed::connect(boost::asio::io_context& ioc, std::chrono::milliseconds timeout, ConnectHandler done) {
+    auto handshake = std::make_shared<Handshake>(ioc);
+    handshake->done = std::move(done);
+    handshake->key = websocket_key();
+    handshake_ = handshake;
+
+    handshake->deadline.expires_after(timeout);
+    handshake->deadline.async_wait([this, handshake](const boost::system::error_code& ec) {
+        if (!ec && !handshake->finished) {
+            fail_handshake(handshake, "timed out");
+        }
+    });
+    handshake->resolver.async_resolve(host_, port_,
+        [this, handshake](const boost::system::error_code& ec, boost::asio::ip::tcp::resolver::results_type results) {
+            if (handshake->finished) return;
+            if (ec) return fail_handshake(handshake, "cannot resolve: " + ec.message());
+            boost::asio::async_connect(handshake->socket, results,
+                [this, handshake](const boost::system::error_code& ec, const boost::asio::ip::tcp::endpoint&) {
+                    if (handshake->finished) return;
+                    if (ec) return fail_handshake(handshake, "cannot connect: " + ec.message());
+                    boost::system::error_code ignored;
+                    handshake->socket.set_option(boost::asio::ip::tcp::no_delay(true), ignored);
+                    handshake->request = "GET " + path_ + " HTTP/1.1\r\n"
+                                         "Host: " + host_ + ":" + port_ + "\r\n"
+                                         "Upgrade: websocket\r\n"
+                                         "Connection: Upgrade\r\n"
+                                         "Sec-WebSocket-Key: " + handshake->key + "\r\n"
+                                         "Sec-WebSocket-Version: 13\r\n\r\n";
+                    boost::asio::async_write(handshake->socket, boost::asio::buffer(handshake->request),
+                        [this, handshake](const boost::system::error_code& ec, size_t) {
+                            if (handshake->finished) return;
+                            if (ec) return fail_handshake(handshake, "upgrade request failed: " + ec.message());
+                            read_upgrade_response(handshake);
+                        });
+                });
+        });
+}
+
+void IoUringWebSocketFeed::read_upgrade_response(const std::shared_ptr<Handshake>& handshake) {
+    handshake->socket.async_read_some(boost::asio::buffer(handshake->chunk),
+        [this, handshake](const boost::system::error_code& ec, size_t bytes) {
+            if (handshake->finished) return;
+            if (ec) return fail_handshake(handshake, "upgrade response failed: " + ec.message());
+            handshake->response.append(handshake->chunk.data(), bytes);
+            size_t header_end = handshake->response.find("\r\n\r\n");
+            if (header_end == std::string::npos) {
+                if (handshake->response.size() > kMaxUpgradeResponse) {
+                    return fail_handshake(handshake, "upgrade response too large");
+                }
+                return read_upgrade_response(handshake);
+            }
+            std::string headers = handshake->response.substr(0, header_end);
+            if (headers.compare(0, 12, "HTTP/1.1 101") != 0) {
+                return fail_handshake(handshake, "upgrade rejected: " + headers.substr(0, headers.find("\r\n")));
+            }
+            if (header_value(headers, "Sec-WebSocket-Accept") != websocket_accept(handshake->key)) {
+                return fail_handshake(handshake, "upgrade answered with the wrong Sec-WebSocket-Accept");
+            }
+            complete_handshake(handshake, header_end + 4);
+        });
+}
+
+void IoUringWebSocketFeed::complete_handshake(const std::shared_ptr<Handshake>& handshake, size_t body_offset) {
+    handshake->finished = true;
+    handshake->deadline.cancel();
+    handshake_.reset();
+    // The ring owns the socket from here; Asio gives up its copy (release() needs Boost 1.75)
+    fd_ = dup(handshake->socket.native_handle());
+    boost::system::error_code ignored;
+    handshake->socket.close(ignored);
+    if (fd_ < 0) {
+        spdlog::error("io_uring feed {}:{}{}: dup failed: {}", host_, port_, path_, std::strerror(errno));
+        handshake->done(false);
+        return;
+    }
+
+    is_connected_ = true;
+    registered_ = true;
+    conn_id_ = transport_.add_connection(fd_,
+        [this](const char* data, size_t len) { on_data(data, len); },
+        [this](int error) {
+            registered_ = false;  // the transport may hand the slot to another connection
+            if (error != 0) {
+                spdlog::warn("io_uring feed {}{} closed: {}", host_, path_, std::strerror(error));
+            }
+            closed();
+        });
+    ConnectHandler done = std::move(handshake->done);
+    done(true);
+    // Frames may already have arrived behind the upgrade response
+    if (is_connected_ && handshake->response.size() > body_offset) {
+        on_data(handshake->response.data() + body_offset, handshake->response.size() - body_offset);
+    }
+}
+
+void IoUringWebSocketFeed::fail_handshake(const std::shared_ptr<Handshake>& handshake, const std::string& reason) {
+    spdlog::error("io_uring feed {}:{}{}: {}", host_, port_, path_, reason);
+    handshake->finished = true;
+    handshake->deadline.cancel();
+    handshake->resolver.cancel();
+    boost::system::error_code ignored;
+    handshake->socket.close(ignored);
+    handshake_.reset();
+    ConnectHandler done = std::move(handshake->done);
+    done(false);
+}
+
+void IoUringWebSocketFeed::stop() {
+    is_connected_ = false;
+    if (handshake_) {
+        // Its handlers still run, with operation_aborted, but see it finished
+        handshake_->finished = true;
+        handshake_->deadline.cancel();
+        handshake_->resolver.cancel();
+        boost::system::error_code ignored;
+        handshake_->socket.close(ignored);
+        handshake_.reset();
+    }
+    if (registered_) {
+        registered_ = false;
+        transport_.remove_connection(conn_id_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+void IoUringWebSocketFeed::send_text(const std::string& message) {
+    static thread_local std::mt19937 mask_gen{std::random_device{}()};
+    transport_.send(conn_id_, WebSocketFrameDecoder::encode_client_frame(WebSocketFrameDecoder::Opcode::Text, message, mask_gen()));
+}
+
+void IoUringWebSocketFeed::on_data(const char* data, size_t len) {
+    bool ok = decoder_.feed(data, len, [this](WebSocketFrameDecoder::Opcode opcode, std::string&& payload) {
+        switch (opcode) {
+            case WebSocketFrameDecoder::Opcode::Text:
+            case WebSocketFrameDecoder::Opcode::Binary:
+                if (on_message_) {
+                    on_message_(std::move(payload));
+                } else {
+                    message_processor_.add_message(true, std::move(payload));
+                }
+                break;
+            case WebSocketFrameDecoder::Opcode::Ping:
+                transport_.send(conn_id_, WebSocketFrameDecoder::encode_client_frame(
+                    WebSocketFrameDecoder::Opcode::Pong, payload, static_cast<uint32_t>(fd_) * 2654435761u));
+                break;
+            case WebSocketFrameDecoder::Opcode::Close:
+                closed();
+                break;
+            default:
+                break;
+        }
+    });
+    if (!ok) {
+        spdlog::error("io_uring feed {}{}: websocket protocol error", host_, path_);
+        closed();
+        stop();
+    }
+}
+
+void IoUringWebSocketFeed::closed() {
+    if (is_connected_.exchange(false) && on_close_) {
+        on_close_();
+    }
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "EventLoop.h"
+#include "HugePageArena.h"
+#include "WebSocketFrameDecoder.h"
+
+class MessageProcessor;
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf;
+
+struct IoUringConfig {
+    unsigned entries = 256;
+    unsigned buffer_count = 1024;   // provided buffers, must be a power of two
+    unsigned buffer_size = 16384;
+    bool sqpoll = false;            // kernel thread polls the SQ, submissions need no syscall
+    unsigned sqpoll_idle_ms = 1000;
+    int sqpoll_cpu = -1;
+    // Only the creating thread submits (SINGLE_ISSUER) and it runs completions itself
+    // (COOP_TASKRUN). Off when the ring is created on one thread and driven by another,
+    // e.g. attached to an EventLoop.
+    bool single_issuer = true;
+};
+
+struct IoUringStats {
+    uint64_t enter_calls = 0;       // io_uring_enter syscalls
+    uint64_t completions = 0;
+    uint64_t receives = 0;
+    uint64_t bytes_received = 0;
+    uint64_t recv_rearms = 0;       // multishot receives that had to be re-submitted
+    uint64_t bytes_sent = 0;
+    uint64_t short_sends = 0;       // sends the socket took only part of, remainder resubmitted
+};
+
+// Socket transport on io_uring: one multishot receive per connection reading into a
+// registered provided-buffer ring, with all submissions batched into a single
+// io_uring_enter per poll. Talks to the kernel directly, no liburing dependency.
+class IoUringTransport {
+public:
+    using DataHandler = std::function<void(const char* data, size_t len)>;
+    using CloseHandler = std::function<void(int error)>;
+
+    explicit IoUringTransport(const IoUringConfig& config = IoUringConfig());
+    ~IoUringTransport();
+
+    IoUringTransport(const IoUringTransport&) = delete;
+    IoUringTransport& operator=(const IoUringTransport&) = delete;
+
+    static bool is_supported();
+
+    // Not thread safe: connections are added and served from the polling thread
+    uint32_t add_connection(int fd, DataHandler on_data, CloseHandler on_close);
+    void remove_connection(uint32_t conn_id);
+    // Sends go out in order, one in flight per connection; a short send is resubmitted
+    // from where it stopped
+    void send(uint32_t conn_id, std::string data);
+
+    // Submits queued SQEs and dispatches completions; blocks for at least one when wait is set
+    size_t poll(bool wait);
+    void run(const std::atomic<bool>& running);
+    // Instead of run(): the loop polls the ring on every pass, and a completion wakes it
+    // while it is parked. Call before the loop runs; the transport is then used only
+    // from the loop's thread, or after the loop stopped.
+    void attach(EventLoop& loop);
+    // Once the attached loop has stopped, before its io_context goes: lets the transport
+    // outlive the loop, e.g. for connections torn down with it
+    void detach();
+
+    IoUringStats stats() const { return stats_; }
+
+private:
+    struct Connection {
+        int fd = -1;
+        bool active = false;
+        // Bumped each time the slot is reused and carried in the receive's user_data, so
+        // completions still in flight for a removed connection are not taken for its successor
+        uint32_t generation = 0;
+        DataHandler on_data;
+        CloseHandler on_close;
+        std::deque<uint64_t> sends;  // pending_sends_ keys, the front one in flight
+    };
+
+    struct PendingSend {
+        std::string data;
+        size_t offset = 0;  // bytes the socket already took
+        uint32_t conn_id = 0;
+        uint32_t generation = 0;
+    };
+
+    IoUringConfig config_;
+    int ring_fd_ = -1;
+
+    // Submission queue
+    void* sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_flags_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned sqe_tail_ = 0;
+    unsigned sqe_submitted_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    // Completion queue
+    void* cq_ring_ = nullptr;
+    size_t cq_ring_size_ = 0;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    // Provided buffer ring (buffer group 0)
+    io_uring_buf* buf_ring_ = nullptr;
+    size_t buf_ring_size_ = 0;
+    ArenaArray<char> buffers_;  // from the buffers arena when one is configured
+    uint16_t buf_tail_ = 0;
+    unsigned buf_mask_ = 0;
+
+    // Readable while the CQ has completions, for attach()
+    std::unique_ptr<boost::asio::posix::stream_descriptor> wake_descriptor_;
+    bool wakeup_armed_ = false;  // loop thread only
+
+    std::vector<Connection> connections_;
+    // Owns each send's bytes until its last completion, even after its connection is gone
+    std::unordered_map<uint64_t, PendingSend> pending_sends_;
+    uint64_t next_send_id_ = 0;
+    IoUringStats stats_;
+
+    io_uring_sqe* get_sqe();
+    void flush_sq();
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags);
+    void arm_receive(uint32_t conn_id);
+    void submit_send(uint64_t send_id);
+    void handle_send_completion(uint64_t send_id, int res);
+    void drop_queued_sends(Connection& conn);
+    void recycle_buffer(uint16_t bid);
+    void publish_buffers();
+    void handle_completion(const io_uring_cqe& cqe);
+    void arm_wakeup();
+    void setup_ring();
+    void setup_buffer_ring();
+    void teardown();
+};
+
+// Plaintext WebSocket stream on top of IoUringTransport. Resolves, connects and upgrades
+// asynchronously on the polling loop's io_context, checking Sec-WebSocket-Accept, then
+// hands the socket to the ring and decodes frames into MessageProcessor, or a message
+// handler when one is set. TLS endpoints stay on the websocketpp/Asio path. Used from the
+// transport's polling thread only.
+class IoUringWebSocketFeed {
+public:
+    using MessageHandler = std::function<void(std::string&& payload)>;
+    using CloseHandler = std::function<void()>;
+    using ConnectHandler = std::function<void(bool connected)>;
+
+    IoUringWebSocketFeed(IoUringTransport& transport, const std::string& host, const std::string& port,
+                         const std::string& path, MessageProcessor& message_processor);
+    ~IoUringWebSocketFeed();
+
+    // ioc is the io_context of the loop polling the transport; nothing blocks it. done
+    // runs there once, false on failure or after timeout, and not at all after stop().
+    void connect(boost::asio::io_context& ioc, std::chrono::milliseconds timeout, ConnectHandler done);
+    void stop();
+    bool is_connected() const { return is_connected_; }
+    void send_text(const std::string& message);
+    // Text and binary payloads go here instead of MessageProcessor; set before connect()
+    void set_message_handler(MessageHandler handler) { on_message_ = std::move(handler); }
+    // Called once when the peer closes the stream or it fails, not after stop(). It must
+    // not destroy the feed.
+    void set_close_handler(CloseHandler handler) { on_close_ = std::move(handler); }
+    int native_handle() const { return fd_; }
+
+private:
+    IoUringTransport& transport_;
+    std::string host_;
+    std::string port_;
+    std::string path_;
+    MessageProcessor& message_processor_;
+    WebSocketFrameDecoder decoder_;
+    uint32_t conn_id_ = 0;
+    bool registered_ = false;  // conn_id_ is ours until removed or closed by the transport
+    int fd_ = -1;
+    std::atomic<bool> is_connected_{false};
+    MessageHandler on_message_;
+    CloseHandler on_close_;
+
+    struct Handshake;
+    std::shared_ptr<Handshake> handshake_;  // while connect() is under way
+
+    void read_upgrade_response(const std::shared_ptr<Handshake>& handshake);
+    void complete_handshake(const std::shared_ptr<Handshake>& handshake, size_t body_offset);
+    void fail_handshake(const std::shared_ptr<Handshake>& handshake, const std::string& reason);
+    void on_data(const char* data, size_t len);
+    void closed();
+};
@@ -0,0 +1,216 @@
+#include "LatencyMonitor.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+LatencyTracker::LatencyTracker(size_t window_size) : samples_(std::max<size_t>(window_size, 1)) {}
+
+void LatencyTracker::record(int64_t latency_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    samples_[next_] = latency_us;
+    next_ = (next_ + 1) % samples_.size();
+    filled_ = std::min(filled_ + 1, samples_.size());
+}
+
+LatencyStats LatencyTracker::stats() const {
+    std::vector<int64_t> sorted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sorted.assign(samples_.begin(), samples_.begin() + filled_);
+    }
+
+    LatencyStats result;
+    result.count = sorted.size();
+    if (sorted.empty()) {
+        return result;
+    }
+
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double p) {
+        size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[index];
+    };
+    result.p50_us = percentile(0.50);
+    result.p90_us = percentile(0.90);
+    result.p99_us = percentile(0.99);
+    result.max_us = sorted.back();
+    return result;
+}
+
+void LatencyTracker::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    next_ = 0;
+    filled_ = 0;
+}
+
+LatencyHistogram::LatencyHistogram()
+    : counts_(LINEAR_BUCKETS + (64 - 6) * (size_t{1} << SUB_BUCKET_BITS)) {}
+
+size_t LatencyHistogram::bucket_of(uint64_t ns) {
+    if (ns < LINEAR_BUCKETS) {
+        return static_cast<size_t>(ns);
+    }
+    unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(ns));  // >= 6
+    size_t sub = (ns >> (exponent - SUB_BUCKET_BITS)) & ((size_t{1} << SUB_BUCKET_BITS) - 1);
+    return LINEAR_BUCKETS + (exponent - 6) * (size_t{1} << SUB_BUCKET_BITS) + sub;
+}
+
+int64_t LatencyHistogram::bucket_value(size_t bucket) {
+    if (bucket < LINEAR_BUCKETS) {
+        return static_cast<int64_t>(bucket);
+    }
+    size_t index = bucket - LINEAR_BUCKETS;
+    unsigned exponent = static_cast<unsigned>(index >> SUB_BUCKET_BITS) + 6;
+    uint64_t sub = index & ((size_t{1} << SUB_BUCKET_BITS) - 1);
+    uint64_t width = uint64_t{1} << (exponent - SUB_BUCKET_BITS);
+    uint64_t lower = ((uint64_t{1} << SUB_BUCKET_BITS) + sub) * width;
+    return static_cast<int64_t>(std::min<uint64_t>(lower + width / 2, std::numeric_limits<int64_t>::max()));
+}
+
+void LatencyHistogram::record(int64_t latency_ns) {
+    uint64_t ns = latency_ns > 0 ? static_cast<uint64_t>(latency_ns) : 0;
+    ++counts_[bucket_of(ns)];
+    ++count_;
+    sum_ += static_cast<double>(ns);
+    max_ = std::max<int64_t>(max_, static_cast<int64_t>(ns));
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+}
+
+LatencyHistogram::Stats LatencyHistogram::stats() const {
+    Stats result;
+    result.count = count_;
+    if (count_ == 0) {
+        return result;
+    }
+    result.mean_ns = sum_ / static_cast<double>(count_);
+    result.max_ns = max_;
+
+    const double quantiles[] = {0.50, 0.90, 0.99, 0.999};
+    int64_t* outputs[] = {&result.p50_ns, &result.p90_ns, &result.p99_ns, &result.p999_ns};
+    uint64_t seen = 0;
+    size_t next = 0;
+    for (size_t bucket = 0; bucket < counts_.size() && next < 4; ++bucket) {
+        seen += counts_[bucket];
+        while (next < 4 && static_cast<double>(seen) >= quantiles[next] * static_cast<double>(count_)) {
+            // The top bucket's midpoint can overshoot the largest sample
+            *outputs[next++] = std::min(bucket_value(bucket), max_);
+        }
+    }
+    return result;
+}
+
+ClockSync::ClockSync(size_t max_samples) : max_samples_(std::max<size_t>(max_samples, 1)) {}
+
+void ClockSync::add_sample(int64_t local_send_us, int64_t server_time_ms, int64_t local_recv_us) {
+    if (local_recv_us < local_send_us) {
+        return;
+    }
+    // NTP style: assume the server stamped the response halfway through the round trip
+    int64_t midpoint_us = local_send_us + (local_recv_us - local_send_us) / 2;
+    Sample sample{midpoint_us, server_time_ms * 1000 - midpoint_us, local_recv_us - local_send_us};
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (samples_.size() >= max_samples_) {
+        samples_.erase(samples_.begin());
+    }
+    samples_.push_back(sample);
+    recompute();
+}
+
+void ClockSync::recompute() {
+    // Only trust samples close to the best observed round trip: queueing delay on
+    // one leg skews the offset by up to half the extra latency.
+    int64_t min_rtt = std::numeric_limits<int64_t>::max();
+    for (const auto& s : samples_) {
+        min_rtt = std::min(min_rtt, s.rtt_us);
+    }
+    int64_t rtt_limit = 2 * min_rtt + 1000;
+
+    double n = 0, sum_x = 0, sum_y = 0;
+    int64_t x0 = samples_.back().local_us;
+    for (const auto& s : samples_) {
+        if (s.rtt_us > rtt_limit) continue;
+        n += 1;
+        sum_x += static_cast<double>(s.local_us - x0);
+        sum_y += static_cast<double>(s.offset_us);
+    }
+    double mean_x = sum_x / n;
+    double mean_y = sum_y / n;
+
+    double sxx = 0, sxy = 0;
+    for (const auto& s : samples_) {
+        if (s.rtt_us > rtt_limit) continue;
+        double dx = static_cast<double>(s.local_us - x0) - mean_x;
+        sxx += dx * dx;
+        sxy += dx * (static_cast<double>(s.offset_us) - mean_y);
+    }
+
+    // Drift needs at least a few seconds of spread to be meaningful
+    drift_ = (n >= 2 && sxx > 0 && (sxx / n) > 1e12) ? sxy / sxx : 0.0;
+    base_local_us_ = x0 + static_cast<int64_t>(mean_x);
+    base_offset_us_ = static_cast<int64_t>(mean_y);
+    has_estimate_ = true;
+}
+
+bool ClockSync::has_estimate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return has_estimate_;
+}
+
+int64_t ClockSync::offset_us() const {
+    return offset_us_at(wall_clock_us());
+}
+
+int64_t ClockSync::offset_us_at(int64_t local_us) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_estimate_) {
+        return 0;
+    }
+    return base_offset_us_ + static_cast<int64_t>(drift_ * static_cast<double>(local_us - base_local_us_));
+}
+
+double ClockSync::drift_ppm() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return drift_ * 1e6;
+}
+
+int64_t ClockSync::exchange_to_local_us(int64_t exchange_time_ms) const {
+    int64_t exchange_us = exchange_time_ms * 1000;
+    return exchange_us - offset_us_at(exchange_us);
+}
+
+int64_t ClockSync::local_to_exchange_ms(int64_t local_us) const {
+    return (local_us + offset_us_at(local_us)) / 1000;
+}
+
+int64_t extract_json_integer(const std::string& payload, const char* key) {
+    const size_t key_len = std::strlen(key);
+    const char* data = payload.data();
+    const size_t size = payload.size();
+
+    size_t pos = payload.find('"');
+    while (pos != std::string::npos && pos + key_len + 2 < size) {
+        if (std::memcmp(data + pos + 1, key, key_len) == 0 && data[pos + key_len + 1] == '"') {
+            size_t i = pos + key_len + 2;
+            while (i < size && (data[i] == ' ' || data[i] == ':')) ++i;
+            if (i < size && data[i] >= '0' && data[i] <= '9') {
+                int64_t value = 0;
+                while (i < size && data[i] >= '0' && data[i] <= '9') {
+                    value = value * 10 + (data[i] - '0');
+                    ++i;
+                }
+                return value;
+            }
+        }
+        pos = payload.find('"', pos + 1);
+    }
+    return -1;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+struct LatencyStats {
+    int64_t p50_us = 0;
+    int64_t p90_us = 0;
+    int64_t p99_us = 0;
+    int64_t max_us = 0;
+    size_t count = 0;
+};
+
+struct ConnectionLatency {
+    LatencyStats exchange_to_local;  // local receive time - exchange event time (offset corrected)
+    LatencyStats ping_rtt;           // websocket ping/pong round trip
+    // Kernel RX timestamp to on_message, low-latency profile only. Approximate: websocketpp
+    // owns the reads, so the timestamp comes from a MSG_PEEK of the receive queue when the
+    // socket turns readable, not from the read that delivered the message. It can belong to
+    // a later segment, and only the first message of each read is sampled.
+    LatencyStats kernel_to_user_approx;
+};
+
+// Rolling window of the most recent latency samples, queried as percentiles.
+class LatencyTracker {
+public:
+    explicit LatencyTracker(size_t window_size = 1024);
+
+    void record(int64_t latency_us);
+    LatencyStats stats() const;
+    void reset();
+
+private:
+    std::vector<int64_t> samples_;
+    size_t next_ = 0;
+    size_t filled_ = 0;
+    mutable std::mutex mutex_;
+};
+
+// Percentiles over any number of nanosecond samples in fixed memory, for stages too fast
+// or too long-running for LatencyTracker's microsecond window. Exact below 64ns, then 16
+// buckets per power of two (within about 3%). Not thread safe: keep one per thread and
+// merge() them.
+class LatencyHistogram {
+public:
+    struct Stats {
+        uint64_t count = 0;
+        double mean_ns = 0.0;
+        int64_t p50_ns = 0;
+        int64_t p90_ns = 0;
+        int64_t p99_ns = 0;
+        int64_t p999_ns = 0;
+        int64_t max_ns = 0;
+    };
+
+    LatencyHistogram();
+
+    void record(int64_t latency_ns);  // negative samples count as 0
+    void merge(const LatencyHistogram& other);
+    Stats stats() const;
+
+private:
+    static constexpr size_t LINEAR_BUCKETS = 64;
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+
+    std::vector<uint64_t> counts_;
+    uint64_t count_ = 0;
+    double sum_ = 0.0;
+    int64_t max_ = 0;
+
+    static size_t bucket_of(uint64_t ns);
+    static int64_t bucket_value(size_t bucket);  // midpoint of the bucket's range
+};
+
+// Estimates the offset (exchange clock - local clock) and its drift from
+// request/response pairs against the exchange time endpoint.
+class ClockSync {
+public:
+    explicit ClockSync(size_t max_samples = 64);
+
+    // local_send_us / local_recv_us are local wall clock times around the request,
+    // server_time_ms is the exchange timestamp carried in the response.
+    void add_sample(int64_t local_send_us, int64_t server_time_ms, int64_t local_recv_us);
+
+    bool has_estimate() const;
+    int64_t offset_us() const;                // offset at the current local time
+    int64_t offset_us_at(int64_t local_us) const;
+    double drift_ppm() const;
+    int64_t exchange_to_local_us(int64_t exchange_time_ms) const;
+    // Exchange time, in ms, at local wall clock local_us; local_us / 1000 without an estimate
+    int64_t local_to_exchange_ms(int64_t local_us) const;
+
+private:
+    struct Sample {
+        int64_t local_us;
+        int64_t offset_us;
+        int64_t rtt_us;
+    };
+
+    std::vector<Sample> samples_;
+    size_t max_samples_;
+    int64_t base_offset_us_ = 0;
+    int64_t base_local_us_ = 0;
+    double drift_ = 0.0;  // microseconds of offset change per microsecond of local time
+    bool has_estimate_ = false;
+    mutable std::mutex mutex_;
+
+    void recompute();
+};
+
+inline int64_t wall_clock_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Cheap scan for an integer field such as "E" or "serverTime" without a full JSON parse.
+// Returns -1 if the field is missing.
+int64_t extract_json_integer(const std::string& payload, const char* key);
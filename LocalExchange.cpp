@@ -0,0 +1,507 @@
+#include "LocalExchange.h"
+#include "CaptureJournal.h"
+#include "MessageProcessor.h"
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/beast/websocket.hpp>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <simdjson.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace websocket = beast::websocket;
+using net::ip::tcp;
+
+namespace {
+
+constexpr size_t DEFAULT_SNAPSHOT_LIMIT = 100;
+constexpr size_t MAX_SNAPSHOT_LIMIT = 5000;
+constexpr size_t PLAYBACK_YIELD_INTERVAL = 256;  // records between yields when unpaced
+
+auto redirect(boost::system::error_code& ec) {
+    return net::redirect_error(net::use_awaitable, ec);
+}
+
+std::string lower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+int64_t wall_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// "btcusdt@depth" or "btcusdt@depth@100ms" -> "btcusdt"; empty for other streams
+std::string depth_stream_symbol(std::string_view stream) {
+    size_t at = stream.find('@');
+    if (at == std::string_view::npos || stream.compare(at, 6, "@depth") != 0) {
+        return std::string();
+    }
+    return lower(std::string(stream.substr(0, at)));
+}
+
+std::string query_param(std::string_view query, std::string_view name) {
+    size_t pos = 0;
+    while (pos < query.size()) {
+        size_t end = query.find('&', pos);
+        std::string_view pair = query.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+        if (pair.size() > name.size() && pair.substr(0, name.size()) == name && pair[name.size()] == '=') {
+            return std::string(pair.substr(name.size() + 1));
+        }
+        if (end == std::string_view::npos) {
+            break;
+        }
+        pos = end + 1;
+    }
+    return std::string();
+}
+
+// The data member of a combined-stream message, or the message itself
+std::string_view unwrap_combined(std::string_view payload) {
+    static constexpr std::string_view data_key = "\"data\":";
+    if (payload.substr(0, 11) != "{\"stream\":\"") {
+        return payload;
+    }
+    size_t data = payload.find(data_key);
+    if (data == std::string_view::npos || payload.back() != '}') {
+        return payload;
+    }
+    data += data_key.size();
+    return payload.substr(data, payload.size() - 1 - data);
+}
+
+}  // namespace
+
+struct LocalExchange::Session {
+    explicit Session(tcp::socket socket) : ws(std::move(socket)) {}
+
+    websocket::stream<beast::tcp_stream> ws;
+    std::unordered_set<std::string> symbols;
+    bool combined = false;
+    std::deque<std::shared_ptr<const std::string>> outbox;
+    bool writing = false;
+    bool closing = false;
+    std::chrono::steady_clock::time_point opened;
+};
+
+struct LocalExchange::Playback {
+    explicit Playback(const std::string& directory) : reader(directory) {}
+
+    CaptureReader reader;
+    std::unordered_map<std::string, std::string> snapshots;  // latest captured body per symbol
+};
+
+LocalExchange::LocalExchange(const LocalExchangeConfig& config)
+    : config_(config),
+      ssl_ctx_(net::ssl::context::tls_server),
+      stream_acceptor_(ioc_, {net::ip::make_address(config.address), config.stream_port}),
+      rest_acceptor_(ioc_, {net::ip::make_address(config.address), config.rest_port}) {
+    stream_port_ = stream_acceptor_.local_endpoint().port();
+    rest_port_ = rest_acceptor_.local_endpoint().port();
+    use_self_signed_certificate(ssl_ctx_);
+    if (config_.playback_directory.empty()) {
+        market_ = std::make_unique<SyntheticMarket>(config_.market);
+    } else {
+        playback_ = std::make_unique<Playback>(config_.playback_directory);
+    }
+
+    net::co_spawn(ioc_, accept_streams(), net::detached);
+    net::co_spawn(ioc_, accept_rest(), net::detached);
+    if (market_) {
+        net::co_spawn(ioc_, generate(), net::detached);
+    }
+    thread_ = std::thread([this]() { ioc_.run(); });
+    spdlog::info("Local exchange streaming on {}:{}, REST on {}:{}", config_.address, stream_port_,
+                 config_.address, rest_port_);
+}
+
+LocalExchange::~LocalExchange() {
+    ioc_.stop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+ExchangeEndpoints LocalExchange::endpoints() const {
+    return ExchangeEndpoints::local(stream_port_, rest_port_, config_.address);
+}
+
+LocalExchangeStats LocalExchange::stats() const {
+    LocalExchangeStats stats;
+    stats.connections = connections_.load();
+    stats.messages_sent = messages_sent_.load();
+    stats.disconnects = disconnects_.load();
+    stats.slow_consumers = slow_consumers_.load();
+    stats.gaps = gaps_.load();
+    stats.rest_requests = rest_requests_.load();
+    stats.records_played = records_played_.load();
+    stats.playback_finished = playback_finished_.load();
+    return stats;
+}
+
+void LocalExchange::use_self_signed_certificate(net::ssl::context& ctx) {
+    EVP_PKEY* key = nullptr;
+    EVP_PKEY_CTX* key_ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    if (key_ctx == nullptr || EVP_PKEY_keygen_init(key_ctx) <= 0 ||
+        EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_ctx, NID_X9_62_prime256v1) <= 0 ||
+        EVP_PKEY_keygen(key_ctx, &key) <= 0) {
+        EVP_PKEY_CTX_free(key_ctx);
+        throw std::runtime_error("Failed to generate certificate key");
+    }
+    EVP_PKEY_CTX_free(key_ctx);
+
+    X509* cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 7 * 24 * 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME* name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                               reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    bool ok = X509_sign(cert, key, EVP_sha256()) > 0 &&
+              SSL_CTX_use_certificate(ctx.native_handle(), cert) == 1 &&
+              SSL_CTX_use_PrivateKey(ctx.native_handle(), key) == 1;
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    if (!ok) {
+        throw std::runtime_error("Failed to install self-signed certificate");
+    }
+}
+
+net::awaitable<void> LocalExchange::accept_streams() {
+    for (;;) {
+        boost::system::error_code ec;
+        auto socket = co_await stream_acceptor_.async_accept(redirect(ec));
+        if (ec) {
+            co_return;
+        }
+        socket.set_option(tcp::no_delay(true), ec);
+        net::co_spawn(ioc_, stream_session(std::move(socket)), net::detached);
+    }
+}
+
+net::awaitable<void> LocalExchange::stream_session(tcp::socket socket) {
+    auto session = std::make_shared<Session>(std::move(socket));
+    boost::system::error_code ec;
+    beast::flat_buffer buffer;
+    http::request<http::string_body> req;
+    co_await http::async_read(session->ws.next_layer(), buffer, req, redirect(ec));
+    if (ec || !websocket::is_upgrade(req)) {
+        co_return;
+    }
+
+    std::string_view target(req.target().data(), req.target().size());
+    std::string_view streams;
+    if (target.substr(0, 4) == "/ws/") {
+        streams = target.substr(4);
+    } else if (target.substr(0, 16) == "/stream?streams=") {
+        streams = target.substr(16);
+        session->combined = true;
+    } else if (target == "/stream") {
+        session->combined = true;
+    } else if (target != "/ws") {
+        co_return;
+    }
+    while (!streams.empty()) {
+        size_t slash = streams.find('/');
+        std::string symbol = depth_stream_symbol(streams.substr(0, slash));
+        if (!symbol.empty()) {
+            session->symbols.insert(std::move(symbol));
+        }
+        streams = slash == std::string_view::npos ? std::string_view() : streams.substr(slash + 1);
+    }
+
+    co_await session->ws.async_accept(req, redirect(ec));
+    if (ec) {
+        co_return;
+    }
+    session->ws.text(true);
+    session->opened = std::chrono::steady_clock::now();
+    sessions_.push_back(session);
+    ++connections_;
+    // Playback starts with the first subscriber so a test or load run sees the whole capture
+    if (playback_ && !playback_started_) {
+        playback_started_ = true;
+        net::co_spawn(ioc_, play_back(), net::detached);
+    }
+
+    simdjson::dom::parser parser;
+    beast::flat_buffer frame;
+    for (;;) {
+        frame.consume(frame.size());
+        co_await session->ws.async_read(frame, redirect(ec));
+        if (ec) {
+            break;
+        }
+        // {"method":"SUBSCRIBE","params":["btcusdt@depth"],"id":1}
+        std::string text = beast::buffers_to_string(frame.data());
+        simdjson::dom::element request;
+        std::string_view method;
+        int64_t id = 0;
+        if (parser.parse(text).get(request) || request["method"].get(method)) {
+            continue;
+        }
+        if (request["id"].get(id)) {
+            id = 0;
+        }
+        simdjson::dom::array params;
+        if (!request["params"].get(params)) {
+            for (auto param : params) {
+                std::string_view stream;
+                if (param.get(stream)) {
+                    continue;
+                }
+                std::string symbol = depth_stream_symbol(stream);
+                if (symbol.empty()) {
+                    continue;
+                }
+                if (method == "SUBSCRIBE") {
+                    session->symbols.insert(symbol);
+                } else if (method == "UNSUBSCRIBE") {
+                    session->symbols.erase(symbol);
+                }
+            }
+        }
+        session->outbox.push_back(
+            std::make_shared<const std::string>("{\"result\":null,\"id\":" + std::to_string(id) + "}"));
+        if (!session->writing && !session->closing) {
+            session->writing = true;
+            net::co_spawn(ioc_, write_loop(session), net::detached);
+        }
+    }
+    sessions_.remove(session);
+}
+
+net::awaitable<void> LocalExchange::write_loop(std::shared_ptr<Session> session) {
+    boost::system::error_code ec;
+    while (!session->outbox.empty() && !ec) {
+        auto message = session->outbox.front();
+        co_await session->ws.async_write(net::buffer(*message), redirect(ec));
+        session->outbox.pop_front();
+        if (!ec) {
+            ++messages_sent_;
+        }
+    }
+    session->writing = false;
+    if (ec) {
+        sessions_.remove(session);
+    } else if (session->closing) {
+        co_await session->ws.async_close(websocket::close_code::going_away, redirect(ec));
+    }
+}
+
+void LocalExchange::publish(const std::string& symbol, const std::string& event) {
+    std::shared_ptr<const std::string> raw;
+    std::shared_ptr<const std::string> wrapped;
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+        auto session = *it++;  // close_session may remove it
+        if (session->closing || !session->symbols.count(symbol)) {
+            continue;
+        }
+        if (session->outbox.size() >= config_.max_backlog) {
+            spdlog::warn("Local exchange dropping a slow consumer with {} queued messages", session->outbox.size());
+            ++slow_consumers_;
+            sessions_.remove(session);
+            session->closing = true;
+            boost::system::error_code ec;
+            beast::get_lowest_layer(session->ws).socket().close(ec);
+            continue;
+        }
+        auto& message = session->combined ? wrapped : raw;
+        if (!message) {
+            message = std::make_shared<const std::string>(
+                session->combined ? "{\"stream\":\"" + symbol + "@depth\",\"data\":" + event + "}" : event);
+        }
+        session->outbox.push_back(message);
+        if (!session->writing) {
+            session->writing = true;
+            net::co_spawn(ioc_, write_loop(session), net::detached);
+        }
+    }
+}
+
+// Ends a connection the way the exchange does: a close frame once anything queued has
+// been sent
+void LocalExchange::close_session(const std::shared_ptr<Session>& session) {
+    session->closing = true;
+    sessions_.remove(session);
+    if (!session->writing) {
+        session->writing = true;
+        net::co_spawn(ioc_, write_loop(session), net::detached);
+    }
+}
+
+void LocalExchange::drop_expired_sessions() {
+    if (config_.disconnect_interval.count() <= 0) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<Session>> expired;
+    for (const auto& session : sessions_) {
+        if (now - session->opened >= config_.disconnect_interval) {
+            expired.push_back(session);
+        }
+    }
+    for (const auto& session : expired) {
+        ++disconnects_;
+        close_session(session);
+    }
+}
+
+net::awaitable<void> LocalExchange::generate() {
+    net::steady_timer timer(ioc_);
+    boost::system::error_code ec;
+    while (!ec) {
+        for (auto& [symbol, event] : market_->tick(wall_ns())) {
+            publish(market_->symbols()[symbol], event);
+        }
+        gaps_ = market_->gaps();
+        drop_expired_sessions();
+        timer.expires_after(config_.tick_interval);
+        co_await timer.async_wait(redirect(ec));
+    }
+}
+
+net::awaitable<void> LocalExchange::play_back() {
+    net::steady_timer timer(ioc_);
+    CaptureRecord record;
+    int64_t first_receive_ns = -1;
+    auto start = std::chrono::steady_clock::now();
+    size_t since_yield = 0;
+    while (playback_->reader.next(record)) {
+        std::string symbol = lower(playback_->reader.symbol(record.symbol_id));
+        if (record.source == CaptureSource::Rest) {
+            // Only snapshot requests are captured with a symbol
+            if (!symbol.empty()) {
+                playback_->snapshots[symbol] = std::string(record.payload);
+            }
+            continue;
+        }
+        if (record.source != CaptureSource::WebSocket) {
+            continue;
+        }
+
+        if (config_.playback_speed > 0.0) {
+            if (first_receive_ns < 0) {
+                first_receive_ns = record.receive_ns;
+            }
+            auto due = start + std::chrono::nanoseconds(static_cast<int64_t>(
+                static_cast<double>(record.receive_ns - first_receive_ns) / config_.playback_speed));
+            if (due > std::chrono::steady_clock::now()) {
+                boost::system::error_code ec;
+                timer.expires_at(due);
+                co_await timer.async_wait(redirect(ec));
+                if (ec) {
+                    co_return;
+                }
+                since_yield = 0;
+            }
+        }
+        if (++since_yield == PLAYBACK_YIELD_INTERVAL) {
+            // Let the writers drain between batches
+            since_yield = 0;
+            co_await net::post(ioc_, net::use_awaitable);
+        }
+
+        std::string payload(record.payload);
+        if (symbol.empty()) {
+            symbol = lower(MessageProcessor::stream_symbol(payload));
+        }
+        if (!symbol.empty()) {
+            publish(symbol, std::string(unwrap_combined(payload)));
+        }
+        ++records_played_;
+        drop_expired_sessions();
+    }
+    playback_finished_ = true;
+    spdlog::info("Local exchange finished playing back {} records", records_played_.load());
+}
+
+net::awaitable<void> LocalExchange::accept_rest() {
+    for (;;) {
+        boost::system::error_code ec;
+        auto socket = co_await rest_acceptor_.async_accept(redirect(ec));
+        if (ec) {
+            co_return;
+        }
+        net::co_spawn(ioc_, rest_session(std::move(socket)), net::detached);
+    }
+}
+
+net::awaitable<void> LocalExchange::rest_session(tcp::socket socket) {
+    boost::system::error_code ec;
+    beast::ssl_stream<beast::tcp_stream> stream(std::move(socket), ssl_ctx_);
+    co_await stream.async_handshake(net::ssl::stream_base::server, redirect(ec));
+    beast::flat_buffer buffer;
+    while (!ec) {
+        http::request<http::string_body> req;
+        co_await http::async_read(stream, buffer, req, redirect(ec));
+        if (ec) {
+            break;
+        }
+        ++rest_requests_;
+        unsigned status = 200;
+        std::string body = handle_rest(std::string(req.target()), status);
+        http::response<http::string_body> res(static_cast<http::status>(status), req.version());
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+        res.body() = std::move(body);
+        res.prepare_payload();
+        co_await http::async_write(stream, res, redirect(ec));
+    }
+}
+
+std::string LocalExchange::handle_rest(const std::string& target, unsigned& status) {
+    size_t question = target.find('?');
+    std::string path = target.substr(0, question);
+    std::string_view query = question == std::string::npos ? std::string_view()
+                                                           : std::string_view(target).substr(question + 1);
+    if (path == "/api/v3/time") {
+        return "{\"serverTime\":" + std::to_string(wall_ns() / 1000000) + "}";
+    }
+    if (path == "/api/v3/depth") {
+        size_t limit = DEFAULT_SNAPSHOT_LIMIT;
+        std::string limit_param = query_param(query, "limit");
+        if (!limit_param.empty()) {
+            try {
+                limit = std::clamp<size_t>(std::stoul(limit_param), 1, MAX_SNAPSHOT_LIMIT);
+            } catch (const std::exception&) {
+                status = 400;
+                return "{\"code\":-1100,\"msg\":\"Illegal characters found in parameter 'limit'.\"}";
+            }
+        }
+        std::string body = snapshot(lower(query_param(query, "symbol")), limit);
+        if (body.empty()) {
+            status = 400;
+            return "{\"code\":-1121,\"msg\":\"Invalid symbol.\"}";
+        }
+        return body;
+    }
+    status = 404;
+    return "{\"code\":-1000,\"msg\":\"Unknown endpoint.\"}";
+}
+
+std::string LocalExchange::snapshot(const std::string& symbol, size_t limit) {
+    if (market_) {
+        int index = market_->find(symbol);
+        return index < 0 ? std::string() : market_->snapshot(static_cast<size_t>(index), limit);
+    }
+    auto it = playback_->snapshots.find(symbol);
+    return it == playback_->snapshots.end() ? std::string() : it->second;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "ExchangeEndpoints.h"
+#include "SyntheticMarket.h"
+#include <boost/asio.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/ssl.hpp>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+struct LocalExchangeConfig {
+    std::string address = "127.0.0.1";
+    unsigned short stream_port = 0;  // 0 picks a free port
+    unsigned short rest_port = 0;
+    SyntheticConfig market;
+    std::chrono::microseconds tick_interval{1000};
+    // Every stream connection is closed once it is this old, 0 never. The exchange does
+    // it after 24 hours; short intervals exercise reconnects and resyncs.
+    std::chrono::milliseconds disconnect_interval{0};
+    // Messages queued for one connection before it is dropped as a slow consumer
+    size_t max_backlog = 100000;
+    // Plays a CaptureJournal directory back instead of generating: stream records at
+    // their captured spacing divided by playback_speed (0 for as fast as possible), and
+    // each symbol's latest captured snapshot from the REST endpoint
+    std::string playback_directory;
+    double playback_speed = 1.0;
+};
+
+struct LocalExchangeStats {
+    uint64_t connections = 0;
+    uint64_t messages_sent = 0;
+    uint64_t disconnects = 0;      // injected by disconnect_interval
+    uint64_t slow_consumers = 0;   // connections dropped for exceeding max_backlog
+    uint64_t gaps = 0;             // diffs withheld by gap injection
+    uint64_t rest_requests = 0;
+    uint64_t records_played = 0;   // playback only
+    bool playback_finished = false;
+};
+
+// Stand-in for the Binance market data endpoints on one local thread, for load and
+// latency tests without the network:
+//   stream: plain WebSocket; /ws/<symbol>@depth sends raw events, /stream?streams=a@depth/b@depth
+//           the combined {"stream":...,"data":...} wrapper; SUBSCRIBE and UNSUBSCRIBE
+//           requests change a connection's streams and are acknowledged
+//   REST:   HTTPS with a throwaway self-signed certificate; /api/v3/depth?symbol=&limit=
+//           and /api/v3/time
+// Depth events come from a SyntheticMarket, or from a capture in playback mode.
+// endpoints() is what BinanceClient::set_endpoints needs to run against it.
+class LocalExchange {
+public:
+    // Binds both ports and starts serving. Throws if a port cannot be bound or the
+    // playback directory has no capture.
+    explicit LocalExchange(const LocalExchangeConfig& config);
+    ~LocalExchange();
+
+    LocalExchange(const LocalExchange&) = delete;
+    LocalExchange& operator=(const LocalExchange&) = delete;
+
+    unsigned short stream_port() const { return stream_port_; }
+    unsigned short rest_port() const { return rest_port_; }
+    ExchangeEndpoints endpoints() const;
+    LocalExchangeStats stats() const;
+
+    // Installs a freshly generated self-signed P-256 certificate for "localhost"
+    static void use_self_signed_certificate(boost::asio::ssl::context& ctx);
+
+private:
+    struct Session;
+    struct Playback;
+
+    LocalExchangeConfig config_;
+    boost::asio::ssl::context ssl_ctx_;  // before ioc_: sessions still pending at shutdown use it
+    boost::asio::io_context ioc_;
+    boost::asio::ip::tcp::acceptor stream_acceptor_;
+    boost::asio::ip::tcp::acceptor rest_acceptor_;
+    unsigned short stream_port_ = 0;
+    unsigned short rest_port_ = 0;
+
+    // Owned by the exchange thread
+    std::unique_ptr<SyntheticMarket> market_;
+    std::unique_ptr<Playback> playback_;
+    std::list<std::shared_ptr<Session>> sessions_;
+
+    std::atomic<uint64_t> connections_{0};
+    std::atomic<uint64_t> messages_sent_{0};
+    std::atomic<uint64_t> disconnects_{0};
+    std::atomic<uint64_t> slow_consumers_{0};
+    std::atomic<uint64_t> rest_requests_{0};
+    std::atomic<uint64_t> records_played_{0};
+    std::atomic<uint64_t> gaps_{0};
+    bool playback_started_ = false;
+    std::atomic<bool> playback_finished_{false};
+    std::thread thread_;
+
+    boost::asio::awaitable<void> accept_streams();
+    boost::asio::awaitable<void> stream_session(boost::asio::ip::tcp::socket socket);
+    boost::asio::awaitable<void> write_loop(std::shared_ptr<Session> session);
+    boost::asio::awaitable<void> accept_rest();
+    boost::asio::awaitable<void> rest_session(boost::asio::ip::tcp::socket socket);
+    boost::asio::awaitable<void> generate();
+    boost::asio::awaitable<void> play_back();
+
+    // Queues a raw depth event for every connection subscribed to the symbol
+    void publish(const std::string& symbol, const std::string& event);
+    void close_session(const std::shared_ptr<Session>& session);
+    void drop_expired_sessions();
+    std::string handle_rest(const std::string& target, unsigned& status);
+    std::string snapshot(const std::string& symbol, size_t limit);
+};
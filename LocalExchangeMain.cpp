@@ -0,0 +1,82 @@
+#include "LocalExchange.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+// Runs a LocalExchange until interrupted, printing its counters every second. Point the
+// client at it with --stream-base ws://127.0.0.1:<stream port> --rest-endpoint 127.0.0.1:<rest port>.
+
+std::atomic<bool> running(true);
+
+void signal_handler(int signal) {
+    (void)signal;
+    running = false;
+}
+
+int main(int argc, char* argv[]) {
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    LocalExchangeConfig config;
+    config.stream_port = 9443;
+    config.rest_port = 8443;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--stream-port" && has_value) {
+            config.stream_port = static_cast<unsigned short>(std::stoul(argv[++i]));
+        } else if (arg == "--rest-port" && has_value) {
+            config.rest_port = static_cast<unsigned short>(std::stoul(argv[++i]));
+        } else if (arg == "--symbols" && has_value) {
+            // Comma separated
+            config.market.symbols.clear();
+            std::stringstream list(argv[++i]);
+            for (std::string symbol; std::getline(list, symbol, ',');) {
+                config.market.symbols.push_back(symbol);
+            }
+        } else if (arg == "--rate" && has_value) {
+            config.market.messages_per_second = std::stod(argv[++i]);
+        } else if (arg == "--depth" && has_value) {
+            config.market.depth = std::stoul(argv[++i]);
+        } else if (arg == "--levels" && has_value) {
+            config.market.levels_per_update = std::stoul(argv[++i]);
+        } else if (arg == "--bursts" && has_value) {
+            config.market.bursts_per_second = std::stod(argv[++i]);
+        } else if (arg == "--burst-size" && has_value) {
+            config.market.burst_size = std::stoul(argv[++i]);
+        } else if (arg == "--gap" && has_value) {
+            config.market.gap_probability = std::stod(argv[++i]);
+        } else if (arg == "--seed" && has_value) {
+            config.market.seed = std::stoull(argv[++i]);
+        } else if (arg == "--disconnect-ms" && has_value) {
+            config.disconnect_interval = std::chrono::milliseconds(std::stol(argv[++i]));
+        } else if (arg == "--playback" && has_value) {
+            config.playback_directory = argv[++i];
+        } else if (arg == "--speed" && has_value) {
+            config.playback_speed = std::stod(argv[++i]);
+        } else {
+            std::cerr << "Unknown or incomplete option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    LocalExchange exchange(config);
+    ExchangeEndpoints endpoints = exchange.endpoints();
+    std::cout << "Streams on " << endpoints.stream_base << ", REST on https://" << endpoints.rest_host << ":"
+              << endpoints.rest_port << std::endl;
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        LocalExchangeStats stats = exchange.stats();
+        std::cout << "connections " << stats.connections << ", sent " << stats.messages_sent << ", gaps "
+                  << stats.gaps << ", disconnects " << stats.disconnects << ", slow consumers "
+                  << stats.slow_consumers << ", REST " << stats.rest_requests;
+        if (!config.playback_directory.empty()) {
+            std::cout << ", played " << stats.records_played << (stats.playback_finished ? " (finished)" : "");
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
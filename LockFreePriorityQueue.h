@@ -1,59 +1,157 @@
 #pragma once
 
 #include <atomic>
-#include <vector>
-#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include "HugePageArena.h"
 
-template<typename T, typename Compare = std::less<T>>
+// One FIFO lane per priority. Any number of threads may push; a single consumer pops.
+// Each lane is a preallocated ring of sequence-numbered cells (Vyukov's bounded queue),
+// carved from the rings arena when one is configured, so pushing and popping never
+// allocate. When a lane's ring is full, pushes spill into a locked overflow list, and
+// keep going there until it drains, so order within a lane is still the order of push.
+// Which lane to serve next is left to the consumer.
+//
+// T must be default constructible and move assignable.
+template<typename T, size_t LaneCount = 3>
 class LockFreePriorityQueue {
 private:
-    struct Node {
+    struct Cell {
+        std::atomic<size_t> sequence;
         T value;
-        std::atomic<Node*> next;
-        Node(const T& val) : value(val), next(nullptr) {}
     };
 
-    std::atomic<Node*> head;
-    std::atomic<size_t> count;
-    Compare comp;
+    struct alignas(64) Lane {
+        ArenaArray<Cell> cells;
+        size_t mask = 0;
+        alignas(64) std::atomic<size_t> enqueue_pos{0};  // producers
+        alignas(64) size_t dequeue_pos = 0;              // consumer
+        std::atomic<size_t> count{0};
+        std::atomic<size_t> overflow_count{0};
+        std::mutex overflow_mutex;
+        std::deque<T> overflow;
+    };
+
+    std::array<Lane, LaneCount> lanes_;
+    std::atomic<uint64_t> overflows_{0};
+
+    static bool try_push_ring(Lane& lane, T& value) {
+        size_t pos = lane.enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = lane.cells[pos & lane.mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (lane.enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = lane.enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
 
 public:
-    LockFreePriorityQueue() : head(nullptr), count(0) {}
-
-    void push(const T& value) {
-        Node* new_node = new Node(value);
-        Node* old_head = head.load(std::memory_order_relaxed);
-        do {
-            new_node->next = old_head;
-        } while (!head.compare_exchange_weak(old_head, new_node,
-                                             std::memory_order_release,
-                                             std::memory_order_relaxed));
-        count.fetch_add(1, std::memory_order_relaxed);
-    }
-
-    bool pop(T& result) {
-        Node* old_head = head.load(std::memory_order_relaxed);
-        Node* new_head;
-        do {
-            if (old_head == nullptr) {
-                return false;
+    static constexpr size_t lane_count = LaneCount;
+
+    // capacity is per lane and rounded up to a power of two
+    explicit LockFreePriorityQueue(size_t capacity = 1024) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        for (auto& lane : lanes_) {
+            lane.cells = ArenaArray<Cell>(ArenaKind::Rings, size);
+            lane.mask = size - 1;
+            for (size_t i = 0; i < size; ++i) {
+                lane.cells[i].sequence.store(i, std::memory_order_relaxed);
             }
-            new_head = old_head->next;
-        } while (!head.compare_exchange_weak(old_head, new_head,
-                                             std::memory_order_release,
-                                             std::memory_order_relaxed));
-        result = old_head->value;
-        delete old_head;
-        count.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    LockFreePriorityQueue(const LockFreePriorityQueue&) = delete;
+    LockFreePriorityQueue& operator=(const LockFreePriorityQueue&) = delete;
+
+    void push(T value, size_t lane_index) {
+        Lane& lane = lanes_[lane_index];
+        lane.count.fetch_add(1, std::memory_order_relaxed);
+        if (lane.overflow_count.load(std::memory_order_acquire) == 0 && try_push_ring(lane, value)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(lane.overflow_mutex);
+        lane.overflow.push_back(std::move(value));
+        lane.overflow_count.fetch_add(1, std::memory_order_release);
+        overflows_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Consumer only. May briefly report empty while a push is between claiming and filling a cell.
+    bool pop(size_t lane_index, T& result) {
+        Lane& lane = lanes_[lane_index];
+        Cell& cell = lane.cells[lane.dequeue_pos & lane.mask];
+        if (cell.sequence.load(std::memory_order_acquire) == lane.dequeue_pos + 1) {
+            result = std::move(cell.value);
+            cell.value = T();
+            cell.sequence.store(lane.dequeue_pos + lane.mask + 1, std::memory_order_release);
+            ++lane.dequeue_pos;
+            lane.count.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        // Only once every claimed cell is consumed, so a spilled task never overtakes one
+        // its producer pushed into the ring earlier
+        if (lane.overflow_count.load(std::memory_order_acquire) == 0 ||
+            lane.enqueue_pos.load(std::memory_order_acquire) != lane.dequeue_pos) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(lane.overflow_mutex);
+        if (lane.overflow.empty()) {
+            return false;
+        }
+        result = std::move(lane.overflow.front());
+        lane.overflow.pop_front();
+        lane.overflow_count.fetch_sub(1, std::memory_order_release);
+        lane.count.fetch_sub(1, std::memory_order_relaxed);
         return true;
     }
 
+    // Consumer only; size() may be read from any thread
+    bool empty(size_t lane_index) const {
+        const Lane& lane = lanes_[lane_index];
+        const Cell& cell = lane.cells[lane.dequeue_pos & lane.mask];
+        return cell.sequence.load(std::memory_order_acquire) != lane.dequeue_pos + 1 &&
+               lane.overflow_count.load(std::memory_order_acquire) == 0;
+    }
+
     bool empty() const {
-        return head.load(std::memory_order_relaxed) == nullptr;
+        for (size_t i = 0; i < LaneCount; ++i) {
+            if (!empty(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t size(size_t lane_index) const {
+        return lanes_[lane_index].count.load(std::memory_order_relaxed);
     }
 
     size_t size() const {
-        return count.load(std::memory_order_relaxed);
+        size_t total = 0;
+        for (const auto& lane : lanes_) {
+            total += lane.count.load(std::memory_order_relaxed);
+        }
+        return total;
     }
+
+    size_t capacity() const { return lanes_[0].mask + 1; }
+    // Pushes that found their ring full and took the allocating overflow path
+    uint64_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
 };
@@ -2,79 +2,102 @@
 
 #include <atomic>
 #include <memory>
+#include "EpochReclaimer.h"
+#include "SlabAllocator.h"
 
+// Michael-Scott multi-producer multi-consumer queue. A popped head node may still be
+// read by a consumer that loaded it before the pop, so it is retired through
+// EpochReclaimer instead of deleted; every push and pop runs inside an epoch guard.
+//
+// T must be default constructible (the queue keeps one dummy node) and move assignable.
 template<typename T>
 class LockFreeQueue {
 private:
     struct Node {
-        std::shared_ptr<T> data;
-        std::atomic<Node*> next;
-        Node() : next(nullptr) {}
+        T data;
+        std::atomic<Node*> next{nullptr};
+
+        Node() = default;
+        explicit Node(T value) : data(std::move(value)) {}
     };
 
-    std::atomic<Node*> head_;
-    std::atomic<Node*> tail_;
+    static void destroy_node(void* node) {
+        SlabAllocator::destroy(static_cast<Node*>(node));
+    }
+
+    alignas(64) std::atomic<Node*> head_;
+    alignas(64) std::atomic<Node*> tail_;
     std::atomic<size_t> size_;
 
 public:
     LockFreeQueue() : size_(0) {
-        Node* dummy = new Node();
+        Node* dummy = SlabAllocator::create<Node>();
         head_.store(dummy);
         tail_.store(dummy);
     }
 
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    // No other thread may use the queue any more; nodes retired earlier are not ours to free
     ~LockFreeQueue() {
-        while (Node* old_head = head_.load()) {
-            head_.store(old_head->next);
-            delete old_head;
+        Node* node = head_.load(std::memory_order_relaxed);
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            SlabAllocator::destroy(node);
+            node = next;
         }
     }
 
     void push(T item) {
-        std::shared_ptr<T> new_data(std::make_shared<T>(std::move(item)));
-        Node* new_node = new Node();
-        new_node->data = new_data;
+        // Nodes are usually freed by the consuming thread; the slab allocator batches
+        // those frees back to the producer's cache
+        Node* new_node = SlabAllocator::create<Node>(std::move(item));
+        EpochReclaimer::Guard guard;
 
         while (true) {
-            Node* old_tail = tail_.load();
-            Node* next = old_tail->next.load();
+            Node* old_tail = tail_.load(std::memory_order_acquire);
+            Node* next = old_tail->next.load(std::memory_order_acquire);
 
-            if (old_tail == tail_.load()) {
+            if (old_tail == tail_.load(std::memory_order_acquire)) {
                 if (next == nullptr) {
-                    if (old_tail->next.compare_exchange_weak(next, new_node)) {
-                        tail_.compare_exchange_weak(old_tail, new_node);
+                    if (old_tail->next.compare_exchange_weak(next, new_node, std::memory_order_release,
+                                                             std::memory_order_relaxed)) {
+                        tail_.compare_exchange_strong(old_tail, new_node, std::memory_order_release,
+                                                      std::memory_order_relaxed);
                         size_.fetch_add(1, std::memory_order_relaxed);
                         return;
                     }
                 } else {
-                    tail_.compare_exchange_weak(old_tail, next);
+                    tail_.compare_exchange_weak(old_tail, next, std::memory_order_release, std::memory_order_relaxed);
                 }
             }
         }
     }
 
     bool pop(T& item) {
+        EpochReclaimer::Guard guard;
         while (true) {
-            Node* old_head = head_.load();
-            Node* old_tail = tail_.load();
-            Node* next = old_head->next.load();
+            Node* old_head = head_.load(std::memory_order_acquire);
+            Node* old_tail = tail_.load(std::memory_order_acquire);
+            Node* next = old_head->next.load(std::memory_order_acquire);
 
-            if (old_head == head_.load()) {
-                if (old_head == old_tail) {
-                    if (next == nullptr) {
-                        return false;
-                    }
-                    tail_.compare_exchange_weak(old_tail, next);
-                } else {
-                    if (next) {
-                        item = std::move(*next->data);
-                        if (head_.compare_exchange_weak(old_head, next)) {
-                            size_.fetch_sub(1, std::memory_order_relaxed);
-                            delete old_head;
-                            return true;
-                        }
-                    }
-                }
+            if (old_head != head_.load(std::memory_order_acquire)) {
+                continue;
+            }
+            if (next == nullptr) {
+                return false;
+            }
+            if (old_head == old_tail) {
+                tail_.compare_exchange_weak(old_tail, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            // Only the consumer that wins the CAS takes the value; next becomes the dummy
+            if (head_.compare_exchange_weak(old_head, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                item = std::move(next->data);
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                EpochReclaimer::retire(old_head, &destroy_node);
+                return true;
             }
         }
     }
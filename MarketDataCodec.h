@@ -0,0 +1,360 @@
+#pragma once
+
+// Normalized market data in a fixed binary layout, after Simple Binary Encoding: every
+// message is an 8-byte MessageHeader, the template's fixed root block, then for books
+// two repeating groups of levels. Header-only and free of the client's dependencies so
+// other processes can decode what the fan-out server, the capture journal and the
+// shared-memory books produce.
+//
+// Prices and quantities are fixed point: integer units of 10^PRICE_EXPONENT, enough for
+// every Binance tick and step size. Timestamps are nanoseconds since the epoch, 0 when
+// unknown. Everything is native little-endian and 8-byte aligned relative to the start
+// of the message.
+//
+// Compatibility follows SBE: a newer schema version may only append fields to a block
+// and the header and group headers carry the encoded block lengths, so a decoder skips
+// fields it does not know. A decoder rejects blocks shorter than its own.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace md {
+
+constexpr uint16_t SCHEMA_ID = 0x4D44;  // "MD"
+constexpr uint16_t SCHEMA_VERSION = 1;
+constexpr int PRICE_EXPONENT = -8;
+constexpr int64_t PRICE_SCALE = 100000000;
+
+inline int64_t to_fixed(double value) {
+    return std::llround(value * static_cast<double>(PRICE_SCALE));
+}
+
+inline double to_double(int64_t value) {
+    return static_cast<double>(value) / static_cast<double>(PRICE_SCALE);
+}
+
+// Decimal text as the exchange sends it ("67012.34000000"), without going through a
+// double. False for anything else, including more than 8 decimals or overflow.
+inline bool parse_fixed(std::string_view text, int64_t& out) {
+    size_t i = 0;
+    bool negative = !text.empty() && text[0] == '-';
+    if (negative) {
+        ++i;
+    }
+    int64_t value = 0;
+    int digits = 0;
+    int decimals = -1;  // -1 until the point
+    for (; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '.' && decimals < 0) {
+            decimals = 0;
+            continue;
+        }
+        if (c < '0' || c > '9' || decimals == -PRICE_EXPONENT || value > (INT64_MAX - 9) / 10) {
+            return false;
+        }
+        value = value * 10 + (c - '0');
+        ++digits;
+        if (decimals >= 0) {
+            ++decimals;
+        }
+    }
+    if (digits == 0) {
+        return false;
+    }
+    for (int scale = decimals < 0 ? 0 : decimals; scale < -PRICE_EXPONENT; ++scale) {
+        if (value > INT64_MAX / 10) {
+            return false;
+        }
+        value *= 10;
+    }
+    out = negative ? -value : value;
+    return true;
+}
+
+enum class Exchange : uint8_t {
+    Unknown = 0,
+    Binance = 1,
+};
+
+enum class Side : uint8_t {
+    Unknown = 0,
+    Buy = 1,   // the aggressor bought: the resting order was a sell
+    Sell = 2,
+};
+
+struct MessageHeader {
+    uint16_t block_length;  // of the root block as encoded
+    uint16_t template_id;
+    uint16_t schema_id;
+    uint16_t version;
+};
+
+// Padded to 8 bytes so levels stay aligned
+struct GroupHeader {
+    uint16_t block_length;  // of one entry as encoded
+    uint16_t count;
+    uint32_t reserved;
+};
+
+struct Level {
+    int64_t price;
+    int64_t quantity;
+};
+
+// Top levels of a book, best first
+struct Snapshot {
+    static constexpr uint16_t TEMPLATE_ID = 1;
+    static constexpr bool HAS_LEVELS = true;
+
+    uint32_t symbol_id;
+    Exchange exchange;
+    uint8_t stale;  // 1 while the book is known to be behind the exchange
+    uint8_t reserved[2];
+    uint64_t sequence;   // per symbol and publisher
+    uint64_t update_id;  // exchange update ID the book is at
+    int64_t exchange_ns;
+    int64_t local_ns;
+};
+
+// Levels that changed since the previous message, quantity 0 for removed ones
+struct Delta {
+    static constexpr uint16_t TEMPLATE_ID = 2;
+    static constexpr bool HAS_LEVELS = true;
+
+    uint32_t symbol_id;
+    Exchange exchange;
+    uint8_t reserved[3];
+    uint64_t sequence;
+    uint64_t previous_update_id;
+    uint64_t update_id;
+    int64_t exchange_ns;
+    int64_t local_ns;
+};
+
+// Best bid and ask; a side without orders has price and quantity 0
+struct Bbo {
+    static constexpr uint16_t TEMPLATE_ID = 3;
+    static constexpr bool HAS_LEVELS = false;
+
+    uint32_t symbol_id;
+    Exchange exchange;
+    uint8_t reserved[3];
+    uint64_t sequence;
+    uint64_t update_id;
+    int64_t exchange_ns;
+    int64_t local_ns;
+    Level bid;
+    Level ask;
+};
+
+struct Trade {
+    static constexpr uint16_t TEMPLATE_ID = 4;
+    static constexpr bool HAS_LEVELS = false;
+
+    uint32_t symbol_id;
+    Exchange exchange;
+    Side aggressor;
+    uint8_t reserved[2];
+    uint64_t trade_id;  // the exchange's, which doubles as the sequence
+    int64_t exchange_ns;
+    int64_t local_ns;
+    int64_t price;
+    int64_t quantity;
+};
+
+// Names a symbol ID for the decoders that follow, e.g. once per connection and symbol
+struct SymbolDefinition {
+    static constexpr uint16_t TEMPLATE_ID = 5;
+    static constexpr bool HAS_LEVELS = false;
+    static constexpr size_t NAME_SIZE = 24;
+
+    uint32_t symbol_id;
+    Exchange exchange;
+    uint8_t reserved[3];
+    char name[NAME_SIZE];  // NUL-padded, longer names are cut
+
+    std::string_view symbol() const { return std::string_view(name, strnlen(name, NAME_SIZE)); }
+};
+
+template<typename Block>
+constexpr bool is_block = std::is_trivially_copyable_v<Block> && sizeof(Block) % 8 == 0 &&
+                          sizeof(Block) <= UINT16_MAX;
+
+static_assert(sizeof(MessageHeader) == 8 && sizeof(GroupHeader) == 8 && sizeof(Level) == 16);
+static_assert(is_block<Snapshot> && is_block<Delta> && is_block<Bbo> && is_block<Trade> &&
+              is_block<SymbolDefinition>);
+
+inline SymbolDefinition make_definition(uint32_t symbol_id, std::string_view symbol,
+                                        Exchange exchange = Exchange::Binance) {
+    SymbolDefinition definition{};
+    definition.symbol_id = symbol_id;
+    definition.exchange = exchange;
+    std::memcpy(definition.name, symbol.data(), std::min(symbol.size(), SymbolDefinition::NAME_SIZE));
+    return definition;
+}
+
+template<typename Block>
+constexpr size_t encoded_size(size_t bid_count = 0, size_t ask_count = 0) {
+    static_assert(is_block<Block>);
+    size_t size = sizeof(MessageHeader) + sizeof(Block);
+    if constexpr (Block::HAS_LEVELS) {
+        size += 2 * sizeof(GroupHeader) + (bid_count + ask_count) * sizeof(Level);
+    }
+    return size;
+}
+
+// Writes one message to out, which must have encoded_size<Block>() bytes. Returns the
+// number of bytes written.
+template<typename Block>
+size_t encode(char* out, const Block& block) {
+    static_assert(!Block::HAS_LEVELS, "book templates take their levels");
+    const MessageHeader header{sizeof(Block), Block::TEMPLATE_ID, SCHEMA_ID, SCHEMA_VERSION};
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + sizeof(header), &block, sizeof(block));
+    return encoded_size<Block>();
+}
+
+// Book templates; out must have encoded_size<Block>(bid_count, ask_count) bytes and a
+// side holds at most 65535 levels. A null side is left for the caller to write in place
+// at bids_offset / asks_offset, e.g. when converting from another representation.
+template<typename Block>
+size_t encode(char* out, const Block& block, const Level* bids, size_t bid_count, const Level* asks,
+              size_t ask_count) {
+    static_assert(Block::HAS_LEVELS, "only book templates have levels");
+    const MessageHeader header{sizeof(Block), Block::TEMPLATE_ID, SCHEMA_ID, SCHEMA_VERSION};
+    char* p = out;
+    std::memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    std::memcpy(p, &block, sizeof(block));
+    p += sizeof(block);
+    for (auto [levels, count] : {std::pair{bids, bid_count}, std::pair{asks, ask_count}}) {
+        const GroupHeader group{sizeof(Level), static_cast<uint16_t>(count), 0};
+        std::memcpy(p, &group, sizeof(group));
+        p += sizeof(group);
+        if (count && levels) {
+            std::memcpy(p, levels, count * sizeof(Level));
+        }
+        p += count * sizeof(Level);
+    }
+    return static_cast<size_t>(p - out);
+}
+
+template<typename Block>
+constexpr size_t bids_offset() {
+    static_assert(Block::HAS_LEVELS);
+    return sizeof(MessageHeader) + sizeof(Block) + sizeof(GroupHeader);
+}
+
+template<typename Block>
+constexpr size_t asks_offset(size_t bid_count) {
+    return bids_offset<Block>() + bid_count * sizeof(Level) + sizeof(GroupHeader);
+}
+
+// Replace out's contents, keeping its capacity
+template<typename Block>
+void encode(std::string& out, const Block& block) {
+    out.resize(encoded_size<Block>());
+    encode(out.data(), block);
+}
+
+template<typename Block>
+void encode(std::string& out, const Block& block, const Level* bids, size_t bid_count, const Level* asks,
+            size_t ask_count) {
+    out.resize(encoded_size<Block>(bid_count, ask_count));
+    encode(out.data(), block, bids, bid_count, asks, ask_count);
+}
+
+// Template of a message of this schema, 0 for anything else
+inline uint16_t template_id(std::string_view frame) {
+    MessageHeader header;
+    if (frame.size() < sizeof(header)) {
+        return 0;
+    }
+    std::memcpy(&header, frame.data(), sizeof(header));
+    return header.schema_id == SCHEMA_ID ? header.template_id : 0;
+}
+
+// One repeating group inside a received message
+class Levels {
+public:
+    Levels() = default;
+    Levels(const char* data, size_t count, size_t stride) : data_(data), count_(count), stride_(stride) {}
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+    Level operator[](size_t i) const {
+        Level level;
+        std::memcpy(&level, data_ + i * stride_, sizeof(level));
+        return level;
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t count_ = 0;
+    size_t stride_ = sizeof(Level);
+};
+
+// Reads a message in place; the frame must outlive the view. Fields are copied out on
+// access, so the frame needs no particular alignment.
+template<typename Block>
+class View {
+public:
+    // False if the frame is not a complete message of this template
+    bool wrap(std::string_view frame) {
+        MessageHeader header;
+        if (frame.size() < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, frame.data(), sizeof(header));
+        if (header.schema_id != SCHEMA_ID || header.template_id != Block::TEMPLATE_ID ||
+            header.block_length < sizeof(Block) || frame.size() < sizeof(header) + header.block_length) {
+            return false;
+        }
+        data_ = frame.data();
+        size_t offset = sizeof(header) + header.block_length;
+        if constexpr (Block::HAS_LEVELS) {
+            for (Levels* side : {&bids_, &asks_}) {
+                GroupHeader group;
+                if (frame.size() < offset + sizeof(group)) {
+                    return false;
+                }
+                std::memcpy(&group, frame.data() + offset, sizeof(group));
+                offset += sizeof(group);
+                if (group.block_length < sizeof(Level) || frame.size() < offset + size_t{group.count} * group.block_length) {
+                    return false;
+                }
+                *side = Levels(frame.data() + offset, group.count, group.block_length);
+                offset += size_t{group.count} * group.block_length;
+            }
+        }
+        size_ = offset;
+        return true;
+    }
+
+    Block block() const {
+        Block block;
+        std::memcpy(&block, data_ + sizeof(MessageHeader), sizeof(block));
+        return block;
+    }
+
+    const Levels& bids() const requires Block::HAS_LEVELS { return bids_; }
+    const Levels& asks() const requires Block::HAS_LEVELS { return asks_; }
+    // Bytes the message takes, for frames that carry several
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    Levels bids_;
+    Levels asks_;
+};
+
+}  // namespace md
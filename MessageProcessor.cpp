@@ -1,8 +1,13 @@
 #include "MessageProcessor.h"
 #include "OrderbookManager.h"
+#include "SymbolRouter.h"
+#include "TradeStatistics.h"
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <charconv>
+#include <cctype>
 #include <simdjson.h>
 #include <spdlog/spdlog.h>
 
@@ -32,40 +37,146 @@ void MessageProcessor::stop() {
 }
 
 void MessageProcessor::add_message(bool is_websocket, std::string&& message) {
+    add_message(is_websocket, std::move(message), std::string());
+}
+
+void MessageProcessor::set_router(SymbolRouter* router) {
+    router_ = router;
+}
+
+void MessageProcessor::set_inline(bool process_inline) {
+    inline_ = process_inline;
+}
+
+void MessageProcessor::set_trade_statistics(TradeStatistics* trade_statistics) {
+    trade_statistics_ = trade_statistics;
+}
+
+std::string MessageProcessor::stream_symbol(const std::string& message) {
+    static constexpr std::string_view prefix = "{\"stream\":\"";
+    if (message.compare(0, prefix.size(), prefix) != 0) {
+        return std::string();
+    }
+    size_t end = message.find_first_of("@\"", prefix.size());
+    if (end == std::string::npos || message[end] != '@') {
+        return std::string();
+    }
+    return message.substr(prefix.size(), end - prefix.size());
+}
+
+void MessageProcessor::add_message(bool is_websocket, std::string&& message, const std::string& symbol) {
+    if (inline_) {
+        process_message(Message{is_websocket, std::move(message), symbol}, parser_);
+        return;
+    }
+    if (router_) {
+        std::string route_symbol = symbol.empty() ? stream_symbol(message) : symbol;
+        if (!route_symbol.empty()) {
+            router_->route(route_symbol, [this, msg = Message{is_websocket, std::move(message), route_symbol}]() {
+                // One parser per loop thread; the shared parser_ belongs to the market data loop
+                thread_local simdjson::dom::parser parser;
+                process_message(msg, parser);
+            });
+            return;
+        }
+    }
     if (message_queue_.size() > MAX_QUEUE_SIZE) {
         spdlog::warn("Message queue full, dropping message");
         return; // Back-pressure: drop messages if queue is full
     }
-    message_queue_.push({is_websocket, std::move(message)});
+    message_queue_.push({is_websocket, std::move(message), symbol});
     queue_size->Add({}).Set(message_queue_.size());
+    schedule_processing();
 }
 
 void MessageProcessor::process_messages() {
+    // Cleared before draining: a message pushed after this point posts the next drain.
+    // The exchange also pairs with the producer's, so everything it pushed is visible.
+    scheduled_.exchange(false);
+    if (!running_) {
+        return;  // run() posts a drain for what is queued meanwhile
+    }
     Message msg;
     while (message_queue_.pop(msg)) {
-        if (!deduplicator_.is_duplicate(msg.content)) {
-            simdjson::dom::parser parser;
-            simdjson::dom::element doc = parser.parse(msg.content);
-            
-            try {
-                if (msg.is_websocket) {
-                    orderbook_manager_.OnOrderbookWs("", doc);
-                } else {
-                    orderbook_manager_.OnOrderbookRest("", doc);
-                }
-                messages_processed->Add({}).Increment();
-            } catch (const std::exception& e) {
-                spdlog::error("Error processing message: {}", e.what());
-            }
-        }
+        process_message(msg, parser_);
     }
     queue_size->Add({}).Set(message_queue_.size());
+}
 
-    if (running_) {
-        schedule_processing();
+void MessageProcessor::process_message(const Message& msg, simdjson::dom::parser& parser) {
+    if (deduplicator_.is_duplicate(msg.content)) {
+        return;
+    }
+    simdjson::dom::element doc;
+    auto error = parser.parse(msg.content).get(doc);
+    if (error) {
+        spdlog::error("Error parsing message: {}", simdjson::error_message(error));
+        return;
+    }
+
+    try {
+        dispatch(msg, doc);
+        messages_processed->Add({}).Increment();
+    } catch (const std::exception& e) {
+        spdlog::error("Error processing message: {}", e.what());
+    }
+}
+
+void MessageProcessor::dispatch(const Message& msg, const simdjson::dom::element& doc) {
+    simdjson::dom::element payload = doc;
+    std::string symbol = msg.symbol;
+
+    // Combined streams wrap each event as {"stream":"btcusdt@depth","data":{...}}
+    std::string_view stream;
+    simdjson::dom::element data;
+    if (!doc["stream"].get(stream) && !doc["data"].get(data)) {
+        payload = data;
+        if (symbol.empty()) {
+            symbol.assign(stream.substr(0, stream.find('@')));
+        }
+    } else if (!doc["result"].error()) {
+        return; // SUBSCRIBE/UNSUBSCRIBE acknowledgement
+    }
+
+    // Depth events share the connection with trades; only trades are routed elsewhere
+    std::string_view event;
+    if (msg.is_websocket && !payload["e"].get(event) && (event == "trade" || event == "aggTrade")) {
+        on_trade(symbol, event, payload);
+        return;
+    }
+
+    if (msg.is_websocket) {
+        orderbook_manager_.OnOrderbookWs(symbol, payload);
+    } else {
+        orderbook_manager_.OnOrderbookRest(symbol, payload);
     }
 }
 
+void MessageProcessor::on_trade(const std::string& symbol, std::string_view event,
+                                const simdjson::dom::element& payload) {
+    if (!trade_statistics_) {
+        return;
+    }
+    std::string_view price_text = payload["p"].get_string();
+    std::string_view quantity_text = payload["q"].get_string();
+    double price = 0.0, quantity = 0.0;
+    std::from_chars(price_text.data(), price_text.data() + price_text.size(), price);
+    std::from_chars(quantity_text.data(), quantity_text.data() + quantity_text.size(), quantity);
+    uint64_t trade_id = payload[event == "trade" ? "t" : "a"].get_uint64();
+    int64_t trade_time_ms = payload["T"].get_int64();
+
+    if (symbol.empty()) {
+        // A raw stream without a known symbol; books are keyed in lower case
+        std::string name(std::string_view(payload["s"].get_string()));
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+        trade_statistics_->on_trade(name, trade_id, price, quantity, trade_time_ms);
+        return;
+    }
+    trade_statistics_->on_trade(symbol, trade_id, price, quantity, trade_time_ms);
+}
+
 void MessageProcessor::schedule_processing() {
-    ioc_.post([this]() { process_messages(); });
+    if (!scheduled_.exchange(true)) {
+        ioc_.post([this]() { process_messages(); });
+    }
 }
@@ -8,8 +8,11 @@
 #include <prometheus/counter.h>
 #include <prometheus/gauge.h>
 #include <boost/asio.hpp>
+#include <simdjson.h>
 
 class OrderbookManager;
+class SymbolRouter;
+class TradeStatistics;
 
 class MessageProcessor {
 public:
@@ -17,6 +20,18 @@ public:
     void run();
     void stop();
     void add_message(bool is_websocket, std::string&& message);
+    // symbol may be empty for combined streams, it is then taken from the "stream" wrapper
+    void add_message(bool is_websocket, std::string&& message, const std::string& symbol);
+    // Messages with a known symbol are processed on the symbol's loop instead of the shared queue
+    void set_router(SymbolRouter* router);
+    // Parse and apply on the calling thread instead of queueing. For shard-per-core mode,
+    // where a shard's connections run on the loop that owns its books and processor.
+    void set_inline(bool process_inline);
+    // Trade and aggTrade events go to these statistics instead of the books; without
+    // them they are dropped. Set before messages arrive.
+    void set_trade_statistics(TradeStatistics* trade_statistics);
+    // Symbol of a combined-stream message ({"stream":"btcusdt@depth",...}), empty if not one
+    static std::string stream_symbol(const std::string& message);
 
 private:
     static constexpr size_t MAX_QUEUE_SIZE = 1000000; // 1 million messages
@@ -24,18 +39,30 @@ private:
     struct Message {
         bool is_websocket;
         std::string content;
+        std::string symbol;
     };
 
     boost::asio::io_context& ioc_;
     OrderbookManager& orderbook_manager_;
     LockFreeQueue<Message> message_queue_;
     std::atomic<bool> running_;
+    // A drain is posted only when none is pending, so an idle processor leaves its loop
+    // with nothing to run and the loop can park
+    std::atomic<bool> scheduled_{false};
     Deduplicator deduplicator_;
+    simdjson::dom::parser parser_;
 
     std::shared_ptr<prometheus::Registry> prometheus_registry;
     prometheus::Family<prometheus::Counter>* messages_processed;
     prometheus::Family<prometheus::Gauge>* queue_size;
 
+    SymbolRouter* router_ = nullptr;
+    bool inline_ = false;
+    TradeStatistics* trade_statistics_ = nullptr;
+
     void process_messages();
+    void process_message(const Message& msg, simdjson::dom::parser& parser);
+    void dispatch(const Message& msg, const simdjson::dom::element& doc);
+    void on_trade(const std::string& symbol, std::string_view event, const simdjson::dom::element& payload);
     void schedule_processing();
 };
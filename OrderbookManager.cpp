@@ -1,15 +1,31 @@
 #include "OrderbookManager.h"
+#include "SharedBookPublisher.h"
+#include "MarketDataCodec.h"
 #include <immintrin.h>
 #include <iostream>
 #include <algorithm>
 #include <sstream>
+#include <charconv>
+#include <chrono>
+#include <cstring>
 #include <simdjson.h>
 
 OrderbookManager::OrderbookManager(size_t shard_count) : shards(shard_count) {}
 
-void OrderbookManager::updateOrderbook(const std::string& symbol, const std::vector<PriceLevel>& bids, const std::vector<PriceLevel>& asks) {
-    size_t shard_index = std::hash<std::string>{}(symbol) % shards.size();
-    auto& shard = shards[shard_index];
+size_t OrderbookManager::shardIndex(const std::string& symbol) const {
+    return std::hash<std::string>{}(symbol) % shards.size();
+}
+
+OrderbookManager::Shard& OrderbookManager::shardFor(const std::string& symbol) {
+    return shards[shardIndex(symbol)];
+}
+
+const OrderbookManager::Shard& OrderbookManager::shardFor(const std::string& symbol) const {
+    return shards[shardIndex(symbol)];
+}
+
+void OrderbookManager::updateOrderbook(const std::string& symbol, const PriceLevels& bids, const PriceLevels& asks) {
+    auto& shard = shardFor(symbol);
     std::lock_guard<std::mutex> lock(shard.mutex);
     
     tbb::concurrent_hash_map<std::string, Orderbook>::accessor acc;
@@ -20,39 +36,43 @@ void OrderbookManager::updateOrderbook(const std::string& symbol, const std::vec
         updatePriceLevels(acc->second.bids, bids);
         updatePriceLevels(acc->second.asks, asks);
     }
-    
-    std::sort(acc->second.bids.begin(), acc->second.bids.end(), 
+    sortLevels(acc->second);
+    publishView(shard, symbol, acc->second);
+}
+
+void OrderbookManager::sortLevels(Orderbook& book) {
+    std::sort(book.bids.begin(), book.bids.end(), 
               [](const PriceLevel& a, const PriceLevel& b) { return a.price > b.price; });
-    std::sort(acc->second.asks.begin(), acc->second.asks.end(), 
+    std::sort(book.asks.begin(), book.asks.end(), 
               [](const PriceLevel& a, const PriceLevel& b) { return a.price < b.price; });
 }
 
-void OrderbookManager::updatePriceLevels(std::vector<PriceLevel>& existing, const std::vector<PriceLevel>& updates) {
+void OrderbookManager::updatePriceLevels(PriceLevels& existing, const PriceLevels& updates) {
     const int vectorSize = 4; // AVX2 supports 4 doubles per vector
     const int numVectors = updates.size() / vectorSize;
 
     for (int i = 0; i < numVectors; ++i) {
-        __m256d updatePrices = _mm256_loadu_pd(&updates[i * vectorSize].price);
-        __m256d updateQuantities = _mm256_loadu_pd(&updates[i * vectorSize].quantity);
+        const PriceLevel* batch = &updates[i * vectorSize];
+        // PriceLevel interleaves price and quantity, so gather the four prices explicitly
+        __m256d updatePrices = _mm256_set_pd(batch[3].price, batch[2].price, batch[1].price, batch[0].price);
+        int matched = 0;
 
         for (auto& level : existing) {
             __m256d existingPrice = _mm256_set1_pd(level.price);
-            __m256d mask = _mm256_cmp_pd(existingPrice, updatePrices, _CMP_EQ_OQ);
+            int mask = _mm256_movemask_pd(_mm256_cmp_pd(existingPrice, updatePrices, _CMP_EQ_OQ));
 
-            if (_mm256_movemask_pd(mask)) {
-                int index = __builtin_ctz(_mm256_movemask_pd(mask));
-                level.quantity = updates[i * vectorSize + index].quantity;
+            if (mask) {
+                int index = 31 - __builtin_clz(mask); // the latest update for a price wins
+                level.quantity = batch[index].quantity;
+                matched |= mask;
             }
         }
 
         // Handle new price levels
-        __m256d zeroMask = _mm256_cmp_pd(updateQuantities, _mm256_setzero_pd(), _CMP_NEQ_OQ);
-        int newLevelsMask = _mm256_movemask_pd(zeroMask);
-
-        while (newLevelsMask) {
-            int index = __builtin_ctz(newLevelsMask);
-            existing.push_back(updates[i * vectorSize + index]);
-            newLevelsMask &= newLevelsMask - 1; // Clear the least significant bit
+        for (int j = 0; j < vectorSize; ++j) {
+            if (!(matched & (1 << j)) && batch[j].quantity != 0.0) {
+                existing.push_back(batch[j]);
+            }
         }
     }
 
@@ -74,71 +94,459 @@ void OrderbookManager::updatePriceLevels(std::vector<PriceLevel>& existing, cons
                    existing.end());
 }
 
-void OrderbookManager::OnOrderbookWs(const std::string& symbol, const simdjson::dom::element& message) {
-    std::vector<PriceLevel> bids, asks;
-    
-    simdjson::dom::array bids_array;
-    simdjson::dom::array asks_array;
-    
-    auto error = message["bids"].get(bids_array);
-    if (!error) {
-        for (auto bid : bids_array) {
-            simdjson::dom::array bid_array;
-            if (!bid.get(bid_array) && bid_array.size() >= 2) {
-                double price, quantity;
-                if (!bid_array.at(0).get(price) && !bid_array.at(1).get(quantity)) {
-                    bids.push_back({price, quantity});
-                }
+bool OrderbookManager::applyDiff(Orderbook& book, const DepthDiff& diff) {
+    if (diff.final_update_id <= book.last_update_id) {
+        return true; // already covered by the snapshot or an earlier diff
+    }
+    if (diff.first_update_id > book.last_update_id + 1) {
+        return false; // gap: updates were missed
+    }
+    updatePriceLevels(book.bids, diff.bids);
+    updatePriceLevels(book.asks, diff.asks);
+    sortLevels(book);
+    book.last_update_id = diff.final_update_id;
+    return true;
+}
+
+void OrderbookManager::parseLevels(const simdjson::dom::element& message, const char* key, const char* alt_key, PriceLevels& out) {
+    // Binance sends prices and quantities as strings; plain numbers are accepted too
+    auto parse_number = [](auto value, double& result) {
+        std::string_view text;
+        if (!value.get(text)) {
+            auto parsed = std::from_chars(text.data(), text.data() + text.size(), result);
+            return parsed.ec == std::errc();
+        }
+        return !value.get(result);
+    };
+
+    simdjson::dom::array levels;
+    if (message[key].get(levels) && message[alt_key].get(levels)) {
+        return;
+    }
+    out.reserve(levels.size());
+    for (auto level : levels) {
+        simdjson::dom::array pair;
+        if (!level.get(pair) && pair.size() >= 2) {
+            double price, quantity;
+            if (parse_number(pair.at(0), price) && parse_number(pair.at(1), quantity)) {
+                out.push_back({price, quantity});
             }
         }
     }
-    
-    error = message["asks"].get(asks_array);
-    if (!error) {
-        for (auto ask : asks_array) {
-            simdjson::dom::array ask_array;
-            if (!ask.get(ask_array) && ask_array.size() >= 2) {
-                double price, quantity;
-                if (!ask_array.at(0).get(price) && !ask_array.at(1).get(quantity)) {
-                    asks.push_back({price, quantity});
+}
+
+void OrderbookManager::notifySync(const std::string& symbol, bool synced) {
+    if (sync_listener_) {
+        sync_listener_(symbol, synced);
+    }
+}
+
+void OrderbookManager::setSyncListener(SyncListener listener) {
+    sync_listener_ = std::move(listener);
+}
+
+void OrderbookManager::setViewListener(ViewListener listener) {
+    view_listener_ = std::move(listener);
+}
+
+void OrderbookManager::setSharedPublisher(SharedBookPublisher* publisher) {
+    shared_publisher_ = publisher;
+}
+
+void OrderbookManager::OnOrderbookWs(const std::string& symbol, const simdjson::dom::element& message) {
+    DepthDiff diff;
+    parseLevels(message, "b", "bids", diff.bids);
+    parseLevels(message, "a", "asks", diff.asks);
+
+    if (message["U"].get(diff.first_update_id) || message["u"].get(diff.final_update_id)) {
+        // No update IDs to sequence against, apply as is
+        updateOrderbook(symbol, diff.bids, diff.asks);
+        return;
+    }
+
+    bool lost_sync = false;
+    bool resumed = false;
+    {
+        auto& shard = shardFor(symbol);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        tbb::concurrent_hash_map<std::string, Orderbook>::accessor acc;
+        bool found = shard.orderbooks.find(acc, symbol);
+        if (found && acc->second.stale && !acc->second.synced) {
+            Orderbook& book = acc->second;
+            if (diff.final_update_id <= book.last_update_id) {
+                return;
+            }
+            if (diff.first_update_id <= book.last_update_id + 1) {
+                // The live stream continues where the checkpoint left off
+                applyDiff(book, diff);
+                book.synced = true;
+                book.stale = false;
+                resumed = true;
+                publishView(shard, symbol, book);
+            } else {
+                auto& pending = shard.pending_diffs[symbol];
+                lost_sync = pending.empty();
+                if (pending.size() >= MAX_PENDING_DIFFS) {
+                    pending.pop_front();
                 }
+                pending.push_back(std::move(diff));
+            }
+        } else if (!found || !acc->second.synced) {
+            auto& pending = shard.pending_diffs[symbol];
+            if (pending.size() >= MAX_PENDING_DIFFS) {
+                pending.pop_front();
+            }
+            pending.push_back(std::move(diff));
+            return;
+        } else {
+            const uint64_t applied_before = acc->second.last_update_id;
+            if (!applyDiff(acc->second, diff)) {
+                acc->second.synced = false;
+                shard.pending_diffs[symbol].push_back(std::move(diff));
+                lost_sync = true;
+            } else if (acc->second.last_update_id != applied_before) {
+                publishView(shard, symbol, acc->second);
             }
         }
     }
-    
-    updateOrderbook(symbol, bids, asks);
+    if (lost_sync) {
+        notifySync(symbol, false);
+    } else if (resumed) {
+        notifySync(symbol, true);
+    }
 }
 
 void OrderbookManager::OnOrderbookRest(const std::string& symbol, const simdjson::dom::element& message) {
-    OnOrderbookWs(symbol, message);
+    uint64_t last_update_id;
+    if (message["lastUpdateId"].get(last_update_id)) {
+        OnOrderbookWs(symbol, message);
+        return;
+    }
+
+    PriceLevels bids, asks;
+    parseLevels(message, "bids", "b", bids);
+    parseLevels(message, "asks", "a", asks);
+
+    bool was_synced = false;
+    bool synced = false;
+    {
+        auto& shard = shardFor(symbol);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        tbb::concurrent_hash_map<std::string, Orderbook>::accessor acc;
+        shard.orderbooks.insert(acc, symbol);
+        Orderbook& book = acc->second;
+        was_synced = book.synced;
+        if (book.synced && last_update_id <= book.last_update_id) {
+            return; // the live book is already newer than this snapshot
+        }
+
+        book.bids = std::move(bids);
+        book.asks = std::move(asks);
+        sortLevels(book);
+        book.last_update_id = last_update_id;
+        book.synced = true;
+        book.stale = false;
+
+        // Replay diffs buffered while waiting for the snapshot; keep them from the first gap on
+        auto it = shard.pending_diffs.find(symbol);
+        if (it != shard.pending_diffs.end()) {
+            auto& pending = it->second;
+            while (!pending.empty() && applyDiff(book, pending.front())) {
+                pending.pop_front();
+            }
+            book.synced = pending.empty();
+            if (pending.empty()) {
+                shard.pending_diffs.erase(it);
+            }
+        }
+        synced = book.synced;
+        publishView(shard, symbol, book);
+    }
+
+    if (synced != was_synced || !synced) {
+        notifySync(symbol, synced);
+    }
+}
+
+bool OrderbookManager::isSynced(const std::string& symbol) const {
+    const auto& shard = shardFor(symbol);
+    tbb::concurrent_hash_map<std::string, Orderbook>::const_accessor acc;
+    return shard.orderbooks.find(acc, symbol) && acc->second.synced;
+}
+
+uint64_t OrderbookManager::getLastUpdateId(const std::string& symbol) const {
+    const auto& shard = shardFor(symbol);
+    tbb::concurrent_hash_map<std::string, Orderbook>::const_accessor acc;
+    return shard.orderbooks.find(acc, symbol) ? acc->second.last_update_id : 0;
+}
+
+std::vector<std::pair<std::string, Orderbook>> OrderbookManager::exportBooks() const {
+    std::vector<std::pair<std::string, Orderbook>> books;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& [symbol, book] : shard.orderbooks) {
+            if (book.last_update_id != 0 || !book.bids.empty() || !book.asks.empty()) {
+                books.emplace_back(symbol, book);
+            }
+        }
+    }
+    return books;
+}
+
+void OrderbookManager::restoreBook(const std::string& symbol, Orderbook book) {
+    book.synced = false;
+    book.stale = true;
+    sortLevels(book);
+
+    auto& shard = shardFor(symbol);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    tbb::concurrent_hash_map<std::string, Orderbook>::accessor acc;
+    if (shard.orderbooks.insert(acc, symbol)) {
+        acc->second = std::move(book);
+    } else if (acc->second.last_update_id == 0) {
+        // Reserved but never filled: copy into the reserved storage
+        Orderbook& existing = acc->second;
+        existing.bids.assign(book.bids.begin(), book.bids.end());
+        existing.asks.assign(book.asks.begin(), book.asks.end());
+        existing.last_update_id = book.last_update_id;
+        existing.synced = false;
+        existing.stale = true;
+    } else {
+        return;
+    }
+    publishView(shard, symbol, acc->second);
+}
+
+void OrderbookManager::reserveBook(const std::string& symbol, size_t levels) {
+    auto& shard = shardFor(symbol);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    tbb::concurrent_hash_map<std::string, Orderbook>::accessor acc;
+    shard.orderbooks.insert(acc, symbol);
+    acc->second.bids.reserve(levels);
+    acc->second.asks.reserve(levels);
+}
+
+bool OrderbookManager::isStale(const std::string& symbol) const {
+    const auto& shard = shardFor(symbol);
+    tbb::concurrent_hash_map<std::string, Orderbook>::const_accessor acc;
+    return shard.orderbooks.find(acc, symbol) && acc->second.stale;
+}
+
+void OrderbookManager::publishView(Shard& shard, const std::string& symbol, const Orderbook& book) {
+    auto view = std::make_unique<BookView>();
+    view->last_update_id = book.last_update_id;
+    view->stale = book.stale;
+    view->bid_count = static_cast<uint32_t>(std::min(book.bids.size(), BookView::DEPTH));
+    view->ask_count = static_cast<uint32_t>(std::min(book.asks.size(), BookView::DEPTH));
+    std::copy_n(book.bids.begin(), view->bid_count, view->bids);
+    std::copy_n(book.asks.begin(), view->ask_count, view->asks);
+
+    if (view_listener_) {
+        view_listener_(symbol, *view);
+    }
+    tbb::concurrent_hash_map<std::string, EpochPublished<BookView>>::accessor acc;
+    shard.views.insert(acc, symbol);
+    acc->second.publish(std::move(view));
+
+    if (shared_publisher_) {
+        auto slot = shard.shared_slots.find(symbol);
+        if (slot == shard.shared_slots.end()) {
+            slot = shard.shared_slots.emplace(symbol, shared_publisher_->slot_for(symbol)).first;
+        }
+        if (slot->second != SharedBookPublisher::NO_SLOT) {
+            shared_publisher_->publish(slot->second, book);
+        }
+    }
 }
 
 std::string OrderbookManager::getOrderbookSnapshot(const std::string& symbol, int depth) const {
-    size_t shard_index = std::hash<std::string>{}(symbol) % shards.size();
-    const auto& shard = shards[shard_index];
-    
+    const auto& shard = shardFor(symbol);
+    const size_t levels = static_cast<size_t>(std::max(depth, 0));
+
+    if (levels <= BookView::DEPTH) {
+        EpochReclaimer::Guard guard;
+        const BookView* view = nullptr;
+        {
+            tbb::concurrent_hash_map<std::string, EpochPublished<BookView>>::const_accessor acc;
+            if (shard.views.find(acc, symbol)) {
+                view = acc->second.read(guard);  // stays valid under the guard once acc is released
+            }
+        }
+        if (view == nullptr || (view->last_update_id == 0 && view->bid_count == 0 && view->ask_count == 0)) {
+            return "{}";  // unknown, or reserved and nothing received yet
+        }
+        return formatSnapshot(view->bids, std::min<size_t>(levels, view->bid_count), view->asks,
+                              std::min<size_t>(levels, view->ask_count), view->stale);
+    }
+
     tbb::concurrent_hash_map<std::string, Orderbook>::const_accessor acc;
     if (!shard.orderbooks.find(acc, symbol)) {
         return "{}";
     }
     
     const auto& orderbook = acc->second;
+    if (orderbook.last_update_id == 0 && orderbook.bids.empty() && orderbook.asks.empty()) {
+        return "{}";  // reserved, nothing received yet
+    }
+    return formatSnapshot(orderbook.bids.data(), std::min(levels, orderbook.bids.size()), orderbook.asks.data(),
+                          std::min(levels, orderbook.asks.size()), orderbook.stale);
+}
+
+void OrderbookManager::getSnapshots(const std::vector<std::string>& symbols, int depth, BookBatch& out) const {
+    out.reset(symbols.size());
+    out.positions.resize(symbols.size());
+    for (uint32_t i = 0; i < symbols.size(); ++i) {
+        out.positions[i] = i;
+    }
+    appendSnapshots(symbols, out.positions, depth, out);
+}
+
+void OrderbookManager::appendSnapshots(const std::vector<std::string>& symbols, const std::vector<uint32_t>& positions,
+                                       int depth, BookBatch& out) const {
+    const size_t levels = static_cast<size_t>(std::max(depth, 0));
+    out.order.clear();
+    for (uint32_t position : positions) {
+        out.order.emplace_back(shardIndex(symbols[position]), position);
+    }
+    std::sort(out.order.begin(), out.order.end());
+
+    if (levels <= BookView::DEPTH) {
+        EpochReclaimer::Guard guard;
+        for (const auto& [shard_index, position] : out.order) {
+            const BookView* view = nullptr;
+            {
+                tbb::concurrent_hash_map<std::string, EpochPublished<BookView>>::const_accessor acc;
+                if (shards[shard_index].views.find(acc, symbols[position])) {
+                    view = acc->second.read(guard);
+                }
+            }
+            if (view == nullptr || (view->last_update_id == 0 && view->bid_count == 0 && view->ask_count == 0)) {
+                continue;
+            }
+            addToBatch(out, position, view->last_update_id, view->stale, view->bids,
+                       std::min<size_t>(levels, view->bid_count), view->asks, std::min<size_t>(levels, view->ask_count));
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < out.order.size();) {
+        const size_t shard_index = out.order[i].first;
+        const Shard& shard = shards[shard_index];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (; i < out.order.size() && out.order[i].first == shard_index; ++i) {
+            const uint32_t position = out.order[i].second;
+            tbb::concurrent_hash_map<std::string, Orderbook>::const_accessor acc;
+            if (!shard.orderbooks.find(acc, symbols[position])) {
+                continue;
+            }
+            const auto& orderbook = acc->second;
+            if (orderbook.last_update_id == 0 && orderbook.bids.empty() && orderbook.asks.empty()) {
+                continue;
+            }
+            addToBatch(out, position, orderbook.last_update_id, orderbook.stale, orderbook.bids.data(),
+                       std::min(levels, orderbook.bids.size()), orderbook.asks.data(),
+                       std::min(levels, orderbook.asks.size()));
+        }
+    }
+}
+
+void OrderbookManager::addToBatch(BookBatch& out, uint32_t position, uint64_t last_update_id, bool stale,
+                                  const PriceLevel* bids, size_t bid_count, const PriceLevel* asks, size_t ask_count) {
+    BookBatch::Book& book = out.books[position];
+    book.found = true;
+    book.stale = stale;
+    book.last_update_id = last_update_id;
+    book.bid_count = static_cast<uint32_t>(bid_count);
+    book.ask_count = static_cast<uint32_t>(ask_count);
+    book.offset = out.levels.size();
+    out.levels.insert(out.levels.end(), bids, bids + bid_count);
+    out.levels.insert(out.levels.end(), asks, asks + ask_count);
+}
+
+bool OrderbookManager::encodeSnapshot(const std::string& symbol, int depth, uint32_t symbol_id,
+                                      std::string& out) const {
+    out.clear();
+    const auto& shard = shardFor(symbol);
+    const size_t levels = static_cast<size_t>(std::max(depth, 0));
+
+    if (levels <= BookView::DEPTH) {
+        EpochReclaimer::Guard guard;
+        const BookView* view = nullptr;
+        {
+            tbb::concurrent_hash_map<std::string, EpochPublished<BookView>>::const_accessor acc;
+            if (shard.views.find(acc, symbol)) {
+                view = acc->second.read(guard);
+            }
+        }
+        if (view == nullptr || (view->last_update_id == 0 && view->bid_count == 0 && view->ask_count == 0)) {
+            return false;
+        }
+        encodeSnapshotMessage(view->bids, std::min<size_t>(levels, view->bid_count), view->asks,
+                              std::min<size_t>(levels, view->ask_count), view->stale, view->last_update_id,
+                              symbol_id, out);
+        return true;
+    }
+
+    tbb::concurrent_hash_map<std::string, Orderbook>::const_accessor acc;
+    if (!shard.orderbooks.find(acc, symbol)) {
+        return false;
+    }
+    const auto& orderbook = acc->second;
+    if (orderbook.last_update_id == 0 && orderbook.bids.empty() && orderbook.asks.empty()) {
+        return false;
+    }
+    encodeSnapshotMessage(orderbook.bids.data(), std::min(levels, orderbook.bids.size()), orderbook.asks.data(),
+                          std::min(levels, orderbook.asks.size()), orderbook.stale, orderbook.last_update_id,
+                          symbol_id, out);
+    return true;
+}
+
+void OrderbookManager::encodeSnapshotMessage(const PriceLevel* bids, size_t bid_count, const PriceLevel* asks,
+                                             size_t ask_count, bool stale, uint64_t update_id,
+                                             uint32_t symbol_id, std::string& out) {
+    md::Snapshot block{};
+    block.symbol_id = symbol_id;
+    block.exchange = md::Exchange::Binance;
+    block.stale = stale ? 1 : 0;
+    block.update_id = update_id;
+    block.local_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    // Levels are converted straight into the message
+    md::encode(out, block, nullptr, bid_count, nullptr, ask_count);
+    auto write = [&out](size_t offset, const PriceLevel* levels, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            const md::Level level{md::to_fixed(levels[i].price), md::to_fixed(levels[i].quantity)};
+            std::memcpy(out.data() + offset + i * sizeof(md::Level), &level, sizeof(level));
+        }
+    };
+    write(md::bids_offset<md::Snapshot>(), bids, bid_count);
+    write(md::asks_offset<md::Snapshot>(bid_count), asks, ask_count);
+}
+
+std::string OrderbookManager::formatSnapshot(const PriceLevel* bids, size_t bid_count, const PriceLevel* asks,
+                                             size_t ask_count, bool stale) {
     std::stringstream ss;
     ss << "{\"bids\":[";
     
-    for (int i = 0; i < std::min(depth, static_cast<int>(orderbook.bids.size())); ++i) {
+    for (size_t i = 0; i < bid_count; ++i) {
         if (i > 0) ss << ",";
-        ss << "[\"" << orderbook.bids[i].price << "\",\"" << orderbook.bids[i].quantity << "\"]";
+        ss << "[\"" << bids[i].price << "\",\"" << bids[i].quantity << "\"]";
     }
     
     ss << "],\"asks\":[";
     
-    for (int i = 0; i < std::min(depth, static_cast<int>(orderbook.asks.size())); ++i) {
+    for (size_t i = 0; i < ask_count; ++i) {
         if (i > 0) ss << ",";
-        ss << "[\"" << orderbook.asks[i].price << "\",\"" << orderbook.asks[i].quantity << "\"]";
+        ss << "[\"" << asks[i].price << "\",\"" << asks[i].quantity << "\"]";
     }
     
-    ss << "]}";
+    ss << "]";
+    if (stale) {
+        ss << ",\"stale\":true";
+    }
+    ss << "}";
     
     return ss.str();
 }
@@ -3,37 +3,163 @@
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include <deque>
+#include <functional>
 #include <mutex>
 #include <shared_mutex>
 #include <tbb/concurrent_hash_map.h>
 #include <simdjson.h>
 #include <immintrin.h>
-#include "MemoryPool.h"
+#include "EpochReclaimer.h"
+#include "SlabAllocator.h"
+
+class SharedBookPublisher;
 
 struct PriceLevel {
     double price;
     double quantity;
 };
 
+// Level storage comes from the updating thread's slab cache
+using PriceLevels = std::vector<PriceLevel, SlabStlAllocator<PriceLevel>>;
+
 struct Orderbook {
-    std::vector<PriceLevel> bids;
-    std::vector<PriceLevel> asks;
+    PriceLevels bids;
+    PriceLevels asks;
+    uint64_t last_update_id = 0;
+    bool synced = false;  // snapshot applied and every diff since then was contiguous
+    bool stale = false;   // restored from a checkpoint, not yet confirmed by the exchange
+};
+
+// Top of a book as its writer last published it. Readers get it without taking the
+// book's lock, so formatting a snapshot never stalls the thread applying diffs.
+struct BookView {
+    static constexpr size_t DEPTH = 20;
+
+    uint64_t last_update_id = 0;
+    bool stale = false;
+    uint32_t bid_count = 0;
+    uint32_t ask_count = 0;
+    PriceLevel bids[DEPTH];
+    PriceLevel asks[DEPTH];
+
+    static void* operator new(size_t size) { return SlabAllocator::allocate(size, alignof(BookView)); }
+    static void operator delete(void* p, size_t size) { SlabAllocator::deallocate(p, size, alignof(BookView)); }
+};
+
+// Reusable output of OrderbookManager::getSnapshots. Keep one per caller across cycles:
+// its vectors only grow, so steady-state queries do not allocate.
+struct BookBatch {
+    struct Book {
+        bool found = false;  // false where getOrderbookSnapshot gives "{}"
+        bool stale = false;
+        uint64_t last_update_id = 0;
+        uint32_t bid_count = 0;
+        uint32_t ask_count = 0;
+        size_t offset = 0;   // of the book's first bid in levels; its asks follow its bids
+    };
+
+    std::vector<Book> books;         // one per requested symbol, in request order
+    std::vector<PriceLevel> levels;  // every found book's levels, best first
+    // Scratch for grouping the request by shard, kept for its capacity
+    std::vector<std::string> symbols;  // the request in stream form, lowercase
+    std::vector<std::pair<size_t, uint32_t>> order;
+    std::vector<std::pair<size_t, uint32_t>> groups;
+    std::vector<uint32_t> positions;
+
+    void reset(size_t count) {
+        books.assign(count, Book{});
+        levels.clear();
+    }
+    size_t size() const { return books.size(); }
+    const PriceLevel* bids(size_t i) const { return levels.data() + books[i].offset; }
+    const PriceLevel* asks(size_t i) const { return bids(i) + books[i].bid_count; }
 };
 
 class OrderbookManager {
 public:
+    // Called when a book becomes consistent (true) or loses continuity and needs a new snapshot (false)
+    using SyncListener = std::function<void(const std::string& symbol, bool synced)>;
+    // Called with every newly published view, on the updating thread and under the book's
+    // shard lock, so it must be quick and must not call back into the manager
+    using ViewListener = std::function<void(const std::string& symbol, const BookView& view)>;
+
     OrderbookManager(size_t shard_count = 16);
     void OnOrderbookWs(const std::string& symbol, const simdjson::dom::element& message);
     void OnOrderbookRest(const std::string& symbol, const simdjson::dom::element& message);
+    // Up to BookView::DEPTH levels come from the published view without locking the book
     std::string getOrderbookSnapshot(const std::string& symbol, int depth) const;
+    // The same levels as one MarketDataCodec Snapshot in out, replacing its contents and
+    // keeping its capacity; false, with out empty, where getOrderbookSnapshot gives "{}"
+    bool encodeSnapshot(const std::string& symbol, int depth, uint32_t symbol_id, std::string& out) const;
+    // The top `depth` levels of every symbol into out, replacing its contents. Symbols are
+    // visited shard by shard: up to BookView::DEPTH levels come from the published views
+    // under one epoch guard, deeper ones are copied under one hold of each shard's lock.
+    // Each book is consistent in itself; different shards may be at different moments.
+    void getSnapshots(const std::vector<std::string>& symbols, int depth, BookBatch& out) const;
+    // getSnapshots for the symbols at `positions` only, adding to out without resetting it
+    void appendSnapshots(const std::vector<std::string>& symbols, const std::vector<uint32_t>& positions, int depth,
+                         BookBatch& out) const;
+
+    bool isSynced(const std::string& symbol) const;
+    uint64_t getLastUpdateId(const std::string& symbol) const;
+    void setSyncListener(SyncListener listener);
+    // Set before any update arrives
+    void setViewListener(ViewListener listener);
+
+    // Copies of every book, for checkpointing
+    std::vector<std::pair<std::string, Orderbook>> exportBooks() const;
+    // Installs a checkpointed book as stale; the first diff that continues its update ID
+    // resumes it, otherwise it is served stale until a snapshot replaces it
+    void restoreBook(const std::string& symbol, Orderbook book);
+    bool isStale(const std::string& symbol) const;
+    // Creates an empty book with room for levels per side. Called on the thread that
+    // will update the book, so its storage comes from that thread's NUMA node.
+    void reserveBook(const std::string& symbol, size_t levels);
+    // Also publishes every book change into shared memory for other processes. Set before
+    // any update arrives; the publisher must outlive the manager's use of it.
+    void setSharedPublisher(SharedBookPublisher* publisher);
 
 private:
+    static constexpr size_t MAX_PENDING_DIFFS = 1000;
+
+    struct DepthDiff {
+        uint64_t first_update_id;
+        uint64_t final_update_id;
+        PriceLevels bids;
+        PriceLevels asks;
+    };
+
     struct Shard {
         tbb::concurrent_hash_map<std::string, Orderbook> orderbooks;
+        // Diffs that arrived before the book had a snapshot to apply them to
+        std::unordered_map<std::string, std::deque<DepthDiff>> pending_diffs;
+        // Published under mutex, read lock-free
+        tbb::concurrent_hash_map<std::string, EpochPublished<BookView>> views;
+        // Shared-memory slot per symbol, resolved on the first publication
+        std::unordered_map<std::string, uint32_t> shared_slots;
         mutable std::mutex mutex;
     };
     std::vector<Shard> shards;
+    SyncListener sync_listener_;
+    ViewListener view_listener_;
+    SharedBookPublisher* shared_publisher_ = nullptr;
 
-    void updateOrderbook(const std::string& symbol, const std::vector<PriceLevel>& bids, const std::vector<PriceLevel>& asks);
-    void updatePriceLevels(std::vector<PriceLevel>& existing, const std::vector<PriceLevel>& updates);
+    size_t shardIndex(const std::string& symbol) const;
+    Shard& shardFor(const std::string& symbol);
+    const Shard& shardFor(const std::string& symbol) const;
+    void updateOrderbook(const std::string& symbol, const PriceLevels& bids, const PriceLevels& asks);
+    void updatePriceLevels(PriceLevels& existing, const PriceLevels& updates);
+    void sortLevels(Orderbook& book);
+    bool applyDiff(Orderbook& book, const DepthDiff& diff);
+    void notifySync(const std::string& symbol, bool synced);
+    void publishView(Shard& shard, const std::string& symbol, const Orderbook& book);
+    static std::string formatSnapshot(const PriceLevel* bids, size_t bid_count, const PriceLevel* asks,
+                                      size_t ask_count, bool stale);
+    static void encodeSnapshotMessage(const PriceLevel* bids, size_t bid_count, const PriceLevel* asks,
+                                      size_t ask_count, bool stale, uint64_t update_id, uint32_t symbol_id,
+                                      std::string& out);
+    static void addToBatch(BookBatch& out, uint32_t position, uint64_t last_update_id, bool stale,
+                           const PriceLevel* bids, size_t bid_count, const PriceLevel* asks, size_t ask_count);
+    static void parseLevels(const simdjson::dom::element& message, const char* key, const char* alt_key, PriceLevels& out);
 };
@@ -0,0 +1,259 @@
+#include "ReplayEngine.h"
+#include "CaptureJournal.h"
+#include "MessageProcessor.h"
+#include "OrderbookManager.h"
+#include "ShardRuntime.h"
+#include "xxhash.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+namespace {
+
+// Records a shard may have queued but not yet applied before the reader waits for it
+constexpr uint64_t MAX_IN_FLIGHT = 65536;
+// Paced waits shorter than this spin instead of sleeping
+constexpr int64_t SPIN_NS = 100000;
+
+int64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Maps capture receive times onto the replay clock, anchored at the first record
+class Pacer {
+public:
+    Pacer(ReplayPacing pacing, double speed)
+        : paced_(pacing != ReplayPacing::AsFastAsPossible),
+          speed_(pacing == ReplayPacing::Scaled ? speed : 1.0) {}
+
+    bool paced() const { return paced_; }
+
+    // Waits until the record is due and returns how late it is by then
+    int64_t wait(int64_t receive_ns) {
+        int64_t now = steady_ns();
+        if (!started_) {
+            started_ = true;
+            wall_start_ = now;
+            capture_start_ = receive_ns;
+            return 0;
+        }
+        // Records from concurrent connections are not strictly in receive order; one
+        // that is due in the past goes out immediately
+        int64_t due = wall_start_ + static_cast<int64_t>(static_cast<double>(receive_ns - capture_start_) / speed_);
+        if (due - now > SPIN_NS) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(due - now - SPIN_NS / 2));
+            now = steady_ns();
+        }
+        while (now < due) {
+            now = steady_ns();
+        }
+        return now - due;
+    }
+
+private:
+    bool paced_;
+    double speed_;
+    bool started_ = false;
+    int64_t wall_start_ = 0;
+    int64_t capture_start_ = 0;
+};
+
+// Owned by one shard's loop; the reader thread only touches sent and done
+struct ShardState {
+    OrderbookManager books{1};
+    std::unique_ptr<MessageProcessor> processor;
+    LatencyHistogram queue;
+    LatencyHistogram apply;
+    std::atomic<uint64_t> done{0};
+    uint64_t sent = 0;
+};
+
+}  // namespace
+
+ReplayEngine::ReplayEngine(const ReplayConfig& config) : config_(config) {
+    if (config_.pacing == ReplayPacing::Scaled && !(config_.speed > 0.0)) {
+        throw std::invalid_argument("Replay speed must be positive");
+    }
+}
+
+ReplayReport ReplayEngine::run() {
+    CaptureReader reader(config_.directory);
+    std::unordered_set<std::string> wanted(config_.symbols.begin(), config_.symbols.end());
+    Pacer pacer(config_.pacing, config_.speed);
+    ReplayReport report;
+    LatencyHistogram read;
+    LatencyHistogram apply;
+    LatencyHistogram lateness;
+    int64_t first_receive = std::numeric_limits<int64_t>::max();
+    int64_t last_receive = std::numeric_limits<int64_t>::min();
+
+    // Inline target: the calling thread parses and applies
+    boost::asio::io_context unused;
+    OrderbookManager inline_books;
+    MessageProcessor inline_processor(unused, inline_books);
+    inline_processor.set_inline(true);
+
+    // Shard target: processors live on their shard's loop and apply inline there
+    std::unique_ptr<ShardRuntime> runtime;
+    std::vector<std::unique_ptr<ShardState>> shards;
+    if (config_.shards > 0) {
+        runtime = std::make_unique<ShardRuntime>(config_.shards);
+        for (size_t i = 0; i < config_.shards; ++i) {
+            shards.push_back(std::make_unique<ShardState>());
+            shards.back()->processor =
+                std::make_unique<MessageProcessor>(runtime->loop(i).get_io_context(), shards.back()->books);
+            shards.back()->processor->set_inline(true);
+        }
+        runtime->run();
+    }
+
+    CaptureRecord record;
+    const int64_t start = steady_ns();
+    while (config_.max_records == 0 || report.records < config_.max_records) {
+        int64_t read_start = steady_ns();
+        if (!reader.next(record)) {
+            break;
+        }
+        if (record.source == CaptureSource::Normalized) {
+            continue;  // the recording client's output, not something to feed the books
+        }
+        std::string symbol = reader.symbol(record.symbol_id);
+        std::string payload(record.payload);
+        if (symbol.empty()) {
+            symbol = MessageProcessor::stream_symbol(payload);
+        }
+        read.record(steady_ns() - read_start);
+
+        if (!wanted.empty() && !wanted.count(symbol)) {
+            ++report.skipped;
+            continue;
+        }
+        if (pacer.paced()) {
+            lateness.record(pacer.wait(record.receive_ns));
+        }
+        ++report.records;
+        report.payload_bytes += payload.size();
+        first_receive = std::min(first_receive, record.receive_ns);
+        last_receive = std::max(last_receive, record.receive_ns);
+        bool is_websocket = record.source != CaptureSource::Rest;
+
+        if (!runtime) {
+            int64_t apply_start = steady_ns();
+            inline_processor.add_message(is_websocket, std::move(payload), symbol);
+            apply.record(steady_ns() - apply_start);
+            continue;
+        }
+        // Records without a symbol (subscription acknowledgements) still go somewhere,
+        // as they do inline
+        size_t shard = symbol.empty() ? 0 : runtime->assign(symbol);
+        ShardState& state = *shards[shard];
+        while (state.sent - state.done.load(std::memory_order_acquire) >= MAX_IN_FLIGHT) {
+            std::this_thread::yield();
+        }
+        ++state.sent;
+        runtime->send(shard, [&state, is_websocket, payload = std::move(payload), symbol = std::move(symbol),
+                              sent = steady_ns()]() mutable {
+            int64_t apply_start = steady_ns();
+            state.queue.record(apply_start - sent);
+            state.processor->add_message(is_websocket, std::move(payload), symbol);
+            state.apply.record(steady_ns() - apply_start);
+            state.done.fetch_add(1, std::memory_order_release);
+        });
+    }
+
+    std::vector<std::pair<std::string, Orderbook>> books;
+    LatencyHistogram queue;
+    if (runtime) {
+        for (size_t i = 0; i < shards.size(); ++i) {
+            // Runs after everything sent to the shard, so its books are final
+            auto exported = runtime->call(i, [&state = *shards[i]]() { return state.books.exportBooks(); }).get();
+            books.insert(books.end(), std::make_move_iterator(exported.begin()), std::make_move_iterator(exported.end()));
+        }
+        report.seconds = static_cast<double>(steady_ns() - start) / 1e9;
+        runtime->stop();
+        for (const auto& state : shards) {
+            queue.merge(state->queue);
+            apply.merge(state->apply);
+        }
+    } else {
+        report.seconds = static_cast<double>(steady_ns() - start) / 1e9;
+        books = inline_books.exportBooks();
+    }
+
+    report.messages_per_second = report.seconds > 0 ? static_cast<double>(report.records) / report.seconds : 0.0;
+    report.capture_span_ns = report.records > 0 ? last_receive - first_receive : 0;
+    report.read = read.stats();
+    report.queue = queue.stats();
+    report.apply = apply.stats();
+    report.lateness = lateness.stats();
+
+    std::sort(books.begin(), books.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<uint64_t> checksums;
+    for (const auto& [symbol, book] : books) {
+        ReplayBook summary;
+        summary.symbol = symbol;
+        summary.last_update_id = book.last_update_id;
+        summary.synced = book.synced;
+        summary.bid_levels = book.bids.size();
+        summary.ask_levels = book.asks.size();
+        summary.checksum = book_checksum(symbol, book);
+        checksums.push_back(summary.checksum);
+        report.books.push_back(std::move(summary));
+    }
+    report.checksum = XXH64(checksums.data(), checksums.size() * sizeof(uint64_t), 0);
+    return report;
+}
+
+uint64_t ReplayEngine::book_checksum(const std::string& symbol, const Orderbook& book) {
+    std::string bytes = symbol;
+    bytes.push_back('\0');
+    auto append = [&bytes](const void* data, size_t size) {
+        bytes.append(static_cast<const char*>(data), size);
+    };
+    uint64_t header[] = {book.last_update_id, book.synced ? 1u : 0u, book.bids.size(), book.asks.size()};
+    append(header, sizeof(header));
+    for (const PriceLevels* side : {&book.bids, &book.asks}) {
+        for (const auto& level : *side) {
+            append(&level.price, sizeof(level.price));
+            append(&level.quantity, sizeof(level.quantity));
+        }
+    }
+    return XXH64(bytes.data(), bytes.size(), 0);
+}
+
+std::string ReplayEngine::format_report(const ReplayReport& report) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "Replayed " << report.records << " records (" << report.payload_bytes << " bytes, "
+        << report.skipped << " skipped) in " << std::setprecision(3) << report.seconds << " s: "
+        << std::setprecision(0) << report.messages_per_second << " msgs/s, capture span "
+        << std::setprecision(3) << static_cast<double>(report.capture_span_ns) / 1e9 << " s\n";
+    auto stage = [&out](const char* name, const LatencyHistogram::Stats& stats) {
+        if (stats.count == 0) {
+            return;
+        }
+        out << "  " << std::left << std::setw(9) << name << std::right << " n=" << stats.count
+            << std::setprecision(0) << " mean=" << stats.mean_ns << "ns p50=" << stats.p50_ns << "ns p99="
+            << stats.p99_ns << "ns p99.9=" << stats.p999_ns << "ns max=" << stats.max_ns << "ns\n";
+    };
+    stage("read", report.read);
+    stage("queue", report.queue);
+    stage("apply", report.apply);
+    stage("lateness", report.lateness);
+    for (const auto& book : report.books) {
+        out << "  " << book.symbol << " u=" << book.last_update_id << (book.synced ? " synced" : " unsynced")
+            << " bids=" << book.bid_levels << " asks=" << book.ask_levels << " checksum=" << std::hex
+            << std::setw(16) << std::setfill('0') << book.checksum << std::dec << std::setfill(' ') << "\n";
+    }
+    out << "Checksum " << std::hex << std::setw(16) << std::setfill('0') << report.checksum << "\n";
+    return out.str();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "LatencyMonitor.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Orderbook;
+
+enum class ReplayPacing {
+    AsFastAsPossible,
+    RealTime,  // records are delivered with their captured receive-time spacing
+    Scaled,    // captured spacing divided by ReplayConfig::speed
+};
+
+struct ReplayConfig {
+    std::string directory;
+    ReplayPacing pacing = ReplayPacing::AsFastAsPossible;
+    double speed = 1.0;  // Scaled only: 10 replays ten times faster than captured
+    // 0 replays on the calling thread through one inline MessageProcessor. Otherwise symbols
+    // are placed on this many ShardRuntime shards, each with its own processor and books,
+    // the way BinanceClient runs in RuntimeMode::ShardPerCore.
+    size_t shards = 0;
+    std::vector<std::string> symbols;  // replay only these, empty for all
+    uint64_t max_records = 0;          // 0 reads to the end of the capture
+};
+
+struct ReplayBook {
+    std::string symbol;
+    uint64_t last_update_id = 0;
+    bool synced = false;
+    size_t bid_levels = 0;
+    size_t ask_levels = 0;
+    uint64_t checksum = 0;
+};
+
+struct ReplayReport {
+    uint64_t records = 0;  // delivered to a processor
+    uint64_t skipped = 0;  // filtered out by ReplayConfig::symbols
+    uint64_t payload_bytes = 0;
+    double seconds = 0.0;
+    double messages_per_second = 0.0;
+    int64_t capture_span_ns = 0;  // receive time covered by the delivered records
+
+    LatencyHistogram::Stats read;      // CaptureReader::next and copying the payload out
+    LatencyHistogram::Stats queue;     // handed to a shard until the shard starts it (shard mode)
+    LatencyHistogram::Stats apply;     // dedup, parse and book update in MessageProcessor
+    LatencyHistogram::Stats lateness;  // delivery behind the record's schedule (paced modes)
+
+    std::vector<ReplayBook> books;  // by symbol
+    uint64_t checksum = 0;          // over every book's checksum in symbol order
+};
+
+// Drives a capture written by CaptureJournal through MessageProcessor into fresh books,
+// the offline benchmark for parser and book changes on real traffic. Records are streamed
+// one segment mapping at a time, so multi-hour captures replay in bounded memory, and in
+// shard mode the reader waits rather than letting shard mailboxes grow without bound.
+//
+// Each symbol's records reach its book in capture order whatever the pacing and target,
+// so the final books, and the checksums over them, depend only on the capture and the
+// code under test. Book checksums cover the update ID, sync state and every price and
+// quantity bit for bit; the same capture gives the same checksums inline and sharded.
+class ReplayEngine {
+public:
+    // Throws std::invalid_argument for a non-positive Scaled speed
+    explicit ReplayEngine(const ReplayConfig& config);
+
+    // Replays from the start of the capture into new books each call. Throws
+    // std::runtime_error if the directory has no capture segments.
+    ReplayReport run();
+
+    static uint64_t book_checksum(const std::string& symbol, const Orderbook& book);
+    // Human-readable summary: throughput, stage latencies and the checksums
+    static std::string format_report(const ReplayReport& report);
+
+private:
+    ReplayConfig config_;
+};
@@ -1,4 +1,8 @@
 #include "RestApiHandler.h"
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
 #include <iostream>
 #include <string>
 #include <thread>
@@ -6,9 +10,10 @@
 #include <queue>
 #include <unordered_map>
 #include <functional>
+#include <algorithm>
 
 RestApiHandler::RestApiHandler(net::io_context& ioc, ssl::context& ctx, const std::string& host, const std::string& port, const std::string& target, MessageProcessor& messageProcessor)
-    : ioc_(ioc), stream_(ioc, ctx), host_(host), port_(port), target_(target), message_processor_(messageProcessor), poll_timer_(ioc)
+    : ioc_(ioc), ctx_(ctx), resolver_(ioc), stream_(std::make_unique<beast::ssl_stream<beast::tcp_stream>>(ioc, ctx)), host_(host), port_(port), target_(target), message_processor_(messageProcessor), poll_timer_(ioc)
 {
     req_.version(11);
     req_.method(http::verb::get);
@@ -19,14 +24,43 @@ RestApiHandler::RestApiHandler(net::io_context& ioc, ssl::context& ctx, const st
 
 void RestApiHandler::start_polling() {
     running_ = true;
-    poll_timer_.expires_after(std::chrono::seconds(1));
-    poll_timer_.async_wait(std::bind(&RestApiHandler::run, shared_from_this()));
+    one_shot_ = false;
+    net::co_spawn(ioc_, poll_loop(shared_from_this()), net::detached);
+}
+
+void RestApiHandler::fetch_snapshot(std::chrono::milliseconds delay) {
+    if (in_flight_.exchange(true)) {
+        return;
+    }
+    running_ = true;
+    one_shot_ = true;
+    net::co_spawn(ioc_, snapshot_after(shared_from_this(), delay), net::detached);
+}
+
+void RestApiHandler::set_symbol(const std::string& symbol) {
+    symbol_ = symbol;
+    if (capture_) {
+        capture_symbol_ = capture_->symbol_id(symbol_);
+    }
+}
+
+void RestApiHandler::set_fetch_condition(std::function<bool()> condition) {
+    fetch_condition_ = std::move(condition);
+}
+
+void RestApiHandler::set_failure_handler(std::function<void()> handler) {
+    failure_handler_ = std::move(handler);
 }
 
 void RestApiHandler::stop() {
     running_ = false;
-    boost::system::error_code ec;
-    stream_.shutdown(ec);
+    // The timer and stream belong to ioc_; a suspended coroutine wakes with operation_aborted
+    if (auto self = weak_from_this().lock()) {
+        net::post(ioc_, [self]() {
+            self->poll_timer_.cancel();
+            self->close();
+        });
+    }
 }
 
 bool RestApiHandler::is_connected() const {
@@ -48,105 +82,155 @@ void RestApiHandler::set_cpu_affinity(int cpu_id) {
 #endif
 }
 
-void RestApiHandler::run() {
-    if (!running_) return;
-
-    if (!can_make_request()) {
-        // If we can't send a request, delay and retry
-        poll_timer_.expires_after(std::chrono::milliseconds(100));
-        poll_timer_.async_wait(std::bind(&RestApiHandler::run, shared_from_this()));
-        return;
-    }
-
-    tcp::resolver resolver(ioc_);
-    resolver.async_resolve(host_, port_,
-        beast::bind_front_handler(&RestApiHandler::on_resolve, shared_from_this()));
-}
+net::awaitable<void> RestApiHandler::poll_loop(std::shared_ptr<RestApiHandler> /*self*/) {
+    beast::error_code ec;
+    poll_timer_.expires_after(std::chrono::seconds(1));
+    co_await poll_timer_.async_wait(net::redirect_error(net::use_awaitable, ec));
 
-void RestApiHandler::on_resolve(beast::error_code ec, tcp::resolver::results_type results) {
-    if(ec) return fail(ec, "resolve");
+    while (running_) {
+        co_await wait_for_token();
+        if (!running_) {
+            break;
+        }
+        co_await fetch();
 
-    beast::get_lowest_layer(stream_).async_connect(results,
-        beast::bind_front_handler(&RestApiHandler::on_connect, shared_from_this()));
+        poll_timer_.expires_after(std::chrono::milliseconds(current_polling_interval_));
+        co_await poll_timer_.async_wait(net::redirect_error(net::use_awaitable, ec));
+    }
+    close();
 }
 
-void RestApiHandler::on_connect(beast::error_code ec, tcp::resolver::results_type::endpoint_type) {
-    if(ec) {
-        fail(ec, "connect");
-        return;
+net::awaitable<void> RestApiHandler::snapshot_after(std::shared_ptr<RestApiHandler> /*self*/, std::chrono::milliseconds delay) {
+    beast::error_code ec;
+    poll_timer_.expires_after(delay);
+    co_await poll_timer_.async_wait(net::redirect_error(net::use_awaitable, ec));
+
+    bool failed = false;
+    if (running_ && (!fetch_condition_ || fetch_condition_())) {
+        co_await wait_for_token();
+        if (running_) {
+            failed = !co_await fetch();
+        }
+    }
+    in_flight_ = false;
+    // After in_flight_ clears, so the handler may schedule the retry
+    if (failed && running_ && failure_handler_) {
+        failure_handler_();
     }
-
-    // Perform the SSL handshake
-    stream_.async_handshake(
-        ssl::stream_base::client,
-        beast::bind_front_handler(
-            &RestApiHandler::on_handshake,
-            shared_from_this()));
 }
 
-void RestApiHandler::on_handshake(beast::error_code ec) {
-    if(ec) return fail(ec, "handshake");
-
-    http::async_write(stream_, req_,
-        beast::bind_front_handler(&RestApiHandler::on_write, shared_from_this()));
+net::awaitable<void> RestApiHandler::wait_for_token() {
+    beast::error_code ec;
+    while (running_ && !can_make_request()) {
+        poll_timer_.expires_after(std::chrono::milliseconds(100));
+        co_await poll_timer_.async_wait(net::redirect_error(net::use_awaitable, ec));
+    }
 }
 
-void RestApiHandler::on_write(beast::error_code ec, std::size_t bytes_transferred) {
-    boost::ignore_unused(bytes_transferred);
+net::awaitable<bool> RestApiHandler::open_stream() {
+    beast::error_code ec;
+    if (!endpoints_) {
+        auto results = co_await resolver_.async_resolve(host_, port_, net::redirect_error(net::use_awaitable, ec));
+        if (ec) {
+            fail(ec, "resolve");
+            co_return false;
+        }
+        endpoints_ = std::move(results);
+    }
 
-    if(ec) return fail(ec, "write");
+    // A TLS stream cannot be reused once shut down, so each connection gets a fresh one
+    stream_ = std::make_unique<beast::ssl_stream<beast::tcp_stream>>(ioc_, ctx_);
+    SSL_set_tlsext_host_name(stream_->native_handle(), host_.c_str());
 
-    http::async_read(stream_, buffer_, res_,
-        beast::bind_front_handler(&RestApiHandler::on_read, shared_from_this()));
+    co_await beast::get_lowest_layer(*stream_).async_connect(*endpoints_, net::redirect_error(net::use_awaitable, ec));
+    if (ec) {
+        endpoints_.reset();
+        fail(ec, "connect");
+        co_return false;
+    }
+    co_await stream_->async_handshake(ssl::stream_base::client, net::redirect_error(net::use_awaitable, ec));
+    if (ec) {
+        fail(ec, "handshake");
+        co_return false;
+    }
+    is_connected_ = true;
+    co_return true;
 }
 
-void RestApiHandler::on_read(beast::error_code ec, std::size_t bytes_transferred) {
-    boost::ignore_unused(bytes_transferred);
+net::awaitable<bool> RestApiHandler::fetch() {
+    beast::error_code ec;
+    // A kept-alive connection may have been closed by the server since the last request;
+    // that only shows up on write or read, so a reused connection gets one retry
+    bool reused = is_connected_;
+    for (;;) {
+        if (!is_connected_ && !co_await open_stream()) {
+            co_return false;
+        }
 
-    if(ec)
-        return fail(ec, "read");
+        request_sent_time_ = std::chrono::system_clock::now();
+        co_await http::async_write(*stream_, req_, net::redirect_error(net::use_awaitable, ec));
+        if (!ec) {
+            res_ = {};
+            co_await http::async_read(*stream_, buffer_, res_, net::redirect_error(net::use_awaitable, ec));
+        }
+        if (!ec) {
+            break;
+        }
+        is_connected_ = false;
+        buffer_.clear();
+        if (!reused || !running_) {
+            fail(ec, "request");
+            co_return false;
+        }
+        reused = false;
+    }
 
-    // Process the response
-    std::string response_body = res_.body();
-    message_processor_.add_message(false, std::move(response_body));
+    bool keep_alive = res_.keep_alive();
+    deliver(std::move(res_.body()));
 
-    // Close the connection
-    stream_.async_shutdown(
-        beast::bind_front_handler(
-            &RestApiHandler::on_shutdown,
-            shared_from_this()));
+    if (!keep_alive) {
+        is_connected_ = false;
+        co_await stream_->async_shutdown(net::redirect_error(net::use_awaitable, ec));
+        if (ec == net::error::eof || ec == ssl::error::stream_truncated) {
+            // Rationale:
+            // http://stackoverflow.com/questions/25587403/boost-asio-ssl-async-shutdown-always-finishes-with-an-error
+            ec = {};
+        }
+        if (ec) {
+            fail(ec, "shutdown");
+        }
+    }
+    co_return true;
 }
 
-void RestApiHandler::on_shutdown(beast::error_code ec) {
-    if(ec == net::error::eof) {
-        // Rationale:
-        // http://stackoverflow.com/questions/25587403/boost-asio-ssl-async-shutdown-always-finishes-with-an-error
-        ec = {};
+void RestApiHandler::deliver(std::string&& body) {
+    if (capture_) {
+        capture_->append(CaptureSource::Rest, capture_connection_, capture_symbol_, CaptureJournal::now_ns(), body);
+    }
+    if (response_handler_) {
+        response_handler_(std::move(body), request_sent_time_, std::chrono::system_clock::now());
+    } else {
+        message_processor_.add_message(false, std::move(body), symbol_);
     }
-    if(ec)
-        return fail(ec, "shutdown");
-
-    // If we get here then the connection is closed gracefully
-
-    // Schedule the next poll
-    poll_timer_.expires_after(std::chrono::milliseconds(current_polling_interval_));
-    poll_timer_.async_wait(std::bind(&RestApiHandler::run, shared_from_this()));
 }
 
 void RestApiHandler::close() {
+    is_connected_ = false;
     beast::error_code ec;
-    stream_.shutdown(ec);
+    beast::get_lowest_layer(*stream_).socket().close(ec);
 }
 
 void RestApiHandler::fail(beast::error_code ec, char const* what) {
-    std::cerr << what << ": " << ec.message() << "\n";
+    if (ec != net::error::operation_aborted) {
+        std::cerr << what << ": " << ec.message() << "\n";
+    }
     is_connected_ = false;
 }
 
 bool RestApiHandler::can_make_request() {
     auto now = std::chrono::steady_clock::now();
     double elapsed = std::chrono::duration<double>(now - last_request_time_).count();
-    tokens_ = std::min(max_tokens_, tokens_ + elapsed * token_rate_);
+    tokens_ = std::min(max_tokens_, tokens_ + elapsed * request_rate_);
     if (tokens_ >= 1.0) {
         tokens_ -= 1.0;
         last_request_time_ = now;
@@ -171,6 +255,26 @@ int RestApiHandler::get_max_polling_interval() const {
     return max_polling_interval_;
 }
 
+void RestApiHandler::set_response_handler(ResponseHandler handler) {
+    response_handler_ = std::move(handler);
+}
+
+void RestApiHandler::set_polling_interval(int interval_ms) {
+    current_polling_interval_ = std::clamp(interval_ms, min_polling_interval_, max_polling_interval_);
+}
+
+void RestApiHandler::set_request_rate(double requests_per_second) {
+    request_rate_ = requests_per_second;
+}
+
+void RestApiHandler::set_capture(CaptureJournal* journal) {
+    capture_ = journal;
+    if (capture_) {
+        capture_connection_ = capture_->register_connection();
+        capture_symbol_ = capture_->symbol_id(symbol_);
+    }
+}
+
 void RestApiHandler::poll_orderbook() {
     while (running_) {
         try {
@@ -180,10 +284,10 @@ void RestApiHandler::poll_orderbook() {
             req_.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
 
             // Send the request
-            http::write(stream_, req_);
+            http::write(*stream_, req_);
 
             // Receive the response
-            http::read(stream_, buffer_, res_);
+            http::read(*stream_, buffer_, res_);
 
             // Process the response
             std::string response_body = res_.body();
@@ -3,10 +3,15 @@
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 #include <boost/beast/ssl.hpp>
+#include <boost/asio/awaitable.hpp>
 #include <string>
+#include <optional>
 #include <memory>
 #include <atomic>
+#include <functional>
+#include <chrono>
 #include "MessageProcessor.h"
+#include "CaptureJournal.h"
 
 namespace beast = boost::beast;
 namespace http = beast::http;
@@ -16,8 +21,21 @@ using tcp = boost::asio::ip::tcp;
 
 class RestApiHandler : public std::enable_shared_from_this<RestApiHandler> {
 public:
+    // Receives the response body together with the local wall clock around the request.
+    using ResponseHandler = std::function<void(std::string&& body,
+                                               std::chrono::system_clock::time_point sent,
+                                               std::chrono::system_clock::time_point received)>;
+
     RestApiHandler(net::io_context& ioc, ssl::context& ctx, const std::string& host, const std::string& port, const std::string& target, MessageProcessor& messageProcessor);
+    // A handler either polls or fetches snapshots; both use one kept-alive connection
     void start_polling();
+    // Fetch once after delay without scheduling further polls; no-op while a fetch is in flight
+    void fetch_snapshot(std::chrono::milliseconds delay = std::chrono::milliseconds(0));
+    void set_symbol(const std::string& symbol);
+    // Checked when a scheduled fetch fires; returning false drops it without a request
+    void set_fetch_condition(std::function<bool()> condition);
+    // Called on ioc_ when a fetch_snapshot request fails; nothing retries it otherwise
+    void set_failure_handler(std::function<void()> handler);
     void stop();
     bool is_connected() const;
     void set_cpu_affinity(int cpu_id);
@@ -28,9 +46,19 @@ public:
     int get_current_polling_interval() const;
     int get_max_polling_interval() const;
 
+    // Route responses to a custom handler instead of the MessageProcessor
+    void set_response_handler(ResponseHandler handler);
+    void set_polling_interval(int interval_ms);
+    // Token bucket refill rate, 1 request per second by default
+    void set_request_rate(double requests_per_second);
+    // Records every response body before it is delivered; nullptr disables
+    void set_capture(CaptureJournal* journal);
+
 private:
     net::io_context& ioc_;
-    beast::ssl_stream<beast::tcp_stream> stream_;
+    ssl::context& ctx_;
+    tcp::resolver resolver_;
+    std::unique_ptr<beast::ssl_stream<beast::tcp_stream>> stream_;
     beast::flat_buffer buffer_;
     http::request<http::string_body> req_;
     http::response<http::string_body> res_;
@@ -45,20 +73,35 @@ private:
     std::chrono::steady_clock::time_point last_request_time_;
     double tokens_ = 1.0;
     const double max_tokens_ = 1.0;
-    const double token_rate_ = 1.0; // Tokens generated per second
 
     // Add these members
     int current_polling_interval_ = 1000; // Start with 1 second
     const int min_polling_interval_ = 100; // Minimum 100ms
     const int max_polling_interval_ = 5000; // Maximum 5 seconds
 
-    void run();
-    void on_resolve(beast::error_code ec, tcp::resolver::results_type results);
-    void on_connect(beast::error_code ec, tcp::resolver::results_type::endpoint_type);
-    void on_handshake(beast::error_code ec);
-    void on_write(beast::error_code ec, std::size_t bytes_transferred);
-    void on_read(beast::error_code ec, std::size_t bytes_transferred);
-    void on_shutdown(beast::error_code ec);
+    ResponseHandler response_handler_;
+    std::function<bool()> fetch_condition_;
+    std::function<void()> failure_handler_;
+    std::string symbol_;
+    std::atomic<bool> one_shot_{false};
+    std::atomic<bool> in_flight_{false};
+    std::chrono::system_clock::time_point request_sent_time_;
+
+    // Resolved once; connect failures clear it so the next request resolves again
+    std::optional<tcp::resolver::results_type> endpoints_;
+    double request_rate_ = 1.0;  // requests per second the token bucket allows
+    CaptureJournal* capture_ = nullptr;
+    uint32_t capture_connection_ = 0;
+    uint32_t capture_symbol_ = 0;
+
+    // Each coroutine runs on ioc_ and holds one reference to the handler for its whole life
+    net::awaitable<void> poll_loop(std::shared_ptr<RestApiHandler> self);
+    net::awaitable<void> snapshot_after(std::shared_ptr<RestApiHandler> self, std::chrono::milliseconds delay);
+    // One request on the kept-alive connection, reconnecting when needed; false on failure
+    net::awaitable<bool> fetch();
+    net::awaitable<bool> open_stream();
+    net::awaitable<void> wait_for_token();
+    void deliver(std::string&& body);
     void close();
     void fail(beast::error_code ec, char const* what);
     bool can_make_request();
@@ -0,0 +1,146 @@
+#include "ShardRuntime.h"
+#include <stdexcept>
+
+ShardRuntime::ShardRuntime(size_t shard_count, const WaitConfig& wait_config, size_t mailbox_capacity) {
+    if (shard_count == 0) {
+        throw std::runtime_error("ShardRuntime needs at least one shard");
+    }
+    for (size_t i = 0; i < shard_count; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->loop = std::make_unique<EventLoop>(wait_config);
+        for (size_t sender = 0; sender <= shard_count; ++sender) {
+            shard->inbox.push_back(std::make_unique<Mailbox>(mailbox_capacity));
+        }
+        shard->loop->add_poller([this, i]() { return drain(i); });
+        shards_.push_back(std::move(shard));
+    }
+}
+
+ShardRuntime::~ShardRuntime() {
+    stop();
+}
+
+void ShardRuntime::run() {
+    for (auto& shard : shards_) {
+        shard->loop->run();
+    }
+}
+
+void ShardRuntime::stop() {
+    for (auto& shard : shards_) {
+        shard->loop->stop();
+    }
+}
+
+void ShardRuntime::set_affinity(const std::vector<int>& cpus, bool local_memory) {
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        shards_[i]->loop->set_affinity(i < cpus.size() ? cpus[i] : -1, local_memory);
+    }
+}
+
+size_t ShardRuntime::assign(const std::string& symbol) {
+    std::lock_guard<std::mutex> lock(placement_mutex_);
+    auto it = placement_.find(symbol);
+    if (it != placement_.end()) {
+        return it->second;
+    }
+    size_t target = 0;
+    for (size_t i = 1; i < shards_.size(); ++i) {
+        if (shards_[i]->symbols < shards_[target]->symbols) {
+            target = i;
+        }
+    }
+    ++shards_[target]->symbols;
+    placement_.emplace(symbol, target);
+    return target;
+}
+
+void ShardRuntime::remove(const std::string& symbol) {
+    std::lock_guard<std::mutex> lock(placement_mutex_);
+    auto it = placement_.find(symbol);
+    if (it != placement_.end()) {
+        --shards_[it->second]->symbols;
+        placement_.erase(it);
+    }
+}
+
+int ShardRuntime::find(const std::string& symbol) const {
+    std::lock_guard<std::mutex> lock(placement_mutex_);
+    auto it = placement_.find(symbol);
+    return it == placement_.end() ? -1 : static_cast<int>(it->second);
+}
+
+std::vector<std::string> ShardRuntime::symbols_of(size_t shard) const {
+    std::lock_guard<std::mutex> lock(placement_mutex_);
+    std::vector<std::string> symbols;
+    for (const auto& [symbol, placed] : placement_) {
+        if (placed == shard) {
+            symbols.push_back(symbol);
+        }
+    }
+    return symbols;
+}
+
+int ShardRuntime::current_shard() const {
+    EventLoop* loop = EventLoop::current();
+    if (loop == nullptr) {
+        return -1;
+    }
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        if (shards_[i]->loop.get() == loop) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void ShardRuntime::send(size_t shard, Task task) {
+    Shard& target = *shards_.at(shard);
+    int sender = current_shard();
+    if (sender >= 0) {
+        deliver(*target.inbox[sender], task);
+    } else {
+        std::lock_guard<std::mutex> lock(target.control_mutex);
+        deliver(*target.inbox.back(), task);
+    }
+    target.loop->notify();
+}
+
+void ShardRuntime::deliver(Mailbox& mailbox, Task& task) {
+    if (mailbox.overflow_count.load(std::memory_order_acquire) == 0 && mailbox.ring.try_push(task)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mailbox.overflow_mutex);
+    mailbox.overflow.push_back(std::move(task));
+    mailbox.overflow_count.fetch_add(1, std::memory_order_release);
+    overflows_.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t ShardRuntime::drain(size_t shard) {
+    size_t ran = 0;
+    Task task;
+    for (auto& mailbox : shards_[shard]->inbox) {
+        size_t taken = 0;
+        while (taken < MAILBOX_BATCH && mailbox->ring.try_pop(task)) {
+            task();
+            task.reset();
+            ++taken;
+        }
+        // The overflow only holds tasks sent after everything in the ring, so it is
+        // served once the ring is empty
+        while (taken < MAILBOX_BATCH && mailbox->overflow_count.load(std::memory_order_acquire) > 0 &&
+               mailbox->ring.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(mailbox->overflow_mutex);
+                task = std::move(mailbox->overflow.front());
+                mailbox->overflow.pop_front();
+                mailbox->overflow_count.fetch_sub(1, std::memory_order_release);
+            }
+            task();
+            task.reset();
+            ++taken;
+        }
+        ran += taken;
+    }
+    return ran;
+}
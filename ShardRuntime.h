@@ -0,0 +1,124 @@
+#pragma once
+
+#include "EventLoop.h"
+#include "SpscMailbox.h"
+#include "Task.h"
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// How BinanceClient moves market data from sockets to books.
+enum class RuntimeMode {
+    // Connection loops hand messages to the shared MessageProcessor, which routes them
+    // to per-symbol processing loops over a shared OrderbookManager
+    SharedQueue,
+    // Each shard's loop owns its symbols end to end: connections, parsing, dedup and
+    // books. Shards only talk through ShardRuntime mailboxes.
+    ShardPerCore
+};
+
+// Shared-nothing runtime: one EventLoop per shard, each on its own core once pinned.
+// A symbol is placed on one shard for its lifetime. Nothing is shared between shards
+// on the hot path; the only way to run code on another shard is send() or call(),
+// which go through one SPSC mailbox per (sender, receiver) pair. Threads that are not
+// shards (control, housekeeping) share a control mailbox per shard, serialized on the
+// sending side.
+//
+// A full mailbox spills into a locked overflow list, and sends keep going there until
+// it drains, so each sender's tasks still run in send order.
+class ShardRuntime {
+public:
+    explicit ShardRuntime(size_t shard_count,
+                          const WaitConfig& wait_config = WaitConfig{WaitStrategy::Adaptive},
+                          size_t mailbox_capacity = 1024);
+    ~ShardRuntime();
+
+    ShardRuntime(const ShardRuntime&) = delete;
+    ShardRuntime& operator=(const ShardRuntime&) = delete;
+
+    void run();
+    void stop();
+    size_t size() const { return shards_.size(); }
+    EventLoop& loop(size_t shard) { return *shards_.at(shard)->loop; }
+    // One CPU per shard in order, -1 leaves a shard unpinned; call before run()
+    void set_affinity(const std::vector<int>& cpus, bool local_memory = true);
+
+    // Places a symbol on the shard with the fewest symbols; no-op for known symbols.
+    // Placement is fixed: a symbol's connection and book live on that shard.
+    size_t assign(const std::string& symbol);
+    void remove(const std::string& symbol);
+    // Shard of a symbol, -1 if unassigned
+    int find(const std::string& symbol) const;
+    std::vector<std::string> symbols_of(size_t shard) const;
+
+    // Runs task on the given shard after everything the caller sent there before
+    void send(size_t shard, Task task);
+    // send() with a future for the result; runs inline when called on that shard.
+    // Do not wait on the future from another shard that the target may call back into.
+    template<typename F>
+    auto call(size_t shard, F&& fn) -> std::future<std::invoke_result_t<std::decay_t<F>&>>;
+
+    // Index of the shard running on the calling thread, -1 off shard threads
+    int current_shard() const;
+    // Sends that found their mailbox full and took the allocating overflow path
+    uint64_t mailbox_overflows() const { return overflows_.load(std::memory_order_relaxed); }
+
+private:
+    struct Mailbox {
+        explicit Mailbox(size_t capacity) : ring(capacity) {}
+        SpscMailbox<Task> ring;
+        std::atomic<size_t> overflow_count{0};
+        std::mutex overflow_mutex;
+        std::deque<Task> overflow;
+    };
+
+    struct Shard {
+        std::unique_ptr<EventLoop> loop;
+        // Indexed by sending shard; the last one is the control mailbox
+        std::vector<std::unique_ptr<Mailbox>> inbox;
+        std::mutex control_mutex;  // serializes senders that are not shards
+        size_t symbols = 0;        // under placement_mutex_
+    };
+
+    static constexpr size_t MAILBOX_BATCH = 64;  // tasks taken from one mailbox per pass
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::unordered_map<std::string, size_t> placement_;
+    mutable std::mutex placement_mutex_;
+    std::atomic<uint64_t> overflows_{0};
+
+    void deliver(Mailbox& mailbox, Task& task);
+    size_t drain(size_t shard);
+};
+
+template<typename F>
+auto ShardRuntime::call(size_t shard, F&& fn) -> std::future<std::invoke_result_t<std::decay_t<F>&>> {
+    using Result = std::invoke_result_t<std::decay_t<F>&>;
+    auto promise = std::make_shared<std::promise<Result>>();
+    auto future = promise->get_future();
+    auto run = [promise, fn = std::forward<F>(fn)]() mutable {
+        try {
+            if constexpr (std::is_void_v<Result>) {
+                fn();
+                promise->set_value();
+            } else {
+                promise->set_value(fn());
+            }
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    };
+    if (current_shard() == static_cast<int>(shard)) {
+        run();
+    } else {
+        send(shard, std::move(run));
+    }
+    return future;
+}
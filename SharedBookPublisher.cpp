@@ -0,0 +1,91 @@
+#include "SharedBookPublisher.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+#include <system_error>
+
+SharedBookPublisher::SharedBookPublisher(const std::string& name, uint32_t capacity)
+    : name_(name), size_(shared_book::region_size(capacity)) {
+    if (capacity == 0) {
+        throw std::invalid_argument("Shared book region needs room for at least one symbol");
+    }
+    // A fresh region rather than reusing one: readers of the old one must not see its
+    // slots reassigned underneath them
+    shm_unlink(name_.c_str());
+    int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create shared book region " + name_ + ": " +
+                                 std::system_category().message(errno));
+    }
+    void* base = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size_)) == 0) {
+        base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    int error = errno;
+    close(fd);
+    if (base == MAP_FAILED) {
+        shm_unlink(name_.c_str());
+        throw std::runtime_error("Cannot map shared book region " + name_ + ": " +
+                                 std::system_category().message(error));
+    }
+
+    // ftruncate zero-fills, so every sequence starts at 0 and every symbol empty
+    header_ = static_cast<shared_book::Header*>(base);
+    slots_ = shared_book::slots(header_);
+    header_->version = shared_book::VERSION;
+    header_->depth = shared_book::DEPTH;
+    header_->capacity = capacity;
+    header_->slot_size = sizeof(shared_book::Slot);
+    header_->writer_pid = static_cast<int32_t>(getpid());
+    __atomic_store_n(&header_->magic, shared_book::MAGIC, __ATOMIC_RELEASE);
+    spdlog::info("Publishing order books to shared memory {} ({} symbols, {} bytes)", name_, capacity, size_);
+}
+
+SharedBookPublisher::~SharedBookPublisher() {
+    munmap(header_, size_);
+    shm_unlink(name_.c_str());
+}
+
+uint32_t SharedBookPublisher::slot_for(const std::string& symbol) {
+    std::lock_guard<std::mutex> lock(slots_mutex_);
+    auto it = slot_of_.find(symbol);
+    if (it != slot_of_.end()) {
+        return it->second;
+    }
+    uint32_t slot = header_->symbol_count.load(std::memory_order_relaxed);
+    if (slot >= header_->capacity || symbol.size() >= shared_book::SYMBOL_SIZE) {
+        spdlog::warn("No shared book slot for {}: region {} is full or the symbol is too long", symbol, name_);
+        slot = NO_SLOT;
+    } else {
+        std::copy(symbol.begin(), symbol.end(), slots_[slot].symbol);
+        header_->symbol_count.store(slot + 1, std::memory_order_release);
+    }
+    slot_of_.emplace(symbol, slot);
+    return slot;
+}
+
+void SharedBookPublisher::publish(uint32_t slot, const Orderbook& book) {
+    shared_book::Slot& s = slots_[slot];
+    shared_book::Top& top = s.top;
+    uint64_t sequence = s.sequence.load(std::memory_order_relaxed);
+    s.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    top.last_update_id = book.last_update_id;
+    top.publish_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    top.bid_count = static_cast<uint32_t>(std::min<size_t>(book.bids.size(), shared_book::DEPTH));
+    top.ask_count = static_cast<uint32_t>(std::min<size_t>(book.asks.size(), shared_book::DEPTH));
+    top.synced = book.synced;
+    top.stale = book.stale;
+    for (uint32_t i = 0; i < top.bid_count; ++i) {
+        top.bids[i] = shared_book::Level{md::to_fixed(book.bids[i].price), md::to_fixed(book.bids[i].quantity)};
+    }
+    for (uint32_t i = 0; i < top.ask_count; ++i) {
+        top.asks[i] = shared_book::Level{md::to_fixed(book.asks[i].price), md::to_fixed(book.asks[i].quantity)};
+    }
+
+    s.sequence.store(sequence + 2, std::memory_order_release);
+}
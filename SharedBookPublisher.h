@@ -0,0 +1,41 @@
+#pragma once
+
+#include "OrderbookManager.h"
+#include "SharedBookReader.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Writer side of the shared-memory books in SharedBookReader.h. Creates the named
+// region, replacing any left by an earlier run, and unlinks it on destruction; readers
+// that still have it mapped keep their mapping.
+//
+// Each symbol gets a slot the first time it is published. publish() for one slot must
+// not run concurrently with itself (OrderbookManager calls it under the book's shard
+// lock); different slots can be published from different threads.
+class SharedBookPublisher {
+public:
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    // Throws std::runtime_error if the region cannot be created
+    explicit SharedBookPublisher(const std::string& name = shared_book::DEFAULT_NAME, uint32_t capacity = 1024);
+    ~SharedBookPublisher();
+
+    SharedBookPublisher(const SharedBookPublisher&) = delete;
+    SharedBookPublisher& operator=(const SharedBookPublisher&) = delete;
+
+    // The symbol's slot, assigned on first use; NO_SLOT once the region is full
+    uint32_t slot_for(const std::string& symbol);
+    void publish(uint32_t slot, const Orderbook& book);
+
+    const std::string& name() const { return name_; }
+    size_t symbol_count() const { return header_->symbol_count.load(std::memory_order_relaxed); }
+
+private:
+    std::string name_;
+    size_t size_ = 0;
+    shared_book::Header* header_ = nullptr;
+    shared_book::Slot* slots_ = nullptr;
+    std::mutex slots_mutex_;
+    std::unordered_map<std::string, uint32_t> slot_of_;
+};
@@ -0,0 +1,209 @@
+#pragma once
+
+// Header-only: strategy processes include this file and MarketDataCodec.h alone (no
+// Boost, simdjson or TBB) to read the books SharedBookPublisher writes into POSIX
+// shared memory.
+
+#include "MarketDataCodec.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Region layout, native endianness:
+//   SharedBookHeader, then `capacity` SharedBookSlots, each on its own cache lines.
+// A slot's symbol is written once, before symbol_count is raised past it, and never
+// changes. Everything in `top` is guarded by the slot's sequence: odd while the writer
+// is copying into it, advanced by two per publication. Levels are MarketDataCodec fixed
+// point, so a reader can forward them without converting.
+namespace shared_book {
+
+constexpr uint64_t MAGIC = 0x4B4F4F4253524853;  // "SHRSBOOK"
+constexpr uint32_t VERSION = 2;
+constexpr uint32_t DEPTH = 20;
+constexpr size_t SYMBOL_SIZE = 24;
+constexpr const char* DEFAULT_NAME = "/binance_books";
+// Tries a read makes before giving up. A publication copies one Top, well under a
+// microsecond, so a slot still odd after this many pauses (milliseconds) was left
+// mid-publication by a writer that died.
+constexpr uint32_t MAX_READ_ATTEMPTS = 1u << 16;
+
+using Level = md::Level;
+
+struct Top {
+    uint64_t last_update_id;
+    int64_t publish_ns;  // writer's CLOCK_REALTIME when it published
+    uint32_t bid_count;
+    uint32_t ask_count;
+    uint8_t synced;
+    uint8_t stale;
+    uint8_t reserved[6];
+    Level bids[DEPTH];  // best first
+    Level asks[DEPTH];
+};
+
+struct alignas(64) Slot {
+    std::atomic<uint64_t> sequence;
+    char symbol[SYMBOL_SIZE];  // lowercase, NUL padded
+    Top top;
+};
+
+struct alignas(64) Header {
+    uint64_t magic;  // written last, with release, once the header is complete
+    uint32_t version;
+    uint32_t depth;
+    uint32_t capacity;
+    uint32_t slot_size;
+    std::atomic<uint32_t> symbol_count;
+    int32_t writer_pid;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "shared-memory seqlocks need lock-free atomics");
+
+inline size_t region_size(uint32_t capacity) {
+    return sizeof(Header) + static_cast<size_t>(capacity) * sizeof(Slot);
+}
+
+inline Slot* slots(Header* header) {
+    return reinterpret_cast<Slot*>(header + 1);
+}
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+}  // namespace shared_book
+
+// Maps a published region read-only. Reads never block or write to the region, so any
+// number of reader processes leave the writer unaffected; a read that overlaps a
+// publication retries, a bounded number of times. If the writer restarts it replaces the
+// region and readers must construct a new reader to see it.
+class SharedBookReader {
+public:
+    // Throws std::runtime_error if the region does not exist or is not a compatible layout
+    explicit SharedBookReader(const std::string& name = shared_book::DEFAULT_NAME) {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open shared book region " + name);
+        }
+        struct stat info {};
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(shared_book::Header)) {
+            close(fd);
+            throw std::runtime_error("Shared book region " + name + " is not initialized");
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        void* base = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("Cannot map shared book region " + name);
+        }
+        header_ = static_cast<const shared_book::Header*>(base);
+        if (__atomic_load_n(&header_->magic, __ATOMIC_ACQUIRE) != shared_book::MAGIC ||
+            header_->version != shared_book::VERSION || header_->depth != shared_book::DEPTH ||
+            header_->slot_size != sizeof(shared_book::Slot) ||
+            shared_book::region_size(header_->capacity) > size_) {
+            munmap(base, size_);
+            throw std::runtime_error("Shared book region " + name + " has an incompatible layout");
+        }
+        slots_ = reinterpret_cast<const shared_book::Slot*>(header_ + 1);
+    }
+
+    ~SharedBookReader() { munmap(const_cast<shared_book::Header*>(header_), size_); }
+
+    SharedBookReader(const SharedBookReader&) = delete;
+    SharedBookReader& operator=(const SharedBookReader&) = delete;
+
+    size_t symbol_count() const { return header_->symbol_count.load(std::memory_order_acquire); }
+    size_t capacity() const { return header_->capacity; }
+    int writer_pid() const { return header_->writer_pid; }
+
+    std::string symbol(size_t slot) const {
+        return slot < symbol_count() ? std::string(slots_[slot].symbol, strnlen(slots_[slot].symbol, shared_book::SYMBOL_SIZE))
+                                     : std::string();
+    }
+
+    // Slot index for a lowercase symbol, -1 until the writer publishes it. Resolve once
+    // and keep the index; slots never move.
+    int find(const std::string& symbol) const {
+        size_t count = symbol_count();
+        for (size_t i = 0; i < count; ++i) {
+            if (strncmp(slots_[i].symbol, symbol.c_str(), shared_book::SYMBOL_SIZE) == 0) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    // Consistent copy of the slot's top levels; false for an unknown slot, or one still
+    // mid-publication after MAX_READ_ATTEMPTS tries, as a dead writer leaves it
+    bool read(size_t slot, shared_book::Top& out) const {
+        if (slot >= symbol_count()) {
+            return false;
+        }
+        const shared_book::Slot& s = slots_[slot];
+        for (uint32_t attempt = 0; attempt < shared_book::MAX_READ_ATTEMPTS; ++attempt) {
+            uint64_t before = s.sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                shared_book::cpu_relax();
+                continue;
+            }
+            std::memcpy(&out, &s.top, sizeof(out));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.sequence.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Best bid and ask only, copying a few words instead of the whole top. The message's
+    // symbol ID is the slot and its sequence the slot's version. Fails as read() does.
+    bool read_bbo(size_t slot, md::Bbo& out) const {
+        if (slot >= symbol_count()) {
+            return false;
+        }
+        const shared_book::Slot& s = slots_[slot];
+        for (uint32_t attempt = 0; attempt < shared_book::MAX_READ_ATTEMPTS; ++attempt) {
+            uint64_t before = s.sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                shared_book::cpu_relax();
+                continue;
+            }
+            out.update_id = s.top.last_update_id;
+            out.local_ns = s.top.publish_ns;
+            out.bid = s.top.bid_count ? s.top.bids[0] : md::Level{0, 0};
+            out.ask = s.top.ask_count ? s.top.asks[0] : md::Level{0, 0};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.sequence.load(std::memory_order_relaxed) == before) {
+                out.symbol_id = static_cast<uint32_t>(slot);
+                out.exchange = md::Exchange::Binance;
+                out.sequence = before / 2;
+                out.exchange_ns = 0;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Publications so far; changes whenever the slot does, so pollers can skip copies
+    uint64_t version(size_t slot) const {
+        return slot < symbol_count() ? slots_[slot].sequence.load(std::memory_order_acquire) / 2 : 0;
+    }
+
+private:
+    const shared_book::Header* header_ = nullptr;
+    const shared_book::Slot* slots_ = nullptr;
+    size_t size_ = 0;
+};
@@ -0,0 +1,439 @@
+#include "SlabAllocator.h"
+#include "HugePageArena.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <mutex>
+
+namespace {
+
+constexpr size_t REMOTE_SLOTS = 8;      // slabs a thread batches remote frees for at once
+constexpr size_t SCAN_LIMIT = 8;        // owned slabs checked for free blocks before taking a new one
+constexpr size_t SLABS_PER_RESERVE = 4;
+
+struct Block {
+    Block* next;
+};
+
+class ThreadCache;
+
+struct Slab {
+    // Owner thread only
+    Block* free = nullptr;
+    char* bump = nullptr;  // start of the part never handed out
+    char* end = nullptr;
+    Slab* prev = nullptr;
+    Slab* next = nullptr;
+    uint32_t class_index = 0;
+    uint32_t block_size = 0;
+    uint32_t used = 0;  // handed out and not yet back on this slab's free list
+    std::atomic<ThreadCache*> owner{nullptr};
+    // Pushed by other threads, taken whole by the owner
+    alignas(64) std::atomic<Block*> remote_free{nullptr};
+};
+
+constexpr size_t compute_class_size(size_t index) {
+    if (index < 8) {
+        return 16 * (index + 1);
+    }
+    size_t k = 7 + (index - 8) / 4;
+    size_t j = (index - 8) % 4 + 1;
+    return (size_t{1} << k) + j * (size_t{1} << (k - 2));
+}
+
+constexpr auto CLASS_SIZES = []() {
+    std::array<uint32_t, SlabAllocator::SIZE_CLASS_COUNT> sizes{};
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        sizes[i] = static_cast<uint32_t>(compute_class_size(i));
+    }
+    return sizes;
+}();
+static_assert(CLASS_SIZES.back() == SlabAllocator::MAX_SMALL_SIZE);
+static_assert(SlabAllocator::MAX_SMALL_SIZE % SlabAllocator::MAX_ALIGNMENT == 0,
+              "every small request has a class that satisfies its alignment");
+
+size_t class_size(size_t index) {
+    return CLASS_SIZES[index];
+}
+
+bool is_large(size_t size, size_t alignment) {
+    return size > SlabAllocator::MAX_SMALL_SIZE || alignment > SlabAllocator::MAX_ALIGNMENT;
+}
+
+// Request must not be large
+size_t class_index(size_t size, size_t alignment) {
+    size_t index;
+    if (size <= 128) {
+        index = size == 0 ? 0 : (size - 1) / 16;
+    } else {
+        size_t k = std::bit_width(size - 1) - 1;
+        size_t step = (size_t{1} << k) >> 2;
+        index = 8 + 4 * (k - 7) + (size - (size_t{1} << k) + step - 1) / step - 1;
+    }
+    // Blocks are aligned to the lowest set bit of their size; every class is a multiple of 16
+    if (alignment > 16) {
+        while ((CLASS_SIZES[index] & (alignment - 1)) != 0) {
+            ++index;
+        }
+    }
+    return index;
+}
+
+Slab* slab_of(void* p) {
+    return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(p) & ~(SlabAllocator::SLAB_SIZE - 1));
+}
+
+struct Global {
+    std::mutex mutex;
+    Slab* empty = nullptr;
+    Slab* abandoned[SlabAllocator::SIZE_CLASS_COUNT] = {};
+
+    std::atomic<uint64_t> slabs{0};
+    std::atomic<uint64_t> empty_slabs{0};
+    std::atomic<uint64_t> abandoned_slabs{0};
+    std::atomic<uint64_t> adopted_slabs{0};
+    std::atomic<uint64_t> large_allocations{0};
+    std::atomic<uint64_t> remote_frees{0};
+    std::atomic<uint64_t> remote_flushes{0};
+
+    // Serves threads whose cache is already destroyed (thread_local and static destructors)
+    std::mutex fallback_mutex;
+    ThreadCache* fallback = nullptr;
+};
+
+Global& global();
+
+class ThreadCache {
+public:
+    void* allocate(size_t index) {
+        Slab* slab = classes_[index].current;
+        if (slab) {
+            if (void* p = take(slab)) {
+                return p;
+            }
+        }
+        return refill(index);
+    }
+
+    void free(void* p) {
+        Slab* slab = slab_of(p);
+        Block* block = static_cast<Block*>(p);
+        if (slab->owner.load(std::memory_order_relaxed) == this) {
+            block->next = slab->free;
+            slab->free = block;
+            if (--slab->used == 0 && slab != classes_[slab->class_index].current) {
+                unlink(slab);
+                release(slab);
+            }
+            return;
+        }
+
+        PendingFree& pending = pending_[(reinterpret_cast<uintptr_t>(slab) / SlabAllocator::SLAB_SIZE) % REMOTE_SLOTS];
+        if (pending.slab != slab) {
+            flush(pending);
+            pending.slab = slab;
+        }
+        block->next = pending.head;
+        if (pending.head == nullptr) {
+            pending.tail = block;
+        }
+        pending.head = block;
+        if (++pending.count >= SlabAllocator::REMOTE_BATCH) {
+            flush(pending);
+        }
+    }
+
+    void flush_remote() {
+        for (auto& pending : pending_) {
+            flush(pending);
+        }
+    }
+
+    // Thread exit: slabs with blocks still out wait for another thread to adopt them
+    void abandon() {
+        flush_remote();
+        for (auto& cache : classes_) {
+            while (Slab* slab = cache.head) {
+                unlink(slab);
+                collect(slab);
+                if (slab->used == 0) {
+                    release(slab);
+                    continue;
+                }
+                slab->owner.store(nullptr, std::memory_order_relaxed);
+                Global& g = global();
+                std::lock_guard<std::mutex> lock(g.mutex);
+                slab->next = g.abandoned[slab->class_index];
+                g.abandoned[slab->class_index] = slab;
+                g.abandoned_slabs.fetch_add(1, std::memory_order_relaxed);
+            }
+            cache.current = nullptr;
+        }
+    }
+
+private:
+    struct ClassCache {
+        Slab* current = nullptr;  // allocated from until it runs out
+        Slab* head = nullptr;     // every slab of this class the thread owns
+        Slab* tail = nullptr;
+    };
+
+    struct PendingFree {
+        Slab* slab = nullptr;
+        Block* head = nullptr;
+        Block* tail = nullptr;
+        uint32_t count = 0;
+    };
+
+    ClassCache classes_[SlabAllocator::SIZE_CLASS_COUNT];
+    PendingFree pending_[REMOTE_SLOTS];
+
+    static void* take(Slab* slab) {
+        if (Block* block = slab->free) {
+            slab->free = block->next;
+            ++slab->used;
+            return block;
+        }
+        if (slab->bump + slab->block_size <= slab->end) {
+            void* p = slab->bump;
+            slab->bump += slab->block_size;
+            ++slab->used;
+            return p;
+        }
+        return nullptr;
+    }
+
+    // Moves blocks freed by other threads onto the local free list
+    static bool collect(Slab* slab) {
+        Block* list = slab->remote_free.exchange(nullptr, std::memory_order_acquire);
+        if (list == nullptr) {
+            return false;
+        }
+        uint32_t count = 1;
+        Block* tail = list;
+        while (tail->next != nullptr) {
+            tail = tail->next;
+            ++count;
+        }
+        tail->next = slab->free;
+        slab->free = list;
+        slab->used -= count;
+        return true;
+    }
+
+    void* refill(size_t index) {
+        ClassCache& cache = classes_[index];
+        if (cache.current && collect(cache.current)) {
+            return take(cache.current);
+        }
+        // Exhausted slabs are rotated to the back, so every owned slab is revisited
+        // once others stop yielding blocks
+        for (size_t scanned = 0; scanned < SCAN_LIMIT && cache.head != cache.tail; ++scanned) {
+            Slab* slab = cache.head;
+            if (slab != cache.current) {
+                collect(slab);
+                if (void* p = take(slab)) {
+                    cache.current = slab;
+                    return p;
+                }
+            }
+            unlink(slab);
+            link_back(slab);
+        }
+        // An adopted slab may still have every block out
+        while (true) {
+            Slab* slab = acquire(index);
+            link_back(slab);
+            if (void* p = take(slab)) {
+                cache.current = slab;
+                return p;
+            }
+        }
+    }
+
+    Slab* acquire(size_t index) {
+        Global& g = global();
+        Slab* slab;
+        bool adopted = false;
+        {
+            std::lock_guard<std::mutex> lock(g.mutex);
+            if ((slab = g.abandoned[index]) != nullptr) {
+                g.abandoned[index] = slab->next;
+                g.abandoned_slabs.fetch_sub(1, std::memory_order_relaxed);
+                g.adopted_slabs.fetch_add(1, std::memory_order_relaxed);
+                adopted = true;
+            } else if ((slab = g.empty) != nullptr) {
+                g.empty = slab->next;
+                g.empty_slabs.fetch_sub(1, std::memory_order_relaxed);
+            } else {
+                slab = reserve(g);
+            }
+        }
+        slab->prev = slab->next = nullptr;
+        if (adopted) {
+            slab->owner.store(this, std::memory_order_relaxed);
+            collect(slab);
+            return slab;
+        }
+        const size_t block_size = class_size(index);
+        const size_t alignment = std::min(block_size & (~block_size + 1), SlabAllocator::MAX_ALIGNMENT);
+        const size_t header = (sizeof(Slab) + alignment - 1) / alignment * alignment;
+        slab->free = nullptr;
+        slab->bump = reinterpret_cast<char*>(slab) + header;
+        slab->end = reinterpret_cast<char*>(slab) + SlabAllocator::SLAB_SIZE;
+        slab->class_index = static_cast<uint32_t>(index);
+        slab->block_size = static_cast<uint32_t>(block_size);
+        slab->used = 0;
+        slab->owner.store(this, std::memory_order_relaxed);
+        return slab;
+    }
+
+    // Called with the global mutex held
+    static Slab* reserve(Global& g) {
+        // From the huge page arena when one is configured; spans are never given back
+        void* span = HugePageArena::allocate_from(ArenaKind::Slabs, SlabAllocator::SLAB_SIZE * SLABS_PER_RESERVE,
+                                                  SlabAllocator::SLAB_SIZE);
+        char* base = static_cast<char*>(span);
+        for (size_t i = 1; i < SLABS_PER_RESERVE; ++i) {
+            Slab* spare = ::new (base + i * SlabAllocator::SLAB_SIZE) Slab();
+            spare->next = g.empty;
+            g.empty = spare;
+        }
+        g.slabs.fetch_add(SLABS_PER_RESERVE, std::memory_order_relaxed);
+        g.empty_slabs.fetch_add(SLABS_PER_RESERVE - 1, std::memory_order_relaxed);
+        return ::new (base) Slab();
+    }
+
+    // An empty slab goes back to the global pool, where any size class can reuse it
+    static void release(Slab* slab) {
+        slab->owner.store(nullptr, std::memory_order_relaxed);
+        slab->block_size = 0;
+        Global& g = global();
+        std::lock_guard<std::mutex> lock(g.mutex);
+        slab->next = g.empty;
+        g.empty = slab;
+        g.empty_slabs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void flush(PendingFree& pending) {
+        if (pending.count == 0) {
+            return;
+        }
+        Block* head = pending.slab->remote_free.load(std::memory_order_relaxed);
+        do {
+            pending.tail->next = head;
+        } while (!pending.slab->remote_free.compare_exchange_weak(head, pending.head, std::memory_order_release,
+                                                                  std::memory_order_relaxed));
+        Global& g = global();
+        g.remote_frees.fetch_add(pending.count, std::memory_order_relaxed);
+        g.remote_flushes.fetch_add(1, std::memory_order_relaxed);
+        pending = PendingFree{};
+    }
+
+    void link_back(Slab* slab) {
+        ClassCache& cache = classes_[slab->class_index];
+        slab->prev = cache.tail;
+        slab->next = nullptr;
+        (cache.tail ? cache.tail->next : cache.head) = slab;
+        cache.tail = slab;
+    }
+
+    void unlink(Slab* slab) {
+        ClassCache& cache = classes_[slab->class_index];
+        (slab->prev ? slab->prev->next : cache.head) = slab->next;
+        (slab->next ? slab->next->prev : cache.tail) = slab->prev;
+        slab->prev = slab->next = nullptr;
+    }
+};
+
+Global& global() {
+    // Never destroyed: blocks may be freed from static destructors after main returns
+    static Global* g = []() {
+        auto* created = new Global();
+        created->fallback = new ThreadCache();
+        return created;
+    }();
+    return *g;
+}
+
+thread_local ThreadCache* t_cache = nullptr;
+thread_local bool t_cache_destroyed = false;
+
+struct CacheReaper {
+    ~CacheReaper() {
+        if (t_cache) {
+            t_cache->abandon();
+            delete t_cache;
+            t_cache = nullptr;
+        }
+        t_cache_destroyed = true;
+    }
+};
+
+ThreadCache* thread_cache() {
+    if (t_cache == nullptr && !t_cache_destroyed) {
+        static thread_local CacheReaper reaper;
+        (void)reaper;
+        global();
+        t_cache = new ThreadCache();
+    }
+    return t_cache;
+}
+
+}  // namespace
+
+void* SlabAllocator::allocate(size_t size, size_t alignment) {
+    if (is_large(size, alignment)) {
+        global().large_allocations.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size, std::align_val_t(alignment));
+    }
+    const size_t index = class_index(size, alignment);
+    if (ThreadCache* cache = thread_cache()) {
+        return cache->allocate(index);
+    }
+    Global& g = global();
+    std::lock_guard<std::mutex> lock(g.fallback_mutex);
+    return g.fallback->allocate(index);
+}
+
+void SlabAllocator::deallocate(void* p, size_t size, size_t alignment) noexcept {
+    if (p == nullptr) {
+        return;
+    }
+    if (is_large(size, alignment)) {
+        ::operator delete(p, size, std::align_val_t(alignment));
+        return;
+    }
+    if (ThreadCache* cache = thread_cache()) {
+        cache->free(p);
+        return;
+    }
+    Global& g = global();
+    std::lock_guard<std::mutex> lock(g.fallback_mutex);
+    g.fallback->free(p);
+    g.fallback->flush_remote();
+}
+
+void SlabAllocator::flush_thread_cache() {
+    if (t_cache) {
+        t_cache->flush_remote();
+    }
+}
+
+SlabAllocator::Stats SlabAllocator::stats() {
+    Global& g = global();
+    Stats stats;
+    stats.slabs = g.slabs.load(std::memory_order_relaxed);
+    stats.empty_slabs = g.empty_slabs.load(std::memory_order_relaxed);
+    stats.abandoned_slabs = g.abandoned_slabs.load(std::memory_order_relaxed);
+    stats.adopted_slabs = g.adopted_slabs.load(std::memory_order_relaxed);
+    stats.large_allocations = g.large_allocations.load(std::memory_order_relaxed);
+    stats.remote_frees = g.remote_frees.load(std::memory_order_relaxed);
+    stats.remote_flushes = g.remote_flushes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+size_t SlabAllocator::size_class(size_t size, size_t alignment) {
+    return is_large(size, alignment) ? 0 : class_size(class_index(size, alignment));
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <utility>
+
+// Process-wide slab allocator with per-thread caches.
+//
+// Requests up to MAX_SMALL_SIZE bytes are rounded up to one of 40 size classes (16-byte
+// steps to 128, then four classes per power of two) and served from SLAB_SIZE slabs
+// aligned to their own size, so the slab of any block is found by masking its address.
+// Each slab belongs to one thread cache: allocating and freeing on that thread touch no
+// shared state. A block freed on another thread is batched per slab on the freeing thread
+// and handed back with one CAS per REMOTE_BATCH blocks; the owner collects the whole list
+// with one exchange when it runs out of local blocks. Slabs of exited threads are adopted
+// by the next thread that needs their size class.
+//
+// Deallocation must pass the size and alignment the block was allocated with; larger
+// requests and alignments above MAX_ALIGNMENT go to the global operator new.
+class SlabAllocator {
+public:
+    static constexpr size_t SLAB_SIZE = 256 * 1024;
+    static constexpr size_t MAX_SMALL_SIZE = 32 * 1024;
+    static constexpr size_t MAX_ALIGNMENT = 4096;
+    static constexpr size_t SIZE_CLASS_COUNT = 40;
+    static constexpr uint32_t REMOTE_BATCH = 32;
+
+    struct Stats {
+        uint64_t slabs = 0;             // reserved from the system, never returned
+        uint64_t empty_slabs = 0;       // free for any size class
+        uint64_t abandoned_slabs = 0;   // left by exited threads, waiting for adoption
+        uint64_t adopted_slabs = 0;
+        uint64_t large_allocations = 0;
+        uint64_t remote_frees = 0;      // blocks handed back to another thread's slab
+        uint64_t remote_flushes = 0;    // CASes that carried them
+    };
+
+    // alignment must be a power of two
+    static void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    static void deallocate(void* p, size_t size, size_t alignment = alignof(std::max_align_t)) noexcept;
+
+    // Hands this thread's batched remote frees to their owners now instead of when a
+    // batch fills or the thread exits
+    static void flush_thread_cache();
+    static Stats stats();
+
+    // Block size used for a request, 0 for requests served by operator new
+    static size_t size_class(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    template<typename T, typename... Args>
+    static T* create(Args&&... args) {
+        void* p = allocate(sizeof(T), alignof(T));
+        try {
+            return ::new (p) T(std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(p, sizeof(T), alignof(T));
+            throw;
+        }
+    }
+
+    template<typename T>
+    static void destroy(T* p) noexcept {
+        if (p) {
+            p->~T();
+            deallocate(p, sizeof(T), alignof(T));
+        }
+    }
+};
+
+// Allocator-aware container adapter, e.g. std::vector<T, SlabStlAllocator<T>> or
+// std::allocate_shared<T>(SlabStlAllocator<T>(), ...). Stateless: all instances are equal.
+template<typename T>
+class SlabStlAllocator {
+public:
+    using value_type = T;
+
+    SlabStlAllocator() noexcept = default;
+    template<typename U>
+    SlabStlAllocator(const SlabStlAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(SlabAllocator::allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        SlabAllocator::deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template<typename U>
+    bool operator==(const SlabStlAllocator<U>&) const noexcept { return true; }
+    template<typename U>
+    bool operator!=(const SlabStlAllocator<U>&) const noexcept { return false; }
+};
@@ -0,0 +1,115 @@
+#include "SocketTuning.h"
+#include <spdlog/spdlog.h>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#endif
+
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+
+namespace {
+
+#ifdef __linux__
+bool set_int_option(int fd, int level, int name, int value, const char* what) {
+    if (setsockopt(fd, level, name, &value, sizeof(value)) != 0) {
+        spdlog::warn("Failed to set {} on fd {}: {}", what, fd, std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+#endif
+
+} // namespace
+
+bool SocketTuning::apply_low_latency_profile(int fd, const LowLatencySocketProfile& profile) {
+#ifdef __linux__
+    bool ok = true;
+
+    if (profile.rx_timestamps) {
+        int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        if (!set_int_option(fd, SOL_SOCKET, SO_TIMESTAMPING, flags, "SO_TIMESTAMPING")) {
+            ok = set_int_option(fd, SOL_SOCKET, SO_TIMESTAMPNS, 1, "SO_TIMESTAMPNS") && ok;
+        }
+    }
+    if (profile.busy_poll_us > 0) {
+        ok = set_int_option(fd, SOL_SOCKET, SO_BUSY_POLL, profile.busy_poll_us, "SO_BUSY_POLL") && ok;
+        if (profile.prefer_busy_poll) {
+            ok = set_int_option(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, 1, "SO_PREFER_BUSY_POLL") && ok;
+        }
+    }
+    if (profile.incoming_cpu >= 0) {
+        ok = set_int_option(fd, SOL_SOCKET, SO_INCOMING_CPU, profile.incoming_cpu, "SO_INCOMING_CPU") && ok;
+    }
+    if (profile.quick_ack) {
+        ok = set_int_option(fd, IPPROTO_TCP, TCP_QUICKACK, 1, "TCP_QUICKACK") && ok;
+    }
+    return ok;
+#else
+    (void)fd;
+    (void)profile;
+    spdlog::warn("Low-latency socket profile is not supported on this platform");
+    return false;
+#endif
+}
+
+void SocketTuning::rearm_quick_ack(int fd) {
+#ifdef __linux__
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+#else
+    (void)fd;
+#endif
+}
+
+int64_t SocketTuning::peek_rx_timestamp_ns(int fd) {
+#ifdef __linux__
+    char byte;
+    struct iovec iov{&byte, 1};
+    alignas(struct cmsghdr) char control[256];
+
+    struct msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (recvmsg(fd, &msg, MSG_PEEK | MSG_DONTWAIT) <= 0) {
+        return -1;
+    }
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) continue;
+        if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            struct scm_timestamping ts;
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            // ts[0] holds the software timestamp
+            if (ts.ts[0].tv_sec != 0 || ts.ts[0].tv_nsec != 0) {
+                return static_cast<int64_t>(ts.ts[0].tv_sec) * 1000000000LL + ts.ts[0].tv_nsec;
+            }
+        } else if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec ts;
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+        }
+    }
+    return -1;
+#else
+    (void)fd;
+    return -1;
+#endif
+}
+
+int64_t SocketTuning::realtime_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
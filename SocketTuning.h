@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+// Optional low-latency profile for market data sockets. Every option is best effort:
+// kernels or privileges that do not support one just leave it unset.
+struct LowLatencySocketProfile {
+    bool enabled = false;
+    bool rx_timestamps = true;     // software RX timestamps (SO_TIMESTAMPING, falls back to SO_TIMESTAMPNS)
+    int busy_poll_us = 50;         // SO_BUSY_POLL budget, 0 disables
+    bool prefer_busy_poll = true;  // SO_PREFER_BUSY_POLL
+    int incoming_cpu = -1;         // SO_INCOMING_CPU steering, -1 leaves it to the kernel
+    bool quick_ack = true;         // TCP_QUICKACK, re-armed after every read
+};
+
+class SocketTuning {
+public:
+    // Returns true if every requested option was accepted by the kernel
+    static bool apply_low_latency_profile(int fd, const LowLatencySocketProfile& profile);
+
+    // TCP_QUICKACK is not sticky, the kernel clears it again after delayed ACK decisions
+    static void rearm_quick_ack(int fd);
+
+    // Peeks at the head of the receive queue without consuming it and returns the kernel
+    // receive timestamp in CLOCK_REALTIME nanoseconds, or -1 if none is available.
+    static int64_t peek_rx_timestamp_ns(int fd);
+
+    static int64_t realtime_ns();
+};
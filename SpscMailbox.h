@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include "HugePageArena.h"
+
+// Bounded single-producer single-consumer ring. Each side owns one index and keeps a
+// cached copy of the other, so a push or pop touches the shared line only when the
+// cached view says the ring looks full or empty. Never allocates after construction;
+// the slots come from the rings arena when one is configured.
+//
+// T must be default constructible and move assignable.
+template<typename T>
+class SpscMailbox {
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscMailbox(size_t capacity = 1024) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots_ = ArenaArray<T>(ArenaKind::Rings, size);
+        mask_ = size - 1;
+    }
+
+    SpscMailbox(const SpscMailbox&) = delete;
+    SpscMailbox& operator=(const SpscMailbox&) = delete;
+
+    // Producer only. Leaves value untouched and returns false when full.
+    bool try_push(T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only
+    bool try_pop(T& result) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+        }
+        result = std::move(slots_[head & mask_]);
+        slots_[head & mask_] = T();
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate from any thread other than the two sides
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    ArenaArray<T> slots_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> head_{0};  // consumer
+    size_t cached_tail_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0};  // producer
+    size_t cached_head_ = 0;
+};
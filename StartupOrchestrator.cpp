@@ -0,0 +1,178 @@
+#include "StartupOrchestrator.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+StartupOrchestrator::StartupOrchestrator(const StartupConfig& config)
+    : config_(config), start_time_(std::chrono::steady_clock::now()) {}
+
+int StartupOrchestrator::snapshot_weight(int limit) {
+    if (limit <= 100) return 5;
+    if (limit <= 500) return 25;
+    if (limit <= 1000) return 50;
+    return 250;
+}
+
+std::vector<std::vector<std::string>> StartupOrchestrator::group_streams(const std::vector<std::string>& symbols,
+                                                                         size_t streams_per_connection) {
+    std::vector<std::vector<std::string>> groups;
+    size_t per_connection = std::max<size_t>(streams_per_connection, 1);
+    for (size_t i = 0; i < symbols.size(); i += per_connection) {
+        size_t end = std::min(symbols.size(), i + per_connection);
+        groups.emplace_back(symbols.begin() + i, symbols.begin() + end);
+    }
+    return groups;
+}
+
+std::vector<std::chrono::milliseconds> StartupOrchestrator::plan_snapshot_schedule(size_t count, const StartupConfig& config) {
+    std::vector<std::chrono::milliseconds> schedule;
+    schedule.reserve(count);
+
+    // Sliding window: at most per_window requests start inside any 60s span, so the
+    // spend never exceeds the budget however the exchange aligns its minute
+    const int weight = snapshot_weight(config.snapshot_limit);
+    const int cold_start_budget = config.weight_budget_per_minute - config.resync_weight_per_minute;
+    const size_t per_window = std::max<size_t>(1, static_cast<size_t>(std::max(cold_start_budget, 0) / weight));
+    const std::chrono::milliseconds window(60000);
+
+    for (size_t i = 0; i < count; ++i) {
+        std::chrono::milliseconds t(0);
+        if (i > 0) {
+            t = schedule[i - 1] + config.stagger;
+        }
+        if (i >= per_window) {
+            t = std::max(t, schedule[i - per_window] + window);
+        }
+        schedule.push_back(t);
+    }
+    return schedule;
+}
+
+void StartupOrchestrator::begin(const std::vector<std::string>& symbols) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    start_time_ = std::chrono::steady_clock::now();
+    consistent_ms_.clear();
+    pending_.clear();
+    resyncs_.clear();
+    resync_slots_.clear();
+    requests_.clear();
+    peak_weight_ = 0;
+    for (const auto& symbol : symbols) {
+        pending_[symbol] = start_time_;
+    }
+}
+
+void StartupOrchestrator::add_symbol(const std::string& symbol) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (consistent_ms_.count(symbol) == 0) {
+        pending_[symbol] = std::chrono::steady_clock::now();
+    }
+}
+
+void StartupOrchestrator::on_book_consistent(const std::string& symbol) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pending_.find(symbol);
+    if (it == pending_.end()) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    consistent_ms_[symbol] = std::chrono::duration<double, std::milli>(now - it->second).count();
+    pending_.erase(it);
+
+    if (pending_.empty()) {
+        double total = std::chrono::duration<double, std::milli>(now - start_time_).count();
+        spdlog::info("All {} order books consistent after {:.1f} ms", consistent_ms_.size(), total);
+    }
+}
+
+bool StartupOrchestrator::complete() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.empty();
+}
+
+StartupReport StartupOrchestrator::report() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    StartupReport report;
+    report.time_to_consistent_ms = consistent_ms_;
+    report.pending = pending_.size();
+    report.peak_weight = peak_weight_;
+
+    std::vector<double> times;
+    times.reserve(consistent_ms_.size());
+    for (const auto& [symbol, ms] : consistent_ms_) {
+        times.push_back(ms);
+    }
+    if (!times.empty()) {
+        std::sort(times.begin(), times.end());
+        report.p50_ms = times[times.size() / 2];
+        report.p99_ms = times[std::min(times.size() - 1, times.size() * 99 / 100)];
+    }
+    report.overall_ms = pending_.empty() && !times.empty()
+        ? times.back()
+        : std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time_).count();
+    return report;
+}
+
+namespace {
+const std::chrono::milliseconds kWeightWindow(60000);
+}
+
+std::chrono::milliseconds StartupOrchestrator::schedule_resync(const std::string& symbol,
+                                                               std::chrono::steady_clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int weight = snapshot_weight(config_.snapshot_limit);
+    const size_t per_window = std::max<size_t>(1, static_cast<size_t>(std::max(config_.resync_weight_per_minute, 0) / weight));
+
+    // A symbol that keeps losing its book backs off; one quiet for a while starts over
+    auto earliest = now;
+    auto it = resyncs_.find(symbol);
+    if (it != resyncs_.end()) {
+        Resync& resync = it->second;
+        if (now - resync.last >= config_.max_resync_backoff) {
+            resync.backoff = std::chrono::milliseconds(0);
+        } else {
+            resync.backoff = resync.backoff.count() == 0
+                ? config_.resync_backoff
+                : std::min(config_.max_resync_backoff, resync.backoff * 2);
+            earliest = std::max(now, resync.last + resync.backoff);
+        }
+    }
+
+    // Slots that can no longer share a window with one at or after now
+    resync_slots_.erase(resync_slots_.begin(), resync_slots_.upper_bound(now - kWeightWindow));
+    // The first slot that fits is earliest itself or just clears the window of a taken one;
+    // the last taken slot plus a window always fits
+    auto slot = earliest;
+    if (!resync_fits(slot, per_window)) {
+        for (auto taken : resync_slots_) {
+            if (taken + kWeightWindow > earliest && resync_fits(taken + kWeightWindow, per_window)) {
+                slot = taken + kWeightWindow;
+                break;
+            }
+        }
+    }
+    resync_slots_.insert(slot);
+    resyncs_[symbol].last = slot;
+    return std::chrono::ceil<std::chrono::milliseconds>(slot - now);
+}
+
+bool StartupOrchestrator::resync_fits(std::chrono::steady_clock::time_point slot, size_t per_window) const {
+    // Every 60s window holding slot must hold fewer than per_window taken slots
+    std::vector<std::chrono::steady_clock::time_point> nearby(
+        resync_slots_.upper_bound(slot - kWeightWindow), resync_slots_.lower_bound(slot + kWeightWindow));
+    nearby.insert(std::upper_bound(nearby.begin(), nearby.end(), slot), slot);
+    for (size_t i = 0; i + per_window < nearby.size(); ++i) {
+        if (nearby[i + per_window] - nearby[i] < kWeightWindow) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void StartupOrchestrator::on_snapshot_request(std::chrono::steady_clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.push_back(now);
+    while (now - requests_.front() >= kWeightWindow) {
+        requests_.pop_front();
+    }
+    peak_weight_ = std::max(peak_weight_, static_cast<int>(requests_.size()) * snapshot_weight(config_.snapshot_limit));
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct StartupConfig {
+    size_t streams_per_connection = 200;   // exchange allows up to 1024 streams per connection
+    int snapshot_limit = 100;              // depth levels per snapshot, drives the request weight
+    int weight_budget_per_minute = 6000;   // REQUEST_WEIGHT limit of the REST API
+    // Weight per minute kept for resyncs; cold start may spend the rest, which with the
+    // defaults is 5100, room for 1020 snapshots of limit 100 in one window
+    int resync_weight_per_minute = 900;
+    std::chrono::milliseconds stagger{2};  // spacing between snapshot requests inside a burst
+    std::chrono::milliseconds resume_grace{1000};  // checkpointed books wait this long for a continuing diff
+    // A symbol resyncing again within max_resync_backoff of its last resync waits
+    // resync_backoff, doubling per repeat up to max_resync_backoff
+    std::chrono::milliseconds resync_backoff{500};
+    std::chrono::milliseconds max_resync_backoff{30000};
+};
+
+struct StartupReport {
+    std::unordered_map<std::string, double> time_to_consistent_ms;  // per symbol
+    double overall_ms = 0.0;   // until the last book became consistent
+    double p50_ms = 0.0;
+    double p99_ms = 0.0;
+    size_t pending = 0;        // symbols that are not consistent yet
+    int peak_weight = 0;       // most snapshot request weight sent inside one 60s window
+};
+
+// Plans a cold start: symbols are packed into combined-stream connections that are all
+// opened at once, and snapshot fetches are spread over time so their total request
+// weight stays inside the budget. Tracks time-to-first-consistent-book per symbol.
+// Resyncs after a lost book spend the reserve cold start leaves over, in their own
+// sliding window, so the two together never exceed it.
+class StartupOrchestrator {
+public:
+    explicit StartupOrchestrator(const StartupConfig& config = StartupConfig());
+
+    static int snapshot_weight(int limit);
+    static std::vector<std::vector<std::string>> group_streams(const std::vector<std::string>& symbols,
+                                                               size_t streams_per_connection);
+    // Start offset of each snapshot fetch; any 60s window stays inside the weight budget
+    static std::vector<std::chrono::milliseconds> plan_snapshot_schedule(size_t count, const StartupConfig& config);
+
+    const StartupConfig& config() const { return config_; }
+
+    void begin(const std::vector<std::string>& symbols);
+    void add_symbol(const std::string& symbol);
+    // Only the first transition to consistent counts
+    void on_book_consistent(const std::string& symbol);
+    bool complete() const;
+    StartupReport report() const;
+
+    // Delay before a resync snapshot of symbol may be requested: the symbol's backoff, then
+    // the first slot that keeps any 60s window of resyncs inside the leftover budget. The
+    // slot is taken, so call once per fetch.
+    std::chrono::milliseconds schedule_resync(const std::string& symbol,
+                                              std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+    // Counts one snapshot request sent now toward the report's peak weight
+    void on_snapshot_request(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+private:
+    StartupConfig config_;
+    std::chrono::steady_clock::time_point start_time_;
+    std::unordered_map<std::string, double> consistent_ms_;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> pending_;
+
+    struct Resync {
+        std::chrono::steady_clock::time_point last;  // when the latest resync was scheduled to start
+        std::chrono::milliseconds backoff{0};        // 0 for the first resync after a quiet period
+    };
+    std::unordered_map<std::string, Resync> resyncs_;
+    std::multiset<std::chrono::steady_clock::time_point> resync_slots_;  // taken, recent and future
+    std::deque<std::chrono::steady_clock::time_point> requests_;        // sent in the last 60s
+    int peak_weight_ = 0;
+    mutable std::mutex mutex_;
+
+    bool resync_fits(std::chrono::steady_clock::time_point slot, size_t per_window) const;
+};
@@ -0,0 +1,230 @@
+#include "SymbolRouter.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <spdlog/spdlog.h>
+
+SymbolRouter::SymbolRouter(EventLoopPool& pool, const PlacementConfig& config)
+    : pool_(pool),
+      config_(config),
+      last_sample_(std::chrono::steady_clock::now()),
+      sampled_loop_busy_ns_(pool.size(), 0),
+      loop_loads_(pool.size()) {
+    for (size_t i = 0; i < pool_.size(); ++i) {
+        sampled_loop_busy_ns_[i] = pool_.get_event_loop(i).get_busy_ns();
+    }
+}
+
+std::shared_ptr<SymbolRouter::SymbolState> SymbolRouter::find(const std::string& symbol) const {
+    std::shared_lock<std::shared_mutex> lock(symbols_mutex_);
+    auto it = symbols_.find(symbol);
+    return it == symbols_.end() ? nullptr : it->second;
+}
+
+size_t SymbolRouter::assign(const std::string& symbol) {
+    std::vector<double> utilization(pool_.size(), 0.0);
+    {
+        std::lock_guard<std::mutex> lock(sample_mutex_);
+        for (size_t i = 0; i < loop_loads_.size(); ++i) {
+            utilization[i] = loop_loads_[i].utilization;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(symbols_mutex_);
+    auto it = symbols_.find(symbol);
+    if (it != symbols_.end()) {
+        return it->second->loop.load();
+    }
+
+    // Least measured load first; before any measurement, fewest symbols
+    std::vector<size_t> counts(pool_.size(), 0);
+    for (const auto& [name, state] : symbols_) {
+        ++counts[state->loop.load()];
+    }
+    size_t best = 0;
+    for (size_t i = 1; i < pool_.size(); ++i) {
+        if (utilization[i] < utilization[best] ||
+            (utilization[i] == utilization[best] && counts[i] < counts[best])) {
+            best = i;
+        }
+    }
+
+    auto state = std::make_shared<SymbolState>();
+    state->loop = best;
+    symbols_.emplace(symbol, std::move(state));
+    return best;
+}
+
+void SymbolRouter::remove(const std::string& symbol) {
+    std::unique_lock<std::shared_mutex> lock(symbols_mutex_);
+    symbols_.erase(symbol);
+}
+
+std::shared_ptr<SymbolRouter::SymbolState> SymbolRouter::find_or_assign(const std::string& symbol) {
+    auto state = find(symbol);
+    if (!state) {
+        assign(symbol);
+        state = find(symbol);
+    }
+    return state;
+}
+
+size_t SymbolRouter::loop_of(const std::string& symbol) const {
+    auto state = find(symbol);
+    return state ? state->loop.load() : std::numeric_limits<size_t>::max();
+}
+
+bool SymbolRouter::is_migrating(const std::string& symbol) const {
+    auto state = find(symbol);
+    if (!state) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->migrating;
+}
+
+bool SymbolRouter::migrate(const std::string& symbol, size_t target_loop) {
+    auto state = find(symbol);
+    if (!state || target_loop >= pool_.size()) {
+        return false;
+    }
+
+    size_t source_loop;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->migrating || state->loop == target_loop) {
+            return false;
+        }
+        state->migrating = true;
+        source_loop = state->loop;
+    }
+    migrations_.fetch_add(1, std::memory_order_relaxed);
+
+    // Same lane as the symbol's tasks, so the fence runs after all of them on the old loop
+    pool_.get_event_loop(source_loop).post([this, state, target_loop]() {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->loop = target_loop;
+        for (auto& task : state->held) {
+            post_to(target_loop, state, std::move(task));
+        }
+        state->held.clear();
+        state->migrating = false;
+    }, EventLoop::Priority::High);
+    return true;
+}
+
+void SymbolRouter::sample(std::chrono::steady_clock::time_point now) {
+    double elapsed_s = std::chrono::duration<double>(now - last_sample_).count();
+    if (elapsed_s <= 0.0) {
+        return;
+    }
+    last_sample_ = now;
+
+    std::vector<LoopLoad> loads(pool_.size());
+    for (size_t i = 0; i < pool_.size(); ++i) {
+        uint64_t busy = pool_.get_event_loop(i).get_busy_ns();
+        loads[i].utilization = (busy - sampled_loop_busy_ns_[i]) / 1e9 / elapsed_s;
+        sampled_loop_busy_ns_[i] = busy;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(symbols_mutex_);
+    for (auto& [symbol, state] : symbols_) {
+        uint64_t messages = state->messages.load(std::memory_order_relaxed);
+        uint64_t busy = state->busy_ns.load(std::memory_order_relaxed);
+        state->message_rate = (messages - state->sampled_messages) / elapsed_s;
+        state->utilization = (busy - state->sampled_busy_ns) / 1e9 / elapsed_s;
+        state->sampled_messages = messages;
+        state->sampled_busy_ns = busy;
+
+        LoopLoad& load = loads[state->loop.load()];
+        load.message_rate += state->message_rate;
+        ++load.symbols;
+    }
+    loop_loads_ = std::move(loads);
+}
+
+size_t SymbolRouter::rebalance() {
+    if (pool_.size() < 2) {
+        return 0;
+    }
+
+    std::vector<LoopLoad> loads;
+    std::vector<SymbolLoad> candidates;
+    {
+        std::lock_guard<std::mutex> lock(sample_mutex_);
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_sample_ < config_.sample_interval) {
+            return 0;
+        }
+        sample(now);
+        loads = loop_loads_;
+
+        std::shared_lock<std::shared_mutex> symbols_lock(symbols_mutex_);
+        for (const auto& [symbol, state] : symbols_) {
+            candidates.push_back({symbol, state->loop.load(), state->message_rate, state->utilization});
+        }
+    }
+
+    size_t started = 0;
+    while (started < config_.max_migrations) {
+        auto by_utilization = [](const LoopLoad& a, const LoopLoad& b) { return a.utilization < b.utilization; };
+        size_t busiest = std::max_element(loads.begin(), loads.end(), by_utilization) - loads.begin();
+        size_t idlest = std::min_element(loads.begin(), loads.end(), by_utilization) - loads.begin();
+        double gap = loads[busiest].utilization - loads[idlest].utilization;
+        if (gap <= config_.imbalance_threshold) {
+            break;
+        }
+
+        // The symbol whose load comes closest to halving the gap; one that alone exceeds
+        // the gap would only move the hot spot
+        SymbolLoad* best = nullptr;
+        for (auto& candidate : candidates) {
+            if (candidate.loop != busiest || candidate.utilization <= 0.0 || candidate.utilization >= gap) {
+                continue;
+            }
+            if (!best || std::abs(gap / 2 - candidate.utilization) < std::abs(gap / 2 - best->utilization)) {
+                best = &candidate;
+            }
+        }
+        if (!best) {
+            break;
+        }
+
+        if (migrate(best->symbol, idlest)) {
+            spdlog::info("Migrating {} from loop {} to loop {} ({:.0f} msg/s, {:.1f}% of a core)",
+                         best->symbol, busiest, idlest, best->message_rate, best->utilization * 100.0);
+            loads[busiest].utilization -= best->utilization;
+            loads[idlest].utilization += best->utilization;
+            ++started;
+        }
+        best->loop = idlest;
+        best->utilization = 0.0;  // never pick it twice in one round
+    }
+    return started;
+}
+
+double SymbolRouter::imbalance() const {
+    std::lock_guard<std::mutex> lock(sample_mutex_);
+    if (loop_loads_.empty()) {
+        return 0.0;
+    }
+    auto [min_it, max_it] = std::minmax_element(loop_loads_.begin(), loop_loads_.end(),
+        [](const LoopLoad& a, const LoopLoad& b) { return a.utilization < b.utilization; });
+    return max_it->utilization - min_it->utilization;
+}
+
+std::vector<LoopLoad> SymbolRouter::loop_loads() const {
+    std::lock_guard<std::mutex> lock(sample_mutex_);
+    return loop_loads_;
+}
+
+std::vector<SymbolLoad> SymbolRouter::symbol_loads() const {
+    std::lock_guard<std::mutex> lock(sample_mutex_);
+    std::shared_lock<std::shared_mutex> symbols_lock(symbols_mutex_);
+    std::vector<SymbolLoad> loads;
+    loads.reserve(symbols_.size());
+    for (const auto& [symbol, state] : symbols_) {
+        loads.push_back({symbol, state->loop.load(), state->message_rate, state->utilization});
+    }
+    return loads;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "EventLoop.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct PlacementConfig {
+    std::chrono::milliseconds sample_interval{1000};  // rebalance() is a no-op until this much time passed
+    double imbalance_threshold = 0.2;   // busiest minus idlest loop, as a fraction of one core
+    size_t max_migrations = 4;          // per rebalance()
+};
+
+struct SymbolLoad {
+    std::string symbol;
+    size_t loop = 0;
+    double message_rate = 0.0;  // messages per second over the last sample
+    double utilization = 0.0;   // share of a core spent on this symbol's tasks
+};
+
+struct LoopLoad {
+    double utilization = 0.0;   // busy time / wall time over the last sample
+    double message_rate = 0.0;
+    size_t symbols = 0;
+};
+
+// Owns the symbol -> event loop placement for message processing. Tasks routed for a
+// symbol run on its loop in the order they were routed. Placement follows measured
+// load: per-symbol message rate and task time, per-loop busy time. A symbol migrates
+// by drain-and-handoff: new tasks are held, a fence task runs on the old loop after
+// everything already queued there, then the held tasks move to the new loop in order.
+class SymbolRouter {
+public:
+    explicit SymbolRouter(EventLoopPool& pool, const PlacementConfig& config = PlacementConfig());
+
+    // Places a symbol on the least loaded loop; no-op for known symbols. Returns its loop.
+    size_t assign(const std::string& symbol);
+    void remove(const std::string& symbol);
+    // Unknown symbols are assigned on first use. A template so the callable is wrapped
+    // once, straight into the loop's inline Task storage.
+    template<typename F>
+    void route(const std::string& symbol, F&& task);
+
+    size_t loop_of(const std::string& symbol) const;
+    bool is_migrating(const std::string& symbol) const;
+    // Starts a handoff; false if the symbol is unknown, already there or already moving
+    bool migrate(const std::string& symbol, size_t target_loop);
+
+    // Samples loads if sample_interval passed, then migrates symbols off the busiest loop
+    // while it exceeds the idlest by more than imbalance_threshold. Returns migrations started.
+    size_t rebalance();
+    // Busiest minus idlest loop utilization from the last sample
+    double imbalance() const;
+    bool is_imbalanced() const { return imbalance() > config_.imbalance_threshold; }
+    std::vector<LoopLoad> loop_loads() const;
+    std::vector<SymbolLoad> symbol_loads() const;
+    uint64_t migrations() const { return migrations_.load(std::memory_order_relaxed); }
+
+private:
+    struct SymbolState {
+        std::atomic<size_t> loop{0};
+        std::atomic<uint64_t> messages{0};
+        std::atomic<uint64_t> busy_ns{0};
+        std::mutex mutex;       // orders route() against a handoff
+        bool migrating = false;
+        std::vector<Task> held;
+        // Sampling, under sample_mutex_
+        uint64_t sampled_messages = 0;
+        uint64_t sampled_busy_ns = 0;
+        double message_rate = 0.0;
+        double utilization = 0.0;
+    };
+
+    EventLoopPool& pool_;
+    PlacementConfig config_;
+    std::unordered_map<std::string, std::shared_ptr<SymbolState>> symbols_;
+    mutable std::shared_mutex symbols_mutex_;
+
+    mutable std::mutex sample_mutex_;
+    std::chrono::steady_clock::time_point last_sample_;
+    std::vector<uint64_t> sampled_loop_busy_ns_;
+    std::vector<LoopLoad> loop_loads_;
+    std::atomic<uint64_t> migrations_{0};
+
+    std::shared_ptr<SymbolState> find(const std::string& symbol) const;
+    std::shared_ptr<SymbolState> find_or_assign(const std::string& symbol);
+    template<typename F>
+    void post_to(size_t loop, const std::shared_ptr<SymbolState>& state, F&& task);
+    void sample(std::chrono::steady_clock::time_point now);
+};
+
+template<typename F>
+void SymbolRouter::route(const std::string& symbol, F&& task) {
+    auto state = find_or_assign(symbol);
+    if (!state) {
+        return;
+    }
+    state->messages.fetch_add(1, std::memory_order_relaxed);
+
+    // Posting under the symbol lock orders this task against a concurrent handoff fence
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->migrating) {
+        state->held.emplace_back(std::forward<F>(task));
+        return;
+    }
+    post_to(state->loop.load(std::memory_order_relaxed), state, std::forward<F>(task));
+}
+
+template<typename F>
+void SymbolRouter::post_to(size_t loop, const std::shared_ptr<SymbolState>& state, F&& task) {
+    pool_.get_event_loop(loop).post([state, task = std::forward<F>(task)]() mutable {
+        auto start = std::chrono::steady_clock::now();
+        task();
+        auto spent = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        state->busy_ns.fetch_add(spent.count(), std::memory_order_relaxed);
+    }, EventLoop::Priority::High);
+}
@@ -0,0 +1,194 @@
+#include "SyntheticMarket.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+constexpr double MID_MOVE_PROBABILITY = 0.1;  // per diff
+constexpr double DELETE_PROBABILITY = 0.15;   // per changed level
+constexpr size_t ACTIVE_LEVELS = 10;          // diffs touch the top of the book
+
+std::string lower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+std::string upper(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::toupper(c); });
+    return text;
+}
+
+}  // namespace
+
+SyntheticMarket::SyntheticMarket(const SyntheticConfig& config)
+    : config_(config), rng_(config.seed), owed_(config.symbols.size(), 0.0) {
+    if (config_.symbols.empty() || config_.depth == 0 || !(config_.tick_size > 0.0)) {
+        throw std::invalid_argument("SyntheticMarket needs symbols, a depth and a positive tick size");
+    }
+    decimals_ = std::max(0, static_cast<int>(std::lround(-std::log10(config_.tick_size))));
+    const int64_t mid = std::llround(config_.start_price / config_.tick_size);
+    for (const auto& symbol : config_.symbols) {
+        symbols_.push_back(lower(symbol));
+        Book book;
+        for (size_t i = 1; i <= config_.depth; ++i) {
+            book.bids[mid - static_cast<int64_t>(i)] = quantity();
+            book.asks[mid + static_cast<int64_t>(i)] = quantity();
+        }
+        books_.push_back(std::move(book));
+    }
+}
+
+int SyntheticMarket::find(const std::string& symbol) const {
+    auto it = std::find(symbols_.begin(), symbols_.end(), lower(symbol));
+    return it == symbols_.end() ? -1 : static_cast<int>(it - symbols_.begin());
+}
+
+double SyntheticMarket::quantity() {
+    return static_cast<double>(1 + rng_() % 10000) / 1000.0;
+}
+
+std::vector<std::pair<size_t, std::string>> SyntheticMarket::tick(int64_t now_ns) {
+    std::vector<std::pair<size_t, std::string>> events;
+    if (last_tick_ns_ < 0) {
+        last_tick_ns_ = now_ns;
+        return events;
+    }
+    double elapsed = std::min(static_cast<double>(now_ns - last_tick_ns_) / 1e9, 1.0);
+    last_tick_ns_ = now_ns;
+    if (elapsed <= 0.0) {
+        return events;
+    }
+    const int64_t now_ms = now_ns / 1000000;
+
+    auto emit = [&](size_t symbol, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            std::string event = next_diff(symbol, now_ms);
+            if (!event.empty()) {
+                events.emplace_back(symbol, std::move(event));
+            }
+        }
+    };
+    for (size_t symbol = 0; symbol < books_.size(); ++symbol) {
+        owed_[symbol] += config_.messages_per_second * elapsed;
+        auto due = static_cast<size_t>(owed_[symbol]);
+        owed_[symbol] -= static_cast<double>(due);
+        emit(symbol, due);
+    }
+    // Bursts arrive as a Poisson process, each on one random symbol
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    if (config_.bursts_per_second > 0.0 && uniform(rng_) < 1.0 - std::exp(-config_.bursts_per_second * elapsed)) {
+        emit(rng_() % books_.size(), config_.burst_size);
+    }
+    return events;
+}
+
+std::string SyntheticMarket::next_diff(size_t symbol, int64_t event_time_ms) {
+    Book& book = books_.at(symbol);
+    Changes bids, asks;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    if (uniform(rng_) < MID_MOVE_PROBABILITY) {
+        move_mid(book, rng_() % 2 == 0, bids, asks);
+    }
+    for (size_t i = 0; i < config_.levels_per_update; ++i) {
+        bool bid = rng_() % 2 == 0;
+        size_t index = rng_() % std::min(config_.depth, ACTIVE_LEVELS);
+        bool remove = uniform(rng_) < DELETE_PROBABILITY;
+        auto change = [&](auto& side, int64_t direction, Changes& changes) {
+            auto level = std::next(side.begin(), static_cast<std::ptrdiff_t>(std::min(index, side.size() - 1)));
+            if (remove) {
+                changes[level->first] = 0.0;
+                side.erase(level);
+                refill(side, direction, changes);
+            } else {
+                level->second = quantity();
+                changes[level->first] = level->second;
+            }
+        };
+        if (bid) {
+            change(book.bids, -1, bids);
+        } else {
+            change(book.asks, 1, asks);
+        }
+    }
+
+    uint64_t first = book.last_update_id + 1;
+    book.last_update_id += 1 + rng_() % 3;
+    if (config_.gap_probability > 0.0 && uniform(rng_) < config_.gap_probability) {
+        ++gaps_;
+        return std::string();
+    }
+    return "{\"e\":\"depthUpdate\",\"E\":" + std::to_string(event_time_ms) + ",\"s\":\"" + upper(symbols_[symbol]) +
+           "\",\"U\":" + std::to_string(first) + ",\"u\":" + std::to_string(book.last_update_id) +
+           ",\"b\":" + format_levels(bids) + ",\"a\":" + format_levels(asks) + "}";
+}
+
+// Up: the best ask is taken out and its price becomes the best bid; down mirrors it
+void SyntheticMarket::move_mid(Book& book, bool up, Changes& bids, Changes& asks) {
+    if (up) {
+        auto best_ask = book.asks.begin();
+        int64_t price = best_ask->first;
+        asks[price] = 0.0;
+        book.asks.erase(best_ask);
+        bids[price] = book.bids[price] = quantity();
+    } else {
+        auto best_bid = book.bids.begin();
+        int64_t price = best_bid->first;
+        bids[price] = 0.0;
+        book.bids.erase(best_bid);
+        asks[price] = book.asks[price] = quantity();
+    }
+    refill(book.bids, -1, bids);
+    refill(book.asks, 1, asks);
+}
+
+// Brings a side back to `depth` levels: new levels one tick beyond the far end, or the
+// far end dropped
+template<typename Side>
+void SyntheticMarket::refill(Side& side, int64_t direction, Changes& changes) {
+    while (side.size() > config_.depth) {
+        auto last = std::prev(side.end());
+        changes[last->first] = 0.0;
+        side.erase(last);
+    }
+    while (side.size() < config_.depth) {
+        int64_t price = std::prev(side.end())->first + direction;
+        changes[price] = side[price] = quantity();
+    }
+}
+
+std::string SyntheticMarket::format_price(int64_t ticks) const {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.*f", decimals_, static_cast<double>(ticks) * config_.tick_size);
+    return buffer;
+}
+
+std::string SyntheticMarket::format_levels(const Changes& changes) const {
+    std::string out = "[";
+    char quantity[32];
+    for (const auto& [price, qty] : changes) {
+        std::snprintf(quantity, sizeof(quantity), "%.8f", qty);
+        out += (out.size() > 1 ? ",[\"" : "[\"") + format_price(price) + "\",\"" + quantity + "\"]";
+    }
+    return out + "]";
+}
+
+std::string SyntheticMarket::snapshot(size_t symbol, size_t limit) const {
+    const Book& book = books_.at(symbol);
+    auto side = [this, limit](const auto& levels) {
+        std::string out = "[";
+        char quantity[32];
+        size_t n = 0;
+        for (auto it = levels.begin(); it != levels.end() && n < limit; ++it, ++n) {
+            std::snprintf(quantity, sizeof(quantity), "%.8f", it->second);
+            out += (n ? ",[\"" : "[\"") + format_price(it->first) + "\",\"" + quantity + "\"]";
+        }
+        return out + "]";
+    };
+    return "{\"lastUpdateId\":" + std::to_string(book.last_update_id) + ",\"bids\":" + side(book.bids) +
+           ",\"asks\":" + side(book.asks) + "}";
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct SyntheticConfig {
+    std::vector<std::string> symbols = {"btcusdt"};
+    size_t depth = 100;                // levels per side every book keeps
+    size_t levels_per_update = 5;      // levels changed by one diff
+    double messages_per_second = 100;  // per symbol, outside bursts
+    double bursts_per_second = 0.0;    // on average, across all symbols
+    size_t burst_size = 100;           // extra diffs sent back to back for one symbol
+    double gap_probability = 0.0;      // chance a diff is applied but not sent, leaving a hole in the update IDs
+    double start_price = 100.0;
+    double tick_size = 0.01;
+    uint64_t seed = 1;
+};
+
+// Deterministic synthetic depth books that emit Binance depthUpdate events. Each book
+// keeps `depth` levels per side around a randomly walking mid price; every level change,
+// including levels dropping off the far end, is in some diff, so a client that applies
+// a snapshot and the diffs after it has the same book as snapshot() returns. Diffs cover
+// one to three update IDs, like the exchange's. A gapped diff changes the book and uses
+// its IDs but is never returned, which forces a resync from the next snapshot.
+//
+// Not thread safe; LocalExchange drives it from its one thread.
+class SyntheticMarket {
+public:
+    explicit SyntheticMarket(const SyntheticConfig& config);
+
+    const std::vector<std::string>& symbols() const { return symbols_; }
+    // Index into symbols() for a symbol in any case, -1 if unknown
+    int find(const std::string& symbol) const;
+
+    // The diffs due since the previous call at the configured rate and burstiness, as
+    // (symbol index, event) pairs. The first call only starts the clock; catch-up after
+    // a stall is limited to one second of traffic.
+    std::vector<std::pair<size_t, std::string>> tick(int64_t now_ns);
+    // Moves one book on and returns its depthUpdate event, empty if the diff was gapped
+    std::string next_diff(size_t symbol, int64_t event_time_ms);
+
+    // /api/v3/depth response body for the book's current state
+    std::string snapshot(size_t symbol, size_t limit) const;
+    uint64_t last_update_id(size_t symbol) const { return books_.at(symbol).last_update_id; }
+    uint64_t gaps() const { return gaps_; }
+
+private:
+    // Prices are whole ticks, so levels compare exactly
+    struct Book {
+        std::map<int64_t, double, std::greater<int64_t>> bids;
+        std::map<int64_t, double> asks;
+        uint64_t last_update_id = 1000;
+    };
+    using Changes = std::map<int64_t, double>;  // one entry per price, quantity 0 removes
+
+    SyntheticConfig config_;
+    std::vector<std::string> symbols_;
+    std::vector<Book> books_;
+    std::mt19937_64 rng_;
+    int decimals_;
+    int64_t last_tick_ns_ = -1;
+    std::vector<double> owed_;  // fractional diffs carried to the next tick, per symbol
+    uint64_t gaps_ = 0;
+
+    double quantity();
+    void move_mid(Book& book, bool up, Changes& bids, Changes& asks);
+    template<typename Side>
+    void refill(Side& side, int64_t direction, Changes& changes);
+    std::string format_levels(const Changes& changes) const;
+    std::string format_price(int64_t ticks) const;
+};
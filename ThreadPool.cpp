@@ -1,50 +1,173 @@
 #include "ThreadPool.h"
+#include "CpuTopology.h"
 
-ThreadPool::ThreadPool(size_t num_threads)
-    : stop_(false)
+namespace {
+
+// Which pool and deque the calling thread works for, if any
+thread_local const void* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+}  // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(size_t num_threads)
 {
+    if (num_threads == 0)
+        throw std::runtime_error("WorkStealingThreadPool needs at least one thread");
     for(size_t i = 0; i < num_threads; ++i)
-    {
-        workers_.emplace_back(
-            [this]
+        queues.push_back(std::make_unique<Worker>());
+    for(size_t i = 0; i < num_threads; ++i)
+        workers.emplace_back(
+            [this, i]
             {
-                for(;;)
-                {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(this->queue_mutex_);
-                        this->condition_.wait(lock,
-                            [this]{ return this->stop_ || !this->tasks_.empty(); });
-                        if(this->stop_ && this->tasks_.empty())
-                            return;
-                        task = std::move(this->tasks_.front());
-                        this->tasks_.pop();
-                    }
-                    task();
-                }
+                worker_thread(i);
             }
         );
-    }
 }
 
-ThreadPool::~ThreadPool()
+WorkStealingThreadPool::~WorkStealingThreadPool()
 {
+    shutdown();
+}
+
+void WorkStealingThreadPool::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(inject_mutex);
+        stop = true;
+    }
     {
-        std::unique_lock<std::mutex> lock(queue_mutex_);
-        stop_ = true;
+        std::lock_guard<std::mutex> lock(park_mutex);
     }
-    condition_.notify_all();
-    for(std::thread &worker: workers_)
-        worker.join();
+    park_cv.notify_all();
+    for(std::thread &worker: workers)
+        if(worker.joinable())
+            worker.join();
 }
 
-void ThreadPool::enqueue(std::function<void()> task)
+void WorkStealingThreadPool::set_affinity(const std::vector<int>& cpus)
 {
+    for(std::thread &worker: workers)
+        pin_thread(worker, cpus);
+}
+
+void WorkStealingThreadPool::submit(Task* task)
+{
+    if (current_pool == this) {
+        // Forked from one of our tasks: keep it local, thieves take it if we fall behind
+        queues[current_worker]->deque.push(task);
+    } else {
+        std::lock_guard<std::mutex> lock(inject_mutex);
+        if (stop) {
+            delete task;
+            throw std::runtime_error("enqueue on stopped WorkStealingThreadPool");
+        }
+        injected.push_back(task);
+    }
+
+    // Pairs with park(): either the worker sees the new epoch or we see it asleep
+    epoch.fetch_add(1, std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_seq_cst) > 0) {
+        {
+            std::lock_guard<std::mutex> lock(park_mutex);
+        }
+        park_cv.notify_one();
+    }
+}
+
+void WorkStealingThreadPool::worker_thread(size_t id)
+{
+    current_pool = this;
+    current_worker = id;
+    std::minstd_rand rng(static_cast<unsigned>(id) + 1);
+
+    for(;;)
     {
-        std::unique_lock<std::mutex> lock(queue_mutex_);
-        if(stop_)
-            throw std::runtime_error("enqueue on stopped ThreadPool");
-        tasks_.emplace(std::move(task));
+        uint64_t seen_epoch = epoch.load(std::memory_order_seq_cst);
+        // stop is set under inject_mutex, so once it is seen here the scan below sees every
+        // accepted task; tasks forked later land in a running worker's deque and it runs them
+        bool stopping = stop;
+        if (Task* task = find_task(id, rng)) {
+            run_task(task);
+            continue;
+        }
+        if (stopping)
+            return;
+        park(seen_epoch);
     }
-    condition_.notify_one();
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::find_task(size_t id, std::minstd_rand& rng)
+{
+    Task* task = nullptr;
+    if (pop_task_from_local_queue(task, id) || pop_task_from_other_queue(task, id, rng))
+        return task;
+    return nullptr;
+}
+
+bool WorkStealingThreadPool::pop_task_from_local_queue(Task*& task, size_t id)
+{
+    if (queues[id]->deque.take(task))
+        return true;
+    std::lock_guard<std::mutex> lock(inject_mutex);
+    if (injected.empty())
+        return false;
+    task = injected.front();
+    injected.pop_front();
+    return true;
+}
+
+bool WorkStealingThreadPool::pop_task_from_other_queue(Task*& task, size_t id, std::minstd_rand& rng)
+{
+    // Random starting victim so thieves spread out instead of all hitting worker 0
+    size_t count = queues.size();
+    size_t start = rng() % count;
+    for (size_t i = 0; i < count; ++i) {
+        size_t victim = (start + i) % count;
+        if (victim != id && queues[victim]->deque.steal(task)) {
+            steal_count.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkStealingThreadPool::run_one()
+{
+    Task* task = nullptr;
+    if (current_pool == this) {
+        thread_local std::minstd_rand rng(std::random_device{}());
+        task = find_task(current_worker, rng);
+    } else {
+        // Outside threads have no deque of their own but can still help
+        std::minstd_rand rng(static_cast<unsigned>(epoch.load(std::memory_order_relaxed)));
+        {
+            std::lock_guard<std::mutex> lock(inject_mutex);
+            if (!injected.empty()) {
+                task = injected.front();
+                injected.pop_front();
+            }
+        }
+        if (!task)
+            pop_task_from_other_queue(task, queues.size(), rng);
+    }
+    if (!task)
+        return false;
+    run_task(task);
+    return true;
+}
+
+void WorkStealingThreadPool::park(uint64_t seen_epoch)
+{
+    std::unique_lock<std::mutex> lock(park_mutex);
+    sleepers.fetch_add(1, std::memory_order_seq_cst);
+    park_cv.wait(lock, [this, seen_epoch] {
+        return stop || epoch.load(std::memory_order_seq_cst) != seen_epoch;
+    });
+    sleepers.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void WorkStealingThreadPool::run_task(Task* task)
+{
+    std::unique_ptr<Task> owned(task);
+    owned->run();
 }
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <vector>
-#include <queue>
+#include <deque>
 #include <memory>
 #include <thread>
 #include <mutex>
@@ -11,67 +11,112 @@
 #include <stdexcept>
 #include <atomic>
 #include <random>
-#include "LockFreeQueue.h"
+#include <tuple>
+#include <type_traits>
+#include "ChaseLevDeque.h"
 
+// Work-stealing pool for side work that must stay off the feed threads: reports,
+// checkpoints, analytics fan-out. Each worker owns a Chase-Lev deque; tasks enqueued
+// by a worker go to its own deque, tasks from other threads go to a shared injection
+// queue. Idle workers steal from random victims, then park on a condition variable.
 class WorkStealingThreadPool {
 public:
-    WorkStealingThreadPool(size_t num_threads);
-    template<class F, class... Args>
-    auto enqueue(F&& f, Args&&... args) 
-        -> std::future<typename std::result_of<F(Args...)>::type>;
+    explicit WorkStealingThreadPool(size_t num_threads);
     ~WorkStealingThreadPool();
 
+    WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+    WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+    // Throws std::runtime_error after shutdown()
+    template<class F, class... Args>
+    auto enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>;
+
+    // Waits for a result while running queued tasks, so a task can wait on tasks it
+    // forked without tying up its worker
+    template<class R>
+    R wait(std::future<R>& future);
+
+    // Runs everything already queued, then joins the workers
+    void shutdown();
+    void set_affinity(const std::vector<int>& cpus);
+
+    size_t size() const { return workers.size(); }
+    uint64_t steals() const { return steal_count.load(std::memory_order_relaxed); }
+
 private:
+    struct Task {
+        virtual ~Task() = default;
+        virtual void run() = 0;
+    };
+
+    template<class F, class R>
+    struct PromiseTask : Task {
+        F fn;
+        std::promise<R> promise;
+        explicit PromiseTask(F&& f) : fn(std::move(f)) {}
+        void run() override {
+            try {
+                if constexpr (std::is_void_v<R>) {
+                    fn();
+                    promise.set_value();
+                } else {
+                    promise.set_value(fn());
+                }
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }
+    };
+
+    struct alignas(64) Worker {
+        ChaseLevDeque<Task*> deque;
+    };
+
+    std::vector<std::unique_ptr<Worker>> queues;
     std::vector<std::thread> workers;
-    std::vector<LockFreeQueue<std::function<void()>>> queues;
-    std::atomic<bool> stop;
-    std::atomic<size_t> index;
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> steal_count{0};
+
+    std::mutex inject_mutex;
+    std::deque<Task*> injected;
+
+    // Parking: submit() bumps the epoch; a worker sleeps only while it is unchanged
+    std::mutex park_mutex;
+    std::condition_variable park_cv;
+    std::atomic<uint64_t> epoch{0};
+    std::atomic<size_t> sleepers{0};
 
     void worker_thread(size_t id);
-    bool pop_task_from_local_queue(std::function<void()>& task, size_t id);
-    bool pop_task_from_other_queue(std::function<void()>& task, size_t id);
+    void submit(Task* task);
+    Task* find_task(size_t id, std::minstd_rand& rng);
+    bool pop_task_from_local_queue(Task*& task, size_t id);
+    bool pop_task_from_other_queue(Task*& task, size_t id, std::minstd_rand& rng);
+    bool run_one();
+    void park(uint64_t seen_epoch);
+    static void run_task(Task* task);
 };
 
-// the constructor just launches some amount of workers
-inline WorkStealingThreadPool::WorkStealingThreadPool(size_t num_threads)
-    :   stop(false)
-{
-    for(size_t i = 0;i<num_threads;++i)
-        workers.emplace_back(
-            [this, i]
-            {
-                worker_thread(i);
-            }
-        );
-}
-
-// Implementation of enqueue function
 template<class F, class... Args>
-auto WorkStealingThreadPool::enqueue(F&& f, Args&&... args) 
-    -> std::future<typename std::result_of<F(Args...)>::type>
+auto WorkStealingThreadPool::enqueue(F&& f, Args&&... args)
+    -> std::future<std::invoke_result_t<F, Args...>>
 {
-    using return_type = typename std::result_of<F(Args...)>::type;
-
-    auto task = std::make_shared< std::packaged_task<return_type()> >(
-        std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-    );
-        
-    std::future<return_type> res = task->get_future();
-    
-    size_t i = index++;
-    queues[i % queues.size()].push([task](){ (*task)(); });
-    
-    return res;
+    using return_type = std::invoke_result_t<F, Args...>;
+    auto fn = [f = std::forward<F>(f), args = std::make_tuple(std::forward<Args>(args)...)]() mutable -> return_type {
+        return std::apply(std::move(f), std::move(args));
+    };
+    auto* task = new PromiseTask<decltype(fn), return_type>(std::move(fn));
+    std::future<return_type> result = task->promise.get_future();
+    submit(task);
+    return result;
 }
 
-// the destructor joins all threads
-inline WorkStealingThreadPool::~WorkStealingThreadPool()
+template<class R>
+R WorkStealingThreadPool::wait(std::future<R>& future)
 {
-    {
-        std::unique_lock<std::mutex> lock(queue_mutexes[0]);
-        stop = true;
+    while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        if (!run_one()) {
+            std::this_thread::yield();
+        }
     }
-    condition_vars[0].notify_all();
-    for(std::thread &worker: workers)
-        worker.join();
+    return future.get();
 }
@@ -0,0 +1,125 @@
+#include "TradeStatistics.h"
+#include <algorithm>
+#include <stdexcept>
+
+RollingWindow::RollingWindow(int64_t bucket_ms, size_t buckets)
+    : bucket_ms_(bucket_ms), size_(static_cast<int64_t>(buckets)), ring_(buckets) {
+    if (bucket_ms <= 0 || buckets == 0) {
+        throw std::invalid_argument("RollingWindow needs a positive bucket width and count");
+    }
+}
+
+void RollingWindow::move_to(int64_t index) {
+    if (head_ == INT64_MIN || index - head_ >= size_) {
+        // Everything falls out at once
+        std::fill(ring_.begin(), ring_.end(), Bucket());
+        volume_ = quote_volume_ = 0.0;
+        trades_ = 0;
+        head_ = index;
+        oldest_ = index + 1;
+        return;
+    }
+    while (head_ < index) {
+        ++head_;
+        Bucket& evicted = bucket(head_);  // the slot held head_ - size_
+        volume_ -= evicted.volume;
+        quote_volume_ -= evicted.quote_volume;
+        trades_ -= evicted.trades;
+        evicted = Bucket();
+    }
+    if (trades_ == 0) {
+        // Clear what the subtractions left in rounding
+        volume_ = quote_volume_ = 0.0;
+        oldest_ = head_ + 1;
+        return;
+    }
+    // Each bucket is stepped over once per pass of the window, so this is O(1) amortized
+    oldest_ = std::max(oldest_, head_ - size_ + 1);
+    while (bucket(oldest_).trades == 0) {
+        ++oldest_;
+    }
+}
+
+void RollingWindow::add(int64_t time_ms, double price, double quantity) {
+    int64_t index = time_ms / bucket_ms_;
+    if (index > head_) {
+        move_to(index);
+    } else if (index <= head_ - size_) {
+        return;
+    }
+    Bucket& target = bucket(index);
+    if (target.trades == 0 || time_ms < target.first_time_ms) {
+        target.open = price;
+        target.first_time_ms = time_ms;
+    }
+    target.volume += quantity;
+    target.quote_volume += price * quantity;
+    ++target.trades;
+    volume_ += quantity;
+    quote_volume_ += price * quantity;
+    ++trades_;
+    oldest_ = std::min(oldest_, index);
+}
+
+void RollingWindow::advance(int64_t now_ms) {
+    int64_t index = now_ms / bucket_ms_;
+    if (head_ != INT64_MIN && index > head_) {
+        move_to(index);
+    }
+}
+
+WindowStats RollingWindow::stats(double last_price) const {
+    WindowStats stats;
+    if (trades_ == 0) {
+        return stats;
+    }
+    stats.volume = volume_;
+    stats.quote_volume = quote_volume_;
+    stats.trades = trades_;
+    stats.vwap = volume_ > 0.0 ? quote_volume_ / volume_ : 0.0;
+    double open = bucket(oldest_).open;
+    stats.price_change = last_price - open;
+    stats.price_change_percent = open != 0.0 ? stats.price_change / open * 100.0 : 0.0;
+    return stats;
+}
+
+bool TradeStatistics::on_trade(const std::string& symbol, uint64_t trade_id, double price, double quantity,
+                               int64_t trade_time_ms) {
+    tbb::concurrent_hash_map<std::string, std::unique_ptr<Symbol>>::accessor acc;
+    if (symbols_.insert(acc, symbol)) {
+        acc->second = std::make_unique<Symbol>();
+    }
+    Symbol& stats = *acc->second;
+    if (stats.has_trade && trade_id <= stats.last_trade_id) {
+        return false;  // replayed after a reconnect
+    }
+    stats.has_trade = true;
+    stats.last_trade_id = trade_id;
+    stats.last_price = price;
+    stats.last_trade_ms = trade_time_ms;
+    stats.second.add(trade_time_ms, price, quantity);
+    stats.minute.add(trade_time_ms, price, quantity);
+    stats.day.add(trade_time_ms, price, quantity);
+    return true;
+}
+
+TradingStats TradeStatistics::get(const std::string& symbol, int64_t now_ms) {
+    tbb::concurrent_hash_map<std::string, std::unique_ptr<Symbol>>::accessor acc;
+    if (!symbols_.find(acc, symbol)) {
+        return TradingStats();
+    }
+    Symbol& stats = *acc->second;
+    stats.second.advance(now_ms);
+    stats.minute.advance(now_ms);
+    stats.day.advance(now_ms);
+
+    TradingStats result;
+    result.last_price = stats.last_price;
+    result.last_trade_ms = stats.last_trade_ms;
+    result.second = stats.second.stats(stats.last_price);
+    result.minute = stats.minute.stats(stats.last_price);
+    result.day = stats.day.stats(stats.last_price);
+    result.volume = result.day.volume;
+    result.price_change = result.day.price_change;
+    return result;
+}
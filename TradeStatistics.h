@@ -0,0 +1,91 @@
+#pragma once
+
+#include <tbb/concurrent_hash_map.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Totals over one rolling window
+struct WindowStats {
+    double volume = 0.0;        // base asset
+    double quote_volume = 0.0;  // sum of price * quantity
+    double vwap = 0.0;          // 0 without trades
+    double price_change = 0.0;  // last price - first price in the window
+    double price_change_percent = 0.0;
+    uint64_t trades = 0;
+};
+
+struct TradingStats {
+    double volume = 0.0;        // 24h, as day.volume
+    double price_change = 0.0;  // 24h, as day.price_change
+    double last_price = 0.0;
+    int64_t last_trade_ms = 0;  // exchange trade time, 0 before the first trade
+    WindowStats second;
+    WindowStats minute;
+    WindowStats day;
+};
+
+// Trade totals over a window of `buckets` ring-buffered buckets of bucket_ms each. A trade
+// adds to the bucket of its time and to running totals; moving to a new bucket subtracts
+// the bucket that falls out, so recording is O(1) amortized and reading is O(1). The
+// window is whole buckets, so it spans between (buckets - 1) and buckets times bucket_ms.
+class RollingWindow {
+public:
+    RollingWindow(int64_t bucket_ms, size_t buckets);
+
+    // Trades older than the window are ignored
+    void add(int64_t time_ms, double price, double quantity);
+    // Drops what is older than the window as of now_ms; never moves back
+    void advance(int64_t now_ms);
+    WindowStats stats(double last_price) const;
+
+private:
+    struct Bucket {
+        double volume = 0.0;
+        double quote_volume = 0.0;
+        uint64_t trades = 0;
+        double open = 0.0;          // first trade's price
+        int64_t first_time_ms = 0;  // to keep `open` the earliest if trades arrive late
+    };
+
+    int64_t bucket_ms_;
+    int64_t size_;
+    std::vector<Bucket> ring_;
+    int64_t head_ = INT64_MIN;  // newest bucket index (time / bucket_ms)
+    int64_t oldest_ = 0;        // oldest bucket in the window with trades, head_ + 1 when none
+    double volume_ = 0.0;
+    double quote_volume_ = 0.0;
+    uint64_t trades_ = 0;
+
+    Bucket& bucket(int64_t index) { return ring_[static_cast<size_t>(index % size_)]; }
+    const Bucket& bucket(int64_t index) const { return ring_[static_cast<size_t>(index % size_)]; }
+    void move_to(int64_t index);
+};
+
+// Rolling 1s, 1m and 24h statistics per symbol from the trade or aggTrade stream.
+// Windows run on the exchange's trade time. Each symbol's entry is locked only while one
+// trade is recorded or read, so trades of different symbols never contend.
+class TradeStatistics {
+public:
+    // trade_id is the stream's trade or aggregate trade ID; an ID not above the symbol's
+    // last one is a duplicate and dropped. False for a dropped trade.
+    bool on_trade(const std::string& symbol, uint64_t trade_id, double price, double quantity, int64_t trade_time_ms);
+
+    // As of now_ms, on the same clock as trade times; all zero for a symbol without trades
+    TradingStats get(const std::string& symbol, int64_t now_ms);
+    size_t symbol_count() const { return symbols_.size(); }
+
+private:
+    struct Symbol {
+        RollingWindow second{100, 10};
+        RollingWindow minute{1000, 60};
+        RollingWindow day{60 * 1000, 24 * 60};
+        uint64_t last_trade_id = 0;
+        bool has_trade = false;
+        double last_price = 0.0;
+        int64_t last_trade_ms = 0;
+    };
+
+    tbb::concurrent_hash_map<std::string, std::unique_ptr<Symbol>> symbols_;
+};
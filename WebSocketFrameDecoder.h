@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+// Minimal RFC 6455 framing for transports that bypass websocketpp. Decodes the
+// unmasked frames a server sends and encodes masked client frames.
+class WebSocketFrameDecoder {
+public:
+    enum class Opcode : uint8_t {
+        Continuation = 0x0,
+        Text = 0x1,
+        Binary = 0x2,
+        Close = 0x8,
+        Ping = 0x9,
+        Pong = 0xA
+    };
+
+    // Feeds raw stream bytes; on_frame(Opcode, std::string&&) is called for every complete
+    // message (fragments are reassembled, control frames are delivered as they arrive).
+    // Returns false on a protocol error.
+    template <typename Handler>
+    bool feed(const char* data, size_t len, Handler&& on_frame) {
+        if (pending_.empty()) {
+            size_t consumed = 0;
+            if (!decode(data, len, consumed, on_frame)) return false;
+            pending_.assign(data + consumed, len - consumed);
+            return true;
+        }
+        pending_.append(data, len);
+        size_t consumed = 0;
+        if (!decode(pending_.data(), pending_.size(), consumed, on_frame)) return false;
+        pending_.erase(0, consumed);
+        return true;
+    }
+
+    static std::string encode_client_frame(Opcode opcode, const std::string& payload, uint32_t mask_key) {
+        std::string frame;
+        frame.reserve(payload.size() + 14);
+        frame.push_back(static_cast<char>(0x80 | static_cast<uint8_t>(opcode)));
+
+        uint64_t len = payload.size();
+        if (len < 126) {
+            frame.push_back(static_cast<char>(0x80 | len));
+        } else if (len <= 0xFFFF) {
+            frame.push_back(static_cast<char>(0x80 | 126));
+            frame.push_back(static_cast<char>((len >> 8) & 0xFF));
+            frame.push_back(static_cast<char>(len & 0xFF));
+        } else {
+            frame.push_back(static_cast<char>(0x80 | 127));
+            for (int shift = 56; shift >= 0; shift -= 8) {
+                frame.push_back(static_cast<char>((len >> shift) & 0xFF));
+            }
+        }
+
+        char mask[4] = {
+            static_cast<char>((mask_key >> 24) & 0xFF), static_cast<char>((mask_key >> 16) & 0xFF),
+            static_cast<char>((mask_key >> 8) & 0xFF), static_cast<char>(mask_key & 0xFF)};
+        frame.append(mask, 4);
+        for (size_t i = 0; i < payload.size(); ++i) {
+            frame.push_back(static_cast<char>(payload[i] ^ mask[i & 3]));
+        }
+        return frame;
+    }
+
+    // Server side framing, used by local feeders and tests
+    static std::string encode_server_frame(Opcode opcode, const std::string& payload) {
+        std::string frame;
+        frame.reserve(payload.size() + 10);
+        frame.push_back(static_cast<char>(0x80 | static_cast<uint8_t>(opcode)));
+        uint64_t len = payload.size();
+        if (len < 126) {
+            frame.push_back(static_cast<char>(len));
+        } else if (len <= 0xFFFF) {
+            frame.push_back(static_cast<char>(126));
+            frame.push_back(static_cast<char>((len >> 8) & 0xFF));
+            frame.push_back(static_cast<char>(len & 0xFF));
+        } else {
+            frame.push_back(static_cast<char>(127));
+            for (int shift = 56; shift >= 0; shift -= 8) {
+                frame.push_back(static_cast<char>((len >> shift) & 0xFF));
+            }
+        }
+        frame.append(payload);
+        return frame;
+    }
+
+private:
+    std::string pending_;
+    std::string fragments_;
+    Opcode fragment_opcode_ = Opcode::Text;
+
+    template <typename Handler>
+    bool decode(const char* data, size_t len, size_t& consumed, Handler& on_frame) {
+        const auto* p = reinterpret_cast<const uint8_t*>(data);
+        while (len - consumed >= 2) {
+            const uint8_t* frame = p + consumed;
+            size_t available = len - consumed;
+
+            bool fin = (frame[0] & 0x80) != 0;
+            auto opcode = static_cast<Opcode>(frame[0] & 0x0F);
+            bool masked = (frame[1] & 0x80) != 0;
+            uint64_t payload_len = frame[1] & 0x7F;
+            size_t header_len = 2;
+
+            if (payload_len == 126) {
+                if (available < 4) return true;
+                payload_len = (static_cast<uint64_t>(frame[2]) << 8) | frame[3];
+                header_len = 4;
+            } else if (payload_len == 127) {
+                if (available < 10) return true;
+                payload_len = 0;
+                for (int i = 0; i < 8; ++i) {
+                    payload_len = (payload_len << 8) | frame[2 + i];
+                }
+                header_len = 10;
+            }
+            if (masked) header_len += 4;
+            if (available < header_len || available - header_len < payload_len) return true;
+
+            std::string payload(reinterpret_cast<const char*>(frame + header_len), payload_len);
+            if (masked) {
+                const uint8_t* mask = frame + header_len - 4;
+                for (size_t i = 0; i < payload.size(); ++i) {
+                    payload[i] = static_cast<char>(payload[i] ^ mask[i & 3]);
+                }
+            }
+            consumed += header_len + payload_len;
+
+            if (static_cast<uint8_t>(opcode) >= 0x8) {
+                if (!fin) return false;  // control frames must not be fragmented
+                on_frame(opcode, std::move(payload));
+            } else if (opcode == Opcode::Continuation) {
+                fragments_.append(payload);
+                if (fin) {
+                    on_frame(fragment_opcode_, std::move(fragments_));
+                    fragments_.clear();
+                }
+            } else if (fin) {
+                on_frame(opcode, std::move(payload));
+            } else {
+                fragment_opcode_ = opcode;
+                fragments_ = std::move(payload);
+            }
+        }
+        return true;
+    }
+};
@@ -1,4 +1,7 @@
 #include "WebSocketHandler.h"
+#ifdef __linux__
+#include "IoUringTransport.h"
+#endif
 #include <iostream>
 #include <boost/beast.hpp>
 #include <boost/beast/ssl.hpp>
@@ -7,12 +10,18 @@
 #include <boost/beast/websocket.hpp>
 #include <boost/beast/websocket/ssl.hpp>
 #include <boost/asio/strand.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
 #include <boost/asio/ssl/error.hpp>
 #include <boost/asio/ssl/stream.hpp>
 #include <boost/asio/connect.hpp>
 #include <boost/asio/detail/socket_option.hpp>
 #include <boost/asio/socket_base.hpp>
 #include <chrono>
+#include <cstdlib>
+#include <algorithm>
 #include <websocketpp/config/asio_client.hpp>
 #include <websocketpp/client.hpp>
 #include <boost/container/flat_set.hpp>
@@ -26,7 +35,19 @@ namespace net = boost::asio;
 using tcp = boost::asio::ip::tcp;
 
 WebSocketHandler::WebSocketHandler(net::io_context& ioc, const std::string& symbol, MessageProcessor& messageProcessor)
-    : io_context_(ioc), symbol_(symbol), message_processor_(messageProcessor), reconnect_timer_(ioc), is_connected_(false) {
+    : io_context_(ioc), symbol_(symbol), symbols_{symbol}, message_processor_(messageProcessor), reconnect_timer_(ioc), is_connected_(false) {
+    init_client();
+}
+
+WebSocketHandler::WebSocketHandler(net::io_context& ioc, const std::vector<std::string>& symbols, MessageProcessor& messageProcessor)
+    : io_context_(ioc), symbol_(symbols.size() == 1 ? symbols.front() : std::string()), symbols_(symbols),
+      message_processor_(messageProcessor), reconnect_timer_(ioc), is_connected_(false) {
+    init_client();
+}
+
+WebSocketHandler::~WebSocketHandler() = default;
+
+void WebSocketHandler::init_client() {
     client_.clear_access_channels(websocketpp::log::alevel::all);
     client_.set_access_channels(websocketpp::log::alevel::connect);
     client_.set_access_channels(websocketpp::log::alevel::disconnect);
@@ -38,21 +59,73 @@ WebSocketHandler::WebSocketHandler(net::io_context& ioc, const std::string& symb
     client_.set_open_handler(std::bind(&WebSocketHandler::on_connect, this, std::placeholders::_1));
     client_.set_close_handler(std::bind(&WebSocketHandler::handle_disconnect, this));
     client_.set_fail_handler(std::bind(&WebSocketHandler::on_fail, this, std::placeholders::_1));
+    client_.set_pong_handler(std::bind(&WebSocketHandler::on_pong, this, std::placeholders::_1, std::placeholders::_2));
 }
 
 void WebSocketHandler::connect() {
+    stopped_ = false;
+    // Connections are opened on the handler's loop, one attempt at a time; a failed or
+    // dropped one comes back through handle_disconnect and its backoff
+    if (connecting_.exchange(true)) {
+        return;
+    }
+    if (io_uring_) {
+        // The feed is created and used on the loop that polls its transport
+        net::post(io_context_, [self = shared_from_this()]() { self->connect_io_uring(); });
+        return;
+    }
+    net::post(io_context_, [self = shared_from_this()]() { self->connect_websocketpp(); });
+}
+
+void WebSocketHandler::connect_websocketpp() {
+    if (stopped_) {
+        connecting_ = false;
+        return;
+    }
     websocketpp::lib::error_code ec;
-    auto conn = client_.get_connection("wss://stream.binance.com:9443/ws/" + symbol_ + "@depth", ec);
+    auto conn = client_.get_connection(stream_url(), ec);
     if (ec) {
         std::cout << "Could not create connection: " << ec.message() << std::endl;
+        connecting_ = false;
+        handle_disconnect();
         return;
     }
 
     client_.connect(conn);
 }
 
+std::string WebSocketHandler::stream_url() const {
+    if (!symbol_.empty()) {
+        return stream_base_ + "/ws/" + stream_names(symbol_, "/");
+    }
+    std::string url = stream_base_ + "/stream?streams=";
+    for (size_t i = 0; i < symbols_.size(); ++i) {
+        if (i > 0) url += '/';
+        url += stream_names(symbols_[i], "/");
+    }
+    return url;
+}
+
+std::string WebSocketHandler::stream_names(const std::string& symbol, const char* separator) const {
+    std::string names = symbol + "@depth";
+    if (!trade_stream_.empty()) {
+        names += separator + symbol + "@" + trade_stream_;
+    }
+    return names;
+}
+
 void WebSocketHandler::stop() {
     is_connected_ = false;
+    stopped_ = true;
+    reconnect_timer_.cancel();
+    if (io_uring_) {
+        // Keeps the handler alive until its loop has closed the feed
+        net::post(io_context_, [self = shared_from_this()]() {
+            self->feed_.reset();  // an upgrade under way is dropped without calling back
+            self->connecting_ = false;
+        });
+        return;
+    }
     websocketpp::lib::error_code ec;
     client_.close(connection_, websocketpp::close::status::normal, "Stopping", ec);
     if (ec) {
@@ -81,37 +154,129 @@ void WebSocketHandler::set_cpu_affinity(int cpu_id) {
 
 void WebSocketHandler::on_message(websocketpp::connection_hdl hdl, websocketpp::config::asio_client::message_type::ptr msg) {
     (void)hdl;  // Suppress unused parameter warning
-    std::string payload = msg->get_payload();
-    message_processor_.add_message(true, std::move(payload));
+    deliver(std::string(msg->get_payload()));
+}
+
+void WebSocketHandler::deliver(std::string&& payload) {
+    int64_t receive_time_us = wall_clock_us();
+    if (capture_) {
+        capture_->append(CaptureSource::WebSocket, capture_connection_, capture_symbol_, receive_time_us * 1000, payload);
+    }
+
+    int64_t kernel_rx_ns = last_kernel_rx_ns_.exchange(-1, std::memory_order_relaxed);
+    if (kernel_rx_ns > 0 && receive_time_us >= kernel_rx_ns / 1000) {
+        // A peeked timestamp after the receive time belonged to a later segment
+        kernel_to_user_approx_.record(receive_time_us - kernel_rx_ns / 1000);
+    }
+
+    int64_t event_time_ms = extract_json_integer(payload, "E");
+    if (event_time_ms > 0 && clock_sync_ != nullptr && clock_sync_->has_estimate()) {
+        exchange_latency_.record(receive_time_us - clock_sync_->exchange_to_local_us(event_time_ms));
+    }
+
+    // Combined streams carry the symbol in the "stream" wrapper
+    message_processor_.add_message(true, std::move(payload), symbol_);
 }
 
 void WebSocketHandler::handle_disconnect() {
     is_connected_ = false;
+    if (stopped_ || reconnecting_.exchange(true)) {
+        return;  // a close after a failed attempt must not start a second backoff
+    }
     std::cout << "WebSocket disconnected. Attempting to reconnect..." << std::endl;
-    
-    static int retry_count = 0;
-    int backoff_time = std::min(1000 * (1 << retry_count), 30000);  // Max 30 seconds
-    
+    net::co_spawn(io_context_, reconnect_with_backoff(shared_from_this()), net::detached);
+}
+
+net::awaitable<void> WebSocketHandler::reconnect_with_backoff(std::shared_ptr<WebSocketHandler> /*self*/) {
+    int backoff_time = std::min(1000 << std::min(retry_count_, 5), 30000);  // Max 30 seconds
+    ++retry_count_;
+
+    boost::system::error_code ec;
     reconnect_timer_.expires_after(std::chrono::milliseconds(backoff_time));
-    reconnect_timer_.async_wait([this](const boost::system::error_code& ec) {
-        if (!ec) {
-            connect();
-            retry_count++;
-        } else {
+    co_await reconnect_timer_.async_wait(net::redirect_error(net::use_awaitable, ec));
+    reconnecting_ = false;
+    if (ec) {
+        if (ec != net::error::operation_aborted) {
             std::cerr << "Error in reconnect timer: " << ec.message() << std::endl;
-            // Implement further error recovery logic here
         }
-    });
+        co_return;
+    }
+    if (!stopped_) {
+        connect();
+    }
 }
 
 void WebSocketHandler::on_connect(websocketpp::connection_hdl hdl) {
-    is_connected_ = true;
+    connecting_ = false;
     connection_ = hdl;
     set_tcp_options(hdl);
+    on_open();
+}
+
+void WebSocketHandler::on_open() {
+    is_connected_ = true;
+    retry_count_ = 0;
     std::cout << "WebSocket connected for symbol: " << symbol_ << std::endl;
-    
-    auto con = client_.get_con_from_hdl(hdl);
-    con->send("{ \"method\": \"SUBSCRIBE\", \"params\": [\"" + symbol_ + "@depth\"], \"id\": 1 }");
+
+    if (!symbol_.empty()) {
+        send_message("{ \"method\": \"SUBSCRIBE\", \"params\": [\"" + stream_names(symbol_, "\", \"") + "\"], \"id\": 1 }");
+    }
+    if (connected_callback_) {
+        connected_callback_();
+    }
+}
+
+void WebSocketHandler::connect_io_uring() {
+#ifdef __linux__
+    if (stopped_ || (feed_ && feed_->is_connected())) {
+        connecting_ = false;
+        return;
+    }
+    // ws://host[:port], the path is what stream_url() appends
+    static constexpr std::string_view scheme = "ws://";
+    std::string authority = stream_base_.compare(0, scheme.size(), scheme) == 0 ? stream_base_.substr(scheme.size()) : std::string();
+    size_t colon = authority.rfind(':');
+    std::string host = authority.substr(0, colon);
+    std::string port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+    if (host.empty()) {
+        std::cerr << "io_uring streams need a ws:// stream base, not " << stream_base_ << std::endl;
+        connecting_ = false;
+        return;
+    }
+
+    feed_.reset();  // closes the previous connection, if any
+    feed_ = std::make_unique<IoUringWebSocketFeed>(*io_uring_, host, port, stream_url().substr(stream_base_.size()),
+                                                   message_processor_);
+    feed_->set_message_handler([this](std::string&& payload) { deliver(std::move(payload)); });
+    feed_->set_close_handler([this]() { handle_disconnect(); });
+    // Stays connecting until the upgrade finishes, so connect() does not start a second one
+    feed_->connect(io_context_, std::chrono::seconds(10), [self = shared_from_this()](bool connected) {
+        self->connecting_ = false;
+        if (!connected) {
+            std::cout << "io_uring connection failed for symbol " << self->symbol_ << std::endl;
+            self->handle_disconnect();
+            return;
+        }
+        if (self->socket_profile_.enabled) {
+            SocketTuning::apply_low_latency_profile(self->feed_->native_handle(), self->socket_profile_);
+        }
+        self->on_open();
+    });
+#endif
+}
+
+void WebSocketHandler::set_io_uring(IoUringTransport* transport) {
+    io_uring_ = transport;
+}
+
+
+void WebSocketHandler::set_connected_callback(std::function<void()> callback) {
+    connected_callback_ = std::move(callback);
+}
+
+void WebSocketHandler::unsubscribe(const std::string& symbol) {
+    send_message("{ \"method\": \"UNSUBSCRIBE\", \"params\": [\"" + stream_names(symbol, "\", \"") + "\"], \"id\": 2 }");
+    symbols_.erase(std::remove(symbols_.begin(), symbols_.end(), symbol), symbols_.end());
 }
 
 void WebSocketHandler::set_tcp_options(websocketpp::connection_hdl hdl) {
@@ -123,16 +288,63 @@ void WebSocketHandler::set_tcp_options(websocketpp::connection_hdl hdl) {
     socket.set_option(boost::asio::socket_base::send_buffer_size(262144));
     socket.set_option(boost::asio::socket_base::send_low_watermark(1024));
     socket.set_option(boost::asio::socket_base::receive_low_watermark(1024));
+
+    if (socket_profile_.enabled) {
+        SocketTuning::apply_low_latency_profile(socket.native_handle(), socket_profile_);
+        if (socket_profile_.rx_timestamps || socket_profile_.quick_ack) {
+            arm_rx_timestamp_probe(hdl);
+        }
+    }
+}
+
+void WebSocketHandler::arm_rx_timestamp_probe(websocketpp::connection_hdl hdl) {
+    // websocketpp owns the reads, so peek at the receive queue whenever it becomes readable
+    // to learn when the next bytes reached the kernel before the read consumes them.
+    auto con = client_.get_con_from_hdl(hdl);
+    con->get_socket().async_wait(boost::asio::ip::tcp::socket::wait_read,
+        [this, hdl](const boost::system::error_code& ec) {
+            if (ec || !is_connected_) {
+                return;
+            }
+            websocketpp::lib::error_code con_ec;
+            auto current = client_.get_con_from_hdl(hdl, con_ec);
+            if (con_ec) {
+                return;
+            }
+            int fd = current->get_socket().native_handle();
+            if (socket_profile_.rx_timestamps) {
+                int64_t rx_ns = SocketTuning::peek_rx_timestamp_ns(fd);
+                if (rx_ns > 0) {
+                    int64_t expected = -1;
+                    last_kernel_rx_ns_.compare_exchange_strong(expected, rx_ns, std::memory_order_relaxed);
+                }
+            }
+            if (socket_profile_.quick_ack) {
+                SocketTuning::rearm_quick_ack(fd);
+            }
+            arm_rx_timestamp_probe(hdl);
+        });
 }
 
 void WebSocketHandler::on_fail(websocketpp::connection_hdl hdl) {
     auto con = client_.get_con_from_hdl(hdl);
     std::cout << "WebSocket connection failed for symbol " << symbol_ << ": " 
               << con->get_ec().message() << std::endl;
+    connecting_ = false;
     handle_disconnect();
 }
 
 void WebSocketHandler::send_message(const std::string& message) {
+#ifdef __linux__
+    if (io_uring_) {
+        net::post(io_context_, [self = shared_from_this(), message]() {
+            if (self->feed_ && self->feed_->is_connected()) {
+                self->feed_->send_text(message);
+            }
+        });
+        return;
+    }
+#endif
     if (is_connected_) {
         websocketpp::lib::error_code ec;
         client_.send(connection_, message, websocketpp::frame::opcode::text, ec);
@@ -145,17 +357,60 @@ void WebSocketHandler::send_message(const std::string& message) {
 }
 
 void WebSocketHandler::ping() {
-    if (is_connected_) {
+    if (is_connected_ && !io_uring_) {
+        // Carry the send time in the payload so each pong can be matched without extra state
+        auto sent_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
         websocketpp::lib::error_code ec;
-        client_.ping(connection_, "ping", ec);
+        client_.ping(connection_, std::to_string(sent_ns), ec);
         if (ec) {
             std::cout << "Error sending ping: " << ec.message() << std::endl;
         }
     }
 }
 
+void WebSocketHandler::on_pong(websocketpp::connection_hdl hdl, std::string payload) {
+    (void)hdl;  // Suppress unused parameter warning
+    char* end = nullptr;
+    long long sent_ns = std::strtoll(payload.c_str(), &end, 10);
+    if (end == payload.c_str() || sent_ns <= 0) {
+        return;  // Not one of our pings
+    }
+    auto now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    ping_rtt_.record((now_ns - sent_ns) / 1000);
+}
+
+void WebSocketHandler::set_clock_sync(const ClockSync* clock_sync) {
+    clock_sync_ = clock_sync;
+}
+
+void WebSocketHandler::set_capture(CaptureJournal* journal) {
+    capture_ = journal;
+    if (capture_) {
+        capture_connection_ = capture_->register_connection();
+        capture_symbol_ = capture_->symbol_id(symbol_);
+    }
+}
+
+void WebSocketHandler::set_stream_base(const std::string& stream_base) {
+    stream_base_ = stream_base;
+}
+
+void WebSocketHandler::set_trade_stream(const std::string& trade_stream) {
+    trade_stream_ = trade_stream;
+}
+
+void WebSocketHandler::set_socket_profile(const LowLatencySocketProfile& profile) {
+    socket_profile_ = profile;
+}
+
+ConnectionLatency WebSocketHandler::get_latency() const {
+    return ConnectionLatency{exchange_latency_.stats(), ping_rtt_.stats(), kernel_to_user_approx_.stats()};
+}
+
 void WebSocketHandler::set_ping_interval(long interval_ms) {
-    if (is_connected_) {
+    if (is_connected_ && !io_uring_) {
         auto con = client_.get_con_from_hdl(connection_);
         con->set_pong_timeout(interval_ms);
         // Instead of setting ping interval, we can start a timer to send pings periodically
@@ -3,13 +3,29 @@
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 #include <boost/beast/ssl.hpp>
+#include <boost/asio/awaitable.hpp>
 #include <websocketpp/config/asio_client.hpp>
 #include <websocketpp/client.hpp>
 #include <string>
 #include <memory>
+#include <vector>
+#include <functional>
 #include <mutex>
 #include <atomic>
 #include "MessageProcessor.h"
+#include "LatencyMonitor.h"
+#include "SocketTuning.h"
+#include "CaptureJournal.h"
+#include "ExchangeEndpoints.h"
+
+class IoUringTransport;
+class IoUringWebSocketFeed;
+
+// What reads a WebSocketHandler's stream. IoUring serves plaintext ws:// stream bases only.
+enum class StreamTransport {
+    Websocketpp,
+    IoUring,
+};
 
 namespace beast = boost::beast;
 namespace http = beast::http;
@@ -20,6 +36,9 @@ namespace net = boost::asio;
 class WebSocketHandler : public std::enable_shared_from_this<WebSocketHandler> {
 public:
     WebSocketHandler(net::io_context& ioc, const std::string& symbol, MessageProcessor& messageProcessor);
+    // One combined-stream connection carrying the depth streams of several symbols
+    WebSocketHandler(net::io_context& ioc, const std::vector<std::string>& symbols, MessageProcessor& messageProcessor);
+    ~WebSocketHandler();
     void connect();
     void stop();
     bool is_connected() const;
@@ -27,10 +46,29 @@ public:
     void send_message(const std::string& message);
     void ping();
     void set_ping_interval(long interval_ms);
+    void unsubscribe(const std::string& symbol);
+    // Invoked on the connection's io_context every time the stream (re)connects
+    void set_connected_callback(std::function<void()> callback);
+    const std::vector<std::string>& get_symbols() const { return symbols_; }
+    void set_clock_sync(const ClockSync* clock_sync);
+    void set_socket_profile(const LowLatencySocketProfile& profile);
+    ConnectionLatency get_latency() const;
+    // Records every payload before it is processed; nullptr disables. Set before connect().
+    void set_capture(CaptureJournal* journal);
+    // Scheme, host and port the stream paths are appended to; set before connect()
+    void set_stream_base(const std::string& stream_base);
+    // Trade stream subscribed with every symbol's depth, "trade" or "aggTrade"; empty for
+    // depth only. Set before connect().
+    void set_trade_stream(const std::string& trade_stream);
+    // Reads the stream through this io_uring transport instead of websocketpp. The
+    // transport must be attached to the loop of this handler's io_context and the stream
+    // base must be ws://. Set before connect(). Pings and RX timestamps are websocketpp only.
+    void set_io_uring(IoUringTransport* transport);
 
 private:
     net::io_context& io_context_;
     std::string symbol_;
+    std::vector<std::string> symbols_;
     MessageProcessor& message_processor_;
     websocketpp::client<websocketpp::config::asio_client> client_;
     websocketpp::connection_hdl connection_;
@@ -38,11 +76,44 @@ private:
     std::atomic<bool> is_connected_{false};
     int cpu_id_ = -1;
     std::unique_ptr<boost::asio::steady_timer> ping_timer_;
+    const ClockSync* clock_sync_ = nullptr;
+    LatencyTracker exchange_latency_;
+    LatencyTracker ping_rtt_;
+    LatencyTracker kernel_to_user_approx_;  // see ConnectionLatency::kernel_to_user_approx
+    LowLatencySocketProfile socket_profile_;
+    std::atomic<int64_t> last_kernel_rx_ns_{-1};
+    std::function<void()> connected_callback_;
+    CaptureJournal* capture_ = nullptr;
+    uint32_t capture_connection_ = 0;
+    uint32_t capture_symbol_ = 0;  // 0 for combined streams, whose payloads name the symbol
+    std::string stream_base_ = ExchangeEndpoints().stream_base;
+    std::string trade_stream_;
+    IoUringTransport* io_uring_ = nullptr;
+    std::unique_ptr<IoUringWebSocketFeed> feed_;  // loop thread only
+    std::atomic<bool> connecting_{false};  // from connect() until the attempt opens or fails
+    // Reconnect state is per connection: one handler's failures don't lengthen another's backoff
+    int retry_count_ = 0;  // consecutive failed attempts, reset once a connection opens
+    std::atomic<bool> reconnecting_{false};
+    std::atomic<bool> stopped_{false};
 
     void on_message(websocketpp::connection_hdl hdl, websocketpp::config::asio_client::message_type::ptr msg);
+    // Every payload of either transport, on the loop thread
+    void deliver(std::string&& payload);
+    void on_pong(websocketpp::connection_hdl hdl, std::string payload);
     void handle_disconnect();
+    net::awaitable<void> reconnect_with_backoff(std::shared_ptr<WebSocketHandler> self);
     void on_connect(websocketpp::connection_hdl hdl);
+    void on_open();
+    void connect_websocketpp();
+    void connect_io_uring();
     void set_tcp_options(websocketpp::connection_hdl hdl);
+    // Peeks the kernel RX timestamp of the receive queue head each time the socket turns
+    // readable, for the next delivered message. Not the timestamp of the read itself.
+    void arm_rx_timestamp_probe(websocketpp::connection_hdl hdl);
     void on_fail(websocketpp::connection_hdl hdl);
     void start_ping_timer(long interval_ms);
+    void init_client();
+    std::string stream_url() const;
+    // "btcusdt@depth" and the trade stream, joined by separator
+    std::string stream_names(const std::string& symbol, const char* separator) const;
 };
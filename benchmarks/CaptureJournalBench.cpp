@@ -0,0 +1,41 @@
+#include <benchmark/benchmark.h>
+#include "../CaptureJournal.h"
+#include <filesystem>
+#include <string>
+
+// Cost of CaptureJournal::append on the feed thread for depth-diff-sized payloads while
+// the background thread flushes underneath. The run fits in one prefaulted segment: a
+// writer this fast outruns segment preparation, which the dropped counter would show.
+// The directory is removed afterwards; point TMPDIR at the disk production captures go
+// to for realistic page cache behaviour.
+
+namespace {
+
+std::string capture_directory() {
+    return (std::filesystem::temp_directory_path() / "capture_journal_bench").string();
+}
+
+void BM_CaptureAppend(benchmark::State& state) {
+    const std::string payload(static_cast<size_t>(state.range(0)), 'x');
+    std::filesystem::remove_all(capture_directory());
+    {
+        CaptureConfig config;
+        config.directory = capture_directory();
+        config.segment_size = 256 * 1024 * 1024;
+        CaptureJournal journal(config);
+        uint32_t connection = journal.register_connection();
+        uint32_t symbol = journal.symbol_id("btcusdt");
+        int64_t now = CaptureJournal::now_ns();
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(journal.append(CaptureSource::WebSocket, connection, symbol, ++now, payload));
+        }
+        state.counters["dropped"] = static_cast<double>(journal.stats().dropped);
+    }
+    std::filesystem::remove_all(capture_directory());
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_CaptureAppend)->Arg(128)->Arg(256)->Iterations(1 << 19);
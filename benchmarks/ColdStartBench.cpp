@@ -0,0 +1,170 @@
+#include <benchmark/benchmark.h>
+#include "../EventLoop.h"
+#include "../IoUringTransport.h"
+#include "../LocalExchange.h"
+#include "../MessageProcessor.h"
+#include "../OrderbookManager.h"
+#include "../RestApiHandler.h"
+#include "../StartupOrchestrator.h"
+#include <boost/asio/ssl.hpp>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Cold start of state.range(0) symbols against a LocalExchange, wired the way
+// BinanceClient wires it for io_uring streams but without websocketpp: every combined
+// stream connection opens at once and each symbol's snapshot is fetched at its
+// StartupOrchestrator offset once its stream is open. Reports wall time until every
+// book is synced, the spread of per-symbol times, and the peak snapshot weight sent
+// inside one 60s window next to the budget. With the defaults cold start may spend 5100
+// of 6000 weight, so 1000 snapshots of weight 5 fit in the first window.
+//
+// Seconds of wall time and a local exchange per run, so it is its own binary,
+// cold_start_bench, rather than part of the default suite.
+
+namespace {
+
+std::vector<std::string> symbols(int64_t count) {
+    std::vector<std::string> names;
+    for (int64_t i = 0; i < count; ++i) {
+        names.push_back("sym" + std::to_string(i) + "usdt");
+    }
+    return names;
+}
+
+// One stream loop: its ring, books and inline processor, as in shard-per-core mode
+struct StreamLoop {
+    EventLoop loop;
+    IoUringTransport transport;
+    OrderbookManager books;
+    MessageProcessor processor;
+    std::vector<std::unique_ptr<IoUringWebSocketFeed>> feeds;  // loop thread only
+
+    StreamLoop(const WaitConfig& wait, const IoUringConfig& config)
+        : loop(wait), transport(config), processor(loop.get_io_context(), books) {
+        processor.set_inline(true);
+        transport.attach(loop);
+    }
+};
+
+void BM_ColdStart(benchmark::State& state) {
+    const std::vector<std::string> names = symbols(state.range(0));
+    LocalExchangeConfig exchange_config;
+    exchange_config.market.symbols = names;
+    exchange_config.market.depth = 20;
+    exchange_config.market.messages_per_second = 10;  // per symbol; the exchange is one thread
+    LocalExchange exchange(exchange_config);
+    const ExchangeEndpoints endpoints = exchange.endpoints();
+    const std::string stream_host = "127.0.0.1";
+    const std::string stream_port = endpoints.stream_base.substr(endpoints.stream_base.rfind(':') + 1);
+
+    StartupConfig startup;
+    StartupReport report;
+    for (auto _ : state) {
+        // Declared before the loops: whatever their io_contexts still hold refers to these
+        boost::asio::ssl::context ssl_ctx{boost::asio::ssl::context::tlsv12_client};
+        StartupOrchestrator orchestrator(startup);
+        orchestrator.begin(names);
+        WaitConfig wait;
+        wait.strategy = WaitStrategy::Adaptive;
+        IoUringConfig ring;
+        ring.single_issuer = false;  // created here, driven by the loop's thread
+        std::vector<std::unique_ptr<StreamLoop>> loops;
+        for (int i = 0; i < 2; ++i) {
+            loops.push_back(std::make_unique<StreamLoop>(wait, ring));
+        }
+        for (auto& stream_loop : loops) {
+            stream_loop->books.setSyncListener([&orchestrator](const std::string& symbol, bool synced) {
+                if (synced) orchestrator.on_book_consistent(symbol);
+            });
+        }
+
+        const auto groups = StartupOrchestrator::group_streams(names, startup.streams_per_connection);
+        const auto offsets = StartupOrchestrator::plan_snapshot_schedule(names.size(), startup);
+        std::vector<std::shared_ptr<RestApiHandler>> rest_handlers;
+        std::vector<std::vector<RestApiHandler*>> group_handlers(groups.size());
+        for (size_t g = 0; g < groups.size(); ++g) {
+            StreamLoop& stream_loop = *loops[g % loops.size()];
+            for (const auto& symbol : groups[g]) {
+                std::string rest_symbol = symbol;
+                std::transform(rest_symbol.begin(), rest_symbol.end(), rest_symbol.begin(), ::toupper);
+                auto handler = std::make_shared<RestApiHandler>(
+                    stream_loop.loop.get_io_context(), ssl_ctx, endpoints.rest_host, endpoints.rest_port,
+                    "/api/v3/depth?symbol=" + rest_symbol + "&limit=" + std::to_string(startup.snapshot_limit),
+                    stream_loop.processor);
+                handler->set_symbol(symbol);
+                OrderbookManager* books = &stream_loop.books;
+                handler->set_fetch_condition([books, &orchestrator, symbol]() {
+                    if (books->isSynced(symbol)) {
+                        return false;
+                    }
+                    orchestrator.on_snapshot_request();
+                    return true;
+                });
+                handler->set_failure_handler([&orchestrator, raw = handler.get(), symbol]() {
+                    raw->fetch_snapshot(orchestrator.schedule_resync(symbol));
+                });
+                rest_handlers.push_back(handler);
+                group_handlers[g].push_back(handler.get());
+            }
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        for (auto& stream_loop : loops) {
+            stream_loop->loop.run();
+        }
+        for (size_t g = 0, first = 0; g < groups.size(); first += groups[g].size(), ++g) {
+            StreamLoop& stream_loop = *loops[g % loops.size()];
+            std::string path = "/stream?streams=";
+            for (size_t i = 0; i < groups[g].size(); ++i) {
+                path += (i > 0 ? "/" : "") + groups[g][i] + "@depth";
+            }
+            stream_loop.loop.post([&, g, first, path]() {
+                auto feed = std::make_unique<IoUringWebSocketFeed>(stream_loop.transport, stream_host, stream_port, path,
+                                                                   stream_loop.processor);
+                feed->connect(stream_loop.loop.get_io_context(), std::chrono::seconds(10), [&, g, first](bool connected) {
+                    if (!connected) return;
+                    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+                    for (size_t i = 0; i < group_handlers[g].size(); ++i) {
+                        group_handlers[g][i]->fetch_snapshot(std::max(offsets[first + i] - elapsed, std::chrono::milliseconds(0)));
+                    }
+                });
+                stream_loop.feeds.push_back(std::move(feed));
+            });
+        }
+
+        auto deadline = start + std::chrono::minutes(3);
+        while (!orchestrator.complete() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        report = orchestrator.report();
+        for (auto& handler : rest_handlers) {
+            handler->stop();
+        }
+        for (auto& stream_loop : loops) {
+            stream_loop->loop.post([&stream_loop]() { stream_loop->feeds.clear(); });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        for (auto& stream_loop : loops) {
+            stream_loop->loop.stop();
+            stream_loop->transport.detach();
+        }
+        if (report.pending > 0) {
+            state.SkipWithError("books still pending after 3 minutes");
+            return;
+        }
+    }
+    state.counters["time_to_all_synced_ms"] = report.overall_ms;
+    state.counters["p50_ms"] = report.p50_ms;
+    state.counters["p99_ms"] = report.p99_ms;
+    state.counters["peak_weight"] = report.peak_weight;
+    state.counters["weight_budget"] = startup.weight_budget_per_minute;
+    state.counters["snapshots_served"] = static_cast<double>(exchange.stats().rest_requests);
+}
+BENCHMARK(BM_ColdStart)->Arg(100)->Arg(1000)->Iterations(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+}  // namespace
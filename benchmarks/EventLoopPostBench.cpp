@@ -0,0 +1,66 @@
+#include <benchmark/benchmark.h>
+#include "../CpuTopology.h"
+#include "../EventLoop.h"
+#include <sched.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// EventLoop::post round trip: this thread posts a task and spins until the loop has run
+// it, one task in flight, per wait strategy. With two or more CPUs allowed (see
+// run_benchmarks.sh) the loop and this thread are pinned to the first two, so runs
+// compare across commits; with one they share it unpinned. Items/s is round trips per
+// second; the busy strategies are the ones a feed loop uses.
+
+namespace {
+
+std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    return cpus;
+}
+
+void BM_EventLoopPostRoundTrip(benchmark::State& state) {
+    WaitConfig config;
+    config.strategy = static_cast<WaitStrategy>(state.range(0));
+    EventLoop loop(config);
+    const auto cpus = allowed_cpus();
+    const bool shared = cpus.size() < 2;
+    if (!shared) {
+        loop.set_affinity(cpus[1]);
+        pin_current_thread({cpus[0]});
+    }
+    loop.run();
+
+    std::atomic<uint64_t> done{0};
+    uint64_t posted = 0;
+    for (auto _ : state) {
+        loop.post([&done]() { done.fetch_add(1, std::memory_order_release); });
+        ++posted;
+        while (done.load(std::memory_order_acquire) != posted) {
+            if (shared) {
+                std::this_thread::yield();  // the loop needs this CPU to run the task
+            }
+        }
+    }
+    loop.stop();
+    if (!shared) {
+        pin_current_thread(cpus);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_EventLoopPostRoundTrip)
+    ->Arg(static_cast<int64_t>(WaitStrategy::BusySpin))
+    ->Arg(static_cast<int64_t>(WaitStrategy::SpinThenYield))
+    ->Arg(static_cast<int64_t>(WaitStrategy::Adaptive))
+    ->ArgName("strategy")->UseRealTime();
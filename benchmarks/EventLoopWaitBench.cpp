@@ -0,0 +1,53 @@
+#include <benchmark/benchmark.h>
+#include "../EventLoop.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Sparse load against one EventLoop per wait strategy: a task every gap_us, as a
+// quiet symbol or housekeeping timer would post. Reports the loop thread's CPU
+// utilization (idle CPU, since the tasks themselves are empty) and post-to-run latency.
+
+namespace {
+
+void BM_EventLoopWait(benchmark::State& state) {
+    WaitConfig config;
+    config.strategy = static_cast<WaitStrategy>(state.range(0));
+    const auto gap = std::chrono::microseconds(state.range(1));
+    constexpr int kPosts = 500;
+
+    EventLoopStats stats;
+    for (auto _ : state) {
+        EventLoop loop(config);
+        loop.run();
+        std::atomic<int> done{0};
+        for (int i = 0; i < kPosts; ++i) {
+            std::this_thread::sleep_for(gap);
+            loop.post([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        while (done.load() < kPosts) {
+            std::this_thread::yield();
+        }
+        stats = loop.get_stats();
+        loop.stop();
+    }
+
+    state.counters["idle_cpu_pct"] = stats.cpu_utilization * 100.0;
+    state.counters["wake_p50_us"] = static_cast<double>(stats.wake_latency.p50_us);
+    state.counters["wake_p99_us"] = static_cast<double>(stats.wake_latency.p99_us);
+    state.counters["parks"] = static_cast<double>(stats.parks);
+}
+
+void strategies(benchmark::internal::Benchmark* bench) {
+    for (auto strategy : {WaitStrategy::BusySpin, WaitStrategy::SpinThenYield,
+                          WaitStrategy::SpinThenBlock, WaitStrategy::Adaptive}) {
+        for (int gap_us : {100, 2000}) {
+            bench->Args({static_cast<int64_t>(strategy), gap_us});
+        }
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_EventLoopWait)->Apply(strategies)->ArgNames({"strategy", "gap_us"})
+    ->Iterations(1)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,142 @@
+#include <benchmark/benchmark.h>
+#include "../FanoutServer.h"
+#include <boost/asio.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/websocket.hpp>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Fan-out of book changes to many local consumers. Each iteration changes the top of
+// every symbol once; all consumers subscribe to all symbols in the binary format and
+// decode every message on one client thread.
+//   BM_Fanout:          the feed publishes flat out and only the last iteration waits
+//                       for every consumer to have the final top, so slow delivery
+//                       shows up as conflation rather than as a slower feed
+//   BM_FanoutLockstep:  every iteration waits until all consumers have the round, so
+//                       nothing conflates and the time is a full fan-out
+//   items/s:      book updates taken from the feed
+//   delivered/s:  messages consumers received; below clients x items/s when conflated
+
+namespace {
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace websocket = beast::websocket;
+
+constexpr size_t kSymbols = 10;
+
+class Consumers {
+public:
+    Consumers(unsigned short port, size_t count) : seen_(count * kSymbols) {
+        std::string target = "/?format=binary&symbols=";
+        for (size_t s = 0; s < kSymbols; ++s) {
+            target += (s ? ",sym" : "sym") + std::to_string(s);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            auto ws = std::make_unique<websocket::stream<beast::tcp_stream>>(ioc_);
+            beast::get_lowest_layer(*ws).connect({net::ip::make_address("127.0.0.1"), port});
+            ws->handshake("127.0.0.1", target);
+            net::co_spawn(ioc_, read_loop(*ws, i), net::detached);
+            streams_.push_back(std::move(ws));
+        }
+        thread_ = std::thread([this]() { ioc_.run(); });
+    }
+
+    ~Consumers() {
+        ioc_.stop();
+        thread_.join();
+    }
+
+    uint64_t messages() const { return messages_.load(); }
+
+    void wait_for(uint64_t update_id) const {
+        for (const auto& seen : seen_) {
+            while (seen.load(std::memory_order_acquire) < update_id) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    net::io_context ioc_;
+    std::vector<std::unique_ptr<websocket::stream<beast::tcp_stream>>> streams_;
+    std::vector<std::atomic<uint64_t>> seen_;  // last update ID per consumer and symbol
+    std::atomic<uint64_t> messages_{0};
+    std::thread thread_;
+
+    net::awaitable<void> read_loop(websocket::stream<beast::tcp_stream>& ws, size_t consumer) {
+        beast::flat_buffer buffer;
+        fanout::BinaryDecoder decoder;
+        fanout::Message message;
+        boost::system::error_code ec;
+        for (;;) {
+            buffer.clear();
+            co_await ws.async_read(buffer, net::redirect_error(net::use_awaitable, ec));
+            if (ec) {
+                co_return;
+            }
+            const auto* data = static_cast<const char*>(buffer.data().data());
+            if (decoder.decode(std::string_view(data, buffer.size()), message) != fanout::BinaryDecoder::Result::Message) {
+                continue;
+            }
+            messages_.fetch_add(1, std::memory_order_relaxed);
+            size_t symbol = std::stoul(message.symbol.substr(3));
+            seen_[consumer * kSymbols + symbol].store(message.update_id, std::memory_order_release);
+        }
+    }
+};
+
+BookView initial_view() {
+    BookView view;
+    view.bid_count = view.ask_count = BookView::DEPTH;
+    for (size_t i = 0; i < BookView::DEPTH; ++i) {
+        view.bids[i] = PriceLevel{100.0 - static_cast<double>(i) * 0.01, 1.0};
+        view.asks[i] = PriceLevel{100.01 + static_cast<double>(i) * 0.01, 1.0};
+    }
+    return view;
+}
+
+std::vector<std::string> symbol_names() {
+    std::vector<std::string> symbols;
+    for (size_t s = 0; s < kSymbols; ++s) {
+        symbols.push_back("sym" + std::to_string(s));
+    }
+    return symbols;
+}
+
+template<bool Lockstep>
+void BM_Fanout(benchmark::State& state) {
+    const auto clients = static_cast<size_t>(state.range(0));
+    FanoutServer server(FanoutConfig{});
+    Consumers consumers(server.port(), clients);
+    BookView view = initial_view();
+    const std::vector<std::string> symbols = symbol_names();
+
+    uint64_t round = 0;
+    const uint64_t delivered_before = consumers.messages();
+    for (auto _ : state) {
+        ++round;
+        view.last_update_id = round;
+        view.bids[round % BookView::DEPTH].quantity = static_cast<double>(round);
+        for (const auto& symbol : symbols) {
+            server.on_book(symbol, view);
+        }
+        if (Lockstep || round == static_cast<uint64_t>(state.max_iterations)) {
+            consumers.wait_for(round);
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(round * kSymbols));
+    state.counters["delivered"] = benchmark::Counter(static_cast<double>(consumers.messages() - delivered_before),
+                                                     benchmark::Counter::kIsRate);
+    state.counters["conflated"] = static_cast<double>(server.stats().conflated);
+}
+BENCHMARK_TEMPLATE(BM_Fanout, false)->Name("BM_Fanout")->Arg(10)->Arg(100)->Arg(200)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Fanout, true)->Name("BM_FanoutLockstep")->Arg(10)->Arg(100)->Arg(200)->UseRealTime();
+
+}  // namespace
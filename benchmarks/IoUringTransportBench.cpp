@@ -0,0 +1,147 @@
+#include <benchmark/benchmark.h>
+#include "../IoUringTransport.h"
+#include "../WebSocketFrameDecoder.h"
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Local feeder: a burst of depth-sized websocket frames written one frame per send(),
+// each carrying its send time, then drained through the transport under test.
+// Reports syscalls per message on the receive side and p99 send-to-decode latency.
+
+namespace {
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string make_frame(int64_t sent_ns) {
+    std::string payload = R"({"e":"depthUpdate","E":1672515782136,"s":"BTCUSDT","U":157,"u":160,)"
+                          R"("b":[["16500.10","0.250"],["16500.00","1.100"]],"a":[["16500.20","0.410"]],"t":)";
+    payload += std::to_string(sent_ns) + "}";
+    return WebSocketFrameDecoder::encode_server_frame(WebSocketFrameDecoder::Opcode::Text, payload);
+}
+
+int64_t sent_time_of(const std::string& payload) {
+    size_t pos = payload.rfind("\"t\":");
+    return std::strtoll(payload.c_str() + pos + 4, nullptr, 10);
+}
+
+struct Feeder {
+    int fds[2];
+    Feeder() {
+        socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+        int size = 4 << 20;
+        setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        setsockopt(fds[0], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+    ~Feeder() {
+        close(fds[0]);
+        close(fds[1]);
+    }
+    void burst(int64_t messages) {
+        for (int64_t i = 0; i < messages; ++i) {
+            std::string frame = make_frame(now_ns());
+            if (write(fds[1], frame.data(), frame.size()) < 0) {
+                return;
+            }
+        }
+    }
+};
+
+void report(benchmark::State& state, std::vector<int64_t>& latencies, uint64_t syscalls, uint64_t messages) {
+    std::sort(latencies.begin(), latencies.end());
+    if (!latencies.empty()) {
+        state.counters["p50_ns"] = static_cast<double>(latencies[latencies.size() / 2]);
+        state.counters["p99_ns"] = static_cast<double>(latencies[latencies.size() * 99 / 100]);
+    }
+    state.counters["syscalls_per_msg"] = static_cast<double>(syscalls) / static_cast<double>(messages);
+    state.SetItemsProcessed(static_cast<int64_t>(messages));
+}
+
+} // namespace
+
+static void BM_EpollRecv(benchmark::State& state) {
+    Feeder feeder;
+    fcntl(feeder.fds[0], F_SETFL, O_NONBLOCK);
+    int epfd = epoll_create1(0);
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = feeder.fds[0];
+    epoll_ctl(epfd, EPOLL_CTL_ADD, feeder.fds[0], &ev);
+
+    WebSocketFrameDecoder decoder;
+    std::vector<int64_t> latencies;
+    uint64_t syscalls = 0, messages = 0;
+    char buf[16384];
+    const int64_t burst = state.range(0);
+
+    for (auto _ : state) {
+        feeder.burst(burst);
+        int64_t received = 0;
+        while (received < burst) {
+            // Same pattern as the Asio reactor: wait for readiness, then read until EAGAIN
+            epoll_event events[1];
+            ++syscalls;
+            epoll_wait(epfd, events, 1, -1);
+            for (;;) {
+                ++syscalls;
+                ssize_t n = read(feeder.fds[0], buf, sizeof(buf));
+                if (n <= 0) break;
+                decoder.feed(buf, static_cast<size_t>(n), [&](WebSocketFrameDecoder::Opcode, std::string&& payload) {
+                    latencies.push_back(now_ns() - sent_time_of(payload));
+                    ++received;
+                });
+            }
+        }
+        messages += static_cast<uint64_t>(received);
+    }
+    close(epfd);
+    report(state, latencies, syscalls, messages);
+}
+BENCHMARK(BM_EpollRecv)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_IoUringRecv(benchmark::State& state) {
+    if (!IoUringTransport::is_supported()) {
+        state.SkipWithError("io_uring not available");
+        return;
+    }
+    Feeder feeder;
+    IoUringConfig config;
+    config.sqpoll = state.range(1) != 0;
+    IoUringTransport transport(config);
+
+    WebSocketFrameDecoder decoder;
+    std::vector<int64_t> latencies;
+    uint64_t messages = 0;
+    int64_t received = 0;
+    transport.add_connection(feeder.fds[0],
+        [&](const char* data, size_t len) {
+            decoder.feed(data, len, [&](WebSocketFrameDecoder::Opcode, std::string&& payload) {
+                latencies.push_back(now_ns() - sent_time_of(payload));
+                ++received;
+            });
+        },
+        [](int) {});
+    transport.poll(false);
+
+    const int64_t burst = state.range(0);
+    uint64_t enter_before = transport.stats().enter_calls;
+    for (auto _ : state) {
+        received = 0;
+        feeder.burst(burst);
+        while (received < burst) {
+            transport.poll(true);
+        }
+        messages += static_cast<uint64_t>(received);
+    }
+    report(state, latencies, transport.stats().enter_calls - enter_before, messages);
+}
+BENCHMARK(BM_IoUringRecv)->ArgsProduct({{16, 256, 4096}, {0, 1}});
@@ -0,0 +1,219 @@
+#include <benchmark/benchmark.h>
+#include "../FanoutProtocol.h"
+#include "../MarketDataCodec.h"
+#include "../OrderbookManager.h"
+#include <simdjson.h>
+#include <charconv>
+#include <string>
+
+// Normalized messages as MarketDataCodec binary against the JSON the client produces
+// today, per message:
+//   snapshot: the top 20 levels of a book. Encode is getOrderbookSnapshot against
+//             encodeSnapshot, both from the published view; decode parses the JSON with
+//             simdjson and converts its quoted decimals, against wrapping the binary
+//             message and reading every level.
+//   delta:    a fan-out delta of 4 changed levels, fanout::encode_json against
+//             encode_binary, and simdjson against BinaryDecoder into a fanout::Message.
+//   trade:    a Binance trade event parsed with simdjson against md::View<md::Trade>;
+//             encoding a trade is a 56-byte copy.
+// Decode benchmarks sum what they read so nothing is skipped.
+
+namespace {
+
+std::string levels(int count, double start, double step) {
+    std::string out = "[";
+    for (int i = 0; i < count; ++i) {
+        out += (i ? ",[\"" : "[\"") + std::to_string(start + step * i) + "\",\"" + std::to_string(1.0 + i) + "\"]";
+    }
+    return out + "]";
+}
+
+OrderbookManager& book() {
+    static OrderbookManager manager;
+    static bool loaded = []() {
+        simdjson::dom::parser parser;
+        manager.OnOrderbookRest("btcusdt", parser.parse("{\"lastUpdateId\":1,\"bids\":" + levels(100, 67000.0, -0.01) +
+                                                        ",\"asks\":" + levels(100, 67000.01, 0.01) + "}"));
+        return true;
+    }();
+    (void)loaded;
+    return manager;
+}
+
+double to_double(std::string_view text) {
+    double value = 0.0;
+    std::from_chars(text.data(), text.data() + text.size(), value);
+    return value;
+}
+
+fanout::Message delta_message() {
+    fanout::Message message;
+    message.type = fanout::MessageType::Delta;
+    message.symbol = "btcusdt";
+    message.sequence = 42;
+    message.previous_update_id = 1000;
+    message.update_id = 1007;
+    message.bids = {{67000.00, 1.25}, {66999.98, 0.0}};
+    message.asks = {{67000.01, 0.5}, {67000.05, 3.0}};
+    return message;
+}
+
+void BM_SnapshotEncodeJson(benchmark::State& state) {
+    OrderbookManager& manager = book();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(manager.getOrderbookSnapshot("btcusdt", 20));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SnapshotEncodeJson);
+
+void BM_SnapshotEncodeBinary(benchmark::State& state) {
+    OrderbookManager& manager = book();
+    std::string out;
+    for (auto _ : state) {
+        manager.encodeSnapshot("btcusdt", 20, 1, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes"] = static_cast<double>(out.size());
+}
+BENCHMARK(BM_SnapshotEncodeBinary);
+
+void BM_SnapshotDecodeJson(benchmark::State& state) {
+    const std::string json = book().getOrderbookSnapshot("btcusdt", 20);
+    simdjson::dom::parser parser;
+    for (auto _ : state) {
+        double sum = 0.0;
+        simdjson::dom::element doc = parser.parse(json);
+        for (const char* side : {"bids", "asks"}) {
+            for (auto level : doc[side].get_array()) {
+                sum += to_double(level.at(0).get_string().value()) + to_double(level.at(1).get_string().value());
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes"] = static_cast<double>(json.size());
+}
+BENCHMARK(BM_SnapshotDecodeJson);
+
+void BM_SnapshotDecodeBinary(benchmark::State& state) {
+    std::string frame;
+    book().encodeSnapshot("btcusdt", 20, 1, frame);
+    for (auto _ : state) {
+        int64_t sum = 0;
+        md::View<md::Snapshot> view;
+        view.wrap(frame);
+        for (const md::Levels* side : {&view.bids(), &view.asks()}) {
+            for (size_t i = 0; i < side->size(); ++i) {
+                md::Level level = (*side)[i];
+                sum += level.price + level.quantity;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SnapshotDecodeBinary);
+
+void BM_DeltaEncodeJson(benchmark::State& state) {
+    const fanout::Message message = delta_message();
+    std::string out;
+    for (auto _ : state) {
+        fanout::encode_json(message, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes"] = static_cast<double>(out.size());
+}
+BENCHMARK(BM_DeltaEncodeJson);
+
+void BM_DeltaEncodeBinary(benchmark::State& state) {
+    const fanout::Message message = delta_message();
+    std::string out;
+    for (auto _ : state) {
+        fanout::encode_binary(message, 1, 0, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes"] = static_cast<double>(out.size());
+}
+BENCHMARK(BM_DeltaEncodeBinary);
+
+void BM_DeltaDecodeJson(benchmark::State& state) {
+    std::string json;
+    fanout::encode_json(delta_message(), json);
+    simdjson::dom::parser parser;
+    fanout::Message message;
+    for (auto _ : state) {
+        simdjson::dom::element doc = parser.parse(json);
+        message.symbol = std::string_view(doc["s"].get_string().value());
+        message.sequence = doc["seq"].get_uint64();
+        message.previous_update_id = doc["pu"].get_uint64();
+        message.update_id = doc["u"].get_uint64();
+        for (auto [key, side] : {std::pair{"b", &message.bids}, std::pair{"a", &message.asks}}) {
+            side->clear();
+            for (auto level : doc[key].get_array()) {
+                side->push_back(fanout::Level{level.at(0).get_double(), level.at(1).get_double()});
+            }
+        }
+        benchmark::DoNotOptimize(message.bids.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DeltaDecodeJson);
+
+void BM_DeltaDecodeBinary(benchmark::State& state) {
+    std::string definition, frame;
+    fanout::encode_definition(1, "btcusdt", definition);
+    fanout::encode_binary(delta_message(), 1, 0, frame);
+    fanout::BinaryDecoder decoder;
+    fanout::Message message;
+    decoder.decode(definition, message);
+    for (auto _ : state) {
+        decoder.decode(frame, message);
+        benchmark::DoNotOptimize(message.bids.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DeltaDecodeBinary);
+
+void BM_TradeDecodeJson(benchmark::State& state) {
+    const std::string json = R"({"e":"trade","E":1700000000123,"s":"BTCUSDT","t":3456789012,"p":"67012.34000000",)"
+                             R"("q":"0.01500000","T":1700000000122,"m":true,"M":true})";
+    simdjson::dom::parser parser;
+    for (auto _ : state) {
+        simdjson::dom::element doc = parser.parse(json);
+        int64_t price = 0, quantity = 0;
+        md::parse_fixed(doc["p"].get_string().value(), price);
+        md::parse_fixed(doc["q"].get_string().value(), quantity);
+        uint64_t id = doc["t"].get_uint64();
+        int64_t time = doc["T"].get_int64();
+        bool maker = doc["m"].get_bool();
+        benchmark::DoNotOptimize(price + quantity + static_cast<int64_t>(id) + time + maker);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes"] = static_cast<double>(json.size());
+}
+BENCHMARK(BM_TradeDecodeJson);
+
+void BM_TradeDecodeBinary(benchmark::State& state) {
+    md::Trade trade{};
+    trade.trade_id = 3456789012;
+    trade.price = 6701234000000;
+    trade.quantity = 1500000;
+    std::string frame;
+    md::encode(frame, trade);
+    for (auto _ : state) {
+        md::View<md::Trade> view;
+        view.wrap(frame);
+        md::Trade decoded = view.block();
+        benchmark::DoNotOptimize(decoded.price + decoded.quantity + static_cast<int64_t>(decoded.trade_id) +
+                                 decoded.exchange_ns);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes"] = static_cast<double>(frame.size());
+}
+BENCHMARK(BM_TradeDecodeBinary);
+
+}  // namespace
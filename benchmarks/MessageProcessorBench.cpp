@@ -0,0 +1,128 @@
+#include <benchmark/benchmark.h>
+#include "../Deduplicator.h"
+#include "../MessageProcessor.h"
+#include "../OrderbookManager.h"
+#include <simdjson.h>
+#include <boost/asio.hpp>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The per-message path from payload to book, in pieces and whole:
+//   decode:    simdjson parse of a combined-stream depth diff with `levels` levels per
+//              side, walking the levels and converting prices and quantities the way
+//              OrderbookManager does
+//   dedup:     Deduplicator::is_duplicate on fresh payloads (unique) and on the one
+//              most recently seen (repeat)
+//   process:   MessageProcessor::add_message inline: dedup, parse, dispatch and apply
+//              into a synced book, each diff continuing the last one's update ID
+// Items/s is messages per second.
+
+namespace {
+
+constexpr size_t kMessages = 4096;  // more than the deduplicator remembers, so none repeat
+
+std::string depth_diff(uint64_t id, int levels) {
+    std::string msg = "{\"stream\":\"btcusdt@depth\",\"data\":{\"e\":\"depthUpdate\",\"E\":1700000000000,"
+                      "\"s\":\"BTCUSDT\",\"U\":" + std::to_string(id) + ",\"u\":" + std::to_string(id) + ",\"b\":[";
+    for (int level = 0; level < levels; ++level) {
+        msg += (level ? "," : "") + std::string("[\"") + std::to_string(30000.0 - level - (id % 7) * 0.01) +
+               "\",\"" + std::to_string((id + level) % 4) + "\"]";
+    }
+    msg += "],\"a\":[";
+    for (int level = 0; level < levels; ++level) {
+        msg += (level ? "," : "") + std::string("[\"") + std::to_string(30001.0 + level + (id % 7) * 0.01) +
+               "\",\"" + std::to_string((id + level) % 3) + "\"]";
+    }
+    return msg + "]}}";
+}
+
+std::vector<std::string> depth_diffs(int levels) {
+    std::vector<std::string> diffs;
+    for (uint64_t id = 1; id <= kMessages; ++id) {
+        diffs.push_back(depth_diff(id, levels));
+    }
+    return diffs;
+}
+
+double walk_levels(const simdjson::dom::element& data, const char* key) {
+    double sum = 0;
+    simdjson::dom::array levels;
+    if (data[key].get(levels)) {
+        return sum;
+    }
+    for (auto level : levels) {
+        std::string_view price, quantity;
+        simdjson::dom::array pair;
+        if (!level.get(pair) && !pair.at(0).get(price) && !pair.at(1).get(quantity)) {
+            double p = 0, q = 0;
+            std::from_chars(price.data(), price.data() + price.size(), p);
+            std::from_chars(quantity.data(), quantity.data() + quantity.size(), q);
+            sum += p * q;
+        }
+    }
+    return sum;
+}
+
+void BM_JsonDecode(benchmark::State& state) {
+    const auto diffs = depth_diffs(static_cast<int>(state.range(0)));
+    simdjson::dom::parser parser;
+    size_t n = 0;
+    int64_t bytes = 0;
+    for (auto _ : state) {
+        const std::string& msg = diffs[n++ % kMessages];
+        simdjson::dom::element data = parser.parse(msg)["data"];
+        benchmark::DoNotOptimize(walk_levels(data, "b") + walk_levels(data, "a"));
+        bytes += static_cast<int64_t>(msg.size());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(bytes);
+}
+
+void BM_Deduplicate(benchmark::State& state) {
+    const bool repeat = state.range(0) != 0;
+    const auto diffs = depth_diffs(5);
+    Deduplicator deduplicator(100000, 1000);  // MessageProcessor's sizes
+    size_t n = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(deduplicator.is_duplicate(diffs[repeat ? 0 : n++ % kMessages]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ProcessMessage(benchmark::State& state) {
+    const int levels = static_cast<int>(state.range(0));
+    boost::asio::io_context unused;
+    OrderbookManager books(1);
+    MessageProcessor processor(unused, books);
+    processor.set_inline(true);
+    processor.add_message(false, "{\"lastUpdateId\":0,\"bids\":[],\"asks\":[]}", "btcusdt");
+
+    // Update IDs keep increasing across batches, so every diff continues the book
+    std::vector<std::string> diffs;
+    size_t n = kMessages;
+    uint64_t next_id = 1;
+    for (auto _ : state) {
+        if (n == kMessages) {
+            state.PauseTiming();
+            diffs.clear();
+            for (size_t i = 0; i < kMessages; ++i) {
+                diffs.push_back(depth_diff(next_id++, levels));
+            }
+            n = 0;
+            state.ResumeTiming();
+        }
+        processor.add_message(true, std::move(diffs[n++]), "btcusdt");
+    }
+    if (!books.isSynced("btcusdt")) {
+        state.SkipWithError("book lost sync");
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_JsonDecode)->Arg(5)->Arg(20)->Arg(100)->ArgName("levels");
+BENCHMARK(BM_Deduplicate)->Arg(0)->Arg(1)->ArgName("repeat");
+BENCHMARK(BM_ProcessMessage)->Arg(5)->Arg(20)->Arg(100)->ArgName("levels");
@@ -0,0 +1,130 @@
+#include <benchmark/benchmark.h>
+#include "../OrderbookManager.h"
+#include <simdjson.h>
+#include <string>
+#include <vector>
+
+// Book maintenance without the feed in front of it:
+//   apply:    OnOrderbookWs with a pre-parsed 10-level diff against a book `depth` levels
+//             deep per side. Diffs carry no update IDs, so they go straight to
+//             updateOrderbook. mix 0 changes quantities at existing prices; mix 1
+//             alternately inserts ten prices between existing levels and deletes them
+//             again, so levels shift inside the vectors.
+//   snapshot: getOrderbookSnapshot of a 1000-level book; up to 20 levels comes from the
+//             published view, deeper ones lock the book.
+//   all books: 100 symbols on the default 16 shards, either one getOrderbookSnapshot
+//             per symbol or one getSnapshots into a reused BookBatch. Items/s is books
+//             per second, so the two compare per book; levels/s is levels copied.
+// Items/s is diffs applied or snapshots formatted per second.
+
+namespace {
+
+constexpr int kDiffLevels = 10;
+constexpr size_t kDiffs = 64;  // even, so every insert is followed by its delete
+
+// count levels from start, step apart in price and quantity_step apart in quantity
+std::string levels(int count, double start, double step, double quantity, double quantity_step = 0.0) {
+    std::string out = "[";
+    for (int i = 0; i < count; ++i) {
+        out += (i ? ",[\"" : "[\"") + std::to_string(start + step * i) + "\",\"" +
+               std::to_string(quantity + quantity_step * i) + "\"]";
+    }
+    return out + "]";
+}
+
+std::string book_snapshot(int depth) {
+    return "{\"lastUpdateId\":1,\"bids\":" + levels(depth, 10000.0, -1.0, 1.0) + ",\"asks\":" +
+           levels(depth, 10001.0, 1.0, 1.0) + "}";
+}
+
+std::string diff(size_t n, int mix) {
+    if (mix == 0) {
+        double quantity = 1.0 + static_cast<double>(n % 5);
+        return "{\"b\":" + levels(kDiffLevels, 10000.0, -1.0, quantity, 0.25) + ",\"a\":" +
+               levels(kDiffLevels, 10001.0, 1.0, quantity, 0.25) + "}";
+    }
+    // Insert on even diffs, delete the same prices on odd ones
+    double quantity = n % 2 == 0 ? 2.0 : 0.0;
+    return "{\"b\":" + levels(kDiffLevels, 9999.5, -1.0, quantity) + ",\"a\":" +
+           levels(kDiffLevels, 10001.5, 1.0, quantity) + "}";
+}
+
+void BM_ApplyDiff(benchmark::State& state) {
+    const int depth = static_cast<int>(state.range(0));
+    const int mix = static_cast<int>(state.range(1));
+    OrderbookManager books(1);
+    simdjson::dom::parser snapshot_parser;
+    books.OnOrderbookRest("btcusdt", snapshot_parser.parse(book_snapshot(depth)));
+
+    // One parser per diff: an element is only valid while its parser holds the document
+    std::vector<simdjson::dom::parser> parsers(kDiffs);
+    std::vector<simdjson::dom::element> diffs;
+    for (size_t n = 0; n < kDiffs; ++n) {
+        diffs.push_back(parsers[n].parse(diff(n, mix)));
+    }
+
+    size_t n = 0;
+    for (auto _ : state) {
+        books.OnOrderbookWs("btcusdt", diffs[n++ % kDiffs]);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_Snapshot(benchmark::State& state) {
+    const int depth = static_cast<int>(state.range(0));
+    OrderbookManager books(1);
+    simdjson::dom::parser parser;
+    books.OnOrderbookRest("btcusdt", parser.parse(book_snapshot(1000)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(books.getOrderbookSnapshot("btcusdt", depth));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+constexpr int kBatchSymbols = 100;
+
+std::vector<std::string> load_books(OrderbookManager& books) {
+    std::vector<std::string> symbols;
+    simdjson::dom::parser parser;
+    const std::string snapshot = book_snapshot(100);
+    for (int i = 0; i < kBatchSymbols; ++i) {
+        symbols.push_back("sym" + std::to_string(i) + "usdt");
+        books.OnOrderbookRest(symbols.back(), parser.parse(snapshot));
+    }
+    return symbols;
+}
+
+void BM_AllBooksOneByOne(benchmark::State& state) {
+    const int depth = static_cast<int>(state.range(0));
+    OrderbookManager books;
+    const std::vector<std::string> symbols = load_books(books);
+    for (auto _ : state) {
+        for (const auto& symbol : symbols) {
+            benchmark::DoNotOptimize(books.getOrderbookSnapshot(symbol, depth));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBatchSymbols);
+    state.counters["levels"] = benchmark::Counter(static_cast<double>(state.iterations() * kBatchSymbols * depth * 2),
+                                                  benchmark::Counter::kIsRate);
+}
+
+void BM_AllBooksBatch(benchmark::State& state) {
+    const int depth = static_cast<int>(state.range(0));
+    OrderbookManager books;
+    const std::vector<std::string> symbols = load_books(books);
+    BookBatch batch;
+    for (auto _ : state) {
+        books.getSnapshots(symbols, depth, batch);
+        benchmark::DoNotOptimize(batch.levels.data());
+    }
+    state.SetItemsProcessed(state.iterations() * kBatchSymbols);
+    state.counters["levels"] = benchmark::Counter(static_cast<double>(state.iterations() * batch.levels.size()),
+                                                  benchmark::Counter::kIsRate);
+}
+
+}  // namespace
+
+BENCHMARK(BM_ApplyDiff)->ArgsProduct({{20, 100, 1000}, {0, 1}})->ArgNames({"depth", "mix"});
+BENCHMARK(BM_Snapshot)->Arg(5)->Arg(20)->Arg(100)->ArgName("depth");
+BENCHMARK(BM_AllBooksOneByOne)->Arg(5)->Arg(20)->Arg(100)->ArgName("depth");
+BENCHMARK(BM_AllBooksBatch)->Arg(5)->Arg(20)->Arg(100)->ArgName("depth");
@@ -0,0 +1,97 @@
+#include <benchmark/benchmark.h>
+#include "../LockFreePriorityQueue.h"
+#include "../LockFreeQueue.h"
+#include "../Task.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// The queues between feed threads and loops:
+//   single:  push then pop on one thread, the uncontended cost of an operation pair
+//   handoff: `producers` threads push while this thread pops everything, the
+//            MessageProcessor queue and EventLoop lane pattern
+// Items/s is items through the queue per second.
+
+namespace {
+
+constexpr int kHandoffItems = 200000;  // per producer
+
+void BM_LockFreeQueueSingle(benchmark::State& state) {
+    LockFreeQueue<int> queue;
+    int value = 0;
+    for (auto _ : state) {
+        queue.push(value);
+        queue.pop(value);
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_LockFreeQueueHandoff(benchmark::State& state) {
+    const int producers = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        LockFreeQueue<int> queue;
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&queue]() {
+                for (int i = 0; i < kHandoffItems; ++i) {
+                    queue.push(i);
+                }
+            });
+        }
+        int value;
+        for (int received = 0; received < producers * kHandoffItems;) {
+            received += queue.pop(value) ? 1 : 0;
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * producers * kHandoffItems);
+}
+
+void BM_PriorityQueueSingle(benchmark::State& state) {
+    LockFreePriorityQueue<Task> queue(1024);
+    Task task;
+    size_t lane = 0;
+    for (auto _ : state) {
+        queue.push([]() {}, lane);
+        queue.pop(lane, task);
+        lane = (lane + 1) % queue.lane_count;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_PriorityQueueHandoff(benchmark::State& state) {
+    const int producers = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        LockFreePriorityQueue<Task> queue(1024);
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&queue, p]() {
+                for (int i = 0; i < kHandoffItems; ++i) {
+                    queue.push([]() {}, static_cast<size_t>(p) % queue.lane_count);
+                }
+            });
+        }
+        Task task;
+        for (int received = 0; received < producers * kHandoffItems;) {
+            for (size_t lane = 0; lane < queue.lane_count; ++lane) {
+                received += queue.pop(lane, task) ? 1 : 0;
+            }
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * producers * kHandoffItems);
+}
+
+}  // namespace
+
+BENCHMARK(BM_LockFreeQueueSingle);
+BENCHMARK(BM_LockFreeQueueHandoff)->Arg(1)->Arg(2)->Arg(4)->ArgName("producers")
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_PriorityQueueSingle);
+BENCHMARK(BM_PriorityQueueHandoff)->Arg(1)->Arg(2)->Arg(4)->ArgName("producers")
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+#include "../CaptureJournal.h"
+#include "../ReplayEngine.h"
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+// End-to-end offline replay: CaptureReader, MessageProcessor and OrderbookManager over a
+// multi-symbol capture, as fast as possible, inline and on 1, 2 and 4 shards. Set
+// REPLAY_CAPTURE to a directory written by --capture to run it on recorded traffic;
+// otherwise a synthetic capture is written once to the temp directory. Items/s is
+// records replayed per second; the counters are the apply stage's percentiles.
+
+namespace {
+
+constexpr int kSymbols = 16;
+constexpr int kDiffsPerSymbol = 5000;
+
+std::string synthetic_capture() {
+    static const std::string directory = []() {
+        std::string dir = (std::filesystem::temp_directory_path() / "replay_bench_capture").string();
+        std::filesystem::remove_all(dir);
+        CaptureConfig config;
+        config.directory = dir;
+        config.segment_size = 256 * 1024 * 1024;
+        CaptureJournal journal(config);
+        uint32_t connection = journal.register_connection();
+        int64_t now = CaptureJournal::now_ns();
+        for (int s = 0; s < kSymbols; ++s) {
+            std::string symbol = "sym" + std::to_string(s) + "usdt";
+            journal.append(CaptureSource::Rest, connection, journal.symbol_id(symbol), ++now,
+                           "{\"lastUpdateId\":0,\"s\":\"" + symbol + "\",\"bids\":[],\"asks\":[]}");
+        }
+        for (int id = 1; id <= kDiffsPerSymbol; ++id) {
+            for (int s = 0; s < kSymbols; ++s) {
+                std::string symbol = "sym" + std::to_string(s) + "usdt";
+                std::string msg = "{\"stream\":\"" + symbol + "@depth\",\"data\":{\"e\":\"depthUpdate\",\"s\":\"" +
+                                  symbol + "\",\"U\":" + std::to_string(id) + ",\"u\":" + std::to_string(id) +
+                                  ",\"b\":[";
+                for (int level = 0; level < 5; ++level) {
+                    msg += (level ? "," : "") + std::string("[\"") + std::to_string(100 - level - (id % 7) * 0.01) +
+                           "\",\"" + std::to_string((id + level) % 4) + "\"]";
+                }
+                msg += "],\"a\":[";
+                for (int level = 0; level < 5; ++level) {
+                    msg += (level ? "," : "") + std::string("[\"") + std::to_string(101 + level + (id % 7) * 0.01) +
+                           "\",\"" + std::to_string((id + level) % 3) + "\"]";
+                }
+                journal.append(CaptureSource::WebSocket, connection, 0, now += 1000, msg + "]}}");
+            }
+        }
+        return dir;
+    }();
+    return directory;
+}
+
+void BM_Replay(benchmark::State& state) {
+    ReplayConfig config;
+    const char* recorded = std::getenv("REPLAY_CAPTURE");
+    config.directory = recorded ? recorded : synthetic_capture();
+    config.shards = static_cast<size_t>(state.range(0));
+    ReplayReport report;
+    for (auto _ : state) {
+        report = ReplayEngine(config).run();
+        state.SetIterationTime(report.seconds);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(report.records));
+    state.counters["apply_p50_ns"] = static_cast<double>(report.apply.p50_ns);
+    state.counters["apply_p99_ns"] = static_cast<double>(report.apply.p99_ns);
+}
+
+}  // namespace
+
+BENCHMARK(BM_Replay)->Arg(0)->Arg(1)->Arg(2)->Arg(4)->ArgName("shards")
+    ->Unit(benchmark::kMillisecond)->UseManualTime();
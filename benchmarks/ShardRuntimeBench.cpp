@@ -0,0 +1,185 @@
+#include <benchmark/benchmark.h>
+#include "../EventLoop.h"
+#include "../MessageProcessor.h"
+#include "../OrderbookManager.h"
+#include "../ShardRuntime.h"
+#include "../SymbolRouter.h"
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Multi-symbol depth-diff replay through both runtime layouts, `loops` threads each:
+//   shared: one feeder thread per connection loop calls MessageProcessor::add_message,
+//           which routes through SymbolRouter to the processing loops and one shared
+//           OrderbookManager (what websocketpp handler threads do today)
+//   shard:  each shard replays its own symbols on its own loop, parsing and applying
+//           inline into its own OrderbookManager
+// Items/s is diffs applied per second; setup and snapshot sync are not timed.
+
+namespace {
+
+constexpr int kSymbols = 32;
+constexpr uint64_t kDiffsPerSymbol = 2000;
+
+std::string symbol_name(int i) {
+    return "sym" + std::to_string(i) + "usdt";
+}
+
+// Each diff moves a handful of levels near the top of the book
+std::vector<std::string> depth_diffs(const std::string& symbol) {
+    std::vector<std::string> diffs;
+    diffs.reserve(kDiffsPerSymbol);
+    for (uint64_t id = 1; id <= kDiffsPerSymbol; ++id) {
+        std::string msg = "{\"e\":\"depthUpdate\",\"s\":\"" + symbol + "\",\"U\":" + std::to_string(id) +
+                          ",\"u\":" + std::to_string(id) + ",\"b\":[";
+        for (int level = 0; level < 5; ++level) {
+            msg += (level ? "," : "") + std::string("[\"") + std::to_string(100 - level - (id % 7) * 0.01) +
+                   "\",\"" + std::to_string((id + level) % 4) + "\"]";
+        }
+        msg += "],\"a\":[";
+        for (int level = 0; level < 5; ++level) {
+            msg += (level ? "," : "") + std::string("[\"") + std::to_string(101 + level + (id % 7) * 0.01) +
+                   "\",\"" + std::to_string((id + level) % 3) + "\"]";
+        }
+        diffs.push_back(msg + "]}");
+    }
+    return diffs;
+}
+
+const std::vector<std::vector<std::string>>& replay() {
+    static const auto diffs = []() {
+        std::vector<std::vector<std::string>> all;
+        for (int i = 0; i < kSymbols; ++i) {
+            all.push_back(depth_diffs(symbol_name(i)));
+        }
+        return all;
+    }();
+    return diffs;
+}
+
+// Distinct per symbol, or the deduplicator drops all but the first
+std::string empty_snapshot(const std::string& symbol) {
+    return "{\"lastUpdateId\":0,\"s\":\"" + symbol + "\",\"bids\":[],\"asks\":[]}";
+}
+
+bool caught_up(const OrderbookManager& books, const std::vector<std::string>& symbols) {
+    for (const auto& symbol : symbols) {
+        if (books.getLastUpdateId(symbol) < kDiffsPerSymbol) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BM_SharedQueueReplay(benchmark::State& state) {
+    const size_t loops = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        boost::asio::io_context unused;
+        OrderbookManager books;
+        MessageProcessor processor(unused, books);
+        EventLoopPool pool(loops, WaitConfig{WaitStrategy::Adaptive});
+        SymbolRouter router(pool);
+        processor.set_router(&router);
+        pool.run();
+        std::vector<std::string> symbols;
+        for (int i = 0; i < kSymbols; ++i) {
+            symbols.push_back(symbol_name(i));
+            processor.add_message(false, empty_snapshot(symbols.back()), symbols.back());
+        }
+        for (const auto& symbol : symbols) {
+            while (!books.isSynced(symbol)) {
+                std::this_thread::yield();
+            }
+        }
+        auto copies = replay();
+        state.ResumeTiming();
+
+        std::vector<std::thread> feeders;
+        for (size_t f = 0; f < loops; ++f) {
+            feeders.emplace_back([&, f]() {
+                for (uint64_t n = 0; n < kDiffsPerSymbol; ++n) {
+                    for (size_t s = f; s < symbols.size(); s += loops) {
+                        processor.add_message(true, std::move(copies[s][n]), symbols[s]);
+                    }
+                }
+            });
+        }
+        for (auto& feeder : feeders) {
+            feeder.join();
+        }
+        while (!caught_up(books, symbols)) {
+            std::this_thread::yield();
+        }
+
+        state.PauseTiming();
+        pool.stop();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * kSymbols * static_cast<int64_t>(kDiffsPerSymbol));
+}
+
+void BM_ShardPerCoreReplay(benchmark::State& state) {
+    const size_t shards = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        ShardRuntime runtime(shards);
+        std::vector<std::unique_ptr<OrderbookManager>> books;
+        std::vector<std::unique_ptr<MessageProcessor>> processors;
+        for (size_t i = 0; i < shards; ++i) {
+            books.push_back(std::make_unique<OrderbookManager>(1));
+            processors.push_back(std::make_unique<MessageProcessor>(runtime.loop(i).get_io_context(), *books.back()));
+            processors.back()->set_inline(true);
+        }
+        runtime.run();
+        std::vector<std::string> symbols;
+        std::vector<std::vector<size_t>> owned(shards);
+        for (int i = 0; i < kSymbols; ++i) {
+            symbols.push_back(symbol_name(i));
+            size_t shard = runtime.assign(symbols.back());
+            owned[shard].push_back(static_cast<size_t>(i));
+            runtime.call(shard, [&, shard, i]() {
+                processors[shard]->add_message(false, empty_snapshot(symbols[i]), symbols[i]);
+            }).get();
+        }
+        auto copies = replay();
+        state.ResumeTiming();
+
+        std::vector<std::future<void>> done;
+        for (size_t shard = 0; shard < shards; ++shard) {
+            done.push_back(runtime.call(shard, [&, shard]() {
+                for (uint64_t n = 0; n < kDiffsPerSymbol; ++n) {
+                    for (size_t s : owned[shard]) {
+                        processors[shard]->add_message(true, std::move(copies[s][n]), symbols[s]);
+                    }
+                }
+            }));
+        }
+        for (auto& shard_done : done) {
+            shard_done.get();
+        }
+
+        state.PauseTiming();
+        for (size_t shard = 0; shard < shards; ++shard) {
+            std::vector<std::string> mine;
+            for (size_t s : owned[shard]) {
+                mine.push_back(symbols[s]);
+            }
+            if (!caught_up(*books[shard], mine)) {
+                state.SkipWithError("shard fell behind its replay");
+            }
+        }
+        runtime.stop();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * kSymbols * static_cast<int64_t>(kDiffsPerSymbol));
+}
+
+}  // namespace
+
+BENCHMARK(BM_SharedQueueReplay)->Arg(1)->Arg(2)->Arg(4)->ArgName("loops")
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ShardPerCoreReplay)->Arg(1)->Arg(2)->Arg(4)->ArgName("loops")
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
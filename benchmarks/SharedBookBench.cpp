@@ -0,0 +1,65 @@
+#include <benchmark/benchmark.h>
+#include "../SharedBookPublisher.h"
+#include "../SharedBookReader.h"
+#include <string>
+#include <unistd.h>
+
+// Shared-memory book publication:
+//   publish:   the writer's cost per book change, added to every publishView
+//   read/bbo:  a reader's consistent copy of the top 20 levels, or just the best bid
+//              and ask, with no concurrent writer (the retry-free path)
+// Readers in other processes map the same pages, so these are also their costs.
+
+namespace {
+
+const std::string kRegion = "/shared_book_bench_" + std::to_string(getpid());
+
+Orderbook full_book() {
+    Orderbook book;
+    book.last_update_id = 1;
+    for (int i = 0; i < 100; ++i) {
+        book.bids.push_back(PriceLevel{100.0 - i * 0.01, 1.0 + i});
+        book.asks.push_back(PriceLevel{100.01 + i * 0.01, 1.0 + i});
+    }
+    return book;
+}
+
+void BM_SharedBookPublish(benchmark::State& state) {
+    SharedBookPublisher publisher(kRegion, 1);
+    uint32_t slot = publisher.slot_for("btcusdt");
+    Orderbook book = full_book();
+    for (auto _ : state) {
+        ++book.last_update_id;
+        publisher.publish(slot, book);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SharedBookPublish);
+
+void BM_SharedBookRead(benchmark::State& state) {
+    SharedBookPublisher publisher(kRegion, 1);
+    publisher.publish(publisher.slot_for("btcusdt"), full_book());
+    SharedBookReader reader(kRegion);
+    shared_book::Top top;
+    for (auto _ : state) {
+        reader.read(0, top);
+        benchmark::DoNotOptimize(top);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SharedBookRead);
+
+void BM_SharedBookReadBbo(benchmark::State& state) {
+    SharedBookPublisher publisher(kRegion, 1);
+    publisher.publish(publisher.slot_for("btcusdt"), full_book());
+    SharedBookReader reader(kRegion);
+    md::Bbo bbo;
+    for (auto _ : state) {
+        reader.read_bbo(0, bbo);
+        benchmark::DoNotOptimize(bbo);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SharedBookReadBbo);
+
+}  // namespace
@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+#include "../ThreadPool.h"
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+// Fork-join scaling of WorkStealingThreadPool: a recursive reduction over a vector,
+// split down to leaves of kLeaf elements, with a transcendental per element so the
+// leaves are compute-bound. Compare items/s across thread counts; 0 threads is the
+// sequential baseline.
+
+namespace {
+
+constexpr size_t kElements = 1 << 22;
+constexpr size_t kLeaf = 4096;
+
+double leaf_sum(const std::vector<double>& values, size_t begin, size_t end) {
+    double sum = 0.0;
+    for (size_t i = begin; i < end; ++i) {
+        sum += std::sqrt(values[i]) * std::log1p(values[i]);
+    }
+    return sum;
+}
+
+double fork_join_sum(WorkStealingThreadPool& pool, const std::vector<double>& values, size_t begin, size_t end) {
+    if (end - begin <= kLeaf) {
+        return leaf_sum(values, begin, end);
+    }
+    size_t mid = begin + (end - begin) / 2;
+    auto left = pool.enqueue(fork_join_sum, std::ref(pool), std::cref(values), begin, mid);
+    double right = fork_join_sum(pool, values, mid, end);
+    return pool.wait(left) + right;
+}
+
+void BM_ForkJoinSum(benchmark::State& state) {
+    std::vector<double> values(kElements);
+    std::iota(values.begin(), values.end(), 1.0);
+    const size_t threads = static_cast<size_t>(state.range(0));
+
+    if (threads == 0) {
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(leaf_sum(values, 0, values.size()));
+        }
+    } else {
+        WorkStealingThreadPool pool(threads);
+        for (auto _ : state) {
+            auto result = pool.enqueue(fork_join_sum, std::ref(pool), std::cref(values), size_t{0}, values.size());
+            benchmark::DoNotOptimize(result.get());
+        }
+        state.counters["steals"] = benchmark::Counter(static_cast<double>(pool.steals()),
+                                                      benchmark::Counter::kAvgIterations);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kElements));
+}
+
+}  // namespace
+
+BENCHMARK(BM_ForkJoinSum)->Arg(0)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->ArgName("threads")
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
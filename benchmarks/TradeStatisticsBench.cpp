@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+#include "../TradeStatistics.h"
+#include <string>
+#include <vector>
+
+// Rolling trade statistics under a burst: state.range(0) symbols each take a trade in
+// turn, several per millisecond, so the 100ms, 1s and 1min buckets keep rolling over.
+// Per trade the cost should not depend on the symbol count or how long the burst runs,
+// and reading a symbol's windows should cost about as much as one trade.
+
+namespace {
+
+std::vector<std::string> symbols(int64_t count) {
+    std::vector<std::string> names;
+    for (int64_t i = 0; i < count; ++i) {
+        names.push_back("sym" + std::to_string(i) + "usdt");
+    }
+    return names;
+}
+
+void BM_TradeBurst(benchmark::State& state) {
+    const std::vector<std::string> names = symbols(state.range(0));
+    TradeStatistics stats;
+    uint64_t id = 0;
+    int64_t time_ms = 1700000000000;
+    size_t next = 0;
+    for (auto _ : state) {
+        ++id;
+        time_ms += id % 4 == 0;  // four trades per millisecond across all symbols
+        benchmark::DoNotOptimize(stats.on_trade(names[next], id, 100.0 + static_cast<double>(id % 13) * 0.01, 0.5, time_ms));
+        next = next + 1 == names.size() ? 0 : next + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TradeBurst)->Arg(1)->Arg(100)->Arg(1000);
+
+void BM_TradeStatsRead(benchmark::State& state) {
+    const std::vector<std::string> names = symbols(state.range(0));
+    TradeStatistics stats;
+    uint64_t id = 0;
+    int64_t time_ms = 1700000000000;
+    for (int round = 0; round < 100; ++round, time_ms += 50) {
+        for (const auto& name : names) {
+            stats.on_trade(name, ++id, 100.0, 1.0, time_ms);
+        }
+    }
+    size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(stats.get(names[next], time_ms));
+        next = next + 1 == names.size() ? 0 : next + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TradeStatsRead)->Arg(1)->Arg(1000);
+
+}  // namespace
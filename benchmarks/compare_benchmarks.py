@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""Compares two Google Benchmark JSON files written by run_benchmarks.sh.
+
+Usage: compare_benchmarks.py baseline.json contender.json [--metric median] [--threshold 5]
+
+Benchmarks are matched by name and compared on real time per iteration, normalized to
+nanoseconds, using the chosen aggregate (median by default, which ignores a noisy
+repetition) or the mean of the plain runs when the file has no aggregates. A change is
+reported as a regression or improvement only when it exceeds the threshold (percent)
+and the two results differ by more than their standard deviations combined. Exits 1 if
+any benchmark regressed, so it can gate CI.
+"""
+
+import argparse
+import json
+import sys
+
+UNIT_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path, metric):
+    with open(path) as f:
+        data = json.load(f)
+    times, stddevs, plain = {}, {}, {}
+    for bench in data.get("benchmarks", []):
+        if bench.get("error_occurred"):
+            continue
+        name = bench.get("run_name", bench["name"])
+        ns = bench["real_time"] * UNIT_NS[bench.get("time_unit", "ns")]
+        if bench.get("run_type") == "aggregate":
+            if bench.get("aggregate_name") == metric:
+                times[name] = ns
+            elif bench.get("aggregate_name") == "stddev":
+                stddevs[name] = ns
+        else:
+            plain.setdefault(name, []).append(ns)
+    for name, samples in plain.items():
+        times.setdefault(name, sum(samples) / len(samples))
+    return data.get("context", {}), times, stddevs
+
+
+def format_ns(ns):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return f"{ns / scale:.2f} {unit}"
+    return f"{ns:.1f} ns"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("contender")
+    parser.add_argument("--metric", default="median", choices=["median", "mean"])
+    parser.add_argument("--threshold", type=float, default=5.0, help="percent change to report")
+    args = parser.parse_args()
+
+    base_context, base, base_dev = load(args.baseline, args.metric)
+    new_context, new, new_dev = load(args.contender, args.metric)
+    for key in ("cpus", "num_cpus", "mhz_per_cpu", "library_build_type"):
+        if base_context.get(key) != new_context.get(key):
+            print(f"warning: {key} differs: {base_context.get(key)} vs {new_context.get(key)}", file=sys.stderr)
+
+    names = [name for name in base if name in new]
+    width = max([len(name) for name in names] + [9])
+    print(f"{'Benchmark':<{width}}  {'Baseline':>11}  {'Contender':>11}  {'Change':>8}")
+    regressions = 0
+    for name in names:
+        before, after = base[name], new[name]
+        change = (after - before) / before * 100.0 if before else 0.0
+        noise = base_dev.get(name, 0.0) + new_dev.get(name, 0.0)
+        verdict = ""
+        if abs(change) > args.threshold and abs(after - before) > noise:
+            verdict = "  regression" if change > 0 else "  improvement"
+            regressions += change > 0
+        print(f"{name:<{width}}  {format_ns(before):>11}  {format_ns(after):>11}  {change:>+7.1f}%{verdict}")
+
+    for name in sorted(set(base) ^ set(new)):
+        print(f"{name:<{width}}  only in {'baseline' if name in base else 'contender'}")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,52 @@
+#!/usr/bin/env bash
+# Runs the benchmark suite pinned to a fixed CPU set and writes Google Benchmark JSON,
+# named after the checked-out commit, for compare_benchmarks.py.
+#
+# Usage: benchmarks/run_benchmarks.sh [build_dir] [benchmark flags...]
+#   BENCH_CPUS         CPUs to pin to, as a taskset list. Defaults to 2,3 (clear of CPU 0,
+#                      where most interrupts land) on machines with four or more CPUs.
+#                      Use the same list for every run you intend to compare.
+#   BENCH_REPETITIONS  repetitions per benchmark, reported as mean/median/stddev (5)
+#   BENCH_OUT          output file (bench-<commit>.json)
+#
+# Example: benchmarks/run_benchmarks.sh build --benchmark_filter='ApplyDiff|JsonDecode'
+set -euo pipefail
+
+build_dir=${1:-build}
+[[ $# -gt 0 ]] && shift
+binary="$build_dir/benchmarks/benchmarks"
+if [[ ! -x $binary ]]; then
+    echo "No benchmark binary at $binary; build the 'benchmarks' target first" >&2
+    exit 1
+fi
+
+if [[ -z ${BENCH_CPUS:-} ]]; then
+    if (( $(nproc --all) >= 4 )); then
+        BENCH_CPUS=2,3
+    else
+        BENCH_CPUS=0-$(( $(nproc --all) - 1 ))
+        echo "Fewer than 4 CPUs: pinning to $BENCH_CPUS, results are noisier" >&2
+    fi
+fi
+if ! taskset -c "$BENCH_CPUS" true 2>/dev/null; then
+    echo "Cannot pin to CPUs $BENCH_CPUS; set BENCH_CPUS to CPUs this process may use" >&2
+    exit 1
+fi
+
+governor=/sys/devices/system/cpu/cpu${BENCH_CPUS%%[,-]*}/cpufreq/scaling_governor
+if [[ -r $governor && $(cat "$governor") != performance ]]; then
+    echo "CPU frequency governor is $(cat "$governor"), not performance; expect run-to-run drift" >&2
+fi
+
+commit=$(git -C "$(dirname "$0")/.." rev-parse --short HEAD 2>/dev/null || echo unknown)
+out=${BENCH_OUT:-bench-$commit.json}
+
+taskset -c "$BENCH_CPUS" "$binary" \
+    --benchmark_out="$out" \
+    --benchmark_out_format=json \
+    --benchmark_repetitions="${BENCH_REPETITIONS:-5}" \
+    --benchmark_report_aggregates_only=true \
+    --benchmark_context=commit="$commit" \
+    --benchmark_context=cpus="$BENCH_CPUS" \
+    "$@"
+echo "Wrote $out" >&2
@@ -1,4 +1,6 @@
 #include "BinanceClient.h"
+#include "HugePageArena.h"
+#include "ReplayEngine.h"
 #include <iostream>
 #include <thread>
 #include <chrono>
@@ -19,6 +21,7 @@ void signal_handler(int signal) {
 }
 
 void process_user_input(BinanceClient& client) {
+    client.pin_housekeeping_thread();
     std::string input;
     while (running) {
         std::getline(std::cin, input);
@@ -34,6 +37,15 @@ void process_user_input(BinanceClient& client) {
             std::string symbol = input.substr(7);
             client.remove_symbol(symbol);
             std::cout << "Removed symbol: " << symbol << std::endl;
+        } else if (input.substr(0, 6) == "stats ") {
+            TradingStats stats = client.get_trading_stats(input.substr(6));
+            std::cout << "Last " << stats.last_price;
+            for (const auto& [name, window] : {std::pair{"1s", &stats.second}, std::pair{"1m", &stats.minute},
+                                               std::pair{"24h", &stats.day}}) {
+                std::cout << " | " << name << ": " << window->trades << " trades, volume " << window->volume
+                          << ", VWAP " << window->vwap << ", change " << window->price_change_percent << "%";
+            }
+            std::cout << std::endl;
         } else if (input == "list") {
             auto symbols = client.get_active_symbols();
             std::cout << "Active symbols: ";
@@ -42,7 +54,7 @@ void process_user_input(BinanceClient& client) {
             }
             std::cout << std::endl;
         } else {
-            std::cout << "Unknown command. Available commands: exit, status, add <symbol>, remove <symbol>, list" << std::endl;
+            std::cout << "Unknown command. Available commands: exit, status, add <symbol>, remove <symbol>, stats <symbol>, list" << std::endl;
         }
     }
 }
@@ -57,6 +69,7 @@ void log_to_file(const std::string& message) {
 }
 
 void market_data_thread_func(BinanceClient& client) {
+    client.pin_housekeeping_thread();
     while (running) {
         client.process_market_data();
         std::this_thread::sleep_for(std::chrono::microseconds(10));
@@ -64,24 +77,130 @@ void market_data_thread_func(BinanceClient& client) {
 }
 
 void system_monitor_thread_func(BinanceClient& client) {
+    client.pin_housekeeping_thread();
+    auto last_housekeeping = std::chrono::steady_clock::now();
     while (running) {
         client.monitor_system_health();
-        client.reconnect_failed_connections();
         client.check_load_balancing();
+        if (std::chrono::steady_clock::now() - last_housekeeping > std::chrono::minutes(1)) {
+            client.run_housekeeping();
+            last_housekeeping = std::chrono::steady_clock::now();
+        }
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
 
     std::cout << "Initializing BinanceClient..." << std::endl;
-    BinanceClient client(std::thread::hardware_concurrency());
-    
+    size_t thread_count = std::thread::hardware_concurrency();
+    RuntimeMode mode = RuntimeMode::SharedQueue;
+    bool huge_pages = false;
+    ArenaOptions arena_options;
+    std::string capture_directory;
+    bool capture_book_tops = false;
+    ReplayConfig replay;
+    ExchangeEndpoints endpoints;
+    std::string shared_books;
+    int fanout_port = -1;
+    std::string trade_stream = "aggTrade";
+    StreamTransport transport = StreamTransport::Websocketpp;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--shard-per-core") {
+            mode = RuntimeMode::ShardPerCore;
+        } else if (arg == "--huge-pages") {
+            huge_pages = true;
+        } else if (arg == "--prefault") {
+            arena_options.prefault = true;
+        } else if (arg == "--mlock") {
+            arena_options.lock = true;
+        } else if (arg == "--capture" && i + 1 < argc) {
+            capture_directory = argv[++i];
+        } else if (arg == "--capture-tops") {
+            capture_book_tops = true;
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replay.directory = argv[++i];
+        } else if (arg == "--replay-speed" && i + 1 < argc) {
+            // 0 (the default) replays as fast as possible, 1 in real time
+            replay.speed = std::stod(argv[++i]);
+            replay.pacing = replay.speed == 0.0 ? ReplayPacing::AsFastAsPossible
+                          : replay.speed == 1.0 ? ReplayPacing::RealTime : ReplayPacing::Scaled;
+        } else if (arg == "--replay-shards" && i + 1 < argc) {
+            replay.shards = std::stoul(argv[++i]);
+        } else if (arg == "--shared-books") {
+            // Optional region name, e.g. /binance_books
+            shared_books = i + 1 < argc && argv[i + 1][0] == '/' ? argv[++i] : shared_book::DEFAULT_NAME;
+        } else if (arg == "--fanout-port" && i + 1 < argc) {
+            // Local consumers connect to ws://127.0.0.1:<port>/?symbols=btcusdt
+            fanout_port = std::stoi(argv[++i]);
+        } else if (arg == "--trade-stream" && i + 1 < argc) {
+            // trade, aggTrade (the default) or none
+            trade_stream = argv[++i];
+            if (trade_stream == "none") {
+                trade_stream.clear();
+            }
+        } else if (arg == "--transport" && i + 1 < argc) {
+            // websocketpp (the default) or io_uring, which needs a ws:// --stream-base
+            transport = std::string(argv[++i]) == "io_uring" ? StreamTransport::IoUring : StreamTransport::Websocketpp;
+        } else if (arg == "--stream-base" && i + 1 < argc) {
+            // e.g. ws://127.0.0.1:9443 for a local_exchange
+            endpoints.stream_base = argv[++i];
+        } else if (arg == "--rest-endpoint" && i + 1 < argc) {
+            std::string endpoint = argv[++i];
+            size_t colon = endpoint.rfind(':');
+            endpoints.rest_host = endpoint.substr(0, colon);
+            endpoints.rest_port = colon == std::string::npos ? "443" : endpoint.substr(colon + 1);
+        }
+    }
+    if (huge_pages) {
+        // Before the client exists, so its books, rings and receive buffers land in the arenas
+        arena_options.bytes = 256 << 20;
+        HugePageArena::configure(ArenaKind::Slabs, arena_options);
+        arena_options.bytes = 32 << 20;
+        HugePageArena::configure(ArenaKind::Rings, arena_options);
+        arena_options.bytes = 64 << 20;
+        HugePageArena::configure(ArenaKind::Buffers, arena_options);
+        for (const auto& arena : HugePageArena::report()) {
+            std::cout << "Arena " << HugePageArena::kind_name(arena.kind) << ": " << (arena.reserved >> 20)
+                      << " MB of " << HugePageArena::backing_name(arena.backing)
+                      << (arena.prefaulted ? ", prefaulted" : "") << (arena.locked ? ", locked" : "") << std::endl;
+        }
+    }
+    if (!replay.directory.empty()) {
+        // Offline: feeds the capture through fresh books and exits without connecting
+        std::cout << ReplayEngine::format_report(ReplayEngine(replay).run());
+        return 0;
+    }
+    BinanceClient client(thread_count, StartupConfig(), mode);
+    client.set_endpoints(endpoints);
+    client.set_trade_stream(trade_stream);
+    client.set_stream_transport(transport);
+    if (!shared_books.empty()) {
+        client.set_shared_books(shared_books);
+    }
+    if (fanout_port >= 0) {
+        FanoutConfig fanout;
+        fanout.port = static_cast<unsigned short>(fanout_port);
+        client.set_fanout(fanout);
+    }
+    if (!capture_directory.empty()) {
+        CaptureConfig capture;
+        capture.directory = capture_directory;
+        capture.book_tops = capture_book_tops;
+        client.set_capture(capture);
+    }
+    // Event loops and the market data loop get cores of their own; this thread and the
+    // helper threads below share what is left
+    client.set_topology(TopologyConfig::automatic(client.get_cpu_topology(), thread_count));
+
     std::vector<std::string> symbols = {"btcusdt", "ethusdt", "bnbusdt", "adausdt"};
     std::cout << "Starting BinanceClient..." << std::endl;
     client.start(symbols);
+    // After start() so threads it spawns do not inherit the housekeeping mask
+    client.pin_housekeeping_thread();
 
     std::cout << "BinanceClient started. Enter commands (type 'exit' to stop):" << std::endl;
     
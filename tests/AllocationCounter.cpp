@@ -0,0 +1,52 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<bool> counting_all{false};
+thread_local bool counting_this_thread = false;
+std::atomic<uint64_t> allocations{0};
+
+}  // namespace
+
+// Replaces the global allocator for the whole unit_tests binary
+void* operator new(std::size_t size) {
+    if (counting_all.load(std::memory_order_relaxed) || counting_this_thread) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// GCC flags free() on memory from the operator new above, which is what it came from
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+uint64_t count_allocations(const std::function<void()>& fn, bool this_thread_only) {
+    allocations = 0;
+    if (this_thread_only) {
+        counting_this_thread = true;
+    } else {
+        counting_all = true;
+    }
+    fn();
+    counting_this_thread = false;
+    counting_all = false;
+    return allocations.load();
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// Heap allocations made through the global operator new while fn runs. By default every
+// thread is counted; this_thread_only ignores other threads, e.g. a server the test runs
+// alongside the code under measurement.
+uint64_t count_allocations(const std::function<void()>& fn, bool this_thread_only = false);
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include "../BinanceClient.h"
+#include "../LocalExchange.h"
+#include <chrono>
+#include <thread>
 
 TEST(BinanceClientTest, Initialization) {
     BinanceClient client(4);
@@ -18,3 +21,57 @@ TEST(BinanceClientTest, AddRemoveSymbol) {
     symbols = client.get_active_symbols();
     EXPECT_TRUE(std::find(symbols.begin(), symbols.end(), "ETHUSDT") == symbols.end());
 }
+
+TEST(BinanceClientTest, SharedModeRoutesThroughSymbolRouter) {
+    BinanceClient client(2);
+    ASSERT_NE(client.get_symbol_router(), nullptr);
+    client.start({"BTCUSDT"});
+    EXPECT_LT(client.get_symbol_router()->loop_of("btcusdt"), 2u);
+    client.stop();
+}
+
+TEST(BinanceClientTest, ShardPerCoreMode) {
+    BinanceClient client(2, StartupConfig(), RuntimeMode::ShardPerCore);
+    EXPECT_EQ(client.get_runtime_mode(), RuntimeMode::ShardPerCore);
+    EXPECT_EQ(client.get_symbol_router(), nullptr);  // only the shards are built
+    EXPECT_NO_THROW(client.start({"BTCUSDT", "ETHUSDT", "BNBUSDT"}));
+
+    EXPECT_NO_THROW(client.add_symbol("ADAUSDT"));
+    EXPECT_FALSE(client.need_load_balancing());  // placement is fixed per shard
+    EXPECT_NO_THROW(client.get_orderbook_snapshot("ADAUSDT", 5));
+    EXPECT_NO_THROW(client.remove_symbol("ADAUSDT"));
+    client.stop();
+}
+
+TEST(BinanceClientTest, ShardedBatchSnapshotsFindEverySymbolInAnyCase) {
+    LocalExchangeConfig exchange_config;
+    exchange_config.market.symbols = {"btcusdt", "ethusdt", "bnbusdt", "adausdt"};
+    exchange_config.market.messages_per_second = 10;
+    LocalExchange exchange(exchange_config);
+
+    BinanceClient client(2, StartupConfig(), RuntimeMode::ShardPerCore);
+    client.set_endpoints(exchange.endpoints());
+    client.set_trade_stream("");
+    client.start({"BTCUSDT", "ETHUSDT", "BNBUSDT", "ADAUSDT"});
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (client.get_startup_report().pending > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    ASSERT_EQ(client.get_startup_report().pending, 0u);
+
+    // Mixed case, spread over both shards, with one unknown symbol in between
+    const std::vector<std::string> request = {"ADAUSDT", "btcusdt", "XRPUSDT", "EthUsdt", "BNBUSDT"};
+    BookBatch batch;
+    for (int round = 0; round < 2; ++round) {  // the second reuses the batch
+        client.get_orderbook_snapshots(request, 5, batch);
+        ASSERT_EQ(batch.size(), request.size());
+        for (size_t i = 0; i < request.size(); ++i) {
+            EXPECT_EQ(batch.books[i].found, request[i] != "XRPUSDT") << request[i];
+            if (batch.books[i].found) {
+                EXPECT_GT(batch.books[i].bid_count, 0u);
+                EXPECT_NE(client.get_orderbook_snapshot(request[i], 5), "{}") << request[i];
+            }
+        }
+    }
+    client.stop();
+}
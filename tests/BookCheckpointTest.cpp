@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include "../BookCheckpoint.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+class BookCheckpointTest : public ::testing::Test {
+protected:
+    std::string path = "book_checkpoint_test.bin";
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+};
+
+TEST_F(BookCheckpointTest, RoundTrip) {
+    BookCheckpoint::Books books;
+    Orderbook btc;
+    btc.bids = {{100.5, 1.0}, {100.0, 2.5}};
+    btc.asks = {{101.0, 0.5}};
+    btc.last_update_id = 123456789;
+    books.emplace_back("btcusdt", btc);
+
+    Orderbook eth;
+    eth.last_update_id = 42;
+    books.emplace_back("ethusdt", eth);
+
+    BookCheckpoint::save(path, books);
+    auto restored = BookCheckpoint::load(path);
+
+    ASSERT_EQ(restored.size(), 2u);
+    EXPECT_EQ(restored[0].first, "btcusdt");
+    EXPECT_EQ(restored[0].second.last_update_id, 123456789u);
+    ASSERT_EQ(restored[0].second.bids.size(), 2u);
+    EXPECT_DOUBLE_EQ(restored[0].second.bids[1].price, 100.0);
+    EXPECT_DOUBLE_EQ(restored[0].second.bids[1].quantity, 2.5);
+    ASSERT_EQ(restored[0].second.asks.size(), 1u);
+    EXPECT_DOUBLE_EQ(restored[0].second.asks[0].price, 101.0);
+    EXPECT_EQ(restored[1].first, "ethusdt");
+    EXPECT_EQ(restored[1].second.last_update_id, 42u);
+    EXPECT_TRUE(restored[1].second.bids.empty());
+}
+
+TEST_F(BookCheckpointTest, MissingOrCorruptFileRestoresNothing) {
+    EXPECT_TRUE(BookCheckpoint::load(path).empty());
+
+    std::ofstream(path, std::ios::binary) << "definitely not a checkpoint file";
+    EXPECT_TRUE(BookCheckpoint::load(path).empty());
+}
+
+TEST_F(BookCheckpointTest, TruncatedFileIsRejected) {
+    BookCheckpoint::Books books;
+    Orderbook book;
+    book.bids = {{1.0, 1.0}, {0.5, 1.0}};
+    book.last_update_id = 7;
+    books.emplace_back("bnbusdt", book);
+    BookCheckpoint::save(path, books);
+
+    std::filesystem::resize_file(path, BookCheckpoint::encoded_size(books) - 8);
+    EXPECT_TRUE(BookCheckpoint::load(path).empty());
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include "../CaptureJournal.h"
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class CaptureJournalTest : public ::testing::Test {
+protected:
+    std::string directory = "capture_journal_test";
+
+    void SetUp() override {
+        fs::remove_all(directory);
+    }
+
+    void TearDown() override {
+        fs::remove_all(directory);
+        fs::remove_all(directory + "_copy");
+    }
+
+    CaptureConfig config(size_t segment_size) const {
+        CaptureConfig config;
+        config.directory = directory;
+        config.segment_size = segment_size;
+        config.flush_interval = std::chrono::milliseconds(1);
+        return config;
+    }
+
+    static std::string payload_for(int i) {
+        return "{\"u\":" + std::to_string(i) + ",\"b\":\"" + std::string(static_cast<size_t>(i % 97), 'x') + "\"}";
+    }
+};
+
+TEST_F(CaptureJournalTest, RecordsRoundTripAcrossSegmentRolls) {
+    constexpr int kRecords = 3000;
+    {
+        CaptureJournal journal(config(64 * 1024));
+        uint32_t ws = journal.register_connection();
+        uint32_t rest = journal.register_connection();
+        uint32_t btc = journal.symbol_id("btcusdt");
+        uint32_t eth = journal.symbol_id("ethusdt");
+        EXPECT_EQ(journal.symbol_id("btcusdt"), btc);
+        EXPECT_NE(btc, eth);
+        for (int i = 0; i < kRecords; ++i) {
+            bool snapshot = i % 100 == 0;
+            ASSERT_TRUE(journal.append(snapshot ? CaptureSource::Rest : CaptureSource::WebSocket, snapshot ? rest : ws,
+                                       i % 2 ? eth : btc, 1000 + i, payload_for(i)));
+            if (i % 100 == 0) {
+                // Gives the flusher time to replace the spare the last roll used
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+        EXPECT_EQ(journal.stats().dropped, 0u);
+    }
+
+    CaptureReader reader(directory);
+    EXPECT_GT(reader.segments().size(), 1u);
+    for (uint64_t segment : reader.segments()) {
+        EXPECT_TRUE(fs::exists(CaptureJournal::index_path(directory, segment)));
+    }
+    CaptureRecord record;
+    int n = 0;
+    for (; reader.next(record); ++n) {
+        ASSERT_LT(n, kRecords);
+        EXPECT_EQ(record.receive_ns, 1000 + n);
+        EXPECT_EQ(record.payload, payload_for(n));
+        EXPECT_EQ(record.source, n % 100 == 0 ? CaptureSource::Rest : CaptureSource::WebSocket);
+        EXPECT_EQ(reader.symbol(record.symbol_id), n % 2 ? "ethusdt" : "btcusdt");
+    }
+    EXPECT_EQ(n, kRecords);
+}
+
+TEST_F(CaptureJournalTest, ConcurrentWritersKeepTheirOrder) {
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 20000;
+    CaptureStats stats;
+    {
+        CaptureJournal journal(config(256 * 1024));
+        std::vector<std::thread> writers;
+        for (int t = 0; t < kThreads; ++t) {
+            writers.emplace_back([&journal, t]() {
+                uint32_t connection = journal.register_connection();
+                for (int i = 0; i < kPerThread; ++i) {
+                    journal.append(CaptureSource::WebSocket, connection, 0, i, std::to_string(t) + ":" + std::to_string(i));
+                }
+            });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+        stats = journal.stats();
+    }
+    EXPECT_EQ(stats.records + stats.dropped, static_cast<uint64_t>(kThreads * kPerThread));
+
+    CaptureReader reader(directory);
+    CaptureRecord record;
+    std::vector<int64_t> last(kThreads + 1, -1);
+    uint64_t read = 0;
+    while (reader.next(record)) {
+        ASSERT_LE(record.connection_id, static_cast<uint32_t>(kThreads));
+        EXPECT_GT(record.receive_ns, last[record.connection_id]);
+        last[record.connection_id] = record.receive_ns;
+        ++read;
+    }
+    EXPECT_EQ(read, stats.records);
+}
+
+TEST_F(CaptureJournalTest, UnsealedSegmentReadsUpToTheLastCompleteRecord) {
+    CaptureJournal journal(config(1024 * 1024));
+    uint32_t symbol = journal.symbol_id("bnbusdt");
+    for (int i = 0; i < 100; ++i) {
+        journal.append(CaptureSource::WebSocket, 1, symbol, i, payload_for(i));
+    }
+
+    // What a crash would leave: the live segment at its full size, never sealed
+    fs::create_directories(directory + "_copy");
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        fs::copy_file(entry.path(), fs::path(directory + "_copy") / entry.path().filename());
+    }
+    CaptureReader reader(directory + "_copy");
+    CaptureRecord record;
+    int n = 0;
+    while (reader.next(record)) {
+        EXPECT_EQ(record.payload, payload_for(n));
+        EXPECT_EQ(reader.symbol(record.symbol_id), "bnbusdt");
+        ++n;
+    }
+    EXPECT_EQ(n, 100);
+}
+
+TEST_F(CaptureJournalTest, RetentionDeletesTheOldestSegments) {
+    CaptureConfig retained = config(64 * 1024);
+    retained.max_segments = 2;
+    {
+        CaptureJournal journal(retained);
+        for (int i = 0; i < 5000; ++i) {
+            journal.append(CaptureSource::WebSocket, 1, 0, i, payload_for(i));
+            if (i % 100 == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+        EXPECT_GT(journal.stats().segments_deleted, 0u);
+    }
+    CaptureReader reader(directory);
+    EXPECT_EQ(reader.segments().size(), 2u);
+    CaptureRecord record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_GT(record.receive_ns, 0);  // the first records went with the deleted segments
+}
+
+TEST_F(CaptureJournalTest, OversizedRecordsAreDroppedNotWritten) {
+    CaptureJournal journal(config(64 * 1024));
+    EXPECT_FALSE(journal.append(CaptureSource::Rest, 1, 0, 0, std::string(128 * 1024, 'x')));
+    EXPECT_TRUE(journal.append(CaptureSource::Rest, 1, 0, 0, "{}"));
+    EXPECT_EQ(journal.stats().dropped, 1u);
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include "../CpuTopology.h"
+#include <algorithm>
+#include <thread>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+TEST(CpuTopologyTest, ParsesKernelCpuLists) {
+    EXPECT_EQ(CpuTopology::parse_cpu_list("0-3,8,10-11\n"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(CpuTopology::parse_cpu_list("5"), (std::vector<int>{5}));
+    EXPECT_TRUE(CpuTopology::parse_cpu_list("").empty());
+}
+
+TEST(CpuTopologyTest, AutomaticLayoutKeepsHotThreadsTogetherAndOffTheHousekeepingCore) {
+    auto topology = CpuTopology::from_nodes({{1, {4, 5, 6, 7}}, {0, {0, 1, 2, 3}}});
+    auto config = TopologyConfig::automatic(topology, 4);
+
+    ASSERT_TRUE(config.enabled);
+    EXPECT_EQ(config.market_data_cpu, 1);
+    EXPECT_EQ(config.event_loop_cpus, (std::vector<int>{2, 3, 4, 5}));
+    EXPECT_EQ(config.housekeeping_cpus, (std::vector<int>{0, 6, 7}));
+
+    auto layout = describe_layout(config, topology);
+    ASSERT_EQ(layout.size(), 6u);
+    EXPECT_EQ(layout[0].thread, "market-data");
+    EXPECT_EQ(layout[0].node, 0);
+    EXPECT_EQ(layout[3].node, 1);  // event-loop-2 spills onto the second node
+    EXPECT_EQ(layout[5].thread, "housekeeping");
+    EXPECT_EQ(layout[5].node, -1);  // spans both nodes
+
+    // More loops than cores: the extra loops are left to the scheduler
+    auto crowded = TopologyConfig::automatic(CpuTopology::from_nodes({{0, {0, 1, 2}}}), 3);
+    EXPECT_EQ(crowded.event_loop_cpus, (std::vector<int>{2, -1, -1}));
+    EXPECT_EQ(crowded.housekeeping_cpus, (std::vector<int>{0}));
+}
+
+#ifdef __linux__
+TEST(CpuTopologyTest, PinsTheCallingThread) {
+    auto topology = CpuTopology::detect();
+    ASSERT_GE(topology.cpu_count(), 1u);
+    int cpu = topology.nodes().front().cpus.front();
+
+    std::thread worker([cpu]() {
+        ASSERT_TRUE(pin_current_thread({cpu}));
+        EXPECT_EQ(sched_getcpu(), cpu);
+        use_local_memory();
+    });
+    worker.join();
+}
+#endif
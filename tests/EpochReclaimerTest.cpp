@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include "../EpochReclaimer.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace {
+
+struct Tracked {
+    explicit Tracked(std::atomic<int>& destroyed, int value = 0) : destroyed(destroyed), value(value) {}
+    ~Tracked() { ++destroyed; }
+    std::atomic<int>& destroyed;
+    int value;
+};
+
+}  // namespace
+
+TEST(EpochReclaimerTest, RetiredObjectsOutliveGuardsThatMaySeeThem) {
+    std::atomic<int> destroyed{0};
+    std::atomic<bool> pinned{false};
+    std::atomic<bool> release{false};
+
+    std::thread reader([&]() {
+        EpochReclaimer::Guard guard;
+        pinned = true;
+        while (!release) {
+            std::this_thread::yield();
+        }
+    });
+    while (!pinned) {
+        std::this_thread::yield();
+    }
+
+    // Several batches, so the retiring thread tries to advance and reclaim repeatedly
+    constexpr int kRetired = 4 * static_cast<int>(EpochReclaimer::RETIRE_BATCH);
+    for (int i = 0; i < kRetired; ++i) {
+        EpochReclaimer::retire(new Tracked(destroyed));
+    }
+    EXPECT_EQ(destroyed.load(), 0);
+
+    release = true;
+    reader.join();
+    EpochReclaimer::synchronize();
+    EXPECT_EQ(destroyed.load(), kRetired);
+}
+
+TEST(EpochReclaimerTest, NestedGuardsPinUntilTheOutermostEnds) {
+    std::atomic<int> destroyed{0};
+    constexpr int kRetired = 4 * static_cast<int>(EpochReclaimer::RETIRE_BATCH);
+    {
+        EpochReclaimer::Guard outer;
+        {
+            EpochReclaimer::Guard inner;
+        }
+        // Still pinned by outer: another thread's retirements move the epoch at most once
+        auto epoch = EpochReclaimer::stats().epoch;
+        std::thread retirer([&destroyed]() {
+            for (int i = 0; i < kRetired; ++i) {
+                EpochReclaimer::retire(new Tracked(destroyed));
+            }
+        });
+        retirer.join();
+        EXPECT_LE(EpochReclaimer::stats().epoch, epoch + 1);
+        EXPECT_EQ(destroyed.load(), 0);
+    }
+    EpochReclaimer::synchronize();
+    EXPECT_EQ(destroyed.load(), kRetired);
+}
+
+TEST(EpochReclaimerTest, ExitedThreadsHandOffTheirBags) {
+    std::atomic<int> destroyed{0};
+    std::thread retirer([&destroyed]() {
+        EpochReclaimer::retire(new Tracked(destroyed));
+    });
+    retirer.join();
+    EpochReclaimer::synchronize();
+    EXPECT_EQ(destroyed.load(), 1);
+
+    auto stats = EpochReclaimer::stats();
+    EXPECT_GE(stats.retired, 1u);
+    EXPECT_GE(stats.reclaimed, 1u);
+}
+
+TEST(EpochReclaimerTest, PublishedValueSurvivesReplacementWhileRead) {
+    std::atomic<int> destroyed{0};
+    EpochPublished<Tracked> published;
+    {
+        EpochReclaimer::Guard guard;
+        EXPECT_EQ(published.read(guard), nullptr);
+    }
+    published.publish(std::make_unique<Tracked>(destroyed, 1));
+
+    std::atomic<bool> reading{false};
+    std::atomic<bool> replaced{false};
+    std::atomic<int> seen{0};
+    std::thread reader([&]() {
+        EpochReclaimer::Guard guard;
+        const Tracked* value = published.read(guard);
+        reading = true;
+        while (!replaced) {
+            std::this_thread::yield();
+        }
+        seen = value->value;  // replaced by now, but not freed
+    });
+    while (!reading) {
+        std::this_thread::yield();
+    }
+    published.publish(std::make_unique<Tracked>(destroyed, 2));
+    replaced = true;
+    reader.join();
+
+    EXPECT_EQ(seen.load(), 1);
+    EpochReclaimer::synchronize();
+    EXPECT_EQ(destroyed.load(), 1);
+    EpochReclaimer::Guard guard;
+    EXPECT_EQ(published.read(guard)->value, 2);
+}
@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 #include "../EventLoop.h"
+#include "../MessageProcessor.h"
+#include "../OrderbookManager.h"
+#include <algorithm>
+#include <string>
+#include <vector>
 
 TEST(EventLoopTest, PostAndRun) {
     EventLoop loop;
@@ -17,3 +22,200 @@ TEST(EventLoopTest, PostAndRun) {
 
     EXPECT_EQ(counter, 10);
 }
+
+class EventLoopWaitStrategyTest : public ::testing::TestWithParam<WaitStrategy> {};
+
+TEST_P(EventLoopWaitStrategyTest, RunsPostedTasksAfterIdling) {
+    WaitConfig config;
+    config.strategy = GetParam();
+    config.spin_time = std::chrono::microseconds(100);
+    EventLoop loop(config);
+    loop.run();
+
+    std::atomic<int> counter(0);
+    for (int round = 0; round < 5; ++round) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));  // let the loop go idle
+        loop.post([&counter]() { ++counter; });
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (counter.load() <= round && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+    loop.stop();
+
+    EXPECT_EQ(counter, 5);
+    EXPECT_GT(loop.get_stats().wake_latency.count, 0u);
+}
+
+INSTANTIATE_TEST_SUITE_P(AllStrategies, EventLoopWaitStrategyTest,
+                         ::testing::Values(WaitStrategy::BusySpin, WaitStrategy::SpinThenYield,
+                                           WaitStrategy::SpinThenBlock, WaitStrategy::Adaptive));
+
+TEST(EventLoopTest, BlockingLoopIsIdleAndWakesOnPost) {
+    WaitConfig config;
+    config.strategy = WaitStrategy::SpinThenBlock;
+    config.max_block = std::chrono::milliseconds(1000);
+    EventLoop loop(config);
+    loop.run();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EventLoopStats idle = loop.get_stats();
+    EXPECT_LT(idle.cpu_utilization, 0.2);
+    EXPECT_GT(idle.parks, 0u);
+
+    std::atomic<bool> ran(false);
+    loop.post([&ran]() { ran = true; });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    while (!ran && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    EXPECT_TRUE(ran);
+    EXPECT_GT(loop.get_stats().wakeups, 0u);
+    loop.stop();
+}
+
+TEST(EventLoopTest, BlockingLoopStillServesIo) {
+    WaitConfig config;
+    config.strategy = WaitStrategy::SpinThenBlock;
+    config.max_block = std::chrono::milliseconds(1000);
+    EventLoop loop(config);
+    loop.run();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    std::atomic<bool> fired(false);
+    boost::asio::steady_timer timer(loop.get_io_context(), std::chrono::milliseconds(20));
+    timer.async_wait([&fired](const boost::system::error_code&) { fired = true; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_TRUE(fired);
+    loop.stop();
+}
+
+TEST(EventLoopTest, IdleMarketDataLoopParks) {
+    // As BinanceClient sets up its market data loop: a running processor with no traffic
+    // must leave the loop nothing to do, or Adaptive never gets past spinning
+    EventLoop loop(WaitConfig{WaitStrategy::Adaptive});
+    OrderbookManager books;
+    MessageProcessor processor(loop.get_io_context(), books);
+    loop.run();
+    loop.post([&processor]() { processor.run(); }, EventLoop::Priority::High);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EventLoopStats idle = loop.get_stats();
+    EXPECT_GT(idle.parks, 0u);
+    EXPECT_LT(idle.cpu_utilization, 0.2);
+
+    // A message still wakes it
+    processor.add_message(false, R"({"lastUpdateId":7,"bids":[],"asks":[]})", "btcusdt");
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    while (books.getLastUpdateId("btcusdt") != 7 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(books.getLastUpdateId("btcusdt"), 7u);
+    loop.stop();
+    processor.stop();
+}
+
+TEST(EventLoopTest, HigherPriorityRunsFirstAndLanesStayFifo) {
+    EventLoop loop;
+    std::vector<std::string> order;
+    loop.post([&order]() { order.push_back("low1"); }, EventLoop::Priority::Low);
+    loop.post([&order]() { order.push_back("medium1"); }, EventLoop::Priority::Medium);
+    loop.post([&order]() { order.push_back("low2"); }, EventLoop::Priority::Low);
+    loop.post([&order]() { order.push_back("high1"); }, EventLoop::Priority::High);
+    loop.post([&order]() { order.push_back("high2"); }, EventLoop::Priority::High);
+
+    loop.run();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    loop.stop();
+
+    std::vector<std::string> expected = {"high1", "high2", "medium1", "low1", "low2"};
+    EXPECT_EQ(order, expected);
+    EventLoopStats stats = loop.get_stats();
+    EXPECT_EQ(stats.dispatched[static_cast<size_t>(EventLoop::Priority::High)], 2u);
+    EXPECT_EQ(stats.dispatched[static_cast<size_t>(EventLoop::Priority::Low)], 2u);
+}
+
+TEST(EventLoopTest, LowPriorityIsNotStarved) {
+    SchedulerConfig scheduler;
+    scheduler.starvation_limit = 8;
+    EventLoop loop(WaitConfig(), scheduler);
+
+    std::vector<int> order;
+    loop.post([&order]() { order.push_back(-1); }, EventLoop::Priority::Low);
+    for (int i = 0; i < 100; ++i) {
+        loop.post([&order, i]() { order.push_back(i); }, EventLoop::Priority::High);
+    }
+
+    loop.run();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    loop.stop();
+
+    ASSERT_EQ(order.size(), 101u);
+    auto low = std::find(order.begin(), order.end(), -1);
+    EXPECT_EQ(low - order.begin(), 8);
+    EXPECT_EQ(loop.get_stats().starvation_promotions, 1u);
+}
+
+TEST(EventLoopTest, ConcurrentProducersKeepPerProducerOrder) {
+    EventLoop loop;
+    loop.run();
+
+    constexpr int kProducers = 4;
+    constexpr int kTasks = 10000;
+    std::vector<int> last_seen(kProducers, -1);
+    std::atomic<int> out_of_order(0);
+    std::atomic<int> done(0);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p]() {
+            for (int i = 0; i < kTasks; ++i) {
+                loop.post([&, p, i]() {
+                    if (i != last_seen[p] + 1) ++out_of_order;
+                    last_seen[p] = i;
+                    ++done;
+                });
+            }
+        });
+    }
+    for (auto& t : producers) t.join();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (done < kProducers * kTasks && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    loop.stop();
+
+    EXPECT_EQ(done, kProducers * kTasks);
+    EXPECT_EQ(out_of_order, 0);
+}
+
+TEST(EventLoopTest, FullLaneSpillsWithoutReordering) {
+    SchedulerConfig scheduler;
+    scheduler.queue_capacity = 8;
+    EventLoop loop(WaitConfig(), scheduler);
+
+    std::vector<int> order;
+    std::atomic<int> done(0);
+    for (int i = 0; i < 100; ++i) {
+        loop.post([&order, &done, i]() { order.push_back(i); ++done; });
+    }
+    EXPECT_EQ(loop.get_stats().queue_overflows, 92u);
+
+    loop.run();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (done < 100 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // Posted after the spill list drained: back on the ring
+    loop.post([&order, &done]() { order.push_back(100); ++done; });
+    while (done < 101 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    loop.stop();
+
+    ASSERT_EQ(order.size(), 101u);
+    for (int i = 0; i <= 100; ++i) {
+        EXPECT_EQ(order[i], i);
+    }
+    EXPECT_EQ(loop.get_stats().queue_overflows, 92u);
+}
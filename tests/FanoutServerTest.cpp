@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+#include "../FanoutServer.h"
+#include "../OrderbookManager.h"
+#include "../SyntheticMarket.h"
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/websocket.hpp>
+#include <simdjson.h>
+#include <string>
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace websocket = beast::websocket;
+
+namespace {
+
+class Consumer {
+public:
+    Consumer(unsigned short port, const std::string& target) {
+        beast::get_lowest_layer(ws_).connect({net::ip::make_address("127.0.0.1"), port});
+        ws_.handshake("127.0.0.1", target);
+    }
+
+    void write(const std::string& text) { ws_.write(net::buffer(text)); }
+
+    // Next frame as text, or decoded into message when it is a binary book message
+    std::string read(fanout::Message& message) {
+        for (;;) {
+            beast::flat_buffer buffer;
+            ws_.read(buffer);
+            std::string frame = beast::buffers_to_string(buffer.data());
+            if (!ws_.got_binary()) {
+                return frame;
+            }
+            auto result = decoder_.decode(frame, message);
+            EXPECT_NE(result, fanout::BinaryDecoder::Result::Invalid);
+            if (result != fanout::BinaryDecoder::Result::Definition) {
+                return std::string();
+            }
+        }
+    }
+
+private:
+    fanout::BinaryDecoder decoder_;
+    net::io_context ioc_;
+    websocket::stream<beast::tcp_stream> ws_{ioc_};
+};
+
+bool parse_json(simdjson::dom::parser& parser, const std::string& text, fanout::Message& message) {
+    simdjson::dom::element doc;
+    std::string_view type;
+    if (parser.parse(text).get(doc) || doc["type"].get(type)) {
+        return false;  // an acknowledgement
+    }
+    message.type = type == "snapshot" ? fanout::MessageType::Snapshot : fanout::MessageType::Delta;
+    message.symbol = std::string(doc["s"].get_string().value());
+    message.sequence = doc["seq"].get_uint64();
+    message.previous_update_id = doc["pu"].get_uint64();
+    message.update_id = doc["u"].get_uint64();
+    auto side = [](simdjson::dom::array levels, std::vector<fanout::Level>& out) {
+        out.clear();
+        for (auto level : levels) {
+            out.push_back(fanout::Level{level.at(0).get_double(), level.at(1).get_double()});
+        }
+    };
+    side(doc["b"].get_array(), message.bids);
+    side(doc["a"].get_array(), message.asks);
+    return true;
+}
+
+bool same_top(const fanout::Book& book, const BookView& view) {
+    auto same = [](const std::vector<fanout::Level>& levels, const PriceLevel* expected, uint32_t count) {
+        if (levels.size() != count) {
+            return false;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            if (levels[i].price != expected[i].price || levels[i].quantity != expected[i].quantity) {
+                return false;
+            }
+        }
+        return true;
+    };
+    return same(book.bids(), view.bids, view.bid_count) && same(book.asks(), view.asks, view.ask_count);
+}
+
+BookView view_of(const Orderbook& book) {
+    BookView view;
+    view.last_update_id = book.last_update_id;
+    view.bid_count = static_cast<uint32_t>(std::min(book.bids.size(), BookView::DEPTH));
+    view.ask_count = static_cast<uint32_t>(std::min(book.asks.size(), BookView::DEPTH));
+    std::copy_n(book.bids.begin(), view.bid_count, view.bids);
+    std::copy_n(book.asks.begin(), view.ask_count, view.asks);
+    return view;
+}
+
+}  // namespace
+
+TEST(FanoutProtocolTest, EncodingsRoundTripAndDeltasApplyInSequence) {
+    fanout::Message snapshot;
+    snapshot.symbol = "btcusdt";
+    snapshot.sequence = 1;
+    snapshot.update_id = 10;
+    snapshot.bids = {{100.5, 2.0}, {100.0, 1.0}};
+    snapshot.asks = {{101.0, 3.0}};
+
+    std::string frame;
+    fanout::encode_binary(snapshot, 7, 0, frame);
+    fanout::BinaryDecoder decoder;
+    fanout::Message decoded;
+    EXPECT_EQ(decoder.decode(frame, decoded), fanout::BinaryDecoder::Result::Invalid);  // symbol not defined yet
+    std::string definition;
+    fanout::encode_definition(7, "btcusdt", definition);
+    ASSERT_EQ(decoder.decode(definition, decoded), fanout::BinaryDecoder::Result::Definition);
+    ASSERT_EQ(decoder.decode(frame, decoded), fanout::BinaryDecoder::Result::Message);
+    EXPECT_EQ(decoded.symbol, "btcusdt");
+    EXPECT_EQ(decoded.update_id, 10u);
+    ASSERT_EQ(decoded.bids.size(), 2u);
+    EXPECT_EQ(decoded.bids[0].price, 100.5);
+    EXPECT_EQ(decoded.bids[1].price, 100.0);
+    EXPECT_EQ(decoder.decode(std::string_view(frame).substr(0, frame.size() - 1), decoded),
+              fanout::BinaryDecoder::Result::Invalid);
+
+    fanout::encode_json(snapshot, frame);
+    simdjson::dom::parser parser;
+    ASSERT_TRUE(parse_json(parser, frame, decoded));
+    EXPECT_EQ(decoded.asks[0].quantity, 3.0);
+
+    fanout::Book book(2);
+    ASSERT_TRUE(book.apply(snapshot));
+    fanout::Message delta;
+    delta.type = fanout::MessageType::Delta;
+    delta.sequence = 2;
+    delta.previous_update_id = 10;
+    delta.update_id = 14;
+    delta.bids = {{100.7, 1.0}, {100.5, 0.0}};
+    delta.asks = {{100.9, 5.0}, {101.2, 1.0}};
+    ASSERT_TRUE(book.apply(delta));
+    ASSERT_EQ(book.bids().size(), 2u);
+    EXPECT_EQ(book.bids()[0].price, 100.7);
+    EXPECT_EQ(book.bids()[1].price, 100.0);
+    ASSERT_EQ(book.asks().size(), 2u);  // 101.2 falls below the depth
+    EXPECT_EQ(book.asks()[1].price, 101.0);
+    EXPECT_FALSE(book.apply(delta));  // replayed: out of sequence
+}
+
+TEST(FanoutServerTest, ConsumersRebuildTheBookFromSnapshotAndDeltas) {
+    FanoutServer server(FanoutConfig{});
+    OrderbookManager books;
+    books.setViewListener([&server](const std::string& symbol, const BookView& view) { server.on_book(symbol, view); });
+
+    SyntheticConfig config;
+    config.depth = 40;
+    SyntheticMarket market(config);
+    simdjson::dom::parser parser;
+    books.OnOrderbookRest("btcusdt", parser.parse(market.snapshot(0, 1000)));
+
+    Consumer json(server.port(), "/?symbols=btcusdt");
+    Consumer binary(server.port(), "/?format=binary");
+    binary.write(R"({"method":"SUBSCRIBE","params":["BTCUSDT"],"id":3})");
+    fanout::Message message;
+    EXPECT_EQ(binary.read(message), R"({"result":null,"id":3})");
+
+    for (int i = 0; i < 500; ++i) {
+        books.OnOrderbookWs("btcusdt", parser.parse(market.next_diff(0, 0)));
+    }
+    BookView final_view = view_of(books.exportBooks().at(0).second);
+
+    // The last top change may come before the last update ID, so stop on the final top
+    simdjson::dom::parser json_parser;
+    for (bool as_json : {true, false}) {
+        fanout::Book book(BookView::DEPTH);
+        Consumer& consumer = as_json ? json : binary;
+        for (;;) {
+            std::string text = consumer.read(message);
+            if (as_json && !parse_json(json_parser, text, message)) {
+                continue;
+            }
+            ASSERT_TRUE(book.apply(message)) << "sequence " << message.sequence;
+            EXPECT_EQ(message.symbol, "btcusdt");
+            if (same_top(book, final_view)) {
+                break;
+            }
+        }
+        EXPECT_LE(book.update_id(), final_view.last_update_id);
+    }
+    EXPECT_EQ(server.stats().clients, 2u);
+    EXPECT_GE(server.stats().updates, 501u);
+}
+
+TEST(FanoutServerTest, SlowConsumerGetsConflatedDeltas) {
+    FanoutServer server(FanoutConfig{});
+    Consumer consumer(server.port(), "/?format=binary&symbols=ethusdt");
+
+    constexpr int kUpdates = 20000;
+    Orderbook book;
+    for (int i = 0; i < 20; ++i) {
+        book.bids.push_back(PriceLevel{100.0 - i, 1.0});
+        book.asks.push_back(PriceLevel{101.0 + i, 1.0});
+    }
+    // Published without the consumer reading anything
+    for (int k = 1; k <= kUpdates; ++k) {
+        book.last_update_id = static_cast<uint64_t>(k);
+        book.bids[k % 20].quantity = k;
+        book.asks[(k * 7) % 20].quantity = k;
+        server.on_book("ethusdt", view_of(book));
+    }
+
+    fanout::Book received(BookView::DEPTH);
+    fanout::Message message;
+    size_t messages = 0;
+    while (received.update_id() != static_cast<uint64_t>(kUpdates)) {
+        consumer.read(message);
+        ASSERT_TRUE(received.apply(message));
+        ++messages;
+    }
+    EXPECT_TRUE(same_top(received, view_of(book)));
+    EXPECT_LT(messages, static_cast<size_t>(kUpdates));
+    EXPECT_GT(server.stats().conflated, 0u);
+}
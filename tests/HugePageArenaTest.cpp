@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "../HugePageArena.h"
+#include "../SpscMailbox.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+ArenaOptions options_of(size_t bytes) {
+    ArenaOptions options;
+    options.bytes = bytes;
+    return options;
+}
+
+}  // namespace
+
+TEST(HugePageArenaTest, ReservesWholeAlignedHugePagesWithWhateverBackingIsAvailable) {
+    HugePageArena arena(ArenaKind::Slabs, options_of(3 * 1024 * 1024));
+    auto stats = arena.stats();
+    // Explicit pages need vm.nr_hugepages; without them the arena falls back, never fails
+    ASSERT_NE(stats.backing, HugePageArena::Backing::None);
+    EXPECT_EQ(stats.reserved, 2 * HugePageArena::HUGE_PAGE_SIZE);
+    EXPECT_EQ(stats.used, 0u);
+
+    void* p = arena.allocate(1);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % HugePageArena::HUGE_PAGE_SIZE, 0u);
+}
+
+TEST(HugePageArenaTest, CarvesAlignedBlocksUntilFull) {
+    HugePageArena arena(ArenaKind::Rings, options_of(HugePageArena::HUGE_PAGE_SIZE));
+    char* a = static_cast<char*>(arena.allocate(10, 8));
+    char* b = static_cast<char*>(arena.allocate(100, 4096));
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 4096, 0u);
+    EXPECT_GE(b, a + 10);
+    EXPECT_TRUE(arena.contains(a));
+    EXPECT_TRUE(arena.contains(b + 99));
+    EXPECT_EQ(arena.stats().used, 4096u + 100u);
+
+    EXPECT_EQ(arena.allocate(HugePageArena::HUGE_PAGE_SIZE), nullptr);
+    EXPECT_NE(arena.allocate(HugePageArena::HUGE_PAGE_SIZE - 8192), nullptr);
+    EXPECT_EQ(arena.allocate(8192), nullptr);
+
+    int on_stack = 0;
+    EXPECT_FALSE(arena.contains(&on_stack));
+}
+
+TEST(HugePageArenaTest, EmptyArenaHandsOutNothing) {
+    HugePageArena arena(ArenaKind::Buffers, ArenaOptions{});
+    EXPECT_EQ(arena.stats().backing, HugePageArena::Backing::None);
+    EXPECT_EQ(arena.allocate(64), nullptr);
+}
+
+TEST(HugePageArenaTest, PrefaultAndLockAreBestEffort) {
+    ArenaOptions options = options_of(HugePageArena::HUGE_PAGE_SIZE);
+    options.lock = true;
+    HugePageArena arena(ArenaKind::Buffers, options);
+    auto stats = arena.stats();
+    EXPECT_TRUE(stats.prefaulted);
+    // locked depends on RLIMIT_MEMLOCK; the arena is usable either way
+    auto* p = static_cast<uint64_t*>(arena.allocate(sizeof(uint64_t) * 1024, alignof(uint64_t)));
+    ASSERT_NE(p, nullptr);
+    std::fill(p, p + 1024, 7u);
+    EXPECT_EQ(p[1023], 7u);
+}
+
+TEST(HugePageArenaTest, ConcurrentCarvingNeverOverlaps) {
+    HugePageArena arena(ArenaKind::Slabs, options_of(HugePageArena::HUGE_PAGE_SIZE));
+    constexpr int kThreads = 4;
+    std::vector<std::vector<char*>> blocks(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&arena, &blocks, t]() {
+            while (char* p = static_cast<char*>(arena.allocate(64, 64))) {
+                blocks[t].push_back(p);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<char*> all;
+    for (auto& list : blocks) {
+        all.insert(all.end(), list.begin(), list.end());
+    }
+    std::sort(all.begin(), all.end());
+    EXPECT_EQ(all.size(), HugePageArena::HUGE_PAGE_SIZE / 64);
+    EXPECT_EQ(std::adjacent_find(all.begin(), all.end()), all.end());
+}
+
+TEST(HugePageArenaTest, ConfiguredArenaBacksRingsAndOverflowsToTheHeap) {
+    HugePageArena& arena = HugePageArena::configure(ArenaKind::Rings, options_of(HugePageArena::HUGE_PAGE_SIZE));
+    EXPECT_EQ(HugePageArena::get(ArenaKind::Rings), &arena);
+    EXPECT_THROW(HugePageArena::configure(ArenaKind::Rings, options_of(HugePageArena::HUGE_PAGE_SIZE)),
+                 std::runtime_error);
+
+    {
+        ArenaArray<uint64_t> fits(ArenaKind::Rings, 1024);
+        EXPECT_TRUE(arena.contains(fits.data()));
+        ArenaArray<uint64_t> too_big(ArenaKind::Rings, HugePageArena::HUGE_PAGE_SIZE / sizeof(uint64_t));
+        EXPECT_FALSE(arena.contains(too_big.data()));
+        too_big[too_big.size() - 1] = 1;
+
+        SpscMailbox<int> ring(256);
+        int value = 42;
+        ASSERT_TRUE(ring.try_push(value));
+        ASSERT_TRUE(ring.try_pop(value));
+        EXPECT_EQ(value, 42);
+    }
+
+    auto stats = arena.stats();
+    EXPECT_EQ(stats.heap_fallbacks, 1u);
+    EXPECT_EQ(stats.freed, 1024 * sizeof(uint64_t) + 256 * sizeof(int));
+    bool reported = false;
+    for (const auto& entry : HugePageArena::report()) {
+        reported |= entry.kind == ArenaKind::Rings && entry.used == stats.used;
+    }
+    EXPECT_TRUE(reported);
+}
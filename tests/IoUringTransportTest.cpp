@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+#include "../EventLoop.h"
+#include "../IoUringTransport.h"
+#include "../LocalExchange.h"
+#include "../MessageProcessor.h"
+#include "../OrderbookManager.h"
+#include "../WebSocketFrameDecoder.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class IoUringTransportTest : public ::testing::Test {
+protected:
+    int fds[2] = {-1, -1};
+
+    void SetUp() override {
+        if (!IoUringTransport::is_supported()) {
+            GTEST_SKIP() << "io_uring not available";
+        }
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    }
+
+    void TearDown() override {
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+    }
+};
+
+TEST_F(IoUringTransportTest, MultishotReceiveDeliversAllBytes) {
+    IoUringConfig config;
+    config.buffer_count = 8;
+    config.buffer_size = 64;
+    IoUringTransport transport(config);
+
+    std::string received;
+    bool closed = false;
+    transport.add_connection(fds[0],
+        [&received](const char* data, size_t len) { received.append(data, len); },
+        [&closed](int) { closed = true; });
+
+    std::string expected;
+    for (int i = 0; i < 200; ++i) {
+        std::string chunk = "message-" + std::to_string(i) + ";";
+        expected += chunk;
+        ASSERT_EQ(write(fds[1], chunk.data(), chunk.size()), static_cast<ssize_t>(chunk.size()));
+        if (i % 10 == 0) {
+            transport.poll(false);
+        }
+    }
+    close(fds[1]);
+    fds[1] = -1;
+
+    while (!closed) {
+        transport.poll(true);
+    }
+    EXPECT_EQ(received, expected);
+
+    IoUringStats stats = transport.stats();
+    EXPECT_EQ(stats.bytes_received, expected.size());
+    EXPECT_LE(stats.enter_calls, stats.completions + 1);
+}
+
+TEST_F(IoUringTransportTest, SendReachesPeer) {
+    IoUringTransport transport;
+    uint32_t id = transport.add_connection(fds[0], [](const char*, size_t) {}, [](int) {});
+    transport.send(id, "pong");
+    transport.poll(false);
+
+    char buf[4];
+    ASSERT_EQ(read(fds[1], buf, sizeof(buf)), 4);
+    EXPECT_EQ(std::string(buf, 4), "pong");
+}
+
+TEST_F(IoUringTransportTest, LargeSendsArriveWholeAndInOrder) {
+    IoUringTransport transport;
+    uint32_t id = transport.add_connection(fds[0], [](const char*, size_t) {}, [](int) {});
+    // Each is larger than the socket buffer, so the kernel takes them in parts
+    std::string expected;
+    for (char fill : {'a', 'b', 'c'}) {
+        std::string message(512 * 1024, fill);
+        expected += message;
+        transport.send(id, message);
+    }
+
+    std::string received;
+    std::thread reader([&]() {
+        char buf[65536];
+        while (received.size() < expected.size()) {
+            ssize_t n = read(fds[1], buf, sizeof(buf));
+            if (n <= 0) break;
+            received.append(buf, static_cast<size_t>(n));
+        }
+    });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (transport.stats().bytes_sent < expected.size() && std::chrono::steady_clock::now() < deadline) {
+        transport.poll(false);
+    }
+    reader.join();
+    EXPECT_EQ(received.size(), expected.size());
+    EXPECT_TRUE(received == expected);
+}
+
+TEST_F(IoUringTransportTest, ReusedSlotIgnoresThePreviousConnectionsCompletions) {
+    IoUringTransport transport;
+    bool old_closed = false;
+    uint32_t old_id = transport.add_connection(fds[0], [](const char*, size_t) {}, [&old_closed](int) { old_closed = true; });
+    transport.poll(false);  // the multishot receive is in flight
+    transport.remove_connection(old_id);
+
+    int other[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, other), 0);
+    std::string received;
+    bool closed = false;
+    uint32_t id = transport.add_connection(other[0],
+        [&received](const char* data, size_t len) { received.append(data, len); },
+        [&closed](int) { closed = true; });
+    ASSERT_EQ(id, old_id);
+
+    // The old receive's final completion arrives after the slot was taken again
+    for (int i = 0; i < 5; ++i) {
+        transport.poll(false);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    ASSERT_EQ(write(other[1], "tick", 4), 4);
+    while (received.size() < 4 && !closed) {
+        transport.poll(true);
+    }
+    EXPECT_FALSE(closed);
+    EXPECT_FALSE(old_closed);  // removed connections are not reported closed
+    EXPECT_EQ(received, "tick");
+    close(other[0]);
+    close(other[1]);
+}
+
+TEST_F(IoUringTransportTest, AttachedFeedReadsOnTheLoopThreadAndLetsItPark) {
+    LocalExchangeConfig exchange_config;
+    exchange_config.market.symbols = {"btcusdt"};
+    exchange_config.market.messages_per_second = 50;  // quiet enough to park in between
+    LocalExchange exchange(exchange_config);
+
+    WaitConfig wait;
+    wait.strategy = WaitStrategy::Adaptive;
+    EventLoop loop(wait);
+    IoUringConfig config;
+    config.single_issuer = false;  // created here, driven by the loop thread
+    IoUringTransport transport(config);
+    transport.attach(loop);
+
+    OrderbookManager manager;
+    MessageProcessor processor(loop.get_io_context(), manager);
+    std::unique_ptr<IoUringWebSocketFeed> feed;
+    std::atomic<int> messages{0};
+    std::atomic<bool> wrong_thread{false};
+    std::atomic<bool> connected{false};
+    loop.run();
+    loop.post([&]() {
+        feed = std::make_unique<IoUringWebSocketFeed>(transport, "127.0.0.1", std::to_string(exchange.stream_port()),
+                                                      "/stream?streams=btcusdt@depth", processor);
+        feed->set_message_handler([&](std::string&& payload) {
+            if (EventLoop::current() != &loop) wrong_thread = true;
+            if (payload.find("depthUpdate") != std::string::npos) ++messages;
+        });
+        feed->connect(loop.get_io_context(), std::chrono::seconds(5), [&](bool ok) {
+            if (EventLoop::current() != &loop) wrong_thread = true;
+            connected = ok;
+        });
+    });
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (messages < 10 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EventLoopStats stats = loop.get_stats();
+    loop.stop();
+    feed.reset();
+    transport.detach();
+
+    EXPECT_TRUE(connected);
+    EXPECT_GE(messages, 10);
+    EXPECT_FALSE(wrong_thread);
+    EXPECT_GT(stats.parks, 0u);
+}
+
+TEST(WebSocketFrameDecoderTest, ReassemblesSplitAndFragmentedFrames) {
+    using Opcode = WebSocketFrameDecoder::Opcode;
+    std::string big(70000, 'x');
+    std::string stream = WebSocketFrameDecoder::encode_server_frame(Opcode::Text, "{\"u\":1}") +
+                         WebSocketFrameDecoder::encode_server_frame(Opcode::Binary, big) +
+                         WebSocketFrameDecoder::encode_server_frame(Opcode::Ping, "p");
+    // Fragmented text message: "hel" + "lo"
+    stream += std::string("\x01\x03hel", 5) + std::string("\x80\x02lo", 4);
+
+    WebSocketFrameDecoder decoder;
+    std::vector<std::pair<Opcode, std::string>> frames;
+    for (size_t i = 0; i < stream.size(); i += 7) {
+        ASSERT_TRUE(decoder.feed(stream.data() + i, std::min<size_t>(7, stream.size() - i),
+            [&frames](Opcode op, std::string&& payload) { frames.emplace_back(op, std::move(payload)); }));
+    }
+
+    ASSERT_EQ(frames.size(), 4u);
+    EXPECT_EQ(frames[0].second, "{\"u\":1}");
+    EXPECT_EQ(frames[1].second, big);
+    EXPECT_EQ(frames[2].first, Opcode::Ping);
+    EXPECT_EQ(frames[3].first, Opcode::Text);
+    EXPECT_EQ(frames[3].second, "hello");
+}
+
+TEST(WebSocketFrameDecoderTest, ClientFramesAreMasked) {
+    using Opcode = WebSocketFrameDecoder::Opcode;
+    std::string frame = WebSocketFrameDecoder::encode_client_frame(Opcode::Text, "subscribe", 0x12345678);
+    EXPECT_TRUE(static_cast<uint8_t>(frame[1]) & 0x80);
+
+    WebSocketFrameDecoder decoder;
+    std::string payload;
+    decoder.feed(frame.data(), frame.size(), [&payload](Opcode, std::string&& p) { payload = std::move(p); });
+    EXPECT_EQ(payload, "subscribe");
+}
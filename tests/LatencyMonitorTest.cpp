@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "../LatencyMonitor.h"
+
+TEST(LatencyTrackerTest, Percentiles) {
+    LatencyTracker tracker(100);
+    for (int i = 1; i <= 100; ++i) {
+        tracker.record(i);
+    }
+    LatencyStats stats = tracker.stats();
+    EXPECT_EQ(stats.count, 100u);
+    EXPECT_NEAR(stats.p50_us, 50, 1);
+    EXPECT_NEAR(stats.p99_us, 99, 1);
+    EXPECT_EQ(stats.max_us, 100);
+}
+
+TEST(LatencyTrackerTest, RollingWindowForgetsOldSamples) {
+    LatencyTracker tracker(10);
+    for (int i = 0; i < 10; ++i) {
+        tracker.record(1000);
+    }
+    for (int i = 0; i < 10; ++i) {
+        tracker.record(5);
+    }
+    LatencyStats stats = tracker.stats();
+    EXPECT_EQ(stats.count, 10u);
+    EXPECT_EQ(stats.max_us, 5);
+}
+
+TEST(LatencyHistogramTest, PercentilesWithinBucketPrecisionAndMerge) {
+    LatencyHistogram low;
+    LatencyHistogram high;
+    for (int i = 1; i <= 1000; ++i) {
+        (i <= 500 ? low : high).record(i * 1000);
+    }
+    low.record(-5);  // clock went backwards: counted as 0
+    low.merge(high);
+
+    auto stats = low.stats();
+    EXPECT_EQ(stats.count, 1001u);
+    EXPECT_NEAR(stats.p50_ns, 500000, 500000 * 0.04);
+    EXPECT_NEAR(stats.p99_ns, 990000, 990000 * 0.04);
+    EXPECT_EQ(stats.max_ns, 1000000);
+    EXPECT_LE(stats.p999_ns, stats.max_ns);
+    EXPECT_NEAR(stats.mean_ns, 500000, 1000);
+
+    LatencyHistogram exact;
+    for (int i = 0; i < 10; ++i) {
+        exact.record(42);
+    }
+    EXPECT_EQ(exact.stats().p50_ns, 42);
+    EXPECT_EQ(LatencyHistogram().stats().count, 0u);
+}
+
+TEST(ClockSyncTest, OffsetWithInjectedDelay) {
+    ClockSync sync;
+    const int64_t true_offset_us = 250000;  // exchange clock runs 250ms ahead
+    int64_t local = 1700000000000000;
+    for (int i = 0; i < 10; ++i) {
+        int64_t one_way = (i % 3 == 0) ? 40000 : 2000;  // occasional queueing delay on the request leg
+        int64_t server_us = local + one_way + true_offset_us;
+        int64_t recv = local + one_way + 2000;
+        sync.add_sample(local, server_us / 1000, recv);
+        local += 1000000;
+    }
+    ASSERT_TRUE(sync.has_estimate());
+    EXPECT_NEAR(sync.offset_us_at(local), true_offset_us, 2000);
+
+    // An event stamped by the exchange 250ms ahead maps back onto the local clock
+    int64_t event_ms = (local + true_offset_us) / 1000;
+    EXPECT_NEAR(sync.exchange_to_local_us(event_ms), local, 3000);
+    EXPECT_NEAR(sync.local_to_exchange_ms(local), event_ms, 3);
+}
+
+TEST(ClockSyncTest, EstimatesDrift) {
+    ClockSync sync;
+    int64_t local = 1700000000000000;
+    for (int i = 0; i < 30; ++i) {
+        int64_t offset = 1000 + i * 100;  // 100us per second = 100ppm
+        sync.add_sample(local, (local + 500 + offset) / 1000, local + 1000);
+        local += 1000000;
+    }
+    EXPECT_NEAR(sync.drift_ppm(), 100.0, 10.0);
+}
+
+TEST(LatencyMonitorTest, ExtractEventTime) {
+    std::string depth = R"({"e":"depthUpdate","E":1672515782136,"s":"BNBBTC","U":157,"u":160,"b":[],"a":[]})";
+    EXPECT_EQ(extract_json_integer(depth, "E"), 1672515782136);
+    EXPECT_EQ(extract_json_integer(depth, "u"), 160);
+    EXPECT_EQ(extract_json_integer(R"({"serverTime": 1499827319559})", "serverTime"), 1499827319559);
+    EXPECT_EQ(extract_json_integer(R"({"s":"E"})", "E"), -1);
+}
@@ -0,0 +1,274 @@
+#include <gtest/gtest.h>
+#include "../CaptureJournal.h"
+#include "../LocalExchange.h"
+#include "../MessageProcessor.h"
+#include "../OrderbookManager.h"
+#include "../RestApiHandler.h"
+#include "../SyntheticMarket.h"
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/websocket.hpp>
+#include <simdjson.h>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <thread>
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace websocket = beast::websocket;
+
+namespace {
+
+// Blocking WebSocket client on its own io_context, like the one WebSocketHandler opens
+class StreamClient {
+public:
+    StreamClient(unsigned short port, const std::string& target) {
+        net::ip::tcp::endpoint endpoint(net::ip::make_address("127.0.0.1"), port);
+        beast::get_lowest_layer(ws_).connect(endpoint);
+        ws_.handshake("127.0.0.1:" + std::to_string(port), target);
+    }
+
+    std::string read() {
+        beast::flat_buffer buffer;
+        ws_.read(buffer);
+        return beast::buffers_to_string(buffer.data());
+    }
+
+    void write(const std::string& text) { ws_.write(net::buffer(text)); }
+
+private:
+    net::io_context ioc_;
+    websocket::stream<beast::tcp_stream> ws_{ioc_};
+};
+
+struct Ids {
+    uint64_t first = 0;
+    uint64_t last = 0;
+};
+
+Ids update_ids(simdjson::dom::parser& parser, const std::string& event) {
+    simdjson::dom::element doc = parser.parse(event);
+    return Ids{static_cast<uint64_t>(doc["U"].get_int64()), static_cast<uint64_t>(doc["u"].get_int64())};
+}
+
+SyntheticConfig small_market() {
+    SyntheticConfig config;
+    config.symbols = {"btcusdt", "ethusdt"};
+    config.depth = 20;
+    config.seed = 7;
+    return config;
+}
+
+}  // namespace
+
+TEST(SyntheticMarketTest, SameSeedSameEvents) {
+    SyntheticMarket a(small_market());
+    SyntheticMarket b(small_market());
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_EQ(a.next_diff(i % 2, 1000), b.next_diff(i % 2, 1000));
+    }
+    EXPECT_EQ(a.snapshot(0, 20), b.snapshot(0, 20));
+    EXPECT_EQ(a.find("ETHUSDT"), 1);
+    EXPECT_EQ(a.find("xrpusdt"), -1);
+    EXPECT_THROW(SyntheticMarket(SyntheticConfig{.symbols = {}}), std::invalid_argument);
+}
+
+TEST(SyntheticMarketTest, SnapshotAndDiffsRebuildTheBook) {
+    SyntheticMarket market(small_market());
+    OrderbookManager books;
+    simdjson::dom::parser parser;
+    books.OnOrderbookRest("btcusdt", parser.parse(market.snapshot(0, 1000)));
+
+    simdjson::dom::parser diff_parser;
+    uint64_t expected_first = market.last_update_id(0) + 1;
+    for (int i = 0; i < 2000; ++i) {
+        std::string event = market.next_diff(0, 1000);
+        Ids ids = update_ids(diff_parser, event);
+        ASSERT_EQ(ids.first, expected_first);
+        ASSERT_GE(ids.last, ids.first);
+        expected_first = ids.last + 1;
+        books.OnOrderbookWs("btcusdt", diff_parser.parse(event));
+    }
+    ASSERT_TRUE(books.isSynced("btcusdt"));
+    EXPECT_EQ(books.getLastUpdateId("btcusdt"), market.last_update_id(0));
+
+    // Levels that fell off the far end were removed by diffs too, so the whole book matches
+    OrderbookManager fresh;
+    fresh.OnOrderbookRest("btcusdt", parser.parse(market.snapshot(0, 1000)));
+    EXPECT_EQ(books.getOrderbookSnapshot("btcusdt", 1000), fresh.getOrderbookSnapshot("btcusdt", 1000));
+}
+
+TEST(SyntheticMarketTest, GapsWithholdDiffsAndBreakSync) {
+    SyntheticConfig config = small_market();
+    config.gap_probability = 0.05;
+    SyntheticMarket market(config);
+    OrderbookManager books;
+    simdjson::dom::parser parser;
+    books.OnOrderbookRest("btcusdt", parser.parse(market.snapshot(0, 1000)));
+
+    size_t withheld = 0;
+    bool lost_sync = false;
+    for (int i = 0; i < 1000; ++i) {
+        std::string event = market.next_diff(0, 1000);
+        if (event.empty()) {
+            ++withheld;
+            continue;
+        }
+        books.OnOrderbookWs("btcusdt", parser.parse(event));
+        lost_sync = lost_sync || !books.isSynced("btcusdt");
+    }
+    EXPECT_GT(withheld, 0u);
+    EXPECT_EQ(market.gaps(), withheld);
+    EXPECT_TRUE(lost_sync);
+}
+
+TEST(SyntheticMarketTest, TickPacesDiffsToTheRate) {
+    SyntheticConfig config = small_market();
+    config.messages_per_second = 1000;
+    SyntheticMarket market(config);
+    EXPECT_TRUE(market.tick(0).empty());  // starts the clock
+    size_t events = 0;
+    for (int64_t ms = 1; ms <= 500; ++ms) {
+        events += market.tick(ms * 1000000).size();
+    }
+    EXPECT_EQ(events, 2u * 500u);  // both symbols, half a second
+}
+
+TEST(LocalExchangeTest, CombinedStreamCarriesContiguousDiffs) {
+    LocalExchangeConfig config;
+    config.market = small_market();
+    config.market.messages_per_second = 2000;
+    LocalExchange exchange(config);
+
+    StreamClient client(exchange.stream_port(), "/stream?streams=btcusdt@depth/ethusdt@depth");
+    simdjson::dom::parser parser;
+    std::map<std::string, uint64_t> last;
+    for (int i = 0; i < 200; ++i) {
+        std::string message = client.read();
+        std::string symbol = MessageProcessor::stream_symbol(message);
+        ASSERT_TRUE(symbol == "btcusdt" || symbol == "ethusdt") << message;
+        simdjson::dom::element data = parser.parse(message)["data"];
+        auto first = static_cast<uint64_t>(data["U"].get_int64());
+        if (last.count(symbol)) {
+            EXPECT_EQ(first, last[symbol] + 1);
+        }
+        last[symbol] = static_cast<uint64_t>(data["u"].get_int64());
+    }
+    EXPECT_EQ(last.size(), 2u);
+    EXPECT_EQ(exchange.stats().connections, 1u);
+    EXPECT_GE(exchange.stats().messages_sent, 200u);
+    EXPECT_EQ(exchange.endpoints().stream_base, "ws://127.0.0.1:" + std::to_string(exchange.stream_port()));
+}
+
+TEST(LocalExchangeTest, SubscribeIsAcknowledgedThenStreamsRawEvents) {
+    LocalExchangeConfig config;
+    config.market = small_market();
+    LocalExchange exchange(config);
+
+    StreamClient client(exchange.stream_port(), "/ws");
+    client.write(R"({"method":"SUBSCRIBE","params":["ethusdt@depth"],"id":7})");
+    EXPECT_EQ(client.read(), R"({"result":null,"id":7})");
+    std::string event = client.read();
+    EXPECT_EQ(event.rfind("{\"e\":\"depthUpdate\"", 0), 0u) << event;
+    EXPECT_NE(event.find("\"s\":\"ETHUSDT\""), std::string::npos);
+}
+
+TEST(LocalExchangeTest, RestServesSnapshotsToTheClientHandler) {
+    LocalExchangeConfig config;
+    config.market = small_market();
+    LocalExchange exchange(config);
+    ExchangeEndpoints endpoints = exchange.endpoints();
+
+    net::io_context ioc;
+    net::ssl::context ctx(net::ssl::context::tlsv12_client);
+    OrderbookManager books;
+    MessageProcessor processor(ioc, books);
+    auto fetch = [&](const std::string& target) {
+        auto handler = std::make_shared<RestApiHandler>(ioc, ctx, endpoints.rest_host, endpoints.rest_port,
+                                                        target, processor);
+        std::string response;
+        handler->set_response_handler([&response](std::string&& body, auto, auto) { response = std::move(body); });
+        handler->fetch_snapshot();
+        ioc.restart();
+        ioc.run();
+        handler->stop();
+        ioc.restart();
+        ioc.run();
+        return response;
+    };
+
+    simdjson::dom::parser parser;
+    simdjson::dom::element snapshot = parser.parse(fetch("/api/v3/depth?symbol=BTCUSDT&limit=5"));
+    EXPECT_GE(snapshot["lastUpdateId"].get_int64().value(), 1000);
+    EXPECT_EQ(snapshot["bids"].get_array().size(), 5u);
+    EXPECT_EQ(snapshot["asks"].get_array().size(), 5u);
+    EXPECT_NE(fetch("/api/v3/time").find("serverTime"), std::string::npos);
+    EXPECT_GE(exchange.stats().rest_requests, 2u);
+}
+
+TEST(LocalExchangeTest, DisconnectIntervalClosesConnections) {
+    LocalExchangeConfig config;
+    config.market = small_market();
+    config.disconnect_interval = std::chrono::milliseconds(50);
+    LocalExchange exchange(config);
+
+    StreamClient client(exchange.stream_port(), "/ws/btcusdt@depth");
+    auto opened = std::chrono::steady_clock::now();
+    try {
+        for (;;) {
+            client.read();
+        }
+    } catch (const boost::system::system_error& e) {
+        EXPECT_EQ(e.code(), websocket::error::closed);
+    }
+    EXPECT_GE(std::chrono::steady_clock::now() - opened, std::chrono::milliseconds(40));
+    EXPECT_EQ(exchange.stats().disconnects, 1u);
+}
+
+TEST(LocalExchangeTest, PlaysBackACapture) {
+    const std::string directory = "local_exchange_test";
+    std::filesystem::remove_all(directory);
+    constexpr int kDiffs = 50;
+    {
+        CaptureConfig capture;
+        capture.directory = directory;
+        capture.segment_size = 64 * 1024;
+        CaptureJournal journal(capture);
+        uint32_t rest = journal.register_connection();
+        uint32_t ws = journal.register_connection();
+        journal.append(CaptureSource::Rest, rest, journal.symbol_id("btcusdt"), 1000,
+                       R"({"lastUpdateId":0,"bids":[["1.0","1.0"]],"asks":[]})");
+        for (int id = 1; id <= kDiffs; ++id) {
+            for (const char* symbol : {"btcusdt", "ethusdt"}) {
+                std::string u = std::to_string(id);
+                journal.append(CaptureSource::WebSocket, ws, 0, 1000 + id,
+                               std::string("{\"stream\":\"") + symbol + "@depth\",\"data\":{\"e\":\"depthUpdate\",\"U\":" +
+                                   u + ",\"u\":" + u + ",\"b\":[],\"a\":[]}}");
+            }
+        }
+    }
+
+    LocalExchangeConfig config;
+    config.playback_directory = directory;
+    config.playback_speed = 0.0;
+    {
+        LocalExchange exchange(config);
+        StreamClient client(exchange.stream_port(), "/ws/btcusdt@depth");
+        simdjson::dom::parser parser;
+        for (int id = 1; id <= kDiffs; ++id) {
+            std::string event = client.read();
+            ASSERT_EQ(update_ids(parser, event).first, static_cast<uint64_t>(id)) << event;
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!exchange.stats().playback_finished && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_TRUE(exchange.stats().playback_finished);
+        EXPECT_EQ(exchange.stats().records_played, 2u * kDiffs);
+    }
+    std::filesystem::remove_all(directory);
+    EXPECT_THROW(LocalExchange{config}, std::runtime_error);
+}
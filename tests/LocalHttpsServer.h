@@ -0,0 +1,92 @@
+#pragma once
+
+#include "LocalExchange.h"
+#include <boost/asio.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/ssl.hpp>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// HTTPS stand-in for the exchange REST API: answers every GET on 127.0.0.1 with a fixed
+// body over kept-alive connections, from its own io_context and thread. The certificate
+// is a throwaway self-signed P-256 one, so clients must not verify the peer.
+class LocalHttpsServer {
+public:
+    explicit LocalHttpsServer(std::string body)
+        : body_(std::move(body)),
+          ssl_ctx_(boost::asio::ssl::context::tls_server),
+          acceptor_(ioc_, {boost::asio::ip::make_address("127.0.0.1"), 0}) {
+        LocalExchange::use_self_signed_certificate(ssl_ctx_);
+        boost::asio::co_spawn(ioc_, accept_loop(), boost::asio::detached);
+        thread_ = std::thread([this]() { ioc_.run(); });
+    }
+
+    ~LocalHttpsServer() {
+        ioc_.stop();
+        thread_.join();
+    }
+
+    LocalHttpsServer(const LocalHttpsServer&) = delete;
+    LocalHttpsServer& operator=(const LocalHttpsServer&) = delete;
+
+    unsigned short port() const { return acceptor_.local_endpoint().port(); }
+    size_t connections() const { return connections_.load(); }
+    size_t requests() const { return requests_.load(); }
+
+private:
+    using Stream = boost::beast::ssl_stream<boost::beast::tcp_stream>;
+
+    std::string body_;
+    boost::asio::io_context ioc_;
+    boost::asio::ssl::context ssl_ctx_;
+    boost::asio::ip::tcp::acceptor acceptor_;
+    std::thread thread_;
+    std::atomic<size_t> connections_{0};
+    std::atomic<size_t> requests_{0};
+
+    boost::asio::awaitable<void> accept_loop() {
+        for (;;) {
+            boost::system::error_code ec;
+            auto socket = co_await acceptor_.async_accept(
+                boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+            if (ec) {
+                co_return;
+            }
+            ++connections_;
+            boost::asio::co_spawn(ioc_, session(std::move(socket)), boost::asio::detached);
+        }
+    }
+
+    boost::asio::awaitable<void> session(boost::asio::ip::tcp::socket socket) {
+        namespace http = boost::beast::http;
+        boost::system::error_code ec;
+        Stream stream(std::move(socket), ssl_ctx_);
+        co_await stream.async_handshake(boost::asio::ssl::stream_base::server,
+                                        boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        boost::beast::flat_buffer buffer;
+        while (!ec) {
+            http::request<http::string_body> req;
+            co_await http::async_read(stream, buffer, req,
+                                      boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+            if (ec) {
+                break;
+            }
+            ++requests_;
+            http::response<http::string_body> res(http::status::ok, req.version());
+            res.set(http::field::content_type, "application/json");
+            res.keep_alive(req.keep_alive());
+            res.body() = body_;
+            res.prepare_payload();
+            co_await http::async_write(stream, res,
+                                       boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        }
+    }
+};
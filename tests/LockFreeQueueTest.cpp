@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "../LockFreeQueue.h"
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// LOCKFREE_STRESS_OPS raises the operation count for soak runs, e.g. billions under TSAN
+uint64_t stress_ops(uint64_t fallback) {
+    const char* ops = std::getenv("LOCKFREE_STRESS_OPS");
+    return ops ? std::strtoull(ops, nullptr, 10) : fallback;
+}
+
+}  // namespace
+
+TEST(LockFreeQueueTest, KeepsFifoOrderOnOneThread) {
+    LockFreeQueue<std::string> queue;
+    for (int i = 0; i < 100; ++i) {
+        queue.push(std::to_string(i));
+    }
+    EXPECT_EQ(queue.size(), 100u);
+    std::string value;
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(queue.pop(value));
+        EXPECT_EQ(value, std::to_string(i));
+    }
+    EXPECT_FALSE(queue.pop(value));
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(LockFreeQueueTest, ConcurrentProducersAndConsumersLoseNothing) {
+    // Consumers race on the same head node, which is where an unprotected pop frees a
+    // node another consumer is still reading
+    constexpr int kProducers = 4;
+    constexpr int kConsumers = 4;
+    const uint64_t per_producer = stress_ops(400000) / (kProducers + kConsumers);
+
+    LockFreeQueue<uint64_t> queue;
+    std::atomic<uint64_t> popped{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> out_of_order{0};
+    const uint64_t total = per_producer * kProducers;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (uint64_t i = 0; i < per_producer; ++i) {
+                queue.push((static_cast<uint64_t>(p) << 48) | i);
+            }
+        });
+    }
+    for (int c = 0; c < kConsumers; ++c) {
+        threads.emplace_back([&]() {
+            // Each producer's values must come out in push order, as seen by one consumer
+            std::vector<uint64_t> last(kProducers, 0);
+            std::vector<bool> seen(kProducers, false);
+            uint64_t value;
+            while (popped.load(std::memory_order_relaxed) < total) {
+                if (!queue.pop(value)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                size_t producer = value >> 48;
+                uint64_t index = value & ((uint64_t{1} << 48) - 1);
+                if (seen[producer] && index <= last[producer]) {
+                    ++out_of_order;
+                }
+                seen[producer] = true;
+                last[producer] = index;
+                sum += index;
+                ++popped;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(popped.load(), total);
+    EXPECT_EQ(sum.load(), kProducers * (per_producer * (per_producer - 1) / 2));
+    EXPECT_EQ(out_of_order.load(), 0u);
+    EXPECT_EQ(queue.size(), 0u);
+}
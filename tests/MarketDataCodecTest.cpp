@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include "../MarketDataCodec.h"
+#include "../OrderbookManager.h"
+#include <simdjson.h>
+#include <string>
+#include <vector>
+
+TEST(MarketDataCodecTest, FixedPointParsesExchangeDecimals) {
+    int64_t value = 0;
+    ASSERT_TRUE(md::parse_fixed("67012.34000000", value));
+    EXPECT_EQ(value, 6701234000000);
+    ASSERT_TRUE(md::parse_fixed("0.00000001", value));
+    EXPECT_EQ(value, 1);
+    ASSERT_TRUE(md::parse_fixed("12", value));
+    EXPECT_EQ(value, 12 * md::PRICE_SCALE);
+    ASSERT_TRUE(md::parse_fixed("-1.5", value));
+    EXPECT_EQ(value, -150000000);
+    EXPECT_FALSE(md::parse_fixed("0.000000001", value));  // finer than the fixed point
+    EXPECT_FALSE(md::parse_fixed("1.2.3", value));
+    EXPECT_FALSE(md::parse_fixed("", value));
+    EXPECT_FALSE(md::parse_fixed(".", value));
+    EXPECT_FALSE(md::parse_fixed("99999999999999999999", value));
+
+    EXPECT_EQ(md::to_fixed(100.01), 10001000000);
+    EXPECT_EQ(md::to_double(md::to_fixed(0.1)), 0.1);
+}
+
+TEST(MarketDataCodecTest, BookMessagesRoundTripInPlace) {
+    const md::Level bids[] = {{md::to_fixed(100.5), md::to_fixed(2.0)}, {md::to_fixed(100.0), md::to_fixed(1.0)}};
+    const md::Level asks[] = {{md::to_fixed(101.0), md::to_fixed(3.0)}};
+    md::Delta delta{};
+    delta.symbol_id = 7;
+    delta.exchange = md::Exchange::Binance;
+    delta.sequence = 2;
+    delta.previous_update_id = 10;
+    delta.update_id = 14;
+    delta.exchange_ns = 1700000000000000000;
+    delta.local_ns = 1700000000000100000;
+
+    std::string frame;
+    md::encode(frame, delta, bids, 2, asks, 1);
+    ASSERT_EQ(frame.size(), md::encoded_size<md::Delta>(2, 1));
+    EXPECT_EQ(md::template_id(frame), md::Delta::TEMPLATE_ID);
+
+    md::View<md::Delta> view;
+    ASSERT_TRUE(view.wrap(frame));
+    EXPECT_EQ(view.size(), frame.size());
+    md::Delta decoded = view.block();
+    EXPECT_EQ(decoded.symbol_id, 7u);
+    EXPECT_EQ(decoded.previous_update_id, 10u);
+    EXPECT_EQ(decoded.update_id, 14u);
+    EXPECT_EQ(decoded.exchange_ns, delta.exchange_ns);
+    EXPECT_EQ(decoded.local_ns, delta.local_ns);
+    ASSERT_EQ(view.bids().size(), 2u);
+    EXPECT_EQ(view.bids()[1].price, bids[1].price);
+    ASSERT_EQ(view.asks().size(), 1u);
+    EXPECT_EQ(view.asks()[0].quantity, asks[0].quantity);
+
+    // Levels are read from the frame, not copied at wrap
+    md::Level changed{md::to_fixed(99.0), 1};
+    std::memcpy(frame.data() + md::bids_offset<md::Delta>(), &changed, sizeof(changed));
+    EXPECT_EQ(view.bids()[0].price, changed.price);
+
+    md::View<md::Snapshot> other;
+    EXPECT_FALSE(other.wrap(frame));  // another template
+    EXPECT_FALSE(view.wrap(std::string_view(frame).substr(0, frame.size() - 1)));
+    EXPECT_FALSE(view.wrap(std::string_view(frame).substr(0, 4)));
+    frame[4] ^= 0x7f;  // schema ID
+    EXPECT_FALSE(view.wrap(frame));
+    EXPECT_EQ(md::template_id(frame), 0u);
+}
+
+TEST(MarketDataCodecTest, FixedMessagesRoundTrip) {
+    md::Trade trade{};
+    trade.symbol_id = 3;
+    trade.exchange = md::Exchange::Binance;
+    trade.aggressor = md::Side::Sell;
+    trade.trade_id = 123456789;
+    trade.price = md::to_fixed(67012.34);
+    trade.quantity = md::to_fixed(0.015);
+    char buffer[md::encoded_size<md::Trade>()];
+    ASSERT_EQ(md::encode(buffer, trade), sizeof(buffer));
+    md::View<md::Trade> trade_view;
+    ASSERT_TRUE(trade_view.wrap(std::string_view(buffer, sizeof(buffer))));
+    EXPECT_EQ(trade_view.block().aggressor, md::Side::Sell);
+    EXPECT_EQ(trade_view.block().trade_id, 123456789u);
+    EXPECT_EQ(trade_view.block().price, trade.price);
+
+    md::Bbo bbo{};
+    bbo.symbol_id = 3;
+    bbo.bid = md::Level{md::to_fixed(67012.33), md::to_fixed(1.0)};
+    std::string frame;
+    md::encode(frame, bbo);
+    md::View<md::Bbo> bbo_view;
+    ASSERT_TRUE(bbo_view.wrap(frame));
+    EXPECT_EQ(bbo_view.block().bid.price, bbo.bid.price);
+    EXPECT_EQ(bbo_view.block().ask.price, 0);
+
+    md::encode(frame, md::make_definition(3, "a-symbol-longer-than-the-name-field"));
+    md::View<md::SymbolDefinition> definition;
+    ASSERT_TRUE(definition.wrap(frame));
+    EXPECT_EQ(definition.block().symbol_id, 3u);
+    EXPECT_EQ(definition.block().symbol(), "a-symbol-longer-than-the");
+}
+
+TEST(MarketDataCodecTest, DecoderSkipsFieldsAppendedByANewerVersion) {
+    // A version 2 Snapshot with one more u64 in the root block and in every level
+    md::Snapshot block{};
+    block.symbol_id = 9;
+    block.update_id = 42;
+    std::string frame;
+    auto append = [&frame](const void* data, size_t size) { frame.append(static_cast<const char*>(data), size); };
+    md::MessageHeader header{sizeof(block) + 8, md::Snapshot::TEMPLATE_ID, md::SCHEMA_ID, 2};
+    append(&header, sizeof(header));
+    append(&block, sizeof(block));
+    frame.append(8, '\x55');
+    for (uint16_t count : {2, 1}) {
+        md::GroupHeader group{sizeof(md::Level) + 8, count, 0};
+        append(&group, sizeof(group));
+        for (uint16_t i = 0; i < count; ++i) {
+            md::Level level{100 + i, 1};
+            append(&level, sizeof(level));
+            frame.append(8, '\x55');
+        }
+    }
+
+    md::View<md::Snapshot> view;
+    ASSERT_TRUE(view.wrap(frame));
+    EXPECT_EQ(view.block().symbol_id, 9u);
+    EXPECT_EQ(view.block().update_id, 42u);
+    ASSERT_EQ(view.bids().size(), 2u);
+    EXPECT_EQ(view.bids()[1].price, 101);
+    EXPECT_EQ(view.asks()[0].quantity, 1);
+
+    // A block shorter than this decoder's is rejected
+    header.block_length = sizeof(block) - 8;
+    std::memcpy(frame.data(), &header, sizeof(header));
+    EXPECT_FALSE(view.wrap(frame));
+}
+
+TEST(MarketDataCodecTest, OrderbookSnapshotEncodesTheSameLevelsAsTheJson) {
+    OrderbookManager manager;
+    simdjson::dom::parser parser;
+    manager.OnOrderbookRest("btcusdt", parser.parse(std::string(
+        R"({"lastUpdateId":10,"bids":[["100.00","1.5"],["99.99","2"],["99.98","3"]],"asks":[["100.01","0.25"],["100.02","4"]]})")));
+
+    std::string frame;
+    EXPECT_FALSE(manager.encodeSnapshot("ethusdt", 5, 1, frame));
+    EXPECT_TRUE(frame.empty());
+    for (int depth : {2, 1000}) {  // from the published view, and from the book itself
+        ASSERT_TRUE(manager.encodeSnapshot("btcusdt", depth, 1, frame));
+        md::View<md::Snapshot> view;
+        ASSERT_TRUE(view.wrap(frame));
+        EXPECT_EQ(view.block().symbol_id, 1u);
+        EXPECT_EQ(view.block().update_id, 10u);
+        EXPECT_EQ(view.block().stale, 0);
+        ASSERT_EQ(view.bids().size(), depth == 2 ? 2u : 3u);
+        ASSERT_EQ(view.asks().size(), 2u);
+        EXPECT_EQ(view.bids()[0].price, 10000000000);
+        EXPECT_EQ(view.bids()[0].quantity, 150000000);
+        EXPECT_EQ(view.bids()[1].price, 9999000000);
+        EXPECT_EQ(view.asks()[0].quantity, 25000000);
+        EXPECT_EQ(view.asks()[1].price, 10002000000);
+    }
+}
@@ -1,28 +1,84 @@
 #include <gtest/gtest.h>
-#include <gmock/gmock.h>
 #include "../MessageProcessor.h"
 #include "../OrderbookManager.h"
+#include "../TradeStatistics.h"
 #include <boost/asio.hpp>
 
-class MockOrderbookManager : public OrderbookManager {
-public:
-    MockOrderbookManager() : OrderbookManager() {}
-    MOCK_METHOD(void, OnOrderbookWs, (const std::string&, const simdjson::dom::element&));
-    MOCK_METHOD(void, OnOrderbookRest, (const std::string&, const simdjson::dom::element&));
+// OrderbookManager's handlers are not virtual, so these check the books a real one ends
+// up with rather than mocking the calls
+class MessageProcessorTest : public ::testing::Test {
+protected:
+    boost::asio::io_context ioc;
+    OrderbookManager books;
+    MessageProcessor processor{ioc, books};
+
+    static std::string diff(uint64_t first, uint64_t last, const std::string& bid) {
+        return "{\"e\":\"depthUpdate\",\"U\":" + std::to_string(first) + ",\"u\":" + std::to_string(last) +
+               ",\"b\":[[\"" + bid + "\",\"1.0\"]],\"a\":[]}";
+    }
+
+    // Queued messages post one drain; run it, then run anything it left behind
+    void process_queued() {
+        processor.run();
+        ioc.run_one();
+        processor.stop();
+        ioc.poll();
+        ioc.restart();
+    }
 };
 
-TEST(MessageProcessorTest, ProcessMessage) {
-    boost::asio::io_context ioc;
-    MockOrderbookManager mock_orderbook_manager;
-    MessageProcessor processor(ioc, mock_orderbook_manager);
+TEST_F(MessageProcessorTest, ProcessMessage) {
+    processor.add_message(false, R"({"lastUpdateId":10,"bids":[["100.0","2.0"]],"asks":[["101.0","1.0"]]})", "btcusdt");
+    processor.add_message(true, diff(11, 12, "99.5"), "btcusdt");
+    EXPECT_EQ(books.getLastUpdateId("btcusdt"), 0u);  // nothing happens until the io_context runs
+
+    process_queued();
+
+    EXPECT_TRUE(books.isSynced("btcusdt"));
+    EXPECT_EQ(books.getLastUpdateId("btcusdt"), 12u);
+    EXPECT_NE(books.getOrderbookSnapshot("btcusdt", 5).find("99.5"), std::string::npos);
+}
+
+TEST_F(MessageProcessorTest, CombinedStreamTakesSymbolFromWrapper) {
+    processor.add_message(false, R"({"lastUpdateId":1,"bids":[],"asks":[]})", "ethusdt");
+    processor.add_message(true, R"({"stream":"ethusdt@depth","data":)" + diff(2, 2, "10.0") + "}");
+    processor.add_message(true, R"({"result":null,"id":1})");  // subscription acknowledgement, ignored
+    process_queued();
+
+    EXPECT_EQ(books.getLastUpdateId("ethusdt"), 2u);
+    EXPECT_EQ(MessageProcessor::stream_symbol(R"({"stream":"ethusdt@depth","data":{}})"), "ethusdt");
+    EXPECT_EQ(MessageProcessor::stream_symbol(R"({"e":"depthUpdate"})"), "");
+}
+
+TEST_F(MessageProcessorTest, DuplicatesAndMalformedMessagesAreDropped) {
+    processor.set_inline(true);
+    processor.add_message(false, R"({"lastUpdateId":5,"bids":[],"asks":[]})", "bnbusdt");
+    processor.add_message(true, diff(6, 6, "20.0"), "bnbusdt");
+    processor.add_message(true, "{not json", "bnbusdt");
+    // Redelivered: the deduplicator drops it before it is parsed
+    processor.add_message(true, diff(6, 6, "20.0"), "bnbusdt");
+    processor.add_message(true, diff(7, 7, "21.0"), "bnbusdt");
 
-    EXPECT_CALL(mock_orderbook_manager, OnOrderbookWs(testing::_, testing::_)).Times(1);
-    EXPECT_CALL(mock_orderbook_manager, OnOrderbookRest(testing::_, testing::_)).Times(1);
+    EXPECT_TRUE(books.isSynced("bnbusdt"));
+    EXPECT_EQ(books.getLastUpdateId("bnbusdt"), 7u);
+}
 
-    processor.add_message(true, R"({"type": "websocket", "data": "test"})");
-    processor.add_message(false, R"({"type": "rest", "data": "test"})");
+TEST_F(MessageProcessorTest, TradesGoToStatisticsNotTheBooks) {
+    TradeStatistics trades;
+    processor.set_trade_statistics(&trades);
+    processor.set_inline(true);
+    processor.add_message(false, R"({"lastUpdateId":1,"bids":[],"asks":[]})", "btcusdt");
+    processor.add_message(true, R"({"stream":"btcusdt@aggTrade","data":{"e":"aggTrade","E":1700000000101,"s":"BTCUSDT",)"
+                                R"("a":5,"p":"100.00","q":"2.0","f":9,"l":10,"T":1700000000100,"m":false}})");
+    processor.add_message(true, R"({"e":"trade","E":1700000000201,"s":"BTCUSDT","t":7,"p":"103.00","q":"1.0",)"
+                                R"("T":1700000000200,"m":true})", "btcusdt");
+    processor.add_message(true, diff(2, 2, "99.0"), "btcusdt");
 
-    processor.run();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));  // Give some time for processing
-    processor.stop();
+    EXPECT_EQ(books.getLastUpdateId("btcusdt"), 2u);  // the book still syncs around the trades
+    TradingStats stats = trades.get("btcusdt", 1700000000300);
+    EXPECT_EQ(stats.second.trades, 2u);
+    EXPECT_DOUBLE_EQ(stats.second.volume, 3.0);
+    EXPECT_DOUBLE_EQ(stats.second.vwap, 101.0);
+    EXPECT_DOUBLE_EQ(stats.last_price, 103.0);
+    EXPECT_EQ(stats.last_trade_ms, 1700000000200);
 }
@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 #include "../OrderbookManager.h"
+#include "AllocationCounter.h"
 #include <simdjson.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 class OrderbookManagerTest : public ::testing::Test {
 protected:
@@ -31,3 +35,210 @@ TEST_F(OrderbookManagerTest, EmptyOrderbook) {
     std::string snapshot = manager.getOrderbookSnapshot("ETHUSDT", 2);
     EXPECT_EQ(snapshot, "{}");
 }
+
+TEST_F(OrderbookManagerTest, SnapshotThenBufferedDiffsSync) {
+    std::vector<std::pair<std::string, bool>> events;
+    manager.setSyncListener([&events](const std::string& symbol, bool synced) {
+        events.emplace_back(symbol, synced);
+    });
+
+    simdjson::dom::parser parser;
+    // Diffs arrive before the snapshot and are buffered
+    simdjson::dom::element early = parser.parse(std::string(R"({"e":"depthUpdate","U":95,"u":100,"b":[["100.0","1.0"]],"a":[]})"));
+    manager.OnOrderbookWs("btcusdt", early);
+    simdjson::dom::parser parser2;
+    simdjson::dom::element overlap = parser2.parse(std::string(R"({"e":"depthUpdate","U":101,"u":110,"b":[["101.0","2.0"]],"a":[["102.0","3.0"]]})"));
+    manager.OnOrderbookWs("btcusdt", overlap);
+    EXPECT_FALSE(manager.isSynced("btcusdt"));
+
+    simdjson::dom::parser parser3;
+    simdjson::dom::element snapshot = parser3.parse(std::string(R"({"lastUpdateId":105,"bids":[["100.0","5.0"]],"asks":[["103.0","1.0"]]})"));
+    manager.OnOrderbookRest("btcusdt", snapshot);
+
+    EXPECT_TRUE(manager.isSynced("btcusdt"));
+    EXPECT_EQ(manager.getLastUpdateId("btcusdt"), 110u);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_TRUE(events[0].second);
+
+    std::string book = manager.getOrderbookSnapshot("btcusdt", 5);
+    EXPECT_NE(book.find("101"), std::string::npos);
+    EXPECT_NE(book.find("102"), std::string::npos);
+}
+
+TEST_F(OrderbookManagerTest, SequenceGapRequestsResync) {
+    std::vector<bool> events;
+    manager.setSyncListener([&events](const std::string&, bool synced) { events.push_back(synced); });
+
+    simdjson::dom::parser parser;
+    simdjson::dom::element snapshot = parser.parse(std::string(R"({"lastUpdateId":200,"bids":[["10.0","1.0"]],"asks":[["11.0","1.0"]]})"));
+    manager.OnOrderbookRest("ethusdt", snapshot);
+    ASSERT_TRUE(manager.isSynced("ethusdt"));
+
+    simdjson::dom::parser parser2;
+    simdjson::dom::element gap = parser2.parse(std::string(R"({"U":205,"u":210,"b":[["10.5","1.0"]],"a":[]})"));
+    manager.OnOrderbookWs("ethusdt", gap);
+    EXPECT_FALSE(manager.isSynced("ethusdt"));
+    EXPECT_EQ(manager.getLastUpdateId("ethusdt"), 200u);
+
+    // A fresh snapshot covering the gap brings the book back, replaying the buffered diff
+    simdjson::dom::parser parser3;
+    simdjson::dom::element resync = parser3.parse(std::string(R"({"lastUpdateId":206,"bids":[["10.0","2.0"]],"asks":[["11.0","1.0"]]})"));
+    manager.OnOrderbookRest("ethusdt", resync);
+    EXPECT_TRUE(manager.isSynced("ethusdt"));
+    EXPECT_EQ(manager.getLastUpdateId("ethusdt"), 210u);
+
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_TRUE(events[0]);
+    EXPECT_FALSE(events[1]);
+    EXPECT_TRUE(events[2]);
+}
+
+TEST_F(OrderbookManagerTest, RestoredBookResumesFromSavedUpdateId) {
+    std::vector<bool> events;
+    manager.setSyncListener([&events](const std::string&, bool synced) { events.push_back(synced); });
+
+    Orderbook saved;
+    saved.bids = {{50.0, 1.0}};
+    saved.asks = {{51.0, 1.0}};
+    saved.last_update_id = 300;
+    manager.restoreBook("solusdt", saved);
+    EXPECT_TRUE(manager.isStale("solusdt"));
+    EXPECT_NE(manager.getOrderbookSnapshot("solusdt", 1).find("\"stale\":true"), std::string::npos);
+
+    simdjson::dom::parser parser;
+    simdjson::dom::element next = parser.parse(std::string(R"({"U":301,"u":305,"b":[["50.5","1.0"]],"a":[]})"));
+    manager.OnOrderbookWs("solusdt", next);
+
+    EXPECT_FALSE(manager.isStale("solusdt"));
+    EXPECT_TRUE(manager.isSynced("solusdt"));
+    EXPECT_EQ(manager.getLastUpdateId("solusdt"), 305u);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_TRUE(events[0]);
+}
+
+TEST_F(OrderbookManagerTest, RestoredBookStaysStaleAcrossGap) {
+    std::vector<bool> events;
+    manager.setSyncListener([&events](const std::string&, bool synced) { events.push_back(synced); });
+
+    Orderbook saved;
+    saved.bids = {{50.0, 1.0}};
+    saved.last_update_id = 300;
+    manager.restoreBook("solusdt", saved);
+
+    simdjson::dom::parser parser;
+    simdjson::dom::element later = parser.parse(std::string(R"({"U":900,"u":905,"b":[],"a":[]})"));
+    manager.OnOrderbookWs("solusdt", later);
+
+    EXPECT_TRUE(manager.isStale("solusdt"));
+    EXPECT_FALSE(manager.isSynced("solusdt"));
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_FALSE(events[0]);
+
+    simdjson::dom::parser parser2;
+    simdjson::dom::element snapshot = parser2.parse(std::string(R"({"lastUpdateId":902,"bids":[["49.0","1.0"]],"asks":[]})"));
+    manager.OnOrderbookRest("solusdt", snapshot);
+    EXPECT_FALSE(manager.isStale("solusdt"));
+    EXPECT_TRUE(manager.isSynced("solusdt"));
+    EXPECT_EQ(manager.getLastUpdateId("solusdt"), 905u);
+}
+
+TEST_F(OrderbookManagerTest, ReservedBookIsEmptyUntilFilled) {
+    manager.reserveBook("solusdt", 100);
+    EXPECT_EQ(manager.getOrderbookSnapshot("solusdt", 5), "{}");
+    EXPECT_TRUE(manager.exportBooks().empty());
+
+    // A checkpoint restored after the reservation still lands in the book
+    Orderbook saved;
+    saved.bids = {{50.0, 1.0}};
+    saved.last_update_id = 300;
+    manager.restoreBook("solusdt", saved);
+    EXPECT_TRUE(manager.isStale("solusdt"));
+    EXPECT_EQ(manager.getLastUpdateId("solusdt"), 300u);
+    EXPECT_EQ(manager.exportBooks().size(), 1u);
+}
+
+TEST_F(OrderbookManagerTest, SnapshotsReadPublishedViewsWhileDiffsApply) {
+    simdjson::dom::parser parser;
+    simdjson::dom::element snapshot = parser.parse(std::string(R"({"lastUpdateId":1,"bids":[],"asks":[]})"));
+    manager.OnOrderbookRest("btcusdt", snapshot);
+
+    constexpr uint64_t kDiffs = 2000;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> malformed{0};
+    std::atomic<uint64_t> reads{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&]() {
+            while (!done) {
+                std::string book = manager.getOrderbookSnapshot("btcusdt", 5);
+                malformed += book != "{}" && book.rfind("{\"bids\":[", 0) != 0;
+                ++reads;
+            }
+        });
+    }
+
+    simdjson::dom::parser diff_parser;
+    for (uint64_t id = 2; id <= kDiffs + 1; ++id) {
+        std::string diff = "{\"U\":" + std::to_string(id) + ",\"u\":" + std::to_string(id) +
+                           ",\"b\":[[\"" + std::to_string(100 + id % 30) + "\",\"1.0\"]],\"a\":[[\"" +
+                           std::to_string(200 + id % 30) + "\",\"1.0\"]]}";
+        manager.OnOrderbookWs("btcusdt", diff_parser.parse(diff));
+    }
+    while (reads.load() < 100) {
+        std::this_thread::yield();
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(malformed.load(), 0u);
+    EXPECT_EQ(manager.getLastUpdateId("btcusdt"), kDiffs + 1);
+    // Past the published depth the book itself is formatted, under its lock
+    std::string deep = manager.getOrderbookSnapshot("btcusdt", static_cast<int>(BookView::DEPTH) + 10);
+    std::string shallow = manager.getOrderbookSnapshot("btcusdt", static_cast<int>(BookView::DEPTH));
+    EXPECT_EQ(std::count(deep.begin(), deep.end(), '['), 2 + 2 * 30);
+    EXPECT_EQ(std::count(shallow.begin(), shallow.end(), '['), 2 + 2 * static_cast<int>(BookView::DEPTH));
+}
+
+TEST_F(OrderbookManagerTest, BatchSnapshotsFillEveryRequestedBookInOrder) {
+    simdjson::dom::parser parser;
+    std::vector<std::string> symbols;
+    for (int i = 0; i < 40; ++i) {
+        symbols.push_back("sym" + std::to_string(i));
+        std::string rest = "{\"lastUpdateId\":" + std::to_string(100 + i) + ",\"bids\":[";
+        for (int level = 0; level < 30; ++level) {
+            rest += (level ? ",[\"" : "[\"") + std::to_string(1000 + i - level) + "\",\"1\"]";
+        }
+        rest += "],\"asks\":[[\"" + std::to_string(2000 + i) + "\",\"2\"]]}";
+        manager.OnOrderbookRest(symbols.back(), parser.parse(rest));
+    }
+    symbols.insert(symbols.begin() + 5, "missing");
+
+    BookBatch batch;
+    for (int depth : {5, 25}) {  // from the published views, and from the books under their shard locks
+        manager.getSnapshots(symbols, depth, batch);
+        ASSERT_EQ(batch.size(), symbols.size());
+        EXPECT_FALSE(batch.books[5].found);
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            if (i == 5) {
+                continue;
+            }
+            const int n = static_cast<int>(i < 5 ? i : i - 1);
+            const BookBatch::Book& book = batch.books[i];
+            ASSERT_TRUE(book.found) << symbols[i];
+            EXPECT_EQ(book.last_update_id, static_cast<uint64_t>(100 + n));
+            ASSERT_EQ(book.bid_count, static_cast<uint32_t>(depth));
+            ASSERT_EQ(book.ask_count, 1u);
+            EXPECT_EQ(batch.bids(i)[0].price, 1000 + n);
+            EXPECT_EQ(batch.bids(i)[depth - 1].price, 1000 + n - (depth - 1));
+            EXPECT_EQ(batch.asks(i)[0].price, 2000 + n);
+        }
+        EXPECT_EQ(batch.levels.size(), 40u * (depth + 1));
+    }
+
+    // A reused batch does not allocate
+    manager.getSnapshots(symbols, 5, batch);
+    auto allocations = count_allocations([&]() { manager.getSnapshots(symbols, 5, batch); });
+    EXPECT_EQ(allocations, 0u);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include "../CaptureJournal.h"
+#include "../ReplayEngine.h"
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+class ReplayEngineTest : public ::testing::Test {
+protected:
+    static constexpr int kDiffs = 500;
+    static constexpr int64_t kSpacingNs = 100000;  // 0.1ms between captured records
+    std::string directory = "replay_engine_test";
+
+    // Two symbols on one combined-stream connection, each with its snapshot first
+    void SetUp() override {
+        fs::remove_all(directory);
+        CaptureConfig config;
+        config.directory = directory;
+        config.segment_size = 64 * 1024;  // several segments
+        config.flush_interval = std::chrono::milliseconds(1);
+        CaptureJournal journal(config);
+        uint32_t rest = journal.register_connection();
+        uint32_t ws = journal.register_connection();
+        int64_t now = 1000000000;
+        for (const char* symbol : {"btcusdt", "ethusdt"}) {
+            journal.append(CaptureSource::Rest, rest, journal.symbol_id(symbol), now,
+                           std::string("{\"lastUpdateId\":0,\"s\":\"") + symbol + "\",\"bids\":[],\"asks\":[]}");
+            now += kSpacingNs;
+        }
+        for (int id = 1; id <= kDiffs; ++id) {
+            for (const char* symbol : {"btcusdt", "ethusdt"}) {
+                ASSERT_TRUE(journal.append(CaptureSource::WebSocket, ws, 0, now, diff(symbol, id)));
+                now += kSpacingNs;
+            }
+            if (id % 100 == 0) {
+                // Gives the flusher time to replace the spare the last roll used
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+    }
+
+    void TearDown() override {
+        fs::remove_all(directory);
+    }
+
+    static std::string diff(const std::string& symbol, int id) {
+        std::string u = std::to_string(id);
+        return "{\"stream\":\"" + symbol + "@depth\",\"data\":{\"e\":\"depthUpdate\",\"s\":\"" + symbol +
+               "\",\"U\":" + u + ",\"u\":" + u + ",\"b\":[[\"" + std::to_string(100 - id % 13) + ".5\",\"" +
+               std::to_string(id % 4) + "\"]],\"a\":[[\"" + std::to_string(101 + id % 11) + ".25\",\"" +
+               std::to_string(id % 3) + "\"]]}}";
+    }
+
+    ReplayConfig config() const {
+        ReplayConfig config;
+        config.directory = directory;
+        return config;
+    }
+};
+
+TEST_F(ReplayEngineTest, ReplaysEveryRecordIntoSyncedBooks) {
+    ReplayReport report = ReplayEngine(config()).run();
+    EXPECT_EQ(report.records, 2u + 2u * kDiffs);
+    EXPECT_EQ(report.skipped, 0u);
+    EXPECT_EQ(report.capture_span_ns, static_cast<int64_t>(report.records - 1) * kSpacingNs);
+    EXPECT_GT(report.messages_per_second, 0.0);
+    EXPECT_EQ(report.read.count, report.records);
+    EXPECT_EQ(report.apply.count, report.records);
+    EXPECT_EQ(report.queue.count, 0u);
+    EXPECT_EQ(report.lateness.count, 0u);
+
+    ASSERT_EQ(report.books.size(), 2u);
+    EXPECT_EQ(report.books[0].symbol, "btcusdt");
+    EXPECT_EQ(report.books[1].symbol, "ethusdt");
+    for (const auto& book : report.books) {
+        EXPECT_EQ(book.last_update_id, static_cast<uint64_t>(kDiffs));
+        EXPECT_TRUE(book.synced);
+        EXPECT_GT(book.bid_levels, 0u);
+    }
+    EXPECT_NE(ReplayEngine::format_report(report).find("msgs/s"), std::string::npos);
+}
+
+TEST_F(ReplayEngineTest, ChecksumsAreDeterministicAcrossRunsAndTargets) {
+    ReplayReport first = ReplayEngine(config()).run();
+    ReplayReport second = ReplayEngine(config()).run();
+    EXPECT_EQ(first.checksum, second.checksum);
+
+    ReplayConfig sharded = config();
+    sharded.shards = 2;
+    ReplayReport shards = ReplayEngine(sharded).run();
+    EXPECT_EQ(shards.records, first.records);
+    EXPECT_EQ(shards.queue.count, shards.records);
+    EXPECT_EQ(shards.apply.count, shards.records);
+    ASSERT_EQ(shards.books.size(), first.books.size());
+    for (size_t i = 0; i < first.books.size(); ++i) {
+        EXPECT_EQ(shards.books[i].checksum, first.books[i].checksum);
+    }
+    EXPECT_EQ(shards.checksum, first.checksum);
+
+    // A replay cut short leaves different books
+    ReplayConfig truncated = config();
+    truncated.max_records = first.records - 1;
+    EXPECT_NE(ReplayEngine(truncated).run().checksum, first.checksum);
+}
+
+TEST_F(ReplayEngineTest, SymbolFilterReplaysOnlyThoseBooks) {
+    ReplayReport all = ReplayEngine(config()).run();
+    ReplayConfig filtered = config();
+    filtered.symbols = {"ethusdt"};
+    ReplayReport eth = ReplayEngine(filtered).run();
+    EXPECT_EQ(eth.records, 1u + kDiffs);
+    EXPECT_EQ(eth.skipped, 1u + kDiffs);
+    ASSERT_EQ(eth.books.size(), 1u);
+    EXPECT_EQ(eth.books[0].checksum, all.books[1].checksum);
+}
+
+TEST_F(ReplayEngineTest, ScaledPacingFollowsCaptureTime) {
+    ReplayConfig scaled = config();
+    scaled.pacing = ReplayPacing::Scaled;
+    scaled.speed = 4.0;
+    ReplayReport report = ReplayEngine(scaled).run();
+    double captured = static_cast<double>(report.capture_span_ns) / 1e9;
+    EXPECT_GE(report.seconds, captured / scaled.speed);
+    EXPECT_EQ(report.lateness.count, report.records);
+    EXPECT_EQ(report.checksum, ReplayEngine(config()).run().checksum);
+
+    scaled.speed = 0.0;
+    EXPECT_THROW(ReplayEngine{scaled}, std::invalid_argument);
+}
+
+TEST(ReplayEngineMissingCaptureTest, ThrowsWithoutSegments) {
+    ReplayConfig config;
+    config.directory = "replay_engine_no_such_capture";
+    EXPECT_THROW(ReplayEngine(config).run(), std::runtime_error);
+}
@@ -3,6 +3,8 @@
 #include "../RestApiHandler.h"
 #include "../MessageProcessor.h"
 #include "../OrderbookManager.h"
+#include "AllocationCounter.h"
+#include "LocalHttpsServer.h"
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <thread>
@@ -58,3 +60,64 @@ TEST_F(RestApiHandlerTest, SetCpuAffinity) {
     // Note: We can't easily test the actual CPU affinity, so we just ensure it doesn't crash
     SUCCEED();
 }
+
+TEST_F(RestApiHandlerTest, KeepAliveFetchesReuseOneConnection) {
+    LocalHttpsServer server(R"({"lastUpdateId":1,"bids":[],"asks":[]})");
+    auto local = std::make_shared<RestApiHandler>(ioc, ctx, "127.0.0.1", std::to_string(server.port()),
+                                                  "/api/v3/depth?symbol=BTCUSDT&limit=1000", *mock_processor);
+    local->set_request_rate(1e6);
+    size_t responses = 0;
+    local->set_response_handler([&responses](std::string&& body, auto, auto) {
+        responses += body.find("lastUpdateId") != std::string::npos;
+    });
+
+    // The snapshot coroutine is the only work on ioc, so run() returns once it completes
+    auto fetch_once = [&]() {
+        local->fetch_snapshot();
+        ioc.restart();
+        ioc.run();
+    };
+    fetch_once();  // resolve, connect and handshake happen here
+
+    constexpr int kRequests = 200;
+    // Only the client thread is counted; the stand-in server allocates on its own
+    uint64_t allocs = count_allocations([&]() {
+        for (int i = 0; i < kRequests; ++i) {
+            fetch_once();
+        }
+    }, true);
+
+    EXPECT_EQ(responses, kRequests + 1u);
+    EXPECT_EQ(server.connections(), 1u);
+    EXPECT_TRUE(local->is_connected());
+    // The callback chain made 26 per request, reconnecting every time; this is 16 on Boost 1.74
+    EXPECT_LE(allocs, kRequests * 20u);
+
+    local->stop();
+    ioc.restart();
+    ioc.run();
+    EXPECT_FALSE(local->is_connected());
+}
+
+TEST_F(RestApiHandlerTest, FailedSnapshotCallsTheFailureHandler) {
+    // A port nothing listens on any more
+    unsigned short port;
+    {
+        boost::asio::ip::tcp::acceptor acceptor(ioc, {boost::asio::ip::make_address("127.0.0.1"), 0});
+        port = acceptor.local_endpoint().port();
+    }
+    auto local = std::make_shared<RestApiHandler>(ioc, ctx, "127.0.0.1", std::to_string(port),
+                                                  "/api/v3/depth?symbol=BTCUSDT&limit=100", *mock_processor);
+    int failures = 0;
+    local->set_failure_handler([&]() {
+        ++failures;
+        if (failures == 1) {
+            local->fetch_snapshot();  // not in flight any more, so this retries
+        }
+    });
+    local->fetch_snapshot();
+    ioc.restart();
+    ioc.run();
+    EXPECT_EQ(failures, 2);
+    EXPECT_FALSE(local->is_connected());
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include "../ShardRuntime.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+template<typename Predicate>
+bool wait_for(Predicate done, std::chrono::milliseconds timeout = std::chrono::seconds(10)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+}  // namespace
+
+TEST(ShardRuntimeTest, SpscMailboxKeepsOrderAcrossThreads) {
+    SpscMailbox<uint64_t> mailbox(64);
+    EXPECT_EQ(mailbox.capacity(), 64u);
+    constexpr uint64_t kItems = 200000;
+
+    std::thread producer([&mailbox]() {
+        for (uint64_t i = 0; i < kItems; ++i) {
+            uint64_t value = i;
+            while (!mailbox.try_push(value)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint64_t expected = 0;
+    uint64_t out_of_order = 0;
+    uint64_t value;
+    while (expected < kItems) {
+        if (mailbox.try_pop(value)) {
+            out_of_order += value != expected;
+            ++expected;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    EXPECT_EQ(out_of_order, 0u);
+    EXPECT_TRUE(mailbox.empty());
+    for (uint64_t i = 0; i < mailbox.capacity(); ++i) {
+        EXPECT_TRUE(mailbox.try_push(i));
+    }
+    value = 0;
+    EXPECT_FALSE(mailbox.try_push(value));
+}
+
+TEST(ShardRuntimeTest, PlacesSymbolsOnFewestLoadedShard) {
+    ShardRuntime runtime(3);
+    std::vector<size_t> per_shard(3, 0);
+    for (int i = 0; i < 9; ++i) {
+        ++per_shard[runtime.assign("sym" + std::to_string(i))];
+    }
+    EXPECT_EQ(per_shard, (std::vector<size_t>{3, 3, 3}));
+
+    size_t shard = runtime.assign("sym4");  // known symbols keep their shard
+    EXPECT_EQ(runtime.find("sym4"), static_cast<int>(shard));
+    runtime.remove("sym4");
+    EXPECT_EQ(runtime.find("sym4"), -1);
+    EXPECT_EQ(runtime.assign("new"), shard);
+    EXPECT_EQ(runtime.symbols_of(shard).size(), 3u);
+}
+
+TEST(ShardRuntimeTest, CrossShardSendsArriveInOrderThroughFullMailboxes) {
+    // Tiny mailboxes so most sends take the overflow path
+    ShardRuntime runtime(2, WaitConfig{}, 8);
+    runtime.run();
+
+    constexpr uint64_t kMessages = 20000;
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> out_of_order{0};
+    std::atomic<bool> wrong_shard{false};
+    uint64_t next = 0;  // only touched on shard 1
+
+    runtime.send(0, [&]() {
+        for (uint64_t i = 0; i < kMessages; ++i) {
+            runtime.send(1, [&, i]() {
+                wrong_shard = wrong_shard || runtime.current_shard() != 1;
+                out_of_order += i != next;
+                next = i + 1;
+                ++received;
+            });
+        }
+    });
+
+    ASSERT_TRUE(wait_for([&]() { return received.load() == kMessages; }));
+    EXPECT_EQ(out_of_order.load(), 0u);
+    EXPECT_FALSE(wrong_shard.load());
+    EXPECT_GT(runtime.mailbox_overflows(), 0u);
+    runtime.stop();
+}
+
+TEST(ShardRuntimeTest, CallRunsOnTargetShard) {
+    ShardRuntime runtime(2);
+    runtime.run();
+
+    EXPECT_EQ(runtime.current_shard(), -1);
+    EXPECT_EQ(runtime.call(1, [&runtime]() { return runtime.current_shard(); }).get(), 1);
+
+    // Ping-pong: shard 0 asks shard 1, which answers through its own mailbox back
+    auto nested = runtime.call(0, [&runtime]() {
+        auto reply = std::make_shared<std::promise<int>>();
+        auto answer = reply->get_future();
+        runtime.send(1, [&runtime, reply]() {
+            int from = runtime.current_shard();
+            runtime.send(0, [reply, from]() { reply->set_value(from * 10); });
+        });
+        return answer;
+    }).get();
+    EXPECT_EQ(nested.get(), 10);
+
+    auto failed = runtime.call(0, []() -> int { throw std::runtime_error("shard task failed"); });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+    runtime.stop();
+}
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include "../OrderbookManager.h"
+#include "../SharedBookPublisher.h"
+#include "../SharedBookReader.h"
+#include <atomic>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+std::string region_name(const char* test) {
+    return std::string("/shared_book_test_") + test + "_" + std::to_string(getpid());
+}
+
+// Update k of the stress book: every field derives from k, so a copy mixing two
+// publications is detectable
+void fill(Orderbook& book, uint64_t k) {
+    book.last_update_id = k;
+    book.synced = true;
+    book.bids.resize(1 + k % shared_book::DEPTH);
+    book.asks.resize(shared_book::DEPTH - k % shared_book::DEPTH);
+    for (size_t i = 0; i < book.bids.size(); ++i) {
+        book.bids[i] = PriceLevel{static_cast<double>(k * 100 - i), static_cast<double>(k)};
+    }
+    for (size_t i = 0; i < book.asks.size(); ++i) {
+        book.asks[i] = PriceLevel{static_cast<double>(k * 100 + 1 + i), static_cast<double>(k)};
+    }
+}
+
+bool consistent(const shared_book::Top& top) {
+    uint64_t k = top.last_update_id;
+    if (top.bid_count != 1 + k % shared_book::DEPTH || top.ask_count != shared_book::DEPTH - k % shared_book::DEPTH) {
+        return false;
+    }
+    for (uint32_t i = 0; i < top.bid_count; ++i) {
+        if (md::to_double(top.bids[i].price) != static_cast<double>(k * 100 - i) || md::to_double(top.bids[i].quantity) != static_cast<double>(k)) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < top.ask_count; ++i) {
+        if (md::to_double(top.asks[i].price) != static_cast<double>(k * 100 + 1 + i) || md::to_double(top.asks[i].quantity) != static_cast<double>(k)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Shared with the forked readers through an anonymous shared mapping
+struct StressState {
+    std::atomic<uint32_t> ready{0};
+    std::atomic<uint64_t> reads[8];
+    std::atomic<uint64_t> versions_seen[8];
+};
+
+}  // namespace
+
+TEST(SharedBookTest, OrderbookChangesReachTheReader) {
+    const std::string name = region_name("books");
+    SharedBookPublisher publisher(name, 4);
+    OrderbookManager books;
+    books.setSharedPublisher(&publisher);
+    simdjson::dom::parser parser;
+    books.OnOrderbookRest("btcusdt", parser.parse(std::string(
+        R"({"lastUpdateId":10,"bids":[["100.5","2.0"],["100.0","1.0"]],"asks":[["101.0","3.0"]]})")));
+
+    SharedBookReader reader(name);
+    EXPECT_EQ(reader.writer_pid(), getpid());
+    ASSERT_EQ(reader.find("btcusdt"), 0);
+    EXPECT_EQ(reader.find("ethusdt"), -1);
+    EXPECT_EQ(reader.symbol(0), "btcusdt");
+    uint64_t version = reader.version(0);
+
+    books.OnOrderbookWs("btcusdt", parser.parse(std::string(
+        R"({"U":11,"u":11,"b":[["100.5","0"]],"a":[["100.8","4.0"]]})")));
+    EXPECT_GT(reader.version(0), version);
+
+    md::Bbo bbo;
+    ASSERT_TRUE(reader.read_bbo(0, bbo));
+    EXPECT_EQ(bbo.update_id, 11u);
+    EXPECT_EQ(bbo.symbol_id, 0u);
+    EXPECT_EQ(bbo.sequence, reader.version(0));
+    EXPECT_EQ(bbo.bid.price, 100 * md::PRICE_SCALE);
+    EXPECT_EQ(bbo.ask.price, 10080000000);
+    EXPECT_EQ(bbo.ask.quantity, 4 * md::PRICE_SCALE);
+
+    shared_book::Top top;
+    ASSERT_TRUE(reader.read(0, top));
+    EXPECT_TRUE(top.synced);
+    EXPECT_EQ(top.bid_count, 1u);
+    EXPECT_EQ(top.ask_count, 2u);
+    EXPECT_EQ(top.asks[1].price, md::to_fixed(101.0));
+    EXPECT_FALSE(reader.read(1, top));
+}
+
+TEST(SharedBookTest, FullRegionAndMissingRegion) {
+    const std::string name = region_name("full");
+    {
+        SharedBookPublisher publisher(name, 1);
+        EXPECT_EQ(publisher.slot_for("btcusdt"), 0u);
+        EXPECT_EQ(publisher.slot_for("btcusdt"), 0u);
+        EXPECT_EQ(publisher.slot_for("ethusdt"), SharedBookPublisher::NO_SLOT);
+        EXPECT_EQ(publisher.symbol_count(), 1u);
+    }
+    // Unlinked by the publisher
+    EXPECT_THROW(SharedBookReader{name}, std::runtime_error);
+}
+
+TEST(SharedBookTest, SlotLeftMidPublicationFailsTheRead) {
+    const std::string name = region_name("dead");
+    SharedBookPublisher publisher(name, 1);
+    Orderbook book;
+    fill(book, 1);
+    publisher.publish(publisher.slot_for("btcusdt"), book);
+
+    // What a writer that died inside publish() leaves behind: an odd sequence
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    ASSERT_GE(fd, 0);
+    void* base = mmap(nullptr, shared_book::region_size(1), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(base, MAP_FAILED);
+    shared_book::Slot& slot = shared_book::slots(static_cast<shared_book::Header*>(base))[0];
+    uint64_t sequence = slot.sequence.load();
+    slot.sequence.store(sequence + 1);
+
+    SharedBookReader reader(name);
+    shared_book::Top top;
+    md::Bbo bbo;
+    EXPECT_FALSE(reader.read(0, top));
+    EXPECT_FALSE(reader.read_bbo(0, bbo));
+
+    slot.sequence.store(sequence + 2);
+    EXPECT_TRUE(reader.read(0, top));
+    EXPECT_TRUE(reader.read_bbo(0, bbo));
+    munmap(base, shared_book::region_size(1));
+}
+
+// Forked readers poll one slot while this process republishes it as fast as it can;
+// none may ever see a mix of two publications
+TEST(SharedBookTest, ReadersInOtherProcessesNeverSeeTornBooks) {
+    constexpr int kReaders = 3;
+    constexpr uint64_t kUpdatesAfterReady = 1000000;
+    const std::string name = region_name("stress");
+    SharedBookPublisher publisher(name, 1);
+    uint32_t slot = publisher.slot_for("btcusdt");
+    Orderbook book;
+    fill(book, 1);
+    publisher.publish(slot, book);
+
+    void* shared = mmap(nullptr, sizeof(StressState), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(shared, MAP_FAILED);
+    auto* state = new (shared) StressState();
+
+    std::vector<pid_t> children;
+    for (int r = 0; r < kReaders; ++r) {
+        pid_t pid = fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            // Exit status: 0 consistent throughout, 1 torn read, 2 update IDs went backwards
+            int status = 0;
+            {
+                SharedBookReader reader(name);
+                state->ready.fetch_add(1);
+                shared_book::Top top;
+                uint64_t last = 0;
+                uint64_t last_version = 0;
+                uint64_t reads = 0, versions = 0;
+                while (last != UINT64_MAX && status == 0) {
+                    if (!reader.read(0, top)) {
+                        continue;  // the writer was descheduled mid-publication for too long
+                    }
+                    ++reads;
+                    if (top.last_update_id == UINT64_MAX) {
+                        break;
+                    }
+                    if (!consistent(top)) {
+                        status = 1;
+                    } else if (top.last_update_id < last) {
+                        status = 2;
+                    }
+                    last = top.last_update_id;
+                    uint64_t version = reader.version(0);
+                    versions += version != last_version;
+                    last_version = version;
+                }
+                state->reads[r] = reads;
+                state->versions_seen[r] = versions;
+            }
+            _exit(status);
+        }
+        children.push_back(pid);
+    }
+
+    uint64_t k = 1;
+    while (state->ready.load() < kReaders) {
+        fill(book, ++k);
+        publisher.publish(slot, book);
+    }
+    for (uint64_t end = k + kUpdatesAfterReady; k < end;) {
+        fill(book, ++k);
+        publisher.publish(slot, book);
+    }
+    book.last_update_id = UINT64_MAX;  // tells the readers to stop
+    publisher.publish(slot, book);
+
+    for (int r = 0; r < kReaders; ++r) {
+        int status = -1;
+        ASSERT_EQ(waitpid(children[r], &status, 0), children[r]);
+        ASSERT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0) << "reader " << r;
+        EXPECT_GT(state->reads[r].load(), 0u);
+        EXPECT_GT(state->versions_seen[r].load(), 1u);
+    }
+    munmap(shared, sizeof(StressState));
+}
@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include "../SlabAllocator.h"
+#include "AllocationCounter.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct alignas(64) CacheLine {
+    uint64_t value[8];
+};
+
+bool aligned(const void* p, size_t alignment) {
+    return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+}  // namespace
+
+TEST(SlabAllocatorTest, SizeClassesCoverRequestAndAlignment) {
+    EXPECT_EQ(SlabAllocator::size_class(1), 16u);
+    EXPECT_EQ(SlabAllocator::size_class(129), 160u);
+    EXPECT_EQ(SlabAllocator::size_class(257), 320u);
+    EXPECT_EQ(SlabAllocator::size_class(SlabAllocator::MAX_SMALL_SIZE), SlabAllocator::MAX_SMALL_SIZE);
+    EXPECT_EQ(SlabAllocator::size_class(SlabAllocator::MAX_SMALL_SIZE + 1), 0u);
+    EXPECT_EQ(SlabAllocator::size_class(8, 64), 64u);
+    EXPECT_EQ(SlabAllocator::size_class(16, 8192), 0u);
+
+    for (size_t alignment = 1; alignment <= SlabAllocator::MAX_ALIGNMENT; alignment <<= 1) {
+        for (size_t size = 1; size <= SlabAllocator::MAX_SMALL_SIZE; size += size / 8 + 1) {
+            size_t block = SlabAllocator::size_class(size, alignment);
+            if (block == 0) {
+                continue;
+            }
+            EXPECT_GE(block, size);
+            EXPECT_EQ(block % alignment, 0u) << size << " aligned to " << alignment;
+
+            void* p = SlabAllocator::allocate(size, alignment);
+            EXPECT_TRUE(aligned(p, alignment)) << size << " aligned to " << alignment;
+            std::memset(p, 0xab, size);
+            SlabAllocator::deallocate(p, size, alignment);
+        }
+    }
+}
+
+TEST(SlabAllocatorTest, BlocksDoNotOverlapAndAreReused) {
+    std::vector<char*> blocks;
+    for (int i = 0; i < 10000; ++i) {
+        char* p = static_cast<char*>(SlabAllocator::allocate(48));
+        std::memset(p, i & 0xff, 48);
+        blocks.push_back(p);
+    }
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        ASSERT_EQ(blocks[i][0], static_cast<char>(i & 0xff));
+        ASSERT_EQ(blocks[i][47], static_cast<char>(i & 0xff));
+    }
+    char* newest = blocks.back();
+    std::sort(blocks.begin(), blocks.end());
+    for (size_t i = 1; i < blocks.size(); ++i) {
+        ASSERT_GE(blocks[i] - blocks[i - 1], 48);
+    }
+
+    SlabAllocator::deallocate(newest, 48);
+    EXPECT_EQ(SlabAllocator::allocate(48), newest);  // most recently freed block comes back first
+    for (char* p : blocks) {
+        SlabAllocator::deallocate(p, 48);
+    }
+}
+
+TEST(SlabAllocatorTest, LargeRequestsFallBackToOperatorNew) {
+    auto before = SlabAllocator::stats().large_allocations;
+    void* p = SlabAllocator::allocate(1 << 20, 64);
+    EXPECT_TRUE(aligned(p, 64));
+    std::memset(p, 0, 1 << 20);
+    SlabAllocator::deallocate(p, 1 << 20, 64);
+
+    // Alignment above a page is served the same way
+    void* page_aligned = SlabAllocator::allocate(16, 8192);
+    EXPECT_TRUE(aligned(page_aligned, 8192));
+    SlabAllocator::deallocate(page_aligned, 16, 8192);
+    EXPECT_EQ(SlabAllocator::stats().large_allocations, before + 2);
+}
+
+TEST(SlabAllocatorTest, RemoteFreesAreBatchedBackToTheOwner) {
+    constexpr size_t kBlocks = 4096;
+    std::vector<void*> blocks;
+    for (size_t i = 0; i < kBlocks; ++i) {
+        blocks.push_back(SlabAllocator::allocate(96));
+    }
+    auto before = SlabAllocator::stats();
+
+    std::thread consumer([&blocks]() {
+        for (void* p : blocks) {
+            SlabAllocator::deallocate(p, 96);
+        }
+        SlabAllocator::flush_thread_cache();
+    });
+    consumer.join();
+
+    auto after = SlabAllocator::stats();
+    EXPECT_EQ(after.remote_frees - before.remote_frees, kBlocks);
+    EXPECT_LE(after.remote_flushes - before.remote_flushes, kBlocks / SlabAllocator::REMOTE_BATCH + 8);
+
+    // The owner gets the blocks back without reserving more slabs. The last slab still
+    // has room it never handed out, which is used before collecting remote frees.
+    std::set<void*> freed(blocks.begin(), blocks.end());
+    size_t reused = 0;
+    blocks.clear();
+    for (size_t i = 0; i < kBlocks; ++i) {
+        blocks.push_back(SlabAllocator::allocate(96));
+        reused += freed.count(blocks.back());
+    }
+    EXPECT_GE(reused, kBlocks / 2);
+    EXPECT_EQ(SlabAllocator::stats().slabs, after.slabs);
+    for (void* p : blocks) {
+        SlabAllocator::deallocate(p, 96);
+    }
+}
+
+TEST(SlabAllocatorTest, SlabsOfExitedThreadsAreAdopted) {
+    // A size class no other test uses, so the abandoned slab is the only candidate
+    constexpr size_t kSize = 28000;
+    std::vector<void*> blocks;
+    std::thread owner([&blocks]() {
+        for (int i = 0; i < 3; ++i) {
+            blocks.push_back(SlabAllocator::allocate(kSize));
+        }
+    });
+    owner.join();
+    EXPECT_GE(SlabAllocator::stats().abandoned_slabs, 1u);
+
+    auto adopted = SlabAllocator::stats().adopted_slabs;
+    std::thread heir([&blocks]() {
+        void* p = SlabAllocator::allocate(kSize);
+        for (void* block : blocks) {
+            SlabAllocator::deallocate(block, kSize);  // local frees on the adopted slab
+        }
+        SlabAllocator::deallocate(p, kSize);
+    });
+    heir.join();
+    EXPECT_EQ(SlabAllocator::stats().adopted_slabs, adopted + 1);
+}
+
+TEST(SlabAllocatorTest, StlAdapterServesContainersWithoutOperatorNew) {
+    using Map = std::map<int, int, std::less<int>, SlabStlAllocator<std::pair<const int, int>>>;
+    // The first allocation on a thread creates its cache
+    SlabAllocator::deallocate(SlabAllocator::allocate(16), 16);
+
+    auto allocations = count_allocations([]() {
+        std::vector<int, SlabStlAllocator<int>> values;
+        for (int i = 0; i < 1000; ++i) {
+            values.push_back(i);
+        }
+        Map map;
+        for (int i = 0; i < 100; ++i) {
+            map[i] = i;
+        }
+    }, true);
+    EXPECT_EQ(allocations, 0u);
+
+    auto line = std::allocate_shared<CacheLine>(SlabStlAllocator<CacheLine>());
+    EXPECT_TRUE(aligned(line.get(), alignof(CacheLine)));
+    line->value[7] = 42;
+    EXPECT_EQ(line->value[7], 42u);
+}
+
+TEST(SlabAllocatorTest, ConcurrentCrossThreadChurn) {
+    // Producers allocate, consumers free whatever they pick up: mostly remote frees,
+    // with slab reuse racing against the batches being handed back
+    constexpr int kThreads = 4;
+    constexpr int kRounds = 20000;
+    std::mutex mutex;
+    std::vector<std::pair<uint64_t*, size_t>> shared;
+    std::atomic<uint64_t> corrupted{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < kRounds; ++i) {
+                size_t size = 16 + static_cast<size_t>((i * 37 + t * 11) % 600);
+                auto* p = static_cast<uint64_t*>(SlabAllocator::allocate(size));
+                p[0] = size;
+                std::pair<uint64_t*, size_t> other{nullptr, 0};
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    shared.emplace_back(p, size);
+                    if (shared.size() > 64) {
+                        other = shared[(i * 7 + t) % shared.size()];
+                        shared[(i * 7 + t) % shared.size()] = shared.back();
+                        shared.pop_back();
+                    }
+                }
+                if (other.first) {
+                    corrupted += other.first[0] != other.second;
+                    SlabAllocator::deallocate(other.first, other.second);
+                }
+            }
+            SlabAllocator::flush_thread_cache();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (auto& [p, size] : shared) {
+        corrupted += p[0] != size;
+        SlabAllocator::deallocate(p, size);
+    }
+    EXPECT_EQ(corrupted.load(), 0u);
+}
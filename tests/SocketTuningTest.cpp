@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include "../SocketTuning.h"
+#include <boost/asio.hpp>
+
+using tcp = boost::asio::ip::tcp;
+
+class SocketTuningTest : public ::testing::Test {
+protected:
+    boost::asio::io_context ioc;
+    tcp::acceptor acceptor{ioc, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)};
+    tcp::socket client{ioc};
+    tcp::socket server{ioc};
+
+    void SetUp() override {
+        client.connect(acceptor.local_endpoint());
+        acceptor.accept(server);
+    }
+};
+
+TEST_F(SocketTuningTest, KernelRxTimestampPrecedesUserRead) {
+    LowLatencySocketProfile profile;
+    profile.enabled = true;
+    profile.busy_poll_us = 0;  // needs CAP_NET_ADMIN above the sysctl default
+    ASSERT_TRUE(SocketTuning::apply_low_latency_profile(client.native_handle(), profile));
+
+    int64_t before = SocketTuning::realtime_ns();
+    boost::asio::write(server, boost::asio::buffer(std::string("depth")));
+    client.wait(tcp::socket::wait_read);
+
+    int64_t rx_ns = SocketTuning::peek_rx_timestamp_ns(client.native_handle());
+    int64_t after = SocketTuning::realtime_ns();
+    ASSERT_GT(rx_ns, 0);
+    EXPECT_GE(rx_ns, before);
+    EXPECT_LE(rx_ns, after);
+
+    // Peeking must not consume the payload
+    char buf[5];
+    EXPECT_EQ(boost::asio::read(client, boost::asio::buffer(buf)), 5u);
+}
+
+TEST_F(SocketTuningTest, NoTimestampWithoutProfile) {
+    boost::asio::write(server, boost::asio::buffer(std::string("x")));
+    client.wait(tcp::socket::wait_read);
+    EXPECT_EQ(SocketTuning::peek_rx_timestamp_ns(client.native_handle()), -1);
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include "../StartupOrchestrator.h"
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(StartupOrchestratorTest, SnapshotWeightFollowsDepthLimit) {
+    EXPECT_EQ(StartupOrchestrator::snapshot_weight(100), 5);
+    EXPECT_EQ(StartupOrchestrator::snapshot_weight(500), 25);
+    EXPECT_EQ(StartupOrchestrator::snapshot_weight(1000), 50);
+    EXPECT_EQ(StartupOrchestrator::snapshot_weight(5000), 250);
+}
+
+TEST(StartupOrchestratorTest, GroupsStreamsPerConnection) {
+    std::vector<std::string> symbols;
+    for (int i = 0; i < 450; ++i) {
+        symbols.push_back("sym" + std::to_string(i));
+    }
+    auto groups = StartupOrchestrator::group_streams(symbols, 200);
+    ASSERT_EQ(groups.size(), 3u);
+    EXPECT_EQ(groups[0].size(), 200u);
+    EXPECT_EQ(groups[2].size(), 50u);
+    EXPECT_EQ(groups[2].back(), "sym449");
+}
+
+TEST(StartupOrchestratorTest, ScheduleStaysWithinWeightBudget) {
+    StartupConfig config;
+    config.snapshot_limit = 1000;  // weight 50, 5100 budget -> 102 requests in the first burst
+    auto schedule = StartupOrchestrator::plan_snapshot_schedule(1000, config);
+    ASSERT_EQ(schedule.size(), 1000u);
+
+    const int weight = StartupOrchestrator::snapshot_weight(config.snapshot_limit);
+    const int budget = config.weight_budget_per_minute - config.resync_weight_per_minute;
+    for (size_t i = 1; i < schedule.size(); ++i) {
+        EXPECT_GE(schedule[i] - schedule[i - 1], config.stagger);
+    }
+    // Weight spent inside any sliding 60s window starting at a request
+    size_t end = 0;
+    for (size_t begin = 0; begin < schedule.size(); ++begin) {
+        while (end < schedule.size() && schedule[end] - schedule[begin] < std::chrono::seconds(60)) {
+            ++end;
+        }
+        EXPECT_LE(static_cast<int>(end - begin) * weight, budget) << "window starting at request " << begin;
+    }
+}
+
+TEST(StartupOrchestratorTest, SmallColdStartFitsInOneBurst) {
+    StartupConfig config;
+    auto schedule = StartupOrchestrator::plan_snapshot_schedule(200, config);
+    EXPECT_EQ(schedule.front().count(), 0);
+    EXPECT_LE(schedule.back(), std::chrono::milliseconds(200 * config.stagger.count()));
+}
+
+TEST(StartupOrchestratorTest, ReportsTimeToConsistentBook) {
+    StartupOrchestrator orchestrator;
+    orchestrator.begin({"btcusdt", "ethusdt"});
+    EXPECT_FALSE(orchestrator.complete());
+
+    orchestrator.on_book_consistent("btcusdt");
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    orchestrator.on_book_consistent("ethusdt");
+    orchestrator.on_book_consistent("ethusdt");  // later resyncs do not count
+    EXPECT_TRUE(orchestrator.complete());
+
+    StartupReport report = orchestrator.report();
+    EXPECT_EQ(report.pending, 0u);
+    ASSERT_EQ(report.time_to_consistent_ms.size(), 2u);
+    EXPECT_GE(report.time_to_consistent_ms["ethusdt"], 5.0);
+    EXPECT_GE(report.overall_ms, report.time_to_consistent_ms["btcusdt"]);
+    EXPECT_DOUBLE_EQ(report.p99_ms, report.overall_ms);
+}
+
+TEST(StartupOrchestratorTest, ResyncsBackOffPerSymbol) {
+    StartupConfig config;
+    config.resync_backoff = std::chrono::milliseconds(100);
+    config.max_resync_backoff = std::chrono::milliseconds(1000);
+    StartupOrchestrator orchestrator(config);
+    auto t0 = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(orchestrator.schedule_resync("btcusdt", t0).count(), 0);
+    EXPECT_EQ(orchestrator.schedule_resync("btcusdt", t0).count(), 100);
+    EXPECT_EQ(orchestrator.schedule_resync("btcusdt", t0).count(), 300);  // 200 after the last one
+    EXPECT_EQ(orchestrator.schedule_resync("ethusdt", t0).count(), 0);     // other symbols don't wait
+
+    // Quiet for the longest backoff: starts over
+    auto later = t0 + std::chrono::milliseconds(300) + config.max_resync_backoff;
+    EXPECT_EQ(orchestrator.schedule_resync("btcusdt", later).count(), 0);
+}
+
+TEST(StartupOrchestratorTest, ResyncsStayWithinTheirReserve) {
+    StartupConfig config;
+    config.snapshot_limit = 1000;  // weight 50, 900 reserved -> 18 resyncs per window
+    config.resync_backoff = std::chrono::milliseconds(0);
+    StartupOrchestrator orchestrator(config);
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<std::chrono::steady_clock::time_point> slots;
+    for (int i = 0; i < 100; ++i) {
+        auto now = t0 + std::chrono::milliseconds(i * 10);
+        slots.push_back(now + orchestrator.schedule_resync("sym" + std::to_string(i % 40), now));
+    }
+    std::sort(slots.begin(), slots.end());
+    const int weight = StartupOrchestrator::snapshot_weight(config.snapshot_limit);
+    const int reserve = config.resync_weight_per_minute;
+    size_t end = 0;
+    for (size_t begin = 0; begin < slots.size(); ++begin) {
+        while (end < slots.size() && slots[end] - slots[begin] < std::chrono::seconds(60)) {
+            ++end;
+        }
+        EXPECT_LE(static_cast<int>(end - begin) * weight, reserve) << "window starting at resync " << begin;
+    }
+    // The first window is used up before anything waits
+    EXPECT_LT(slots[17] - t0, std::chrono::seconds(1));
+    EXPECT_GE(slots[18] - t0, std::chrono::seconds(60));
+}
+
+TEST(StartupOrchestratorTest, ReportsPeakRequestWeight) {
+    StartupOrchestrator orchestrator;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < 3; ++i) {
+        orchestrator.on_snapshot_request(t0 + std::chrono::seconds(i));
+    }
+    orchestrator.on_snapshot_request(t0 + std::chrono::seconds(70));  // the others have left the window
+    EXPECT_EQ(orchestrator.report().peak_weight, 3 * StartupOrchestrator::snapshot_weight(100));
+}
+
+TEST(StartupOrchestratorTest, ThousandSymbolsFitInOneWindow) {
+    auto schedule = StartupOrchestrator::plan_snapshot_schedule(1000, StartupConfig());
+    EXPECT_LT(schedule.back(), std::chrono::seconds(5));
+}
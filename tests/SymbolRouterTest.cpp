@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include "../SymbolRouter.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+void burn(std::chrono::microseconds cost) {
+    auto until = std::chrono::steady_clock::now() + cost;
+    while (std::chrono::steady_clock::now() < until) {
+    }
+}
+
+// Checks that every symbol sees its sequence numbers in order and none go missing
+struct SequenceCheck {
+    std::unordered_map<std::string, uint64_t> next;  // only touched from the symbol's current loop
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> out_of_order{0};
+
+    void seen(const std::string& symbol, uint64_t seq) {
+        uint64_t& expected = next[symbol];
+        if (seq != expected) {
+            ++out_of_order;
+        }
+        expected = seq + 1;
+        ++received;
+    }
+};
+
+}  // namespace
+
+TEST(SymbolRouterTest, AssignsEvenlyBeforeMeasurements) {
+    EventLoopPool pool(4);
+    SymbolRouter router(pool);
+    std::vector<size_t> per_loop(4, 0);
+    for (int i = 0; i < 20; ++i) {
+        ++per_loop[router.assign("sym" + std::to_string(i))];
+    }
+    for (size_t count : per_loop) {
+        EXPECT_EQ(count, 5u);
+    }
+    EXPECT_EQ(router.assign("sym3"), router.loop_of("sym3"));
+}
+
+TEST(SymbolRouterTest, MigrationKeepsOrderAndDropsNothing) {
+    EventLoopPool pool(2);
+    SymbolRouter router(pool);
+    pool.run();
+    router.assign("btcusdt");
+    size_t source = router.loop_of("btcusdt");
+
+    // Keys are inserted up front so the map is only read and updated in place afterwards
+    SequenceCheck check;
+    check.next["btcusdt"] = 0;
+    constexpr uint64_t kMessages = 20000;
+    for (uint64_t seq = 0; seq < kMessages; ++seq) {
+        router.route("btcusdt", [&check, seq]() {
+            check.seen("btcusdt", seq);
+            burn(std::chrono::microseconds(1));
+        });
+        if (seq == kMessages / 4) {
+            EXPECT_TRUE(router.migrate("btcusdt", 1 - source));
+        }
+        if (seq == kMessages / 2) {
+            // Tasks routed during the first handoff are held; wait for it to finish
+            while (router.is_migrating("btcusdt")) {
+                std::this_thread::yield();
+            }
+            EXPECT_EQ(router.loop_of("btcusdt"), 1 - source);
+            EXPECT_TRUE(router.migrate("btcusdt", source));
+        }
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (check.received < kMessages && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    pool.stop();
+
+    EXPECT_EQ(check.received.load(), kMessages);
+    EXPECT_EQ(check.out_of_order.load(), 0u);
+    EXPECT_EQ(router.loop_of("btcusdt"), source);  // moved there and back
+    EXPECT_EQ(router.migrations(), 2u);
+}
+
+TEST(SymbolRouterTest, SkewedFeedIsRebalanced) {
+    constexpr size_t kLoops = 4;
+    EventLoopPool pool(kLoops);
+    PlacementConfig config;
+    config.sample_interval = std::chrono::milliseconds(100);
+    config.imbalance_threshold = 0.1;
+    SymbolRouter router(pool, config);
+    pool.run();
+
+    // 16 symbols; the hot ones are placed onto the same loop by assignment order
+    std::vector<std::string> symbols;
+    for (int i = 0; i < 16; ++i) {
+        symbols.push_back("sym" + std::to_string(i));
+        router.assign(symbols.back());
+    }
+    const std::vector<std::string> hot = {"sym0", "sym4", "sym8"};
+    for (const auto& symbol : hot) {
+        ASSERT_EQ(router.loop_of(symbol), router.loop_of("sym0"));
+    }
+
+    SequenceCheck check;
+    for (const auto& symbol : symbols) {
+        check.next[symbol] = 0;
+    }
+    std::unordered_map<std::string, uint64_t> sent;
+    uint64_t total = 0;
+
+    // Hot symbols carry ~90% of the messages
+    auto feed_for = [&](std::chrono::milliseconds duration) {
+        auto until = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < until) {
+            for (int round = 0; round < 10; ++round) {
+                for (const auto& symbol : hot) {
+                    uint64_t seq = sent[symbol]++;
+                    router.route(symbol, [&check, symbol, seq]() {
+                        check.seen(symbol, seq);
+                        burn(std::chrono::microseconds(5));
+                    });
+                    ++total;
+                }
+            }
+            for (const auto& symbol : symbols) {
+                uint64_t seq = sent[symbol]++;
+                router.route(symbol, [&check, symbol, seq]() { check.seen(symbol, seq); });
+                ++total;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    };
+
+    for (int i = 0; i < 6; ++i) {
+        feed_for(config.sample_interval + std::chrono::milliseconds(10));
+        router.rebalance();
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (check.received < total && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    pool.stop();
+
+    EXPECT_EQ(check.received.load(), total);
+    EXPECT_EQ(check.out_of_order.load(), 0u);
+    EXPECT_GE(router.migrations(), 2u);
+
+    // The hot symbols no longer share a loop
+    std::vector<size_t> hot_loops;
+    for (const auto& symbol : hot) {
+        hot_loops.push_back(router.loop_of(symbol));
+    }
+    std::sort(hot_loops.begin(), hot_loops.end());
+    EXPECT_EQ(std::unique(hot_loops.begin(), hot_loops.end()), hot_loops.end());
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include "../Task.h"
+#include "../EventLoop.h"
+#include "AllocationCounter.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+TEST(TaskTest, SmallCapturesStayInline) {
+    int calls = 0;
+    auto owned = std::make_unique<int>(7);
+    std::string text(40, 'x');  // heap-backed, moved rather than copied
+
+    uint64_t allocs = count_allocations([&]() {
+        Task task([&calls, p = std::move(owned), s = std::move(text)]() { calls += *p + static_cast<int>(s.size()); });
+        Task moved(std::move(task));
+        EXPECT_FALSE(task);
+        moved();
+    });
+    EXPECT_EQ(calls, 47);
+    EXPECT_EQ(allocs, 0u);
+
+    std::array<char, Task::INLINE_SIZE + 1> big{};
+    allocs = count_allocations([&]() {
+        Task task([big, &calls]() { calls += big[0] + 1; });
+        task();
+    });
+    EXPECT_EQ(calls, 48);
+    EXPECT_EQ(allocs, 1u);  // oversized captures fall back to a single heap block
+}
+
+TEST(TaskTest, MillionPostsDoNotAllocate) {
+    EventLoop loop;
+    loop.run();
+
+    constexpr int kPosts = 1000000;
+    std::atomic<int> done{0};
+    const size_t high_water = SchedulerConfig().queue_capacity / 2;
+    auto post_all = [&]() {
+        for (int i = 0; i < kPosts; ++i) {
+            // Steady state: the producer never outruns the ring
+            while (loop.get_task_count() > high_water) {
+                std::this_thread::yield();
+            }
+            auto priority = static_cast<EventLoop::Priority>(i % 3);
+            loop.post([&done, i, tag = static_cast<double>(i)]() {
+                if (static_cast<int>(tag) == i) {
+                    done.fetch_add(1, std::memory_order_relaxed);
+                }
+            }, priority);
+        }
+        while (done.load() < kPosts) {
+            std::this_thread::yield();
+        }
+    };
+
+    post_all();  // warm up: lets asio and the loop reach steady state
+    done = 0;
+    uint64_t allocs = count_allocations(post_all);
+
+    EXPECT_EQ(done.load(), kPosts);
+    EXPECT_EQ(allocs, 0u);
+    EXPECT_EQ(loop.get_stats().queue_overflows, 0u);
+    loop.stop();
+}
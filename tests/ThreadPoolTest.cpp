@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include "../ThreadPool.h"
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Recursive fork-join: each half is forked into the worker's own deque and stolen by idle workers
+uint64_t parallel_sum(WorkStealingThreadPool& pool, const std::vector<uint64_t>& values, size_t begin, size_t end) {
+    if (end - begin <= 1024) {
+        return std::accumulate(values.begin() + begin, values.begin() + end, uint64_t{0});
+    }
+    size_t mid = begin + (end - begin) / 2;
+    auto left = pool.enqueue(parallel_sum, std::ref(pool), std::cref(values), begin, mid);
+    uint64_t right = parallel_sum(pool, values, mid, end);
+    return pool.wait(left) + right;
+}
+
+}  // namespace
+
+TEST(ThreadPoolTest, FuturesCarryResultsAndExceptions) {
+    WorkStealingThreadPool pool(2);
+    auto sum = pool.enqueue([](int a, int b) { return a + b; }, 2, 3);
+    auto text = pool.enqueue([](std::unique_ptr<std::string> s) { return *s + "!"; },
+                             std::make_unique<std::string>("move-only"));
+    auto failure = pool.enqueue([]() { throw std::runtime_error("boom"); });
+
+    EXPECT_EQ(sum.get(), 5);
+    EXPECT_EQ(text.get(), "move-only!");
+    EXPECT_THROW(failure.get(), std::runtime_error);
+}
+
+TEST(ThreadPoolTest, ForkJoinSpreadsAcrossWorkers) {
+    WorkStealingThreadPool pool(4);
+    std::vector<uint64_t> values(1 << 20);
+    std::iota(values.begin(), values.end(), 0);
+
+    auto total = pool.enqueue(parallel_sum, std::ref(pool), std::cref(values), size_t{0}, values.size());
+    uint64_t n = values.size();
+    EXPECT_EQ(total.get(), n * (n - 1) / 2);
+    EXPECT_GT(pool.steals(), 0u);
+}
+
+TEST(ThreadPoolTest, ShutdownRunsQueuedTasksAndRejectsNewOnes) {
+    std::atomic<int> ran{0};
+    WorkStealingThreadPool pool(2);
+    for (int i = 0; i < 1000; ++i) {
+        pool.enqueue([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); });
+    }
+    pool.shutdown();
+
+    EXPECT_EQ(ran.load(), 1000);
+    EXPECT_THROW(pool.enqueue([]() {}), std::runtime_error);
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include "../TradeStatistics.h"
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr int64_t T0 = 1700000000000;  // on a minute boundary
+}
+
+TEST(TradeStatisticsTest, WindowsSumVolumeVwapAndPriceChange) {
+    TradeStatistics stats;
+    EXPECT_EQ(stats.get("btcusdt", T0).second.trades, 0u);
+
+    ASSERT_TRUE(stats.on_trade("btcusdt", 1, 100.0, 1.0, T0));
+    ASSERT_TRUE(stats.on_trade("btcusdt", 2, 110.0, 3.0, T0 + 250));
+    ASSERT_TRUE(stats.on_trade("btcusdt", 3, 105.0, 1.0, T0 + 950));
+
+    TradingStats now = stats.get("btcusdt", T0 + 950);
+    for (const WindowStats* window : {&now.second, &now.minute, &now.day}) {
+        EXPECT_EQ(window->trades, 3u);
+        EXPECT_DOUBLE_EQ(window->volume, 5.0);
+        EXPECT_DOUBLE_EQ(window->quote_volume, 535.0);
+        EXPECT_DOUBLE_EQ(window->vwap, 107.0);
+        EXPECT_DOUBLE_EQ(window->price_change, 5.0);
+        EXPECT_DOUBLE_EQ(window->price_change_percent, 5.0);
+    }
+    EXPECT_DOUBLE_EQ(now.last_price, 105.0);
+    EXPECT_DOUBLE_EQ(now.volume, now.day.volume);
+    EXPECT_DOUBLE_EQ(now.price_change, now.day.price_change);
+    EXPECT_EQ(stats.get("ethusdt", T0).day.trades, 0u);
+}
+
+TEST(TradeStatisticsTest, TradesExpireBucketByBucket) {
+    TradeStatistics stats;
+    stats.on_trade("btcusdt", 1, 100.0, 1.0, T0);
+    stats.on_trade("btcusdt", 2, 120.0, 2.0, T0 + 500);
+
+    // The 1s window has dropped the first 100ms bucket, the others keep both trades
+    TradingStats later = stats.get("btcusdt", T0 + 1000);
+    EXPECT_EQ(later.second.trades, 1u);
+    EXPECT_DOUBLE_EQ(later.second.volume, 2.0);
+    EXPECT_DOUBLE_EQ(later.second.price_change, 0.0);  // opens at the surviving trade
+    EXPECT_EQ(later.minute.trades, 2u);
+    EXPECT_DOUBLE_EQ(later.minute.price_change, 20.0);
+
+    later = stats.get("btcusdt", T0 + 60 * 1000);
+    EXPECT_EQ(later.second.trades, 0u);
+    EXPECT_DOUBLE_EQ(later.second.vwap, 0.0);
+    EXPECT_EQ(later.minute.trades, 0u);
+    EXPECT_EQ(later.day.trades, 2u);
+
+    // A day later only the latest price is left
+    later = stats.get("btcusdt", T0 + 24 * 3600 * 1000);
+    EXPECT_EQ(later.day.trades, 0u);
+    EXPECT_DOUBLE_EQ(later.volume, 0.0);
+    EXPECT_DOUBLE_EQ(later.last_price, 120.0);
+
+    // Reading never moves a window back, and trades older than it are ignored
+    stats.on_trade("btcusdt", 3, 130.0, 1.0, T0 + 1000);
+    EXPECT_EQ(stats.get("btcusdt", T0).day.trades, 0u);
+}
+
+TEST(TradeStatisticsTest, DuplicatesAndLateTradesWithinTheWindow) {
+    TradeStatistics stats;
+    stats.on_trade("btcusdt", 10, 100.0, 1.0, T0 + 2000);
+    EXPECT_FALSE(stats.on_trade("btcusdt", 10, 100.0, 1.0, T0 + 2000));  // replayed after a reconnect
+    EXPECT_FALSE(stats.on_trade("btcusdt", 9, 90.0, 1.0, T0 + 1500));
+
+    // A later ID with an earlier time still counts and opens the window
+    EXPECT_TRUE(stats.on_trade("btcusdt", 11, 95.0, 1.0, T0 + 800));
+    TradingStats now = stats.get("btcusdt", T0 + 2000);
+    EXPECT_EQ(now.minute.trades, 2u);
+    EXPECT_DOUBLE_EQ(now.minute.price_change, 0.0);  // last 95, first 95
+    EXPECT_EQ(now.second.trades, 1u);                // 1.2s before the latest is outside the 1s window
+}
+
+TEST(TradeStatisticsTest, TotalsStayExactOverManyWindowPasses) {
+    TradeStatistics stats;
+    // One trade every 10ms for five minutes: each 1s window holds 91 to 100 of them
+    uint64_t id = 0;
+    for (int64_t t = T0; t < T0 + 5 * 60 * 1000; t += 10) {
+        ++id;
+        stats.on_trade("btcusdt", id, 100.0 + static_cast<double>(id % 7), 0.1, t);
+    }
+    TradingStats now = stats.get("btcusdt", T0 + 5 * 60 * 1000 - 10);
+    EXPECT_EQ(now.second.trades, 100u);
+    EXPECT_NEAR(now.second.volume, 10.0, 1e-9);
+    EXPECT_EQ(now.minute.trades, 6000u);
+    EXPECT_EQ(now.day.trades, id);
+    EXPECT_GT(now.minute.vwap, 100.0);
+    EXPECT_LT(now.minute.vwap, 106.0);
+
+    // Once they all expire the totals are zero again, not what rounding left
+    now = stats.get("btcusdt", T0 + 10 * 60 * 1000);
+    EXPECT_EQ(now.minute.trades, 0u);
+    EXPECT_EQ(now.minute.volume, 0.0);
+}
+
+TEST(TradeStatisticsTest, SymbolsRecordConcurrently) {
+    TradeStatistics stats;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&stats, i]() {
+            for (uint64_t id = 1; id <= 1000; ++id) {
+                stats.on_trade("sym" + std::to_string(i % 2), id * 2 + static_cast<uint64_t>(i / 2), 10.0, 1.0,
+                               T0 + static_cast<int64_t>(id));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(stats.symbol_count(), 2u);
+    // Two threads per symbol interleave IDs, so some of each are dropped as out of order,
+    // but every recorded trade is counted exactly once
+    for (const char* symbol : {"sym0", "sym1"}) {
+        TradingStats now = stats.get(symbol, T0 + 1000);
+        EXPECT_GE(now.day.trades, 1000u);
+        EXPECT_LE(now.day.trades, 2000u);
+        EXPECT_DOUBLE_EQ(now.day.volume, static_cast<double>(now.day.trades));
+    }
+}